@@ -0,0 +1,141 @@
+/*
+ * arch/arm64/include/arch_atomic.h
+ *
+ * ARM64 atomic read-modify-write primitives
+ *
+ * Every operation has an LSE form (LDADD, LDCLR, LDSET, LDEOR, SWP, CAS)
+ * and an LDXR/STXR fallback. cpufeature_init() patches every site over
+ * to LSE when ID_AA64ISAR0_EL1 has it, so one image runs on ARMv8.0 and
+ * ARMv8.1+ without a test per operation.
+ *
+ * Orderings follow the usual suffixes: _relaxed, _acquire, _release and
+ * no suffix for fully ordered. Fully ordered LL/SC sequences use a
+ * store-release exclusive followed by DMB ISH.
+ *
+ * These work on raw 32-bit and 64-bit words; kernel code should use the
+ * atomic_t / atomic64_t API in atomic.h.
+ */
+
+#ifndef _ARM64_ARCH_ATOMIC_H_
+#define _ARM64_ARCH_ATOMIC_H_
+
+#include <stdint.h>
+#include <cpufeature.h>
+
+/*
+ * Expand gen once per ordering:
+ *   gen(suffix, lse_order, ldxr, stxr, trailing_barrier, ...)
+ */
+#define __ARM64_ATOMIC_ORDERS(gen, ...)                                 \
+    gen(_relaxed, "",   "ldxr",  "stxr",  "",          __VA_ARGS__)     \
+    gen(_acquire, "a",  "ldaxr", "stxr",  "",          __VA_ARGS__)     \
+    gen(_release, "l",  "ldxr",  "stlxr", "",          __VA_ARGS__)     \
+    gen(,         "al", "ldxr",  "stlxr", "dmb ish\n", __VA_ARGS__)
+
+/*
+ * fetch_<op>: returns the old value. lse_arg lets sub and and map onto
+ * LDADD and LDCLR.
+ */
+#define __ARM64_FETCH_OP(sfx, lo, ld, st, mb, bits, T, R, op, lse, llsc, lse_arg) \
+static inline T arch_atomic##bits##_fetch_##op##sfx(T i, volatile T *v) {     \
+    T old, tmp;                                                             \
+    uint32_t fail;                                                          \
+                                                                            \
+    if (cpu_feature_branch(CPU_FEATURE_LSE)) {                              \
+        __asm__ volatile(                                                   \
+            __LSE_PREAMBLE                                                  \
+            "       " lse lo " %" R "2, %" R "0, %1\n"                      \
+            : "=r" (old), "+Q" (*v)                                         \
+            : "r" (lse_arg)                                                 \
+            : "memory");                                                    \
+        return old;                                                         \
+    }                                                                       \
+                                                                            \
+    __asm__ volatile(                                                       \
+        "1:     " ld "  %" R "0, %3\n"                                      \
+        "       " llsc " %" R "1, %" R "0, %" R "4\n"                       \
+        "       " st "  %w2, %" R "1, %3\n"                                 \
+        "       cbnz    %w2, 1b\n"                                          \
+        "       " mb                                                        \
+        : "=&r" (old), "=&r" (tmp), "=&r" (fail), "+Q" (*v)                 \
+        : "r" (i)                                                           \
+        : "memory");                                                        \
+    return old;                                                             \
+}
+
+#define __ARM64_XCHG(sfx, lo, ld, st, mb, bits, T, R)                       \
+static inline T arch_atomic##bits##_xchg##sfx(T i, volatile T *v) {         \
+    T old;                                                                  \
+    uint32_t fail;                                                          \
+                                                                            \
+    if (cpu_feature_branch(CPU_FEATURE_LSE)) {                              \
+        __asm__ volatile(                                                   \
+            __LSE_PREAMBLE                                                  \
+            "       swp" lo " %" R "2, %" R "0, %1\n"                       \
+            : "=r" (old), "+Q" (*v)                                         \
+            : "r" (i)                                                       \
+            : "memory");                                                    \
+        return old;                                                         \
+    }                                                                       \
+                                                                            \
+    __asm__ volatile(                                                       \
+        "1:     " ld "  %" R "0, %2\n"                                      \
+        "       " st "  %w1, %" R "3, %2\n"                                 \
+        "       cbnz    %w1, 1b\n"                                          \
+        "       " mb                                                        \
+        : "=&r" (old), "=&r" (fail), "+Q" (*v)                              \
+        : "r" (i)                                                           \
+        : "memory");                                                        \
+    return old;                                                             \
+}
+
+// cmpxchg: returns the value observed; the swap happened iff it equals old
+#define __ARM64_CMPXCHG(sfx, lo, ld, st, mb, bits, T, R)                    \
+static inline T arch_atomic##bits##_cmpxchg##sfx(volatile T *v, T old, T new) { \
+    T prev;                                                                 \
+    uint32_t fail;                                                          \
+                                                                            \
+    if (cpu_feature_branch(CPU_FEATURE_LSE)) {                              \
+        prev = old;                                                         \
+        __asm__ volatile(                                                   \
+            __LSE_PREAMBLE                                                  \
+            "       cas" lo " %" R "0, %" R "2, %1\n"                       \
+            : "+r" (prev), "+Q" (*v)                                        \
+            : "r" (new)                                                     \
+            : "memory");                                                    \
+        return prev;                                                        \
+    }                                                                       \
+                                                                            \
+    __asm__ volatile(                                                       \
+        "1:     " ld "  %" R "0, %2\n"                                      \
+        "       cmp     %" R "0, %" R "3\n"                                 \
+        "       b.ne    2f\n"                                               \
+        "       " st "  %w1, %" R "4, %2\n"                                 \
+        "       cbnz    %w1, 1b\n"                                          \
+        "       " mb                                                        \
+        "2:\n"                                                              \
+        : "=&r" (prev), "=&r" (fail), "+Q" (*v)                             \
+        : "r" (old), "r" (new)                                              \
+        : "cc", "memory");                                                  \
+    return prev;                                                            \
+}
+
+#define __ARM64_ATOMIC_WIDTH(bits, T, R)                                    \
+    __ARM64_ATOMIC_ORDERS(__ARM64_FETCH_OP, bits, T, R, add, "ldadd", "add", i)  \
+    __ARM64_ATOMIC_ORDERS(__ARM64_FETCH_OP, bits, T, R, sub, "ldadd", "sub", (T)(0 - (uint64_t)i)) \
+    __ARM64_ATOMIC_ORDERS(__ARM64_FETCH_OP, bits, T, R, and, "ldclr", "and", ~i) \
+    __ARM64_ATOMIC_ORDERS(__ARM64_FETCH_OP, bits, T, R, or,  "ldset", "orr", i)  \
+    __ARM64_ATOMIC_ORDERS(__ARM64_FETCH_OP, bits, T, R, xor, "ldeor", "eor", i)  \
+    __ARM64_ATOMIC_ORDERS(__ARM64_XCHG, bits, T, R)                         \
+    __ARM64_ATOMIC_ORDERS(__ARM64_CMPXCHG, bits, T, R)
+
+__ARM64_ATOMIC_WIDTH(32, int32_t, "w")
+__ARM64_ATOMIC_WIDTH(64, int64_t, "x")
+
+#undef __ARM64_ATOMIC_WIDTH
+#undef __ARM64_CMPXCHG
+#undef __ARM64_XCHG
+#undef __ARM64_FETCH_OP
+#undef __ARM64_ATOMIC_ORDERS
+
+#endif /* _ARM64_ARCH_ATOMIC_H_ */
@@ -0,0 +1,16 @@
+/*
+ * arch/arm64/include/arch_bitops.h
+ *
+ * Which bit-count builtins lib/bitops.h may use on ARM64
+ */
+
+#ifndef _ARM64_ARCH_BITOPS_H_
+#define _ARM64_ARCH_BITOPS_H_
+
+// CLZ, and RBIT + CLZ for trailing zeros. Counting set bits needs the
+// vector CNT, which -mgeneral-regs-only rules out.
+#define ARCH_HAS_FAST_CLZ       1
+#define ARCH_HAS_FAST_CTZ       1
+#define ARCH_HAS_FAST_POPCOUNT  0
+
+#endif /* _ARM64_ARCH_BITOPS_H_ */
@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 // Architecture must provide these functions
 void arch_cache_init(void);
@@ -16,6 +17,32 @@ void arch_cache_clean(void *addr, size_t size);
 void arch_cache_invalidate(void *addr, size_t size);
 void arch_cache_flush(void *addr, size_t size);
 
+// The same without the trailing DSB, so a batch of ranges can share one
+// arch_cache_barrier()
+void arch_cache_clean_nosync(void *addr, size_t size);
+void arch_cache_invalidate_nosync(void *addr, size_t size);
+
+static inline void arch_cache_barrier(void) {
+    __asm__ volatile("dsb sy" : : : "memory");
+}
+
+// DC CIVAC and friends work everywhere, so maintenance is always done
+static inline bool arch_cache_coherent(void) {
+    return false;
+}
+
+// VMM_ATTR_NOCACHE maps Normal Non-cacheable (MAIR index 2)
+static inline bool arch_cache_nocache_mappings(void) {
+    return true;
+}
+
+// Zero whole cache blocks with DC ZVA. arch_cache_zero_block_size() is 0
+// before arch_cache_zero_init() and when DCZID_EL0.DZP prohibits DC ZVA;
+// arch_cache_zero() needs addr and size to be multiples of it.
+void arch_cache_zero_init(void);
+size_t arch_cache_zero_block_size(void);
+void arch_cache_zero(void *addr, size_t size);
+
 // Get cache line size from CTR_EL0
 static inline uint64_t arch_cache_get_line_size(void) {
     uint64_t ctr;
@@ -23,4 +50,8 @@ static inline uint64_t arch_cache_get_line_size(void) {
     return 4 << ((ctr >> 16) & 0xF);
 }
 
+// DCZID_EL0: BS is log2 of the DC ZVA block size in words
+#define DCZID_BS_MASK   0xFUL
+#define DCZID_DZP       (1UL << 4)
+
 #endif // _ARM64_ARCH_CACHE_H_
\ No newline at end of file
@@ -56,6 +56,13 @@ static inline void arch_cpu_wait(void) {
     __asm__ volatile("wfe");
 }
 
+// Sleep until an interrupt is pending. Called with IRQs masked: WFI
+// still wakes on a masked interrupt, which the caller takes once it
+// unmasks, so there is no window to lose a wakeup in.
+static inline void arch_cpu_idle(void) {
+    __asm__ volatile("dsb sy\n\twfi" ::: "memory");
+}
+
 // Halt the CPU
 static inline void arch_halt(void) {
     arch_disable_interrupts();
@@ -0,0 +1,49 @@
+/*
+ * arch/arm64/include/arch_cpufeature.h
+ *
+ * ARM64 CPU features and the ID register fields they come from
+ */
+
+#ifndef _ARM64_ARCH_CPUFEATURE_H_
+#define _ARM64_ARCH_CPUFEATURE_H_
+
+#include <stdint.h>
+
+// Bit numbers in cpu_feature_bits; names in cpufeature.c
+enum cpu_feature {
+    CPU_FEATURE_LSE,            // LDADD/CAS/SWP atomics (ARMv8.1)
+    CPU_FEATURE_CRC32,          // CRC32B/H/W/X and CRC32C*
+    CPU_FEATURE_PMULL,          // 64x64 polynomial multiply
+    CPU_FEATURE_TLBI_RANGE,     // TLBI RVAE1IS and friends (ARMv8.4)
+    CPU_FEATURE_DC_ZVA,         // DC ZVA allowed at EL1
+    CPU_FEATURE_LRCPC,          // LDAPR (ARMv8.3)
+    CPU_FEATURE_HW_AF,          // Hardware Access flag updates (ARMv8.1)
+    CPU_FEATURE_COUNT
+};
+
+// 4-bit ID register fields; a higher value includes the lower ones
+#define ID_FIELD(reg, shift)        (((reg) >> (shift)) & 0xFUL)
+
+// ID_AA64ISAR0_EL1
+#define ID_AA64ISAR0_AES_SHIFT      4       // 2 = AES + PMULL
+#define ID_AA64ISAR0_CRC32_SHIFT    16      // 1 = CRC32
+#define ID_AA64ISAR0_ATOMIC_SHIFT   20      // 2 = LSE
+#define ID_AA64ISAR0_TLB_SHIFT      56      // 1 = TLBI OS, 2 = OS + range
+#define ID_AA64ISAR0_AES_PMULL      2
+#define ID_AA64ISAR0_ATOMIC_LSE     2
+#define ID_AA64ISAR0_TLB_RANGE      2
+
+// ID_AA64ISAR1_EL1
+#define ID_AA64ISAR1_LRCPC_SHIFT    20      // 1 = LDAPR
+
+// ID_AA64MMFR1_EL1
+#define ID_AA64MMFR1_HAFDBS_SHIFT   0       // 1 = AF, 2 = AF + dirty state
+
+// Lets the assembler accept LSE instructions in a -march=armv8-a build;
+// they are only executed behind cpu_feature_branch(CPU_FEATURE_LSE)
+#define __LSE_PREAMBLE  ".arch_extension lse\n"
+
+// Likewise for CRC32*, behind cpu_feature_branch(CPU_FEATURE_CRC32)
+#define __CRC32_PREAMBLE    ".arch_extension crc\n"
+
+#endif /* _ARM64_ARCH_CPUFEATURE_H_ */
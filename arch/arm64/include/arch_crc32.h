@@ -0,0 +1,24 @@
+/*
+ * arch/arm64/include/arch_crc32.h
+ *
+ * CRC32 instructions for the CRCs in kernel/lib/checksum.c
+ */
+
+#ifndef _ARM64_ARCH_CRC32_H_
+#define _ARM64_ARCH_CRC32_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <cpufeature.h>
+
+// CRC32X/CRC32CX, optional in ARMv8.0 and patched in at boot
+#define ARCH_HAS_CRC32          1
+#define arch_crc32_usable()     cpu_feature_branch(CPU_FEATURE_CRC32)
+#define ARCH_CRC32_FEATURE      CPU_FEATURE_CRC32
+#define ARCH_CRC32_INSNS        "CRC32X/CRC32CX"
+
+// Fold nwords aligned words into a running (uninverted) CRC
+uint32_t arch_crc32_words(uint32_t crc, const uint64_t *p, size_t nwords);
+uint32_t arch_crc32c_words(uint32_t crc, const uint64_t *p, size_t nwords);
+
+#endif /* _ARM64_ARCH_CRC32_H_ */
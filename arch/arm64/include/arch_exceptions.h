@@ -106,10 +106,37 @@ struct exception_context {
     uint64_t sp;
 };
 
+/*
+ * What the IRQ entry saves: only the registers a C handler may clobber.
+ * x19-x28 survive the handler under AAPCS64, and arch_switch_to() saves
+ * them if the reschedule point switches threads. Offsets are mirrored in
+ * exception_vectors.S.
+ */
+struct irq_frame {
+    uint64_t elr;       // 0
+    uint64_t spsr;      // 8
+    uint64_t x[19];     // 16: x0-x18
+    uint64_t fp;        // 168 (x29)
+    uint64_t lr;        // 176 (x30)
+    uint64_t pad;       // 184: keeps sp 16-byte aligned
+};
+
+/*
+ * Bytes the IRQ entry saves per interrupt. make IRQ_FULL_FRAME=1 builds
+ * the previous entry instead, which saves a struct exception_context and
+ * passes that to irq_handler(); it is kept to compare the two.
+ */
+#define IRQ_FULL_FRAME_SIZE     sizeof(struct exception_context)
+#if CONFIG_IRQ_FULL_FRAME
+#define IRQ_ENTRY_FRAME_SIZE    IRQ_FULL_FRAME_SIZE
+#else
+#define IRQ_ENTRY_FRAME_SIZE    sizeof(struct irq_frame)
+#endif
+
 // Exception handler functions
 void exception_init(void);
 void sync_exception_handler(struct exception_context *ctx);
-void irq_handler(struct exception_context *ctx);
+void irq_handler(struct irq_frame *frame);
 void fiq_handler(struct exception_context *ctx);
 void serror_handler(struct exception_context *ctx);
 
@@ -0,0 +1,60 @@
+/*
+ * arch/arm64/include/arch_fpsimd.h
+ *
+ * Kernel-mode FP/SIMD (NEON) sections
+ *
+ * The kernel is built with -mgeneral-regs-only and CPACR_EL1.FPEN traps
+ * every FP/SIMD instruction, so a stray one stops the machine instead of
+ * silently corrupting registers nobody saves. Code that wants NEON
+ * brackets it with kernel_neon_begin() and kernel_neon_end() and lives
+ * in a file named *_neon.c, which the Makefile builds with SIMD enabled.
+ *
+ * No thread owns FP/SIMD state. A section runs with preemption disabled
+ * and must not sleep, so a context switch never happens inside one and
+ * switching threads never saves or restores vector registers. The only
+ * state ever saved is that of a section interrupted by a handler that
+ * opens its own, and only when the handler actually does so.
+ */
+
+#ifndef _ARM64_ARCH_FPSIMD_H_
+#define _ARM64_ARCH_FPSIMD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// CPACR_EL1.FPEN: 0b00 traps FP/SIMD at EL1 and EL0, 0b11 traps neither
+#define CPACR_EL1_FPEN_SHIFT    20
+#define CPACR_EL1_FPEN_MASK     (3UL << CPACR_EL1_FPEN_SHIFT)
+#define CPACR_EL1_FPEN_TRAP     (0UL << CPACR_EL1_FPEN_SHIFT)
+#define CPACR_EL1_FPEN_ALLOW    (3UL << CPACR_EL1_FPEN_SHIFT)
+
+// A thread's section plus one interrupt handler's
+#define KERNEL_NEON_MAX_DEPTH   2
+
+// V0-V31, then FPSR and FPCR. Offsets mirrored in fpsimd.S.
+struct fpsimd_state {
+    __uint128_t vregs[32];
+    uint32_t fpsr;
+    uint32_t fpcr;
+} __attribute__((aligned(16)));
+
+#define FPSIMD_STATE_FPSR   512
+
+// fpsimd.S; FP/SIMD access must be enabled
+void fpsimd_save_state(struct fpsimd_state *state);
+void fpsimd_load_state(const struct fpsimd_state *state);
+
+// Trap FP/SIMD on this CPU until the first kernel_neon_begin(). Secondary
+// CPUs get the same from their entry code.
+void fpsimd_cpu_init(void);
+
+// False when a section cannot be opened here: before fpsimd_cpu_init()
+// and when sections are already nested KERNEL_NEON_MAX_DEPTH deep
+bool kernel_neon_usable(void);
+
+// Open and close a section. May be called from interrupt handlers; the
+// interrupted section's registers are saved and put back around it.
+void kernel_neon_begin(void);
+void kernel_neon_end(void);
+
+#endif /* _ARM64_ARCH_FPSIMD_H_ */
@@ -59,6 +59,7 @@
 #define ICC_SGI1R_INTID_SHIFT          24
 #define ICC_SGI1R_AFF2_SHIFT           32
 #define ICC_SGI1R_IRM                  (1ULL << 40)  // Interrupt Routing Mode
+#define ICC_SGI1R_RS_SHIFT             44            // Range selector (Aff0 / 16)
 #define ICC_SGI1R_AFF3_SHIFT           48
 
 // Helper macros for system register access
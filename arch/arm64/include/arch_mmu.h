@@ -8,6 +8,11 @@
 #define _ARM64_ARCH_MMU_H_
 
 #include <stdint.h>
+#include <cpufeature.h>
+
+// TLBI ...IS reaches every CPU in the inner shareable domain, so no IPIs
+// are needed to keep their TLBs coherent
+#define ARCH_HAS_BROADCAST_TLBI     1
 
 // ARM64 MMU memory barrier
 static inline void arch_mmu_barrier(void) {
@@ -30,6 +35,64 @@ static inline void arch_mmu_invalidate_page(uint64_t vaddr) {
         : : "r"(vaddr >> 12) : "memory");
 }
 
+/*
+ * TLBI RVAE1IS operand for 4KB pages: (NUM + 1) << (5 * SCALE + 1) pages
+ * from BaseADDR. TG = 1 is the 4KB granule. Written as SYS so a
+ * -march=armv8-a assembler takes it.
+ */
+#define TLBI_RANGE_TG_4K            (1UL << 46)
+#define TLBI_RANGE_SCALE_SHIFT      44
+#define TLBI_RANGE_NUM_SHIFT        39
+#define TLBI_RANGE_PAGES(num, scale) ((uint64_t)((num) + 1) << (5 * (scale) + 1))
+#define TLBI_RANGE_MAX_PAGES        TLBI_RANGE_PAGES(31, 3)
+
+static inline void __tlbi_range(uint64_t va, uint64_t num, uint64_t scale) {
+    uint64_t arg = TLBI_RANGE_TG_4K |
+                   (scale << TLBI_RANGE_SCALE_SHIFT) |
+                   (num << TLBI_RANGE_NUM_SHIFT) |
+                   ((va >> 12) & ((1UL << 37) - 1));
+
+    __asm__ volatile("sys #0, c8, c2, #1, %0" : : "r"(arg) : "memory");    // TLBI RVAE1IS
+}
+
+/*
+ * Invalidate every 4KB page in [start, end) on all CPUs, with one
+ * barrier for the lot. With TLBI range each instruction covers a power
+ * of two run of up to 32 blocks, so a range takes at most one per scale
+ * plus one for an odd page, instead of one per page.
+ */
+static inline void arch_mmu_invalidate_range(uint64_t start, uint64_t end) {
+    uint64_t pages = (end - start) >> 12;
+
+    if (cpu_feature_branch(CPU_FEATURE_TLBI_RANGE) && pages < TLBI_RANGE_MAX_PAGES) {
+        uint64_t va = start;
+
+        for (uint64_t scale = 0; pages; scale++) {
+            uint64_t num;
+
+            if (pages & 1) {
+                __asm__ volatile("tlbi vae1is, %0" : : "r"(va >> 12) : "memory");
+                va += 1UL << 12;
+                pages--;
+            }
+            num = (pages >> (5 * scale + 1)) & 0x1f;
+            if (num) {
+                __tlbi_range(va, num - 1, scale);
+                va += TLBI_RANGE_PAGES(num - 1, scale) << 12;
+                pages -= TLBI_RANGE_PAGES(num - 1, scale);
+            }
+        }
+    } else {
+        for (uint64_t va = start; va < end; va += 1UL << 12) {
+            __asm__ volatile("tlbi vae1is, %0" : : "r"(va >> 12) : "memory");
+        }
+    }
+    __asm__ volatile(
+        "dsb ish\n"
+        "isb\n"
+        : : : "memory");
+}
+
 // Flush entire TLB
 static inline void arch_mmu_flush_all(void) {
     __asm__ volatile(
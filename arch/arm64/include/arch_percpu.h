@@ -0,0 +1,27 @@
+/*
+ * arch/arm64/include/arch_percpu.h
+ *
+ * ARM64 per-CPU base register
+ * TPIDR_EL1 holds the offset of this CPU's per-CPU area from the template
+ */
+
+#ifndef _ARM64_ARCH_PERCPU_H_
+#define _ARM64_ARCH_PERCPU_H_
+
+#include <stdint.h>
+
+// Read this CPU's per-CPU offset
+static inline uintptr_t arch_percpu_offset(void) {
+    uintptr_t off;
+    // Not volatile: the value never changes under a running CPU, so the
+    // compiler may CSE repeated reads
+    __asm__("mrs %0, tpidr_el1" : "=r" (off));
+    return off;
+}
+
+// Set this CPU's per-CPU offset
+static inline void arch_set_percpu_offset(uintptr_t off) {
+    __asm__ volatile("msr tpidr_el1, %0" :: "r" (off) : "memory");
+}
+
+#endif /* _ARM64_ARCH_PERCPU_H_ */
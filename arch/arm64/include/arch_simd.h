@@ -0,0 +1,24 @@
+/*
+ * arch/arm64/include/arch_simd.h
+ *
+ * NEON helpers for the generic bulk routines in kernel/lib/
+ */
+
+#ifndef _ARM64_ARCH_SIMD_H_
+#define _ARM64_ARCH_SIMD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define ARCH_HAS_SIMD_BITMAP    1
+#define ARCH_HAS_SIMD_CSUM      1
+
+// Number of leading words of map known to be all ones: a multiple of the
+// block the vector loop works in, so the caller finishes the scan
+size_t arch_bitmap_skip_full_words(const uint64_t *map, size_t nwords);
+
+// csum_rotxor32() of buf, if it was worth doing with NEON here
+bool arch_csum_rotxor32(const void *buf, size_t len, uint32_t *csum);
+
+#endif /* _ARM64_ARCH_SIMD_H_ */
@@ -0,0 +1,74 @@
+/*
+ * arch/arm64/include/arch_smp.h
+ *
+ * ARM64 secondary CPU bring-up (PSCI) and IPIs (GIC SGIs)
+ */
+
+#ifndef _ARM64_ARCH_SMP_H_
+#define _ARM64_ARCH_SMP_H_
+
+#include <stdint.h>
+
+/*
+ * Handoff block read by secondary_entry in boot.S. The first fields are
+ * read with the MMU off, so the block is cleaned to PoC before CPU_ON.
+ * Offsets are mirrored by the SBD_* constants in boot.S.
+ */
+struct secondary_boot_data {
+    uint64_t ttbr0;             // 0
+    uint64_t ttbr1;             // 8
+    uint64_t tcr;               // 16
+    uint64_t mair;              // 24
+    uint64_t sctlr;             // 32
+    uint64_t stack_top;         // 40
+    uint64_t percpu_offset;     // 48
+    uint64_t cpu;               // 56
+};
+
+// PSCI function IDs (SMC64 calling convention)
+#define PSCI_0_2_FN64_CPU_ON        0xC4000003
+#define PSCI_0_2_FN_PSCI_VERSION    0x84000000
+
+// PSCI return codes
+#define PSCI_RET_SUCCESS            0
+#define PSCI_RET_NOT_SUPPORTED      -1
+#define PSCI_RET_INVALID_PARAMS     -2
+#define PSCI_RET_DENIED             -3
+#define PSCI_RET_ALREADY_ON         -4
+
+// MPIDR affinity fields (Aff3 | Aff2 | Aff1 | Aff0)
+#define MPIDR_HWID_MASK             0xFF00FFFFFFUL
+
+// Hardware ID of the calling CPU
+static inline uint64_t arch_smp_boot_hwid(void) {
+    uint64_t mpidr;
+    __asm__ volatile("mrs %0, mpidr_el1" : "=r" (mpidr));
+    return mpidr & MPIDR_HWID_MASK;
+}
+
+// Idle until another CPU signals an event (or anything else wakes WFE)
+static inline void arch_smp_wait_event(void) {
+    __asm__ volatile("wfe" ::: "memory");
+}
+
+// Wake CPUs idling in arch_smp_wait_event() after publishing work
+static inline void arch_smp_send_event(void) {
+    __asm__ volatile("dsb ishst\n\tsev" ::: "memory");
+}
+
+// Pick up the PSCI conduit from the device tree
+void arch_smp_init(void *fdt);
+
+// Start a secondary CPU at secondary_entry with the given stack
+int arch_smp_boot_cpu(unsigned int cpu, uint64_t hwid, uintptr_t stack_top);
+
+// Claim the IPI SGI on the boot CPU; -1 without a GIC
+int arch_ipi_init(void);
+
+// Bring up the calling secondary's GIC interface and unmask the IPI SGI
+void arch_ipi_init_secondary(void);
+
+// Raise the IPI on a mask of logical CPUs
+void arch_send_ipi_mask(uint64_t mask);
+
+#endif /* _ARM64_ARCH_SMP_H_ */
@@ -1,31 +1,134 @@
 /*
  * arch/arm64/include/arch_spinlock.h
  *
- * Simple spinlock implementation for ARM64
- * Uses compiler built-in atomic operations
+ * ARM64 spinlock implementation
+ *
+ * arch_spinlock_t is a ticket lock: a 16-bit "next" ticket dispenser and a
+ * 16-bit "owner" now-serving counter in one word. Waiters are served in
+ * FIFO order and sleep in WFE on the owner half, which the unlocking
+ * store-release wakes. The ticket grab is an acquire fetch-add, so it is
+ * a single LSE LDADDA when the CPU has it and an LDAXR/STXR loop
+ * otherwise.
+ *
+ * The old test-and-set lock is kept as tas_spinlock_t for comparison
+ * benchmarks. The compare-and-swap helpers back the generic queued
+ * spinlock in qspinlock.h.
  */
 
 #ifndef _ARM64_ARCH_SPINLOCK_H_
 #define _ARM64_ARCH_SPINLOCK_H_
 
 #include <stdint.h>
+#include <arch_atomic.h>
+
+#define TICKET_SHIFT    16
 
 typedef struct {
-    volatile uint32_t lock;
-} spinlock_t;
+    union {
+        volatile uint32_t val;
+        struct {
+            volatile uint16_t owner;    // Ticket being served
+            volatile uint16_t next;     // Next ticket to hand out
+        } tickets;
+    };
+} arch_spinlock_t;
 
-#define SPINLOCK_INITIALIZER    { 0 }
+#define ARCH_SPINLOCK_INITIALIZER    { { 0 } }
 
 // Initialize a spinlock
-static inline void spin_lock_init(spinlock_t *lock) {
-    lock->lock = 0;
+static inline void arch_spin_lock_init(arch_spinlock_t *lock) {
+    lock->val = 0;
+}
+
+/*
+ * Compare-and-swap on a 32-bit word, returning the value observed.
+ * _acquire orders later accesses after a successful swap; the plain
+ * version is fully ordered.
+ */
+static inline uint32_t arch_spin_cmpxchg_acquire(volatile uint32_t *ptr,
+                                                 uint32_t old, uint32_t new) {
+    return arch_atomic32_cmpxchg_acquire((volatile int32_t *)ptr, old, new);
+}
+
+static inline uint32_t arch_spin_cmpxchg(volatile uint32_t *ptr,
+                                         uint32_t old, uint32_t new) {
+    return arch_atomic32_cmpxchg((volatile int32_t *)ptr, old, new);
 }
 
 // Acquire the spinlock
-static inline void spin_lock(spinlock_t *lock) {
+static inline void arch_spin_lock(arch_spinlock_t *lock) {
+    uint32_t tmp, tmp2;
+
+    // Take a ticket: old = lock->val; lock->next++
+    uint32_t old = arch_atomic32_fetch_add_acquire(1 << TICKET_SHIFT,
+                                                   (volatile int32_t *)&lock->val);
+
+    // Wait until our ticket is served; the exclusive load arms the
+    // monitor so the owner's release generates the wake-up event
+    __asm__ volatile(
+        "       eor     %w1, %w0, %w0, ror #16\n"
+        "       cbz     %w1, 3f\n"
+        "       sevl\n"
+        "2:     wfe\n"
+        "       ldaxrh  %w2, %3\n"
+        "       eor     %w1, %w2, %w0, lsr #16\n"
+        "       cbnz    %w1, 2b\n"
+        "3:\n"
+        : "+r" (old), "=&r" (tmp), "=&r" (tmp2)
+        : "Q" (lock->tickets.owner)
+        : "memory");
+}
+
+// Release the spinlock
+static inline void arch_spin_unlock(arch_spinlock_t *lock) {
+    uint16_t owner = lock->tickets.owner + 1;
+
+    __asm__ volatile(
+        "stlrh  %w1, %0\n"              // Store-release of the next owner
+        : "=Q" (lock->tickets.owner)
+        : "r" (owner)
+        : "memory");
+}
+
+// Try to acquire the spinlock without blocking
+static inline int arch_spin_trylock(arch_spinlock_t *lock) {
+    uint32_t old = lock->val;
+
+    // Only free if nobody holds or waits for it
+    if ((old >> TICKET_SHIFT) != (old & 0xFFFF)) {
+        return 0;
+    }
+
+    return arch_spin_cmpxchg_acquire(&lock->val, old,
+                                     old + (1U << TICKET_SHIFT)) == old;
+}
+
+// Check if spinlock is locked
+static inline int arch_spin_is_locked(arch_spinlock_t *lock) {
+    uint32_t val = lock->val;
+    return (val >> TICKET_SHIFT) != (val & 0xFFFF);
+}
+
+// Check if other CPUs are queued behind the holder
+static inline int arch_spin_is_contended(arch_spinlock_t *lock) {
+    uint32_t val = lock->val;
+    return (uint16_t)((val >> TICKET_SHIFT) - (val & 0xFFFF)) > 1;
+}
+
+/*
+ * Legacy test-and-set lock (the previous spinlock_t), kept so lock
+ * benchmarks have a baseline
+ */
+typedef struct {
+    volatile uint32_t lock;
+} tas_spinlock_t;
+
+#define TAS_SPINLOCK_INITIALIZER    { 0 }
+
+static inline void tas_spin_lock(tas_spinlock_t *lock) {
     uint32_t tmp;
     uint32_t newval = 1;
-    
+
     __asm__ volatile(
         "1:     ldaxr   %w0, %1\n"      // Load exclusive with acquire
         "       cbnz    %w0, 2f\n"      // If not zero, spin
@@ -40,8 +143,7 @@ static inline void spin_lock(spinlock_t *lock) {
         : "memory");
 }
 
-// Release the spinlock
-static inline void spin_unlock(spinlock_t *lock) {
+static inline void tas_spin_unlock(tas_spinlock_t *lock) {
     __asm__ volatile(
         "stlr   wzr, %0\n"              // Store-release of zero
         : "=Q" (lock->lock)
@@ -49,26 +151,4 @@ static inline void spin_unlock(spinlock_t *lock) {
         : "memory");
 }
 
-// Try to acquire the spinlock without blocking
-static inline int spin_trylock(spinlock_t *lock) {
-    uint32_t tmp;
-    uint32_t newval = 1;
-    
-    __asm__ volatile(
-        "       ldaxr   %w0, %1\n"      // Load exclusive with acquire
-        "       cbnz    %w0, 1f\n"      // If not zero, fail
-        "       stxr    %w0, %w2, %1\n" // Try to store exclusive
-        "1:\n"
-        : "=&r" (tmp), "+Q" (lock->lock)
-        : "r" (newval)
-        : "memory");
-    
-    return tmp == 0;
-}
-
-// Check if spinlock is locked
-static inline int spin_is_locked(spinlock_t *lock) {
-    return lock->lock != 0;
-}
-
-#endif // _ARM64_ARCH_SPINLOCK_H_
\ No newline at end of file
+#endif // _ARM64_ARCH_SPINLOCK_H_
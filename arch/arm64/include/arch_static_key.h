@@ -0,0 +1,30 @@
+/*
+ * arch/arm64/include/arch_static_key.h
+ *
+ * ARM64 static branch sites: NOP, patched to B
+ */
+
+#ifndef _ARM64_ARCH_STATIC_KEY_H_
+#define _ARM64_ARCH_STATIC_KEY_H_
+
+#include <stdbool.h>
+
+#define ARM64_INSN_NOP      0xd503201fU
+#define ARM64_INSN_B        0x14000000U     // imm26 in words, +-128 MiB
+
+struct static_key;
+
+static inline __attribute__((always_inline)) bool arch_static_branch(struct static_key *key) {
+    __asm__ goto(
+        "1:     nop\n"
+        "       .pushsection .static_keys, \"a\"\n"
+        "       .balign 8\n"
+        "       .quad   1b, %l[l_yes], %c0\n"
+        "       .popsection\n"
+        : : "i"(key) : : l_yes);
+    return false;
+l_yes:
+    return true;
+}
+
+#endif /* _ARM64_ARCH_STATIC_KEY_H_ */
@@ -0,0 +1,25 @@
+/*
+ * arch/arm64/include/arch_string.h
+ *
+ * ARM64 memory and string function overrides
+ */
+
+#ifndef _ARM64_ARCH_STRING_H_
+#define _ARM64_ARCH_STRING_H_
+
+// In arch/arm64/lib/string.S; kernel/lib/string.c leaves these out
+#define ARCH_HAS_MEMCPY     1
+#define ARCH_HAS_MEMMOVE    1
+#define ARCH_HAS_MEMSET     1
+
+#include <stddef.h>
+
+// memcpy hands copies of MEMCPY_NEON_MIN bytes and up to memcpy_large()
+// (arch/arm64/lib/simd.c), which uses NEON when it can and __memcpy(),
+// the general-register copy, when it cannot. Mirrored in string.S.
+#define MEMCPY_NEON_MIN     4096
+
+void *__memcpy(void *dst, const void *src, size_t n);
+void *memcpy_large(void *dst, const void *src, size_t n);
+
+#endif /* _ARM64_ARCH_STRING_H_ */
@@ -0,0 +1,34 @@
+/*
+ * arch/arm64/include/arch_thread.h
+ *
+ * ARM64 kernel thread context
+ */
+
+#ifndef _ARM64_ARCH_THREAD_H_
+#define _ARM64_ARCH_THREAD_H_
+
+#include <stdint.h>
+
+/*
+ * Registers preserved across arch_switch_to(). Everything else is
+ * caller-saved under AAPCS64 and already spilled by the C caller.
+ * Offsets are mirrored in switch.S.
+ */
+struct arch_thread_context {
+    uint64_t x19, x20, x21, x22, x23;   // 0
+    uint64_t x24, x25, x26, x27, x28;   // 40
+    uint64_t fp;                        // 80 (x29)
+    uint64_t lr;                        // 88 (x30)
+    uint64_t sp;                        // 96
+};
+
+// Set up a new thread so the first switch to it "returns" into entry with
+// the previous task as its argument
+static inline void arch_thread_init(struct arch_thread_context *ctx,
+                                    uintptr_t stack_top, uintptr_t entry) {
+    ctx->fp = 0;                // Terminates frame-pointer unwinds
+    ctx->lr = entry;
+    ctx->sp = stack_top & ~15UL;
+}
+
+#endif /* _ARM64_ARCH_THREAD_H_ */
@@ -37,6 +37,10 @@ static inline void arch_timer_clear_interrupt(void) {
     arch_timer_disable();
 }
 
+// Map this CPU's timer interrupt in the root interrupt domain.
+// Returns the virtual IRQ, or IRQ_INVALID if no controller is up yet.
+uint32_t arch_timer_map_irq(void);
+
 static inline void arch_cpu_relax(void) {
     __asm__ volatile("yield");
 }
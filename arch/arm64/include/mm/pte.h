@@ -54,7 +54,8 @@
 
 /* Memory type definitions (MAIR indices) 
  * NOTE: These must match what boot.S sets up in MAIR_EL1!
- * boot.S configures: Index 0 = Normal memory (0x44), Index 1 = Device (0xFF)
+ * boot.S configures: Index 0 = Normal write-back (0xFF), Index 1 = Device nGnRnE
+ * (0x00), Index 2 = Normal non-cacheable (0x44), Index 3 = Device nGnRE (0x04)
  */
 #define MT_NORMAL               0  /* Normal, cacheable - boot.S index 0 */
 #define MT_DEVICE_nGnRnE        1  /* Device, non-gathering, non-reordering, no early ack - boot.S index 1 */
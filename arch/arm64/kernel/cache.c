@@ -9,34 +9,43 @@
 #include <stddef.h>
 
 static uint64_t cache_line_size = 0;
+static size_t cache_zero_block_size = 0;
 
 // Initialize cache subsystem
 void arch_cache_init(void) {
     cache_line_size = arch_cache_get_line_size();
 }
 
-// Clean data cache by address range
-void arch_cache_clean(void *addr, size_t size) {
+// Clean data cache by address range, without waiting for completion
+void arch_cache_clean_nosync(void *addr, size_t size) {
     uint64_t start = (uint64_t)addr & ~(cache_line_size - 1);
     uint64_t end = ((uint64_t)addr + size + cache_line_size - 1) & ~(cache_line_size - 1);
     
     for (uint64_t line = start; line < end; line += cache_line_size) {
         __asm__ volatile("dc cvac, %0" : : "r"(line) : "memory");
     }
-    
-    __asm__ volatile("dsb sy" : : : "memory");
 }
 
-// Invalidate data cache by address range
-void arch_cache_invalidate(void *addr, size_t size) {
+// Invalidate data cache by address range, without waiting for completion
+void arch_cache_invalidate_nosync(void *addr, size_t size) {
     uint64_t start = (uint64_t)addr & ~(cache_line_size - 1);
     uint64_t end = ((uint64_t)addr + size + cache_line_size - 1) & ~(cache_line_size - 1);
     
     for (uint64_t line = start; line < end; line += cache_line_size) {
         __asm__ volatile("dc ivac, %0" : : "r"(line) : "memory");
     }
-    
-    __asm__ volatile("dsb sy" : : : "memory");
+}
+
+// Clean data cache by address range
+void arch_cache_clean(void *addr, size_t size) {
+    arch_cache_clean_nosync(addr, size);
+    arch_cache_barrier();
+}
+
+// Invalidate data cache by address range
+void arch_cache_invalidate(void *addr, size_t size) {
+    arch_cache_invalidate_nosync(addr, size);
+    arch_cache_barrier();
 }
 
 // Clean and invalidate data cache by address range
@@ -48,6 +57,31 @@ void arch_cache_flush(void *addr, size_t size) {
         __asm__ volatile("dc civac, %0" : : "r"(line) : "memory");
     }
     
-    __asm__ volatile("dsb sy" : : : "memory");
+    arch_cache_barrier();
+}
+
+
+void arch_cache_zero_init(void) {
+    uint64_t dczid;
+    __asm__ volatile("mrs %0, dczid_el0" : "=r"(dczid));
+
+    if (dczid & DCZID_DZP) {
+        cache_zero_block_size = 0;
+    } else {
+        cache_zero_block_size = 4UL << (dczid & DCZID_BS_MASK);
+    }
+}
+
+size_t arch_cache_zero_block_size(void) {
+    return cache_zero_block_size;
 }
 
+// Zero by cache block. DC ZVA is a store as far as ordering goes, so
+// nothing more is needed before the memory is handed out.
+void arch_cache_zero(void *addr, size_t size) {
+    uint64_t end = (uint64_t)addr + size;
+
+    for (uint64_t block = (uint64_t)addr; block < end; block += cache_zero_block_size) {
+        __asm__ volatile("dc zva, %0" : : "r"(block) : "memory");
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * arch/arm64/kernel/cpufeature.c
+ *
+ * ARM64 CPU feature detection
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cpufeature.h>
+#include <arch_cache.h>
+
+const char *const cpu_feature_names[CPU_FEATURE_COUNT] = {
+    [CPU_FEATURE_LSE]           = "lse",
+    [CPU_FEATURE_CRC32]         = "crc32",
+    [CPU_FEATURE_PMULL]         = "pmull",
+    [CPU_FEATURE_TLBI_RANGE]    = "tlbi-range",
+    [CPU_FEATURE_DC_ZVA]        = "dczva",
+    [CPU_FEATURE_LRCPC]         = "lrcpc",
+    [CPU_FEATURE_HW_AF]         = "hw-af",
+};
+
+uint64_t arch_cpufeature_detect(void) {
+    uint64_t isar0, isar1, mmfr1, dczid;
+    uint64_t bits = 0;
+
+    __asm__ volatile("mrs %0, id_aa64isar0_el1" : "=r"(isar0));
+    __asm__ volatile("mrs %0, id_aa64isar1_el1" : "=r"(isar1));
+    __asm__ volatile("mrs %0, id_aa64mmfr1_el1" : "=r"(mmfr1));
+    __asm__ volatile("mrs %0, dczid_el0" : "=r"(dczid));
+
+    if (ID_FIELD(isar0, ID_AA64ISAR0_ATOMIC_SHIFT) >= ID_AA64ISAR0_ATOMIC_LSE) {
+        bits |= 1UL << CPU_FEATURE_LSE;
+    }
+    if (ID_FIELD(isar0, ID_AA64ISAR0_CRC32_SHIFT) >= 1) {
+        bits |= 1UL << CPU_FEATURE_CRC32;
+    }
+    if (ID_FIELD(isar0, ID_AA64ISAR0_AES_SHIFT) >= ID_AA64ISAR0_AES_PMULL) {
+        bits |= 1UL << CPU_FEATURE_PMULL;
+    }
+    if (ID_FIELD(isar0, ID_AA64ISAR0_TLB_SHIFT) >= ID_AA64ISAR0_TLB_RANGE) {
+        bits |= 1UL << CPU_FEATURE_TLBI_RANGE;
+    }
+    if (!(dczid & DCZID_DZP)) {
+        bits |= 1UL << CPU_FEATURE_DC_ZVA;
+    }
+    if (ID_FIELD(isar1, ID_AA64ISAR1_LRCPC_SHIFT) >= 1) {
+        bits |= 1UL << CPU_FEATURE_LRCPC;
+    }
+    if (ID_FIELD(mmfr1, ID_AA64MMFR1_HAFDBS_SHIFT) >= 1) {
+        bits |= 1UL << CPU_FEATURE_HW_AF;
+    }
+    return bits;
+}
@@ -10,6 +10,7 @@
 #include <irqchip/arm-gic.h>
 #include <irq/irq.h>
 #include <irq/irq_domain.h>
+#include <rcu.h>
 
 // External assembly function
 extern void install_exception_vectors(void);
@@ -171,6 +172,10 @@ void sync_exception_handler(struct exception_context *ctx) {
             uart_puts("\nSystem call (not implemented)\n");
             break;
             
+        case ESR_EC_FP_ASIMD:
+            uart_puts("\nFP/SIMD instruction outside kernel_neon_begin()/kernel_neon_end()\n");
+            break;
+            
         default:
             uart_puts("\nUnhandled exception type\n");
             break;
@@ -182,12 +187,15 @@ void sync_exception_handler(struct exception_context *ctx) {
     }
 }
 
-// IRQ handler
-void irq_handler(struct exception_context *ctx) {
+// IRQ handler, on this CPU's IRQ stack. The entry code calls
+// sched_irq_exit() once it is back on the interrupted thread's stack.
+void irq_handler(struct irq_frame *frame) {
     uint32_t hwirq;
     uint32_t virq;
     struct irq_desc *desc;
     
+    (void)frame;
+    
     // Check if GIC is initialized
     if (!gic_primary) {
         uart_puts("IRQ: No interrupt controller initialized!\n");
@@ -214,8 +222,10 @@ void irq_handler(struct exception_context *ctx) {
     }
     
     // Get IRQ descriptor
+    rcu_read_lock();
     desc = irq_to_desc(virq);
     if (!desc) {
+        rcu_read_unlock();
         uart_puts("IRQ: No descriptor for virtual IRQ ");
         uart_putdec(virq);
         uart_puts("\n");
@@ -224,7 +234,7 @@ void irq_handler(struct exception_context *ctx) {
     }
     
     // Update statistics
-    desc->count++;
+    atomic64_inc(&desc->count);
     
     // Call handler chain
     if (desc->action && desc->action->handler) {
@@ -241,10 +251,12 @@ void irq_handler(struct exception_context *ctx) {
         uart_puts(" (hwirq ");
         uart_putdec(hwirq);
         uart_puts(")\n");
-        desc->spurious_count++;
+        atomic64_inc(&desc->spurious_count);
     }
+    rcu_read_unlock();
     
-    // Send End Of Interrupt
+    // Send End Of Interrupt, before the entry code's reschedule point so
+    // the GIC is free to deliver to whichever thread runs next
     gic_eoi(hwirq);
 }
 
@@ -0,0 +1,82 @@
+/*
+ * arch/arm64/kernel/fpsimd.c
+ *
+ * Kernel-mode FP/SIMD sections
+ */
+
+#include <arch_fpsimd.h>
+#include <percpu.h>
+#include <preempt.h>
+#include <spinlock.h>
+#include <panic.h>
+
+// Open sections on this CPU: 0 with FP/SIMD trapped, 1 in a thread's or
+// handler's section, 2 in a handler's section that interrupted another
+static DEFINE_PER_CPU(int, neon_depth) = 0;
+
+// Registers of the section interrupted at each depth above the first
+static DEFINE_PER_CPU(struct fpsimd_state, neon_saved[KERNEL_NEON_MAX_DEPTH - 1]);
+
+// Set once the boot CPU has FP/SIMD trapped and its depth is valid
+static bool fpsimd_ready = false;
+
+static inline void fpsimd_set_access(uint64_t fpen) {
+    uint64_t cpacr;
+
+    __asm__ volatile("mrs %0, cpacr_el1" : "=r"(cpacr));
+    cpacr = (cpacr & ~CPACR_EL1_FPEN_MASK) | fpen;
+    __asm__ volatile("msr cpacr_el1, %0\n\tisb" : : "r"(cpacr) : "memory");
+}
+
+void fpsimd_cpu_init(void) {
+    fpsimd_set_access(CPACR_EL1_FPEN_TRAP);
+    fpsimd_ready = true;
+}
+
+bool kernel_neon_usable(void) {
+    return fpsimd_ready && __this_cpu_read(neon_depth) < KERNEL_NEON_MAX_DEPTH;
+}
+
+void kernel_neon_begin(void) {
+    irqflags_t flags;
+    int depth;
+
+    preempt_disable();
+
+    // An interrupt between reading the depth and enabling access or
+    // saving the registers would see a half-opened section
+    flags = arch_local_irq_save();
+    depth = __this_cpu_read(neon_depth);
+    if (depth >= KERNEL_NEON_MAX_DEPTH) {
+        panic("kernel_neon_begin: sections nested too deeply");
+    }
+
+    if (depth == 0) {
+        fpsimd_set_access(CPACR_EL1_FPEN_ALLOW);
+    } else {
+        fpsimd_save_state(this_cpu_ptr(neon_saved[depth - 1]));
+    }
+    __this_cpu_write(neon_depth, depth + 1);
+    arch_local_irq_restore(flags);
+}
+
+void kernel_neon_end(void) {
+    irqflags_t flags;
+    int depth;
+
+    flags = arch_local_irq_save();
+    depth = __this_cpu_read(neon_depth) - 1;
+    if (depth < 0) {
+        panic("kernel_neon_end: no section open");
+    }
+
+    if (depth == 0) {
+        fpsimd_set_access(CPACR_EL1_FPEN_TRAP);
+    } else {
+        fpsimd_load_state(this_cpu_ptr(neon_saved[depth - 1]));
+    }
+    __this_cpu_write(neon_depth, depth);
+    arch_local_irq_restore(flags);
+
+    preempt_enable();
+}
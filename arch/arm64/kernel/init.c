@@ -6,6 +6,9 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <arch_cache.h>
+#include <arch_percpu.h>
+#include <arch_fpsimd.h>
 #include <exceptions/exceptions.h>
 
 // External symbols from linker script
@@ -35,6 +38,17 @@ void init_arm64(void* dtb) {
     // because we have identity mapping for the kernel region
     kernel_phys_base = phys_base_storage;
     
+    // The boot CPU uses the per-CPU template in place (offset 0).
+    // TPIDR_EL1 resets to an UNKNOWN value so it must be set explicitly.
+    arch_set_percpu_offset(0);
+    
+    // Cache line size from CTR_EL0, so cache maintenance works before
+    // cpu_cache_init()
+    arch_cache_init();
+    
+    // FP/SIMD traps unless inside kernel_neon_begin()/kernel_neon_end()
+    fpsimd_cpu_init();
+    
     // Install exception vectors early (before any interrupts can occur)
     // Uses the architecture-agnostic function that handles UART safely
     exception_init();
@@ -0,0 +1,150 @@
+/*
+ * arch/arm64/kernel/smp.c
+ *
+ * ARM64 secondary CPU bring-up via PSCI CPU_ON, and IPIs as GIC SGIs
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch_smp.h>
+#include <arch_cache.h>
+#include <percpu.h>
+#include <smp.h>
+#include <irq/irq.h>
+#include <irq/irq_domain.h>
+#include <irqchip/arm-gic.h>
+#include <drivers/fdt.h>
+#include <memory/vmparam.h>
+#include <string.h>
+#include <uart.h>
+
+// Entry point in boot.S (runs with the MMU off)
+extern char secondary_entry[];
+
+// Handoff block shared with secondary_entry; CPUs are started one at a time
+struct secondary_boot_data secondary_boot_data __attribute__((aligned(64)));
+
+// PSCI conduit: true for HVC, false for SMC
+static bool psci_use_hvc = true;
+
+static int64_t psci_call(uint64_t fn, uint64_t arg0, uint64_t arg1, uint64_t arg2) {
+    register uint64_t x0 __asm__("x0") = fn;
+    register uint64_t x1 __asm__("x1") = arg0;
+    register uint64_t x2 __asm__("x2") = arg1;
+    register uint64_t x3 __asm__("x3") = arg2;
+
+    if (psci_use_hvc) {
+        __asm__ volatile("hvc #0"
+                         : "+r"(x0)
+                         : "r"(x1), "r"(x2), "r"(x3)
+                         : "memory");
+    } else {
+        __asm__ volatile("smc #0"
+                         : "+r"(x0)
+                         : "r"(x1), "r"(x2), "r"(x3)
+                         : "memory");
+    }
+    return (int64_t)x0;
+}
+
+// Read the PSCI method from /psci
+void arch_smp_init(void *fdt) {
+    int node = fdt_path_offset(fdt, "/psci");
+    if (node < 0) {
+        return;
+    }
+
+    const char *method = fdt_getprop(fdt, node, "method", NULL);
+    if (method && strcmp(method, "smc") == 0) {
+        psci_use_hvc = false;
+    }
+}
+
+// Start one secondary CPU
+int arch_smp_boot_cpu(unsigned int cpu, uint64_t hwid, uintptr_t stack_top) {
+    struct secondary_boot_data *bd = &secondary_boot_data;
+    uint64_t val;
+
+    // The secondary enters with exactly our translation regime
+    __asm__ volatile("mrs %0, ttbr0_el1" : "=r" (val));
+    bd->ttbr0 = val;
+    __asm__ volatile("mrs %0, ttbr1_el1" : "=r" (val));
+    bd->ttbr1 = val;
+    __asm__ volatile("mrs %0, tcr_el1" : "=r" (val));
+    bd->tcr = val;
+    __asm__ volatile("mrs %0, mair_el1" : "=r" (val));
+    bd->mair = val;
+    __asm__ volatile("mrs %0, sctlr_el1" : "=r" (val));
+    bd->sctlr = val;
+
+    bd->stack_top = stack_top;
+    bd->percpu_offset = per_cpu_offset(cpu);
+    bd->cpu = cpu;
+
+    // The block is read with the MMU (and so the D-cache) off
+    arch_cache_clean(bd, sizeof(*bd));
+
+    int64_t ret = psci_call(PSCI_0_2_FN64_CPU_ON, hwid,
+                            VIRT_TO_PHYS(secondary_entry),
+                            VIRT_TO_PHYS(bd));
+    if (ret != PSCI_RET_SUCCESS) {
+        uart_puts("PSCI: CPU_ON returned ");
+        uart_puthex((uint64_t)ret);
+        uart_puts("\n");
+        return -1;
+    }
+    return 0;
+}
+
+// SGI carrying every IPI message; the IRQ tests use 15
+#define IPI_SGI     0
+
+static uint32_t ipi_virq;
+
+static void arm64_ipi_handler(void *dev) {
+    (void)dev;
+    smp_ipi_interrupt();
+}
+
+int arch_ipi_init(void) {
+    if (!gic_primary) {
+        return -1;
+    }
+
+    ipi_virq = irq_find_mapping(gic_primary->domain, IPI_SGI);
+    if (ipi_virq == IRQ_INVALID || ipi_virq == 0) {
+        ipi_virq = irq_create_mapping(gic_primary->domain, IPI_SGI);
+    }
+    if (ipi_virq == IRQ_INVALID || ipi_virq == 0) {
+        return -1;
+    }
+
+    // Unmasks the SGI in the boot CPU's banked enable register
+    if (request_irq(ipi_virq, arm64_ipi_handler, 0, "IPI", &ipi_virq) != 0) {
+        return -1;
+    }
+
+    uart_puts("SMP: IPIs on SGI ");
+    uart_putdec(IPI_SGI);
+    uart_puts("\n");
+    return 0;
+}
+
+void arch_ipi_init_secondary(void) {
+    if (gic_secondary_init() != 0) {
+        uart_puts("SMP: no GIC interface on CPU ");
+        uart_putdec(smp_processor_id());
+        uart_puts("\n");
+        return;
+    }
+
+    // SGI priority and enable are banked per CPU
+    gic_set_priority(IPI_SGI, GIC_PRIORITY_DEFAULT);
+    gic_unmask_irq(IPI_SGI);
+}
+
+void arch_send_ipi_mask(uint64_t mask) {
+    // Messages and the data they refer to reach the target before the SGI
+    __asm__ volatile("dsb ishst" ::: "memory");
+    gic_send_sgi(IPI_SGI, (uint32_t)mask);
+}
@@ -0,0 +1,34 @@
+/*
+ * arch/arm64/kernel/static_key.c
+ *
+ * Static branch patching
+ */
+
+#include <static_key.h>
+#include <panic.h>
+
+void arch_static_key_patch(const struct static_key_entry *entry, bool enable) {
+    volatile uint32_t *insn = (volatile uint32_t *)entry->code;
+    int64_t off = (int64_t)(entry->target - entry->code);
+
+    if (!enable) {
+        *insn = ARM64_INSN_NOP;
+    } else {
+        if (off < -(1L << 27) || off >= (1L << 27)) {
+            panic("static key: branch target out of range");
+        }
+        *insn = ARM64_INSN_B | (((uint64_t)off >> 2) & 0x03ffffffU);
+    }
+
+    // Push the new word out to where instruction fetch sees it
+    __asm__ volatile("dc cvau, %0" : : "r"(insn) : "memory");
+}
+
+void arch_static_key_sync(void) {
+    __asm__ volatile(
+        "dsb ish\n"
+        "ic ialluis\n"
+        "dsb ish\n"
+        "isb\n"
+        : : : "memory");
+}
@@ -0,0 +1,82 @@
+/*
+ * arch/arm64/kernel/timer.c
+ *
+ * ARM Generic Timer: clocksource, interrupt wiring and clock event device
+ */
+
+#include <arch_timer.h>
+#include <irq/irq.h>
+#include <irq/irq_domain.h>
+#include <irqchip/arm-gic.h>
+#include <time/clockevents.h>
+#include <time/clocksource.h>
+
+// Non-secure EL1 physical timer: PPI 14, GIC INTID 30
+#define ARCH_TIMER_PHYS_HWIRQ   30
+
+uint32_t arch_timer_map_irq(void) {
+    uint32_t virq;
+
+    if (!gic_primary) {
+        return IRQ_INVALID;
+    }
+
+    virq = irq_find_mapping(gic_primary->domain, ARCH_TIMER_PHYS_HWIRQ);
+    if (virq == IRQ_INVALID || virq == 0) {
+        virq = irq_create_mapping(gic_primary->domain, ARCH_TIMER_PHYS_HWIRQ);
+    }
+    return virq ? virq : IRQ_INVALID;
+}
+
+// The ISB keeps the counter read from being taken early, ahead of the
+// timekeeper loads it is compared against
+static uint64_t arm64_counter_read(struct clocksource *cs) {
+    uint64_t val;
+
+    (void)cs;
+    __asm__ volatile("isb\n\tmrs %0, cntpct_el0" : "=r" (val) : : "memory");
+    return val;
+}
+
+// CNTPCT_EL0 is at least 56 bits wide
+static struct clocksource arm64_clocksource = {
+    .name = "arch_sys_counter",
+    .read = arm64_counter_read,
+    .mask = CLOCKSOURCE_MASK(56),
+};
+
+int arch_clocksource_init(void) {
+    return clocksource_register_hz(&arm64_clocksource, (uint32_t)arch_timer_get_frequency());
+}
+
+static void arm64_timer_set_next_event(struct clock_event_device *dev, uint64_t delta) {
+    (void)dev;
+    arch_timer_set_compare(arch_timer_get_counter() + delta);
+    arch_timer_enable();
+}
+
+static void arm64_timer_shutdown(struct clock_event_device *dev) {
+    (void)dev;
+    arch_timer_disable();
+}
+
+// EL1 physical timer, compared against CNTPCT_EL0
+static struct clock_event_device arm64_clockevent = {
+    .name = "arm,armv8-timer",
+    .set_next_event = arm64_timer_set_next_event,
+    .set_state_shutdown = arm64_timer_shutdown,
+};
+
+int arch_clockevent_init(void) {
+    struct clock_event_device *dev = &arm64_clockevent;
+
+    dev->virq = arch_timer_map_irq();
+    if (dev->virq == IRQ_INVALID) {
+        return -1;
+    }
+
+    uint32_t freq = (uint32_t)arch_timer_get_frequency();
+
+    // At least 1 us out
+    return clockevents_config_and_register(dev, freq, freq / 1000000, UINT64_MAX >> 2);
+}
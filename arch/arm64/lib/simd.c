@@ -0,0 +1,84 @@
+/*
+ * arch/arm64/lib/simd.c
+ *
+ * NEON versions of bulk routines
+ *
+ * Each opens a kernel_neon_begin() section around an inner loop from
+ * simd_neon.c when the work is large enough to pay for it, and leaves
+ * the odd ends, or all of it when NEON is unusable here, to scalar code.
+ */
+
+#include <arch_simd.h>
+#include <arch_string.h>
+#include <arch_fpsimd.h>
+#include "simd_neon.h"
+
+// Below these, opening a section costs more than it saves
+#define BITMAP_NEON_MIN_WORDS   64
+#define CSUM_NEON_MIN           256
+
+void *memcpy_large(void *dst, const void *src, size_t n) {
+    size_t bulk = n & ~(size_t)63;
+
+    if (!kernel_neon_usable()) {
+        return __memcpy(dst, src, n);
+    }
+
+    kernel_neon_begin();
+    __memcpy_neon(dst, src, bulk);
+    kernel_neon_end();
+
+    if (n > bulk) {
+        __memcpy((char *)dst + bulk, (const char *)src + bulk, n - bulk);
+    }
+    return dst;
+}
+
+size_t arch_bitmap_skip_full_words(const uint64_t *map, size_t nwords) {
+    size_t skipped;
+
+    if (nwords < BITMAP_NEON_MIN_WORDS || !kernel_neon_usable()) {
+        return 0;
+    }
+
+    kernel_neon_begin();
+    skipped = __bitmap_skip_full_neon(map, nwords / SIMD_BITMAP_BLOCK);
+    kernel_neon_end();
+    return skipped;
+}
+
+/*
+ * csum_rotxor32() is linear over XOR: each byte ends up rotated left by
+ * its distance from the end of the buffer, mod 32. Cutting the buffer
+ * into 32-byte blocks from the end puts every byte at offset t of its
+ * block at distance 31 - t, so the blocks can be XORed together first
+ * and each of the 32 resulting bytes rotated once.
+ */
+bool arch_csum_rotxor32(const void *buf, size_t len, uint32_t *csum) {
+    const uint8_t *bytes = buf;
+    size_t head = len % SIMD_CSUM_BLOCK;
+    uint8_t acc[SIMD_CSUM_BLOCK];
+    uint32_t sum = 0;
+
+    if (len < CSUM_NEON_MIN || !kernel_neon_usable()) {
+        return false;
+    }
+
+    kernel_neon_begin();
+    __csum_xor_blocks_neon(bytes + head, len / SIMD_CSUM_BLOCK, acc);
+    kernel_neon_end();
+
+    // The first head bytes end a block that starts before buf
+    for (size_t i = 0; i < head; i++) {
+        acc[SIMD_CSUM_BLOCK - head + i] ^= bytes[i];
+    }
+
+    for (unsigned int t = 0; t < SIMD_CSUM_BLOCK; t++) {
+        uint32_t v = acc[t];
+        unsigned int k = SIMD_CSUM_BLOCK - 1 - t;
+
+        sum ^= k ? (v << k) | (v >> (32 - k)) : v;
+    }
+    *csum = sum;
+    return true;
+}
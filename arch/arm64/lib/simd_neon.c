@@ -0,0 +1,64 @@
+/*
+ * arch/arm64/lib/simd_neon.c
+ *
+ * NEON inner loops. Built with the vector registers enabled (see the
+ * Makefile), so every function here must be called inside a
+ * kernel_neon_begin() section; arch/arm64/lib/simd.c does that.
+ *
+ * Written with GCC vector types, which compile to Q-register loads,
+ * stores and bitwise operations. They are declared with byte alignment,
+ * so callers need not align their buffers: unaligned Q accesses are fine
+ * on Normal memory.
+ */
+
+#include "simd_neon.h"
+
+typedef uint8_t u8x16 __attribute__((vector_size(16), aligned(1), may_alias));
+typedef uint64_t u64x2 __attribute__((vector_size(16), aligned(1), may_alias));
+
+void __memcpy_neon(void *dst, const void *src, size_t n) {
+    u8x16 *d = dst;
+    const u8x16 *s = src;
+
+    for (; n; n -= 64, d += 4, s += 4) {
+        u8x16 a = s[0], b = s[1], c = s[2], e = s[3];
+
+        d[0] = a;
+        d[1] = b;
+        d[2] = c;
+        d[3] = e;
+    }
+}
+
+size_t __bitmap_skip_full_neon(const uint64_t *map, size_t nblocks) {
+    size_t i;
+
+    for (i = 0; i < nblocks; i++) {
+        const u64x2 *v = (const u64x2 *)(map + i * SIMD_BITMAP_BLOCK);
+        u64x2 all = v[0] & v[1] & v[2] & v[3];
+
+        if ((all[0] & all[1]) != ~0ULL) {
+            break;
+        }
+    }
+    return i * SIMD_BITMAP_BLOCK;
+}
+
+void __csum_xor_blocks_neon(const void *buf, size_t nblocks, uint8_t acc[SIMD_CSUM_BLOCK]) {
+    const u8x16 *s = buf;
+    u8x16 lo0 = { 0 }, hi0 = { 0 }, lo1 = { 0 }, hi1 = { 0 };
+
+    // Two accumulator pairs keep consecutive XORs independent
+    for (; nblocks >= 2; nblocks -= 2, s += 4) {
+        lo0 ^= s[0];
+        hi0 ^= s[1];
+        lo1 ^= s[2];
+        hi1 ^= s[3];
+    }
+    if (nblocks) {
+        lo0 ^= s[0];
+        hi0 ^= s[1];
+    }
+    *(u8x16 *)acc = lo0 ^ lo1;
+    *(u8x16 *)(acc + 16) = hi0 ^ hi1;
+}
@@ -0,0 +1,26 @@
+/*
+ * arch/arm64/lib/simd_neon.h
+ *
+ * NEON inner loops in simd_neon.c, for simd.c only
+ */
+
+#ifndef _ARM64_SIMD_NEON_H_
+#define _ARM64_SIMD_NEON_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Words per iteration of the bitmap scan, bytes per checksum block
+#define SIMD_BITMAP_BLOCK   8
+#define SIMD_CSUM_BLOCK     32
+
+// Copy n bytes, a multiple of 64
+void __memcpy_neon(void *dst, const void *src, size_t n);
+
+// Words in the leading run of all-ones blocks of SIMD_BITMAP_BLOCK words
+size_t __bitmap_skip_full_neon(const uint64_t *map, size_t nblocks);
+
+// XOR of nblocks consecutive SIMD_CSUM_BLOCK-byte blocks
+void __csum_xor_blocks_neon(const void *buf, size_t nblocks, uint8_t acc[SIMD_CSUM_BLOCK]);
+
+#endif /* _ARM64_SIMD_NEON_H_ */
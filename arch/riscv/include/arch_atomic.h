@@ -0,0 +1,91 @@
+/*
+ * arch/riscv/include/arch_atomic.h
+ *
+ * RISC-V atomic read-modify-write primitives
+ *
+ * Fetch-ops and exchange map directly onto A-extension AMOs, with the
+ * .aq/.rl bits giving the _acquire/_release/fully ordered variants.
+ * Compare-and-swap is an LR/SC loop.
+ *
+ * These work on raw 32-bit and 64-bit words; kernel code should use the
+ * atomic_t / atomic64_t API in atomic.h.
+ */
+
+#ifndef _ARCH_ATOMIC_H_
+#define _ARCH_ATOMIC_H_
+
+#include <stdint.h>
+
+/*
+ * Expand gen once per ordering:
+ *   gen(suffix, amo_order, lr_order, sc_order, trailing_fence, ...)
+ */
+#define __RISCV_ATOMIC_ORDERS(gen, ...)                                     \
+    gen(_relaxed, "",      "",    "",    "",                 __VA_ARGS__)   \
+    gen(_acquire, ".aq",   ".aq", "",    "",                 __VA_ARGS__)   \
+    gen(_release, ".rl",   "",    ".rl", "",                 __VA_ARGS__)   \
+    gen(,         ".aqrl", "",    ".rl", "fence rw, rw\n",   __VA_ARGS__)
+
+// fetch_<op>: returns the old value; sub is an amoadd of the negation
+#define __RISCV_FETCH_OP(sfx, ao, lo, so, fence, bits, sz, T, op, amo, arg)    \
+static inline T arch_atomic##bits##_fetch_##op##sfx(T i, volatile T *v) {      \
+    T old;                                                                  \
+    __asm__ volatile(                                                       \
+        amo "." sz ao " %0, %2, %1\n"                                       \
+        : "=r" (old), "+A" (*v)                                             \
+        : "r" (arg)                                                         \
+        : "memory");                                                        \
+    return old;                                                             \
+}
+
+#define __RISCV_XCHG(sfx, ao, lo, so, fence, bits, sz, T)                   \
+static inline T arch_atomic##bits##_xchg##sfx(T i, volatile T *v) {         \
+    T old;                                                                  \
+    __asm__ volatile(                                                       \
+        "amoswap." sz ao " %0, %2, %1\n"                                    \
+        : "=r" (old), "+A" (*v)                                             \
+        : "r" (i)                                                           \
+        : "memory");                                                        \
+    return old;                                                             \
+}
+
+/*
+ * cmpxchg: returns the value observed; the swap happened iff it equals
+ * old. lr.w sign-extends, hence the comparison against (long)old.
+ */
+#define __RISCV_CMPXCHG(sfx, ao, lo, so, fence, bits, sz, T)                \
+static inline T arch_atomic##bits##_cmpxchg##sfx(volatile T *v, T old, T new) { \
+    T prev;                                                                 \
+    unsigned long tmp;                                                      \
+    __asm__ volatile(                                                       \
+        "0:     lr." sz lo " %0, %2\n"                                      \
+        "       bne     %0, %z3, 1f\n"                                      \
+        "       sc." sz so " %1, %z4, %2\n"                                 \
+        "       bnez    %1, 0b\n"                                           \
+        "       " fence                                                     \
+        "1:\n"                                                              \
+        : "=&r" (prev), "=&r" (tmp), "+A" (*v)                              \
+        : "rJ" ((long)old), "rJ" (new)                                      \
+        : "memory");                                                        \
+    return prev;                                                            \
+}
+
+#define __RISCV_ATOMIC_WIDTH(bits, sz, T)                                   \
+    __RISCV_ATOMIC_ORDERS(__RISCV_FETCH_OP, bits, sz, T, add, "amoadd", i)  \
+    __RISCV_ATOMIC_ORDERS(__RISCV_FETCH_OP, bits, sz, T, sub, "amoadd", (T)(0 - (uint64_t)i)) \
+    __RISCV_ATOMIC_ORDERS(__RISCV_FETCH_OP, bits, sz, T, and, "amoand", i)  \
+    __RISCV_ATOMIC_ORDERS(__RISCV_FETCH_OP, bits, sz, T, or,  "amoor",  i)  \
+    __RISCV_ATOMIC_ORDERS(__RISCV_FETCH_OP, bits, sz, T, xor, "amoxor", i)  \
+    __RISCV_ATOMIC_ORDERS(__RISCV_XCHG, bits, sz, T)                        \
+    __RISCV_ATOMIC_ORDERS(__RISCV_CMPXCHG, bits, sz, T)
+
+__RISCV_ATOMIC_WIDTH(32, "w", int32_t)
+__RISCV_ATOMIC_WIDTH(64, "d", int64_t)
+
+#undef __RISCV_ATOMIC_WIDTH
+#undef __RISCV_CMPXCHG
+#undef __RISCV_XCHG
+#undef __RISCV_FETCH_OP
+#undef __RISCV_ATOMIC_ORDERS
+
+#endif /* _ARCH_ATOMIC_H_ */
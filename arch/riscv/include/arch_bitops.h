@@ -0,0 +1,22 @@
+/*
+ * arch/riscv/include/arch_bitops.h
+ *
+ * Which bit-count builtins lib/bitops.h may use on RISC-V
+ */
+
+#ifndef _ARCH_BITOPS_H_
+#define _ARCH_BITOPS_H_
+
+// Zbb clz/ctz/cpop, when the whole kernel is built for it (RISCV_ZBB=1).
+// Without it GCC would call libgcc for all three.
+#ifdef __riscv_zbb
+#define ARCH_HAS_FAST_CLZ       1
+#define ARCH_HAS_FAST_CTZ       1
+#define ARCH_HAS_FAST_POPCOUNT  1
+#else
+#define ARCH_HAS_FAST_CLZ       0
+#define ARCH_HAS_FAST_CTZ       0
+#define ARCH_HAS_FAST_POPCOUNT  0
+#endif
+
+#endif /* _ARCH_BITOPS_H_ */
@@ -1,7 +1,7 @@
 /*
  * arch/riscv/include/arch_cache.h
  * 
- * RISC-V cache operations (stub for initial testing)
+ * RISC-V cache operations
  */
 
 #ifndef _ARCH_CACHE_H_
@@ -9,12 +9,33 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
-// RISC-V cache operations
+// RISC-V cache operations, with Zicbom. arch_cache_init() reads the block
+// size from the device tree, so must run after fdt_mgr_init() and
+// cpufeature_init(). The range operations are no-ops while
+// arch_cache_coherent() is true.
 void arch_cache_init(void);
 void arch_cache_clean(void *addr, size_t size);
 void arch_cache_invalidate(void *addr, size_t size);
 void arch_cache_flush(void *addr, size_t size);
 uint64_t arch_cache_get_line_size(void);
+bool arch_cache_coherent(void);
+
+// The same without the trailing fence, so a batch of ranges can share one
+// arch_cache_barrier()
+void arch_cache_clean_nosync(void *addr, size_t size);
+void arch_cache_invalidate_nosync(void *addr, size_t size);
+void arch_cache_barrier(void);
+
+// Whether VMM_ATTR_NOCACHE really gives an uncached mapping (Svpbmt)
+bool arch_cache_nocache_mappings(void);
+
+// Zero whole cache blocks with Zicboz cbo.zero. arch_cache_zero_block_size()
+// is 0 before arch_cache_zero_init() and when the hart lacks Zicboz;
+// arch_cache_zero() needs addr and size to be multiples of it.
+void arch_cache_zero_init(void);
+size_t arch_cache_zero_block_size(void);
+void arch_cache_zero(void *addr, size_t size);
 
 #endif /* _ARCH_CACHE_H_ */
\ No newline at end of file
@@ -23,17 +23,17 @@ static inline void arch_disable_interrupts(void) {
 static inline uint64_t arch_save_interrupts(void) {
     uint64_t sstatus;
     __asm__ volatile(
-        "csrr %0, sstatus\n"
-        "csrci sstatus, 2"  // Clear SIE bit
+        "csrrci %0, sstatus, 2"  // Read sstatus and clear SIE atomically
         : "=r"(sstatus)
         :: "memory"
     );
     return sstatus;
 }
 
-// Restore interrupt state
+// Restore interrupt state. Only SIE is put back: the rest of sstatus
+// (SUM, FS, ...) may legitimately have changed in between.
 static inline void arch_restore_interrupts(uint64_t flags) {
-    __asm__ volatile("csrw sstatus, %0" :: "r"(flags) : "memory");
+    __asm__ volatile("csrs sstatus, %0" :: "r"(flags & 2) : "memory");
 }
 
 // Check if interrupts are enabled
@@ -56,4 +56,11 @@ static inline void arch_cpu_wait(void) {
     __asm__ volatile("wfi");
 }
 
+// Sleep until an interrupt is pending. Called with SIE clear: WFI still
+// wakes on an enabled (sie) interrupt, which the caller takes once it
+// sets SIE again, so there is no window to lose a wakeup in.
+static inline void arch_cpu_idle(void) {
+    __asm__ volatile("wfi" ::: "memory");
+}
+
 #endif /* _ARCH_CPU_H_ */
\ No newline at end of file
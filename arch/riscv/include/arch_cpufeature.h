@@ -0,0 +1,26 @@
+/*
+ * arch/riscv/include/arch_cpufeature.h
+ *
+ * RISC-V ISA extensions the kernel looks for
+ */
+
+#ifndef _ARCH_CPUFEATURE_H_
+#define _ARCH_CPUFEATURE_H_
+
+// Bit numbers in cpu_feature_bits; names in cpufeature.c are the
+// lower-case extension names as the device tree spells them
+enum cpu_feature {
+    CPU_FEATURE_ZBA,            // Address generation (sh1add...)
+    CPU_FEATURE_ZBB,            // Basic bit manipulation (clz, ctz, orc.b, rev8)
+    CPU_FEATURE_ZBC,            // Carry-less multiply
+    CPU_FEATURE_ZBS,            // Single-bit instructions
+    CPU_FEATURE_ZICBOM,         // Cache block management
+    CPU_FEATURE_ZICBOZ,         // Cache block zero
+    CPU_FEATURE_SVINVAL,        // Split TLB invalidation
+    CPU_FEATURE_SVPBMT,         // Page-based memory types
+    CPU_FEATURE_SSTC,           // Supervisor timer compare (stimecmp)
+    CPU_FEATURE_V,              // Vector 1.0
+    CPU_FEATURE_COUNT
+};
+
+#endif /* _ARCH_CPUFEATURE_H_ */
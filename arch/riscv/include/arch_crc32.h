@@ -0,0 +1,24 @@
+/*
+ * arch/riscv/include/arch_crc32.h
+ *
+ * Zbc carry-less multiply for the CRCs in kernel/lib/checksum.c
+ */
+
+#ifndef _ARCH_CRC32_H_
+#define _ARCH_CRC32_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <cpufeature.h>
+
+// clmul/clmulr, patched in at boot when the ISA string lists Zbc
+#define ARCH_HAS_CRC32          1
+#define arch_crc32_usable()     cpu_feature_branch(CPU_FEATURE_ZBC)
+#define ARCH_CRC32_FEATURE      CPU_FEATURE_ZBC
+#define ARCH_CRC32_INSNS        "Zbc clmul"
+
+// Fold nwords aligned words into a running (uninverted) CRC
+uint32_t arch_crc32_words(uint32_t crc, const uint64_t *p, size_t nwords);
+uint32_t arch_crc32c_words(uint32_t crc, const uint64_t *p, size_t nwords);
+
+#endif /* _ARCH_CRC32_H_ */
@@ -24,6 +24,27 @@ typedef struct {
     uint64_t sstatus; // Status register
 } arch_context_t;
 
+// What the interrupt entry in trap.S saves: the caller-saved registers
+// and the return state. Offsets are mirrored there.
+struct irq_frame {
+    uint64_t ra;                        // 0
+    uint64_t t0, t1, t2;                // 8
+    uint64_t a0, a1, a2, a3, a4, a5, a6, a7;    // 32
+    uint64_t t3, t4, t5, t6;            // 96
+    uint64_t sepc;                      // 128
+    uint64_t sstatus;                   // 136: SPP/SPIE, the reschedule point may switch threads
+};
+
+// Bytes the interrupt entry saves. make IRQ_FULL_FRAME=1 builds the
+// previous entry instead, which saves an arch_context_t and passes that
+// to riscv_irq_handler(); it is kept to compare the two.
+#define IRQ_FULL_FRAME_SIZE     sizeof(arch_context_t)
+#if CONFIG_IRQ_FULL_FRAME
+#define IRQ_ENTRY_FRAME_SIZE    IRQ_FULL_FRAME_SIZE
+#else
+#define IRQ_ENTRY_FRAME_SIZE    sizeof(struct irq_frame)
+#endif
+
 void arch_install_exception_handlers(void);
 int arch_get_exception_level(void);
 
@@ -0,0 +1,25 @@
+/*
+ * arch/riscv/include/arch_isa.h
+ *
+ * ISA extensions and per-hart properties advertised by the device tree
+ */
+
+#ifndef _ARCH_ISA_H_
+#define _ARCH_ISA_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * True if the boot hart's /cpus node lists the extension, given by its
+ * lower-case name ("sstc", "zicbom", "v"). Looks at riscv,isa-extensions
+ * first and falls back to parsing the riscv,isa string. Reads the device
+ * tree on every call: for use during init.
+ */
+bool riscv_isa_extension_available(const char *name);
+
+// A single-cell property of the boot hart's /cpus node, such as
+// "riscv,cboz-block-size". False if the node or property is missing.
+bool riscv_cpu_prop_u32(const char *prop, uint32_t *val);
+
+#endif /* _ARCH_ISA_H_ */
@@ -8,6 +8,11 @@
 #define _ARCH_MMU_H_
 
 #include <stdint.h>
+#include <cpufeature.h>
+
+// sfence.vma only reaches the local hart: other harts are asked by IPI
+// or through SBI RFENCE
+#define ARCH_HAS_BROADCAST_TLBI     0
 
 // RISC-V MMU operations
 static inline void arch_mmu_barrier(void) {
@@ -24,6 +29,29 @@ static inline void arch_mmu_invalidate_page(uint64_t vaddr) {
     __asm__ volatile("sfence.vma %0, zero" : : "r"(vaddr) : "memory");
 }
 
+/*
+ * Invalidate every 4KB page in [start, end) on this hart. With Svinval
+ * the ordering against earlier page table stores is paid once by
+ * sfence.w.inval and once by sfence.inval.ir around the lot, not by
+ * every page's sfence.vma. Spelled with .insn so the assembler needs no
+ * Svinval.
+ */
+static inline void arch_mmu_invalidate_range(uint64_t start, uint64_t end) {
+    if (cpu_feature_branch(CPU_FEATURE_SVINVAL)) {
+        __asm__ volatile(".insn r 0x73, 0, 0x0c, x0, x0, x0" ::: "memory");   // sfence.w.inval
+        for (uint64_t va = start; va < end; va += 1UL << 12) {
+            // sinval.vma va, zero
+            __asm__ volatile(".insn r 0x73, 0, 0x0b, x0, %0, x0" : : "r"(va) : "memory");
+        }
+        __asm__ volatile(".insn r 0x73, 0, 0x0c, x0, x0, x1" ::: "memory");   // sfence.inval.ir
+        return;
+    }
+
+    for (uint64_t va = start; va < end; va += 1UL << 12) {
+        __asm__ volatile("sfence.vma %0, zero" : : "r"(va) : "memory");
+    }
+}
+
 static inline void arch_mmu_flush_all(void) {
     __asm__ volatile("sfence.vma zero, zero" ::: "memory");
 }
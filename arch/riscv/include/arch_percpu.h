@@ -0,0 +1,31 @@
+/*
+ * arch/riscv/include/arch_percpu.h
+ *
+ * RISC-V per-CPU base register
+ * tp holds the offset of this CPU's per-CPU area from the template.
+ * The kernel is built without TLS so the compiler never touches tp;
+ * sscratch keeps a copy for trap code that needs to recover it.
+ */
+
+#ifndef _ARCH_PERCPU_H_
+#define _ARCH_PERCPU_H_
+
+#include <stdint.h>
+
+// Read this CPU's per-CPU offset
+static inline uintptr_t arch_percpu_offset(void) {
+    uintptr_t off;
+    __asm__("mv %0, tp" : "=r" (off));
+    return off;
+}
+
+// Set this CPU's per-CPU offset
+static inline void arch_set_percpu_offset(uintptr_t off) {
+    __asm__ volatile(
+        "mv tp, %0\n"
+        "csrw sscratch, %0"
+        :: "r" (off) : "memory"
+    );
+}
+
+#endif /* _ARCH_PERCPU_H_ */
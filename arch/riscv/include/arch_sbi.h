@@ -0,0 +1,75 @@
+/*
+ * arch/riscv/include/arch_sbi.h
+ *
+ * RISC-V Supervisor Binary Interface calls
+ */
+
+#ifndef _ARCH_SBI_H_
+#define _ARCH_SBI_H_
+
+#include <stdint.h>
+
+// SBI extension IDs
+#define SBI_EXT_BASE        0x10
+#define SBI_EXT_TIME        0x54494D45
+#define SBI_EXT_IPI         0x735049
+#define SBI_EXT_RFENCE      0x52464E43
+#define SBI_EXT_HSM         0x48534D
+
+// HSM function IDs
+#define SBI_HSM_HART_START          0
+#define SBI_HSM_HART_STOP           1
+#define SBI_HSM_HART_GET_STATUS     2
+
+// IPI function IDs
+#define SBI_IPI_SEND_IPI            0
+
+// RFENCE function IDs
+#define SBI_RFENCE_REMOTE_FENCE_I       0
+#define SBI_RFENCE_REMOTE_SFENCE_VMA    1
+
+// BASE function IDs
+#define SBI_BASE_PROBE_EXTENSION    3
+
+// SBI error codes
+#define SBI_SUCCESS                 0
+#define SBI_ERR_FAILED              -1
+#define SBI_ERR_NOT_SUPPORTED       -2
+#define SBI_ERR_INVALID_PARAM       -3
+#define SBI_ERR_DENIED              -4
+#define SBI_ERR_INVALID_ADDRESS     -5
+#define SBI_ERR_ALREADY_AVAILABLE   -6
+
+struct sbiret {
+    long error;
+    long value;
+};
+
+// Generic SBI call (a0-a5 arguments, a6 function ID, a7 extension ID)
+static inline struct sbiret sbi_ecall(unsigned long ext, unsigned long fid,
+                                      unsigned long arg0, unsigned long arg1,
+                                      unsigned long arg2, unsigned long arg3) {
+    register unsigned long a0 __asm__("a0") = arg0;
+    register unsigned long a1 __asm__("a1") = arg1;
+    register unsigned long a2 __asm__("a2") = arg2;
+    register unsigned long a3 __asm__("a3") = arg3;
+    register unsigned long a6 __asm__("a6") = fid;
+    register unsigned long a7 __asm__("a7") = ext;
+    __asm__ volatile(
+        "ecall"
+        : "+r"(a0), "+r"(a1)
+        : "r"(a2), "r"(a3), "r"(a6), "r"(a7)
+        : "memory"
+    );
+    struct sbiret ret = { .error = (long)a0, .value = (long)a1 };
+    return ret;
+}
+
+// Check whether the SBI implementation provides an extension
+static inline int sbi_probe_extension(unsigned long ext) {
+    struct sbiret ret = sbi_ecall(SBI_EXT_BASE, SBI_BASE_PROBE_EXTENSION,
+                                  ext, 0, 0, 0);
+    return ret.error == SBI_SUCCESS && ret.value != 0;
+}
+
+#endif /* _ARCH_SBI_H_ */
@@ -0,0 +1,14 @@
+/*
+ * arch/riscv/include/arch_simd.h
+ *
+ * Vector helpers for the generic bulk routines in kernel/lib/
+ */
+
+#ifndef _ARCH_SIMD_H_
+#define _ARCH_SIMD_H_
+
+// Only the string routines use the V extension so far (arch_vector.h)
+#define ARCH_HAS_SIMD_BITMAP    0
+#define ARCH_HAS_SIMD_CSUM      0
+
+#endif /* _ARCH_SIMD_H_ */
@@ -0,0 +1,59 @@
+/*
+ * arch/riscv/include/arch_smp.h
+ *
+ * RISC-V secondary hart bring-up (SBI HSM) and IPIs (SBI IPI, RFENCE)
+ */
+
+#ifndef _ARCH_SMP_H_
+#define _ARCH_SMP_H_
+
+#include <stdint.h>
+
+/*
+ * Handoff block read by secondary_entry in boot.S. satp is read with
+ * translation off; offsets are mirrored by the SBD_* constants in boot.S.
+ */
+struct secondary_boot_data {
+    uint64_t satp;              // 0
+    uint64_t stack_top;         // 8
+    uint64_t percpu_offset;     // 16
+    uint64_t cpu;               // 24
+};
+
+// Hart ID the kernel was entered on, saved by init_riscv()
+extern uint64_t boot_hart_id;
+
+static inline uint64_t arch_smp_boot_hwid(void) {
+    return boot_hart_id;
+}
+
+// Nothing to discover: SBI HSM is the only start method
+static inline void arch_smp_init(void *fdt) {
+    (void)fdt;
+}
+
+// No event mechanism besides IPIs: without them idle harts simply poll
+static inline void arch_smp_wait_event(void) {
+    __asm__ volatile("nop" ::: "memory");
+}
+
+static inline void arch_smp_send_event(void) {
+}
+
+// Start a secondary hart at secondary_entry with the given stack
+int arch_smp_boot_cpu(unsigned int cpu, uint64_t hwid, uintptr_t stack_top);
+
+// Claim the supervisor software interrupt; -1 if SBI has no IPI extension
+int arch_ipi_init(void);
+
+// Enable the supervisor software interrupt on the calling hart
+void arch_ipi_init_secondary(void);
+
+// Raise the IPI on a mask of logical CPUs
+void arch_send_ipi_mask(uint64_t mask);
+
+// sfence.vma of [start, end) on a mask of logical CPUs through SBI
+// RFENCE, which returns once they are done; -1 without the extension
+int arch_flush_tlb_remote(uint64_t mask, uintptr_t start, uintptr_t end);
+
+#endif /* _ARCH_SMP_H_ */
@@ -1,40 +1,123 @@
 /*
  * arch/riscv/include/arch_spinlock.h
- * 
+ *
  * RISC-V spinlock operations
+ *
+ * arch_spinlock_t is a ticket lock: a 16-bit "next" ticket dispenser and a
+ * 16-bit "owner" now-serving counter in one word. A ticket is taken with
+ * a single amoadd.w.aq; waiters spin reading the owner half, which only
+ * the lock holder writes, so there is no AMO traffic while waiting.
+ *
+ * The old test-and-set lock is kept as tas_spinlock_t for comparison
+ * benchmarks. The compare-and-swap helpers back the generic queued
+ * spinlock in qspinlock.h.
  */
 
 #ifndef _ARCH_SPINLOCK_H_
 #define _ARCH_SPINLOCK_H_
 
 #include <stdint.h>
+#include <arch_atomic.h>
+
+#define TICKET_SHIFT    16
 
 typedef struct {
-    volatile uint32_t lock;
-} spinlock_t;
+    union {
+        volatile uint32_t val;
+        struct {
+            volatile uint16_t owner;    // Ticket being served
+            volatile uint16_t next;     // Next ticket to hand out
+        } tickets;
+    };
+} arch_spinlock_t;
 
-#define SPINLOCK_INITIALIZER { 0 }
+#define ARCH_SPINLOCK_INITIALIZER { { 0 } }
 
-static inline void spin_lock_init(spinlock_t *lock) {
-    lock->lock = 0;
+static inline void arch_spin_lock_init(arch_spinlock_t *lock) {
+    lock->val = 0;
 }
 
-static inline void spin_lock(spinlock_t *lock) {
-    while (__sync_lock_test_and_set(&lock->lock, 1)) {
-        __asm__ volatile("nop" ::: "memory");
+/*
+ * Compare-and-swap on a 32-bit word, returning the value observed.
+ * _acquire orders later accesses after a successful swap; the plain
+ * version is fully ordered.
+ */
+static inline uint32_t arch_spin_cmpxchg_acquire(volatile uint32_t *ptr,
+                                                 uint32_t old, uint32_t new) {
+    return arch_atomic32_cmpxchg_acquire((volatile int32_t *)ptr, old, new);
+}
+
+static inline uint32_t arch_spin_cmpxchg(volatile uint32_t *ptr,
+                                         uint32_t old, uint32_t new) {
+    return arch_atomic32_cmpxchg((volatile int32_t *)ptr, old, new);
+}
+
+static inline void arch_spin_lock(arch_spinlock_t *lock) {
+    // Take a ticket: old = lock->val; lock->next++
+    uint32_t old = arch_atomic32_fetch_add_acquire(1 << TICKET_SHIFT,
+                                                   (volatile int32_t *)&lock->val);
+
+    uint16_t ticket = old >> TICKET_SHIFT;
+    if ((uint16_t)old == ticket) {
+        return;
+    }
+
+    while (lock->tickets.owner != ticket) {
+        __asm__ volatile("nop");
     }
+    // Order the critical section after observing our turn
+    __asm__ volatile("fence r, rw" ::: "memory");
 }
 
-static inline void spin_unlock(spinlock_t *lock) {
-    __sync_lock_release(&lock->lock);
+static inline void arch_spin_unlock(arch_spinlock_t *lock) {
+    uint16_t owner = lock->tickets.owner + 1;
+
+    // Release: critical section before handing over
+    __asm__ volatile("fence rw, w" ::: "memory");
+    lock->tickets.owner = owner;
+}
+
+static inline int arch_spin_trylock(arch_spinlock_t *lock) {
+    uint32_t old = lock->val;
+
+    // Only free if nobody holds or waits for it
+    if ((old >> TICKET_SHIFT) != (old & 0xFFFF)) {
+        return 0;
+    }
+
+    return arch_spin_cmpxchg_acquire(&lock->val, old,
+                                     old + (1U << TICKET_SHIFT)) == old;
+}
+
+static inline int arch_spin_is_locked(arch_spinlock_t *lock) {
+    uint32_t val = lock->val;
+    return (val >> TICKET_SHIFT) != (val & 0xFFFF);
 }
 
-static inline int spin_trylock(spinlock_t *lock) {
-    return !__sync_lock_test_and_set(&lock->lock, 1);
+// Check if other harts are queued behind the holder
+static inline int arch_spin_is_contended(arch_spinlock_t *lock) {
+    uint32_t val = lock->val;
+    return (uint16_t)((val >> TICKET_SHIFT) - (val & 0xFFFF)) > 1;
 }
 
-static inline int spin_is_locked(spinlock_t *lock) {
-    return lock->lock != 0;
+/*
+ * Legacy test-and-set lock (the previous spinlock_t), kept so lock
+ * benchmarks have a baseline
+ */
+typedef struct {
+    volatile uint32_t lock;
+} tas_spinlock_t;
+
+#define TAS_SPINLOCK_INITIALIZER { 0 }
+
+static inline void tas_spin_lock(tas_spinlock_t *lock) {
+    while (__sync_lock_test_and_set(&lock->lock, 1)) {
+        __asm__ volatile("nop" ::: "memory");
+    }
+}
+
+static inline void tas_spin_unlock(tas_spinlock_t *lock) {
+    __sync_lock_release(&lock->lock);
 }
 
-#endif /* _ARCH_SPINLOCK_H_ */
\ No newline at end of file
+#endif /* _ARCH_SPINLOCK_H_ */
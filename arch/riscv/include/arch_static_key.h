@@ -0,0 +1,35 @@
+/*
+ * arch/riscv/include/arch_static_key.h
+ *
+ * RISC-V static branch sites: a 4-byte NOP, patched to JAL x0
+ */
+
+#ifndef _ARCH_STATIC_KEY_H_
+#define _ARCH_STATIC_KEY_H_
+
+#include <stdbool.h>
+
+#define RISCV_INSN_NOP      0x00000013U     // addi x0, x0, 0
+#define RISCV_INSN_JAL      0x0000006fU     // rd = x0, imm20 in halfwords, +-1 MiB
+
+struct static_key;
+
+// norvc keeps the NOP 4 bytes wide, as the JAL that replaces it. With C
+// the site may be only 2-byte aligned.
+static inline __attribute__((always_inline)) bool arch_static_branch(struct static_key *key) {
+    __asm__ goto(
+        "       .option push\n"
+        "       .option norvc\n"
+        "1:     nop\n"
+        "       .option pop\n"
+        "       .pushsection .static_keys, \"a\"\n"
+        "       .balign 8\n"
+        "       .dword  1b, %l[l_yes], %0\n"
+        "       .popsection\n"
+        : : "i"(key) : : l_yes);
+    return false;
+l_yes:
+    return true;
+}
+
+#endif /* _ARCH_STATIC_KEY_H_ */
@@ -0,0 +1,62 @@
+/*
+ * arch/riscv/include/arch_string.h
+ *
+ * RISC-V memory and string function overrides
+ */
+
+#ifndef _ARCH_STRING_H_
+#define _ARCH_STRING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <cpufeature.h>
+#include <arch_vector.h>
+
+// In arch/riscv/lib/string.S; kernel/lib/string.c leaves these out
+#define ARCH_HAS_MEMCPY     1
+#define ARCH_HAS_MEMMOVE    1
+#define ARCH_HAS_MEMSET     1
+
+// In arch/riscv/lib/string_vector.c when built with RISCV_VECTOR=1
+#define ARCH_HAS_MEMCMP     CONFIG_RISCV_VECTOR
+#define ARCH_HAS_STRLEN     CONFIG_RISCV_VECTOR
+
+// memcpy and memset hand sizes from these up to memcpy_large() and
+// memset_large() once riscv_string_vector is set. Mirrored in string.S.
+#define MEMCPY_RVV_MIN      256
+#define MEMSET_RVV_MIN      256
+
+// memcmp runs the RVV loop from this size; strlen after this many bytes
+#define MEMCMP_RVV_MIN      64
+#define STRLEN_RVV_AFTER    32
+
+// Zbb versions of the word_at_a_time.h helpers, patched in at boot.
+// Spelled with .insn so the assembler needs no Zbb.
+#define ARCH_HAS_WORD_AT_A_TIME         1
+#define arch_word_at_a_time_usable()    cpu_feature_branch(CPU_FEATURE_ZBB)
+
+// orc.b sets every non-zero byte to 0xff and leaves zero bytes 0x00
+static inline uint64_t arch_word_zero_bytes(uint64_t w) {
+    uint64_t r;
+
+    __asm__(".insn i 0x13, 5, %0, %1, 0x287" : "=r"(r) : "r"(w));     // orc.b
+    return ~r & 0x8080808080808080UL;
+}
+
+static inline unsigned int arch_word_first_byte(uint64_t mask) {
+    uint64_t r;
+
+    __asm__(".insn i 0x13, 1, %0, %1, 0x601" : "=r"(r) : "r"(mask));  // ctz
+    return (unsigned int)(r >> 3);
+}
+
+// Set by riscv_vector_init() when the V extension is present
+extern bool riscv_string_vector;
+
+void *__memcpy(void *dst, const void *src, size_t n);
+void *__memset(void *s, int c, size_t n);
+void *memcpy_large(void *dst, const void *src, size_t n);
+void *memset_large(void *s, int c, size_t n);
+
+#endif /* _ARCH_STRING_H_ */
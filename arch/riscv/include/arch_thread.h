@@ -0,0 +1,32 @@
+/*
+ * arch/riscv/include/arch_thread.h
+ *
+ * RISC-V kernel thread context
+ */
+
+#ifndef _ARCH_THREAD_H_
+#define _ARCH_THREAD_H_
+
+#include <stdint.h>
+
+/*
+ * Registers preserved across arch_switch_to(). tp is left alone: it holds
+ * the per-CPU offset and threads do not migrate. Offsets are mirrored in
+ * switch.S.
+ */
+struct arch_thread_context {
+    uint64_t ra;                // 0
+    uint64_t sp;                // 8
+    uint64_t s[12];             // 16 (s0-s11)
+};
+
+// Set up a new thread so the first switch to it "returns" into entry with
+// the previous task as its argument
+static inline void arch_thread_init(struct arch_thread_context *ctx,
+                                    uintptr_t stack_top, uintptr_t entry) {
+    ctx->ra = entry;
+    ctx->sp = stack_top & ~15UL;
+    ctx->s[0] = 0;              // Frame pointer
+}
+
+#endif /* _ARCH_THREAD_H_ */
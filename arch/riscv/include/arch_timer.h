@@ -2,8 +2,10 @@
 #define _ARCH_TIMER_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <cpufeature.h>
 
-// RISC-V Timer functions (using SBI timer extension)
+// RISC-V Timer functions (Sstc stimecmp, or the SBI timer extension)
 
 static inline uint64_t arch_timer_get_counter(void) {
     uint64_t val;
@@ -11,14 +13,16 @@ static inline uint64_t arch_timer_get_counter(void) {
     return val;
 }
 
+// Timebase from the device tree, read when the clocksource registers;
+// 10 MHz (QEMU virt) until then
+extern uint64_t riscv_timebase_frequency;
+
 static inline uint64_t arch_timer_get_frequency(void) {
-    // RISC-V typically runs at 10MHz for QEMU
-    // This should ideally come from device tree
-    return 10000000;
+    return riscv_timebase_frequency;
 }
 
-static inline void arch_timer_set_compare(uint64_t val) {
-    // RISC-V uses SBI call to set timer
+
+static inline void arch_timer_set_compare_sbi(uint64_t val) {
     // SBI timer extension (EID 0x54494D45)
     register unsigned long a0 __asm__("a0") = val;
     register unsigned long a7 __asm__("a7") = 0x54494D45;
@@ -31,6 +35,22 @@ static inline void arch_timer_set_compare(uint64_t val) {
     );
 }
 
+// stimecmp is CSR 0x14d, by number for assemblers without Sstc. Moving
+// the deadline ahead clears a pending STIP, as SBI set_timer does.
+static inline void arch_timer_set_compare_sstc(uint64_t val) {
+    __asm__ volatile("csrw 0x14d, %0" : : "r"(val) : "memory");
+}
+
+static inline void arch_timer_set_compare(uint64_t val) {
+    // With Sstc the compare register is ours; otherwise firmware owns
+    // mtimecmp and every program is an ecall
+    if (cpu_feature_branch(CPU_FEATURE_SSTC)) {
+        arch_timer_set_compare_sstc(val);
+    } else {
+        arch_timer_set_compare_sbi(val);
+    }
+}
+
 static inline void arch_timer_enable(void) {
     // Enable timer interrupts in sie register
     uint64_t sie;
@@ -55,6 +75,10 @@ static inline void arch_timer_clear_interrupt(void) {
     __asm__ volatile("csrw sip, %0" : : "r"(sip));
 }
 
+// Map this CPU's timer interrupt in the root interrupt domain.
+// Returns the virtual IRQ, or IRQ_INVALID if no controller is up yet.
+uint32_t arch_timer_map_irq(void);
+
 static inline void arch_cpu_relax(void) {
     // RISC-V pause instruction (hint) - use nop for compatibility
     __asm__ volatile("nop");
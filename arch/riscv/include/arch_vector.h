@@ -0,0 +1,75 @@
+/*
+ * arch/riscv/include/arch_vector.h
+ *
+ * Kernel-mode vector (RVV 1.0) sections
+ *
+ * Built only with RISCV_VECTOR=1, which needs an assembler that knows
+ * RVV 1.0, and used only when the boot hart's device tree lists "v".
+ * sstatus.VS stays Off outside kernel_vector_begin()/kernel_vector_end(),
+ * so a stray vector instruction is an illegal instruction trap.
+ *
+ * No thread owns vector state. A section runs with preemption disabled
+ * and must not sleep, so switching threads never saves or restores
+ * vector registers. A handler that opens a section while another is
+ * interrupted saves the interrupted registers only if sstatus.VS says
+ * they were written; a section that has not run a vector instruction
+ * yet costs nothing to interrupt.
+ */
+
+#ifndef _ARCH_VECTOR_H_
+#define _ARCH_VECTOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifndef CONFIG_RISCV_VECTOR
+#define CONFIG_RISCV_VECTOR 0
+#endif
+
+// sstatus.VS: Off traps every vector instruction, Dirty is set by hardware
+// on the first write to a vector register or CSR
+#define SSTATUS_VS_SHIFT    9
+#define SSTATUS_VS_MASK     (3UL << SSTATUS_VS_SHIFT)
+#define SSTATUS_VS_OFF      (0UL << SSTATUS_VS_SHIFT)
+#define SSTATUS_VS_INITIAL  (1UL << SSTATUS_VS_SHIFT)
+#define SSTATUS_VS_CLEAN    (2UL << SSTATUS_VS_SHIFT)
+#define SSTATUS_VS_DIRTY    (3UL << SSTATUS_VS_SHIFT)
+
+// A thread's section plus one interrupt handler's
+#define KERNEL_VECTOR_MAX_DEPTH 2
+
+// Largest register the save area holds (VLEN 1024). Harts with longer
+// registers still get sections, just not nested ones.
+#define RISCV_VECTOR_MAX_VLENB  128
+
+// Vector CSRs, then V0-V31 at vlenb bytes each. Offsets mirrored in
+// vector.S.
+struct riscv_vector_state {
+    uint64_t vstart;
+    uint64_t vl;
+    uint64_t vtype;
+    uint64_t vcsr;
+    uint8_t vregs[32 * RISCV_VECTOR_MAX_VLENB] __attribute__((aligned(16)));
+    bool saved;
+};
+
+// vector.S; sstatus.VS must not be Off
+void riscv_vector_save(struct riscv_vector_state *state);
+void riscv_vector_load(const struct riscv_vector_state *state);
+
+// Probe VLEN when cpufeature_init() found "v". Until then, and always
+// without it, kernel_vector_usable() is false.
+void riscv_vector_init(void);
+
+// Bytes per vector register, 0 when vector sections are unavailable
+size_t riscv_vector_vlenb(void);
+
+// False when a section cannot be opened here
+bool kernel_vector_usable(void);
+
+// Open and close a section. May be called from interrupt handlers.
+void kernel_vector_begin(void);
+void kernel_vector_end(void);
+
+#endif /* _ARCH_VECTOR_H_ */
@@ -20,6 +20,13 @@
 #define RISCV_PTE_D     (1UL << 7)   /* Dirty */
 #define RISCV_PTE_RSW   (3UL << 8)   /* Reserved for software (2 bits) */
 
+/* Svpbmt page-based memory types, bits [62:61]; override the PMA */
+#define RISCV_PTE_PBMT_SHIFT    61
+#define RISCV_PTE_PBMT_MASK     (3UL << RISCV_PTE_PBMT_SHIFT)
+#define RISCV_PTE_PBMT_PMA      (0UL << RISCV_PTE_PBMT_SHIFT)  /* As the PMA says */
+#define RISCV_PTE_PBMT_NC       (1UL << RISCV_PTE_PBMT_SHIFT)  /* Non-cacheable, idempotent */
+#define RISCV_PTE_PBMT_IO       (2UL << RISCV_PTE_PBMT_SHIFT)  /* Non-cacheable, I/O */
+
 /* Physical Page Number (PPN) fields in Sv39 */
 #define RISCV_PTE_PPN_SHIFT     10
 #define RISCV_PTE_PPN_MASK      0x3FFFFFFFFFFC00UL  /* Bits [53:10] */
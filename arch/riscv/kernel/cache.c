@@ -2,66 +2,176 @@
  * arch/riscv/kernel/cache.c
  *
  * RISC-V cache management functions
- * 
- * Note: RISC-V doesn't have standardized cache management instructions.
- * Cache operations are typically handled by:
- * 1. Platform-specific instructions (vendor extensions)
- * 2. SBI (Supervisor Binary Interface) calls
- * 3. Cache coherent implementations that don't require explicit management
- * 
- * This implementation provides the required interface with fence instructions
- * for memory ordering, which is sufficient for cache-coherent systems.
+ *
+ * Range maintenance uses the Zicbom cache-block operations (cbo.clean,
+ * cbo.inval, cbo.flush), one block at a time, with the block size the
+ * device tree gives in riscv,cbom-block-size. Harts without Zicbom have
+ * no standard way to write back or discard a line; such platforms keep
+ * DMA coherent in hardware, and the range operations are no-ops. So are
+ * they when the device tree marks the platform dma-coherent, in which
+ * case a CMO would only cost a trip to the point of coherency.
  */
 
 #include <arch_cache.h>
+#include <arch_isa.h>
+#include <cpufeature.h>
+#include <drivers/fdt.h>
+#include <drivers/fdt_mgr.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
-// RISC-V typically has 64-byte cache lines, but this may vary
+// Used when the device tree gives no block size
 #define DEFAULT_CACHE_LINE_SIZE 64
 
 static uint64_t cache_line_size = DEFAULT_CACHE_LINE_SIZE;
+static size_t cache_zero_block_size = 0;
+
+// Set by arch_cache_init() when the range operations must issue CMOs
+static bool cache_cmo;
+
+// cbo.<op> (rs1), spelled with .insn so the assembler needs no Zicbom
+#define CBO_INVAL   0
+#define CBO_CLEAN   1
+#define CBO_FLUSH   2
+
+#define cbo(op, addr) \
+    __asm__ volatile(".insn i 0x0f, 2, x0, %0, " #op : : "r"(addr) : "memory")
+
+static bool cache_block_size_valid(uint32_t size) {
+    return size != 0 && (size & (size - 1)) == 0;
+}
+
+// dma-coherent on the root or /soc covers every device below it
+static bool cache_platform_coherent(void) {
+    const void *fdt = fdt_mgr_get_blob();
+    int node;
+
+    if (!fdt) {
+        return false;
+    }
+    if (fdt_getprop(fdt, 0, "dma-coherent", NULL)) {
+        return true;
+    }
+    node = fdt_path_offset(fdt, "/soc");
+    return node >= 0 && fdt_getprop(fdt, node, "dma-coherent", NULL);
+}
 
-// Initialize cache subsystem
+// Needs the device tree and the CPU features, so runs from kernel_main()
+// after cpufeature_init(). cbo.inval from S-mode also needs firmware to
+// have set menvcfg.CBIE, which OpenSBI does whenever the hart has Zicbom.
 void arch_cache_init(void) {
-    // TODO: Could query cache line size from device tree or 
-    // platform-specific configuration if available
+    uint32_t block;
+
     cache_line_size = DEFAULT_CACHE_LINE_SIZE;
+    cache_cmo = false;
+
+    if (riscv_cpu_prop_u32("riscv,cbom-block-size", &block) &&
+        cache_block_size_valid(block)) {
+        cache_line_size = block;
+    } else if (riscv_cpu_prop_u32("d-cache-block-size", &block) &&
+               cache_block_size_valid(block)) {
+        cache_line_size = block;
+    } else {
+        // Zicbom without a block size is a broken device tree: a guessed
+        // stride larger than the real block would skip lines
+        return;
+    }
+
+    cache_cmo = cpu_has_feature(CPU_FEATURE_ZICBOM) && !cache_platform_coherent();
+}
+
+// Apply one CMO to every block overlapping [addr, addr + size)
+#define cache_range(op, addr, size) do {                                    \
+    uintptr_t _start = (uintptr_t)(addr) & ~(cache_line_size - 1);          \
+    uintptr_t _end = (uintptr_t)(addr) + (size);                            \
+                                                                            \
+    for (uintptr_t _line = _start; _line < _end; _line += cache_line_size) { \
+        cbo(op, _line);                                                     \
+    }                                                                       \
+} while (0)
+
+// Orders the CMOs before whatever tells the device to look at memory
+void arch_cache_barrier(void) {
+    if (cache_cmo) {
+        __asm__ volatile("fence rw, rw" ::: "memory");
+    }
+}
+
+void arch_cache_clean_nosync(void *addr, size_t size) {
+    if (cache_cmo) {
+        cache_range(CBO_CLEAN, addr, size);
+    }
+}
+
+void arch_cache_invalidate_nosync(void *addr, size_t size) {
+    if (cache_cmo) {
+        cache_range(CBO_INVAL, addr, size);
+    }
 }
 
 // Clean data cache by address range
 void arch_cache_clean(void *addr, size_t size) {
-    (void)addr;
-    (void)size;
-    
-    // RISC-V fence ensures memory ordering.
-    // On cache-coherent systems, this is sufficient.
-    // Non-coherent systems would need platform-specific instructions.
-    __asm__ volatile("fence rw, rw" ::: "memory");
+    arch_cache_clean_nosync(addr, size);
+    arch_cache_barrier();
 }
 
 // Invalidate data cache by address range
 void arch_cache_invalidate(void *addr, size_t size) {
-    (void)addr;
-    (void)size;
-    
-    // RISC-V doesn't have standard cache invalidate instructions.
-    // The fence.i instruction synchronizes instruction and data streams,
-    // which is the closest standard equivalent.
-    __asm__ volatile("fence.i" ::: "memory");
+    arch_cache_invalidate_nosync(addr, size);
+    arch_cache_barrier();
 }
 
 // Clean and invalidate data cache by address range
 void arch_cache_flush(void *addr, size_t size) {
-    (void)addr;
-    (void)size;
-    
-    // Ensure all memory operations complete and instruction stream is synchronized
-    __asm__ volatile("fence rw, rw" ::: "memory");
-    __asm__ volatile("fence.i" ::: "memory");
+    if (cache_cmo) {
+        cache_range(CBO_FLUSH, addr, size);
+    }
+    arch_cache_barrier();
 }
 
 // Get cache line size
 uint64_t arch_cache_get_line_size(void) {
     return cache_line_size;
-}
\ No newline at end of file
+}
+
+bool arch_cache_coherent(void) {
+    return !cache_cmo;
+}
+
+// Svpbmt lets a PTE override the PMA and make RAM uncached
+bool arch_cache_nocache_mappings(void) {
+    return cpu_has_feature(CPU_FEATURE_SVPBMT);
+}
+
+// Needs the device tree, so runs after fdt_mgr_init() rather than from
+// arch_cache_init(). As with Sstc, the device tree only says the hart
+// has Zicboz; firmware must also have set menvcfg.CBZE, which OpenSBI
+// does whenever it sees it.
+void arch_cache_zero_init(void) {
+    uint32_t block;
+
+    cache_zero_block_size = 0;
+    if (!cpu_has_feature(CPU_FEATURE_ZICBOZ) ||
+        !riscv_cpu_prop_u32("riscv,cboz-block-size", &block)) {
+        return;
+    }
+    // Must be a power of two; anything else is a broken device tree
+    if (block == 0 || (block & (block - 1)) != 0) {
+        return;
+    }
+    cache_zero_block_size = block;
+}
+
+size_t arch_cache_zero_block_size(void) {
+    return cache_zero_block_size;
+}
+
+// cbo.zero (rs1), spelled with .insn so the assembler needs no Zicboz
+void arch_cache_zero(void *addr, size_t size) {
+    uintptr_t end = (uintptr_t)addr + size;
+
+    for (uintptr_t block = (uintptr_t)addr; block < end; block += cache_zero_block_size) {
+        __asm__ volatile(".insn i 0x0f, 2, x0, %0, 4" : : "r"(block) : "memory");
+    }
+}
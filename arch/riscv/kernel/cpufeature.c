@@ -0,0 +1,34 @@
+/*
+ * arch/riscv/kernel/cpufeature.c
+ *
+ * RISC-V ISA extension detection
+ */
+
+#include <stdint.h>
+#include <cpufeature.h>
+#include <arch_isa.h>
+
+const char *const cpu_feature_names[CPU_FEATURE_COUNT] = {
+    [CPU_FEATURE_ZBA]       = "zba",
+    [CPU_FEATURE_ZBB]       = "zbb",
+    [CPU_FEATURE_ZBC]       = "zbc",
+    [CPU_FEATURE_ZBS]       = "zbs",
+    [CPU_FEATURE_ZICBOM]    = "zicbom",
+    [CPU_FEATURE_ZICBOZ]    = "zicboz",
+    [CPU_FEATURE_SVINVAL]   = "svinval",
+    [CPU_FEATURE_SVPBMT]    = "svpbmt",
+    [CPU_FEATURE_SSTC]      = "sstc",
+    [CPU_FEATURE_V]         = "v",
+};
+
+// riscv,isa-extensions (or the riscv,isa string) of the boot hart
+uint64_t arch_cpufeature_detect(void) {
+    uint64_t bits = 0;
+
+    for (unsigned int f = 0; f < CPU_FEATURE_COUNT; f++) {
+        if (riscv_isa_extension_available(cpu_feature_names[f])) {
+            bits |= 1UL << f;
+        }
+    }
+    return bits;
+}
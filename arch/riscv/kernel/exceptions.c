@@ -5,6 +5,7 @@
  */
 
 #include <arch_exceptions.h>
+#include <arch_vector.h>
 #include <stdint.h>
 #include <panic.h>
 #include <uart.h>
@@ -77,49 +78,62 @@ static const char *interrupt_to_string(uint64_t code) {
     }
 }
 
-// C trap handler called from trap.S
-void riscv_trap_handler(arch_context_t *context, uint64_t cause, uint64_t tval) {
+// C interrupt handler called from trap.S, on this CPU's IRQ stack. The
+// entry code calls sched_irq_exit() once it is back on the interrupted
+// thread's stack, after the interrupt is completed at the controller.
+void riscv_irq_handler(struct irq_frame *frame, uint64_t cause) {
     uint64_t code = CAUSE_EXCEPTION_CODE(cause);
-    int is_interrupt = (cause & CAUSE_INTERRUPT_BIT) != 0;
     
-    if (is_interrupt) {
-        // Handle interrupt through INTC
-        if (intc_primary) {
-            intc_handle_irq(code);
-        } else {
-            // Fallback for early boot before INTC is initialized
-            uart_puts("[RISC-V] Early interrupt (INTC not ready): ");
-            uart_puts(interrupt_to_string(code));
-            uart_puts("\n");
-        }
+    (void)frame;
+    
+    // Handle interrupt through INTC
+    if (intc_primary) {
+        intc_handle_irq(code);
     } else {
-        // Handle exception
-        uart_puts("\n[RISC-V] FATAL EXCEPTION\n");
-        uart_puts("Exception: ");
-        uart_puts(exception_to_string(code));
-        uart_puts("\n");
-        
-        // Print trap value (address for memory faults, instruction for illegal inst)
-        uart_puts("Trap value: 0x");
-        for (int i = 60; i >= 0; i -= 4) {
-            int digit = (tval >> i) & 0xF;
-            uart_putc(digit < 10 ? '0' + digit : 'A' + digit - 10);
-        }
-        uart_puts("\n");
-        
-        // Print saved PC
-        uart_puts("PC: 0x");
-        for (int i = 60; i >= 0; i -= 4) {
-            int digit = (context->sepc >> i) & 0xF;
-            uart_putc(digit < 10 ? '0' + digit : 'A' + digit - 10);
-        }
+        // Fallback for early boot before INTC is initialized
+        uart_puts("[RISC-V] Early interrupt (INTC not ready): ");
+        uart_puts(interrupt_to_string(code));
         uart_puts("\n");
-        
-        // Panic for now - proper exception handling would go here
-        panic("Unhandled RISC-V exception");
     }
 }
 
+// C trap handler called from trap.S for synchronous exceptions
+void riscv_trap_handler(arch_context_t *context, uint64_t cause, uint64_t tval) {
+    uint64_t code = CAUSE_EXCEPTION_CODE(cause);
+    
+    // Handle exception
+    uart_puts("\n[RISC-V] FATAL EXCEPTION\n");
+    uart_puts("Exception: ");
+    uart_puts(exception_to_string(code));
+    uart_puts("\n");
+    
+    // Print trap value (address for memory faults, instruction for illegal inst)
+    uart_puts("Trap value: 0x");
+    for (int i = 60; i >= 0; i -= 4) {
+        int digit = (tval >> i) & 0xF;
+        uart_putc(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    }
+    uart_puts("\n");
+    
+    // Print saved PC
+    uart_puts("PC: 0x");
+    for (int i = 60; i >= 0; i -= 4) {
+        int digit = (context->sepc >> i) & 0xF;
+        uart_putc(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    }
+    uart_puts("\n");
+    
+    // OP-V, or LOAD-FP/STORE-FP (vector loads and stores share them)
+    if (code == EXC_ILLEGAL_INST &&
+        (context->sstatus & SSTATUS_VS_MASK) == SSTATUS_VS_OFF &&
+        ((tval & 0x7F) == 0x57 || (tval & 0x7F) == 0x07 || (tval & 0x7F) == 0x27)) {
+        uart_puts("Vector instruction outside kernel_vector_begin()/kernel_vector_end()?\n");
+    }
+    
+    // Panic for now - proper exception handling would go here
+    panic("Unhandled RISC-V exception");
+}
+
 // Install exception handlers
 void arch_install_exception_handlers(void) {
     // Set trap vector
@@ -6,7 +6,6 @@
 
 #include <stdint.h>
 #include <stddef.h>
-#include <arch_cache.h>
 #include <arch_exceptions.h>
 #include <exceptions/exceptions.h>
 
@@ -19,6 +18,9 @@ extern uint64_t phys_base_storage;
 // Global kernel physical base (used by VIRT_TO_PHYS/PHYS_TO_VIRT macros)
 uint64_t kernel_phys_base;
 
+// Hart we were entered on (becomes logical CPU 0)
+uint64_t boot_hart_id;
+
 // Forward declaration for kernel_main
 void kernel_main(void* dtb);
 
@@ -37,10 +39,7 @@ void init_riscv(unsigned long hart_id, void *dtb) {
     // Initialize kernel physical base from boot.S
     // phys_base_storage was set in physical memory during boot
     kernel_phys_base = phys_base_storage;
-    
-    
-    // Initialize cache subsystem
-    arch_cache_init();
+    boot_hart_id = hart_id;
     
     // Install trap/exception handlers using the architecture-agnostic function
     exception_init();
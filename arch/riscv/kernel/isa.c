@@ -0,0 +1,144 @@
+/*
+ * arch/riscv/kernel/isa.c
+ *
+ * ISA extension lookup and properties of the boot hart's device tree node
+ */
+
+#include <arch_isa.h>
+#include <arch_smp.h>
+#include <drivers/fdt.h>
+#include <drivers/fdt_mgr.h>
+#include <string.h>
+
+static char isa_tolower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// Case-insensitive compare of len characters of s against name
+static bool isa_token_is(const char *s, size_t len, const char *name) {
+    if (strlen(name) != len) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (isa_tolower(s[i]) != name[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The /cpus child whose reg is the boot hart
+static int isa_boot_cpu_node(const void *fdt) {
+    int cpus = fdt_path_offset(fdt, "/cpus");
+    int node;
+
+    if (cpus < 0) {
+        return -1;
+    }
+
+    fdt_for_each_subnode(node, fdt, cpus) {
+        int len;
+        const char *type = fdt_getprop(fdt, node, "device_type", NULL);
+        const uint32_t *reg = fdt_getprop(fdt, node, "reg", &len);
+
+        if (!type || strcmp(type, "cpu") != 0 || !reg || len < 4) {
+            continue;
+        }
+
+        uint64_t hwid = fdt32_to_cpu(reg[0]);
+        if (len >= 8) {
+            hwid = (hwid << 32) | fdt32_to_cpu(reg[1]);
+        }
+        if (hwid == arch_smp_boot_hwid()) {
+            return node;
+        }
+    }
+    return -1;
+}
+
+// riscv,isa-extensions: one string per extension
+static bool isa_in_extension_list(const char *list, int len, const char *name) {
+    int pos = 0;
+
+    while (pos < len) {
+        size_t n = strlen(list + pos);
+        if (isa_token_is(list + pos, n, name)) {
+            return true;
+        }
+        pos += n + 1;
+    }
+    return false;
+}
+
+// riscv,isa: "rv64imafdc_zicsr_zifencei_sstc". Single letters follow
+// the rv32/rv64 prefix; longer names are separated by underscores.
+static bool isa_in_string(const char *isa, const char *name) {
+    const char *p = isa;
+
+    if (isa_tolower(p[0]) == 'r' && isa_tolower(p[1]) == 'v') {
+        p += 2;
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+
+    // Single-letter extensions, up to the first underscore
+    if (name[1] == '\0') {
+        for (; *p && *p != '_'; p++) {
+            if (isa_tolower(*p) == name[0]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    while (*p) {
+        const char *end = p;
+        while (*end && *end != '_') {
+            end++;
+        }
+        if (isa_token_is(p, end - p, name)) {
+            return true;
+        }
+        p = *end ? end + 1 : end;
+    }
+    return false;
+}
+
+bool riscv_isa_extension_available(const char *name) {
+    const void *fdt = fdt_mgr_get_blob();
+    const char *prop;
+    int node, len;
+
+    if (!fdt || !name || !name[0] || (node = isa_boot_cpu_node(fdt)) < 0) {
+        return false;
+    }
+
+    prop = fdt_getprop(fdt, node, "riscv,isa-extensions", &len);
+    if (prop && len > 0) {
+        return isa_in_extension_list(prop, len, name);
+    }
+
+    prop = fdt_getprop(fdt, node, "riscv,isa", &len);
+    if (prop && len > 0) {
+        return isa_in_string(prop, name);
+    }
+    return false;
+}
+
+bool riscv_cpu_prop_u32(const char *prop, uint32_t *val) {
+    const void *fdt = fdt_mgr_get_blob();
+    const uint32_t *cell;
+    int node, len;
+
+    if (!fdt || (node = isa_boot_cpu_node(fdt)) < 0) {
+        return false;
+    }
+
+    cell = fdt_getprop(fdt, node, prop, &len);
+    if (!cell || len < 4) {
+        return false;
+    }
+    *val = fdt32_to_cpu(*cell);
+    return true;
+}
@@ -0,0 +1,151 @@
+/*
+ * arch/riscv/kernel/smp.c
+ *
+ * RISC-V secondary hart bring-up via SBI HSM hart_start, IPIs and remote
+ * TLB flushes via SBI IPI and RFENCE
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch_smp.h>
+#include <arch_sbi.h>
+#include <percpu.h>
+#include <smp.h>
+#include <irq/irq.h>
+#include <irq/irq_domain.h>
+#include <irqchip/riscv-intc.h>
+#include <memory/vmparam.h>
+#include <uart.h>
+
+// Entry point in boot.S (runs with translation off)
+extern char secondary_entry[];
+
+// Handoff block shared with secondary_entry; harts are started one at a time
+struct secondary_boot_data secondary_boot_data __attribute__((aligned(64)));
+
+// Start one secondary hart
+int arch_smp_boot_cpu(unsigned int cpu, uint64_t hwid, uintptr_t stack_top) {
+    struct secondary_boot_data *bd = &secondary_boot_data;
+    uint64_t satp;
+
+    __asm__ volatile("csrr %0, satp" : "=r" (satp));
+    bd->satp = satp;
+    bd->stack_top = stack_top;
+    bd->percpu_offset = per_cpu_offset(cpu);
+    bd->cpu = cpu;
+
+    // Make the block visible before the hart can observe it
+    __asm__ volatile("fence rw, rw" ::: "memory");
+
+    struct sbiret ret = sbi_ecall(SBI_EXT_HSM, SBI_HSM_HART_START, hwid,
+                                  VIRT_TO_PHYS(secondary_entry),
+                                  VIRT_TO_PHYS(bd), 0);
+    if (ret.error != SBI_SUCCESS) {
+        uart_puts("SBI: hart_start returned ");
+        uart_puthex((uint64_t)ret.error);
+        uart_puts("\n");
+        return -1;
+    }
+    return 0;
+}
+
+// The IPI arrives as the supervisor software interrupt, raised by the
+// SBI. The AIA IMSIC could deliver it as an MSI instead, but its driver
+// only sets up hart 0's interrupt file so far.
+
+static uint32_t ipi_virq;
+static bool sbi_has_rfence;
+
+static void riscv_ipi_handler(void *dev) {
+    (void)dev;
+
+    // Clear before reading the messages: one sent after this raises the
+    // interrupt again rather than being lost
+    arch_irq_clear_pending(SIE_SSIE);
+    smp_ipi_interrupt();
+}
+
+int arch_ipi_init(void) {
+    if (!intc_primary || !sbi_probe_extension(SBI_EXT_IPI)) {
+        return -1;
+    }
+
+    ipi_virq = irq_find_mapping(intc_primary->domain, IRQ_S_SOFT);
+    if (ipi_virq == IRQ_INVALID || ipi_virq == 0) {
+        ipi_virq = irq_create_mapping(intc_primary->domain, IRQ_S_SOFT);
+    }
+    if (ipi_virq == IRQ_INVALID || ipi_virq == 0) {
+        return -1;
+    }
+
+    // Shared so the IRQ tests can still hook the software interrupt
+    if (request_irq(ipi_virq, riscv_ipi_handler, IRQF_SHARED, "IPI", &ipi_virq) != 0) {
+        return -1;
+    }
+
+    sbi_has_rfence = sbi_probe_extension(SBI_EXT_RFENCE);
+
+    uart_puts("SMP: IPIs through SBI");
+    uart_puts(sbi_has_rfence ? ", remote fences through SBI RFENCE\n" : "\n");
+    return 0;
+}
+
+void arch_ipi_init_secondary(void) {
+    arch_irq_clear_pending(SIE_SSIE);
+    arch_irq_enable(SIE_SSIE);
+}
+
+// SBI takes harts as a 64-bit mask above a base hart ID. Peel off the
+// CPUs whose hart IDs fit in one window above the lowest remaining one.
+static uint64_t riscv_hart_window(uint64_t *mask, unsigned long *base) {
+    uint64_t harts = 0;
+    unsigned long lo = ~0UL;
+
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+        if ((*mask & cpumask_of(cpu)) && cpu_hwid[cpu] < lo) {
+            lo = cpu_hwid[cpu];
+        }
+    }
+
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+        if ((*mask & cpumask_of(cpu)) && cpu_hwid[cpu] - lo < 64) {
+            harts |= 1ULL << (cpu_hwid[cpu] - lo);
+            *mask &= ~cpumask_of(cpu);
+        }
+    }
+
+    *base = lo;
+    return harts;
+}
+
+void arch_send_ipi_mask(uint64_t mask) {
+    // Messages and the data they refer to reach the target before the IPI
+    __asm__ volatile("fence rw, rw" ::: "memory");
+
+    while (mask) {
+        unsigned long base;
+        uint64_t harts = riscv_hart_window(&mask, &base);
+
+        sbi_ecall(SBI_EXT_IPI, SBI_IPI_SEND_IPI, harts, base, 0, 0);
+    }
+}
+
+int arch_flush_tlb_remote(uint64_t mask, uintptr_t start, uintptr_t end) {
+    if (!sbi_has_rfence) {
+        return -1;
+    }
+
+    // The page table update is visible before any hart refetches
+    __asm__ volatile("fence rw, rw" ::: "memory");
+
+    while (mask) {
+        unsigned long base;
+        uint64_t harts = riscv_hart_window(&mask, &base);
+        struct sbiret ret = sbi_ecall(SBI_EXT_RFENCE, SBI_RFENCE_REMOTE_SFENCE_VMA,
+                                      harts, base, start, end - start);
+        if (ret.error != SBI_SUCCESS) {
+            return -1;
+        }
+    }
+    return 0;
+}
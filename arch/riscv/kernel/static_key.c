@@ -0,0 +1,41 @@
+/*
+ * arch/riscv/kernel/static_key.c
+ *
+ * Static branch patching
+ */
+
+#include <static_key.h>
+#include <panic.h>
+
+// JAL x0, off: imm[20|10:1|11|19:12] in bits 31:12
+static uint32_t riscv_insn_jal(int64_t off) {
+    uint32_t imm = (uint32_t)off;
+
+    return RISCV_INSN_JAL |
+           (((imm >> 20) & 0x1) << 31) |
+           (((imm >> 1) & 0x3ff) << 21) |
+           (((imm >> 11) & 0x1) << 20) |
+           (((imm >> 12) & 0xff) << 12);
+}
+
+void arch_static_key_patch(const struct static_key_entry *entry, bool enable) {
+    // With C the site may sit on a 2-byte boundary, where a 32-bit store
+    // would trap to the firmware
+    volatile uint16_t *half = (volatile uint16_t *)entry->code;
+    int64_t off = (int64_t)(entry->target - entry->code);
+    uint32_t insn = RISCV_INSN_NOP;
+
+    if (enable) {
+        if (off < -(1L << 20) || off >= (1L << 20)) {
+            panic("static key: branch target out of range");
+        }
+        insn = riscv_insn_jal(off);
+    }
+    half[0] = (uint16_t)insn;
+    half[1] = (uint16_t)(insn >> 16);
+}
+
+// fence.i only reaches this hart, which is all there is during boot
+void arch_static_key_sync(void) {
+    __asm__ volatile("fence.i" ::: "memory");
+}
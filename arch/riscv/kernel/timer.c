@@ -0,0 +1,116 @@
+/*
+ * arch/riscv/kernel/timer.c
+ *
+ * Time CSR clocksource, supervisor timer interrupt wiring and clock
+ * event device
+ */
+
+#include <arch_timer.h>
+#include <cpufeature.h>
+#include <irq/irq.h>
+#include <irq/irq_domain.h>
+#include <irqchip/riscv-intc.h>
+#include <time/clockevents.h>
+#include <time/clocksource.h>
+#include <drivers/fdt.h>
+#include <drivers/fdt_mgr.h>
+
+// QEMU virt's rate, until /cpus/timebase-frequency says otherwise
+uint64_t riscv_timebase_frequency = 10000000;
+
+uint32_t arch_timer_map_irq(void) {
+    uint32_t virq;
+
+    if (!intc_primary) {
+        return IRQ_INVALID;
+    }
+
+    virq = irq_find_mapping(intc_primary->domain, IRQ_S_TIMER);
+    if (virq == IRQ_INVALID || virq == 0) {
+        virq = irq_create_mapping(intc_primary->domain, IRQ_S_TIMER);
+    }
+    return virq ? virq : IRQ_INVALID;
+}
+
+// The time CSR ticks at the platform timebase, given in /cpus as one or
+// two cells
+static void riscv_timebase_from_fdt(void) {
+    void *fdt = fdt_mgr_get_blob();
+    const uint32_t *prop;
+    int cpus, len;
+
+    if (!fdt || (cpus = fdt_path_offset(fdt, "/cpus")) < 0) {
+        return;
+    }
+
+    prop = fdt_getprop(fdt, cpus, "timebase-frequency", &len);
+    if (prop && len == 4) {
+        riscv_timebase_frequency = fdt32_to_cpu(prop[0]);
+    } else if (prop && len == 8) {
+        riscv_timebase_frequency = ((uint64_t)fdt32_to_cpu(prop[0]) << 32) | fdt32_to_cpu(prop[1]);
+    }
+}
+
+static uint64_t riscv_counter_read(struct clocksource *cs) {
+    (void)cs;
+    return arch_timer_get_counter();
+}
+
+static struct clocksource riscv_clocksource = {
+    .name = "riscv_clocksource",
+    .read = riscv_counter_read,
+    .mask = CLOCKSOURCE_MASK(64),
+};
+
+int arch_clocksource_init(void) {
+    riscv_timebase_from_fdt();
+    return clocksource_register_hz(&riscv_clocksource, (uint32_t)arch_timer_get_frequency());
+}
+
+static void riscv_timer_set_next_event(struct clock_event_device *dev, uint64_t delta) {
+    (void)dev;
+    arch_timer_set_compare(arch_timer_get_counter() + delta);
+    arch_timer_enable();
+}
+
+// Push the deadline out of reach, which also drops the pending bit
+static void riscv_timer_shutdown(struct clock_event_device *dev) {
+    (void)dev;
+    arch_timer_set_compare(UINT64_MAX);
+}
+
+// SBI set_timer against the time CSR, or stimecmp directly when the
+// hart has Sstc. Named at init once we know which; the registration
+// banner shows it.
+static struct clock_event_device riscv_clockevent = {
+    .set_next_event = riscv_timer_set_next_event,
+    .set_state_shutdown = riscv_timer_shutdown,
+};
+
+int arch_clockevent_init(void) {
+    struct clock_event_device *dev = &riscv_clockevent;
+    uint32_t freq = (uint32_t)arch_timer_get_frequency();
+    uint64_t min_delta;
+
+    dev->virq = arch_timer_map_irq();
+    if (dev->virq == IRQ_INVALID) {
+        return -1;
+    }
+
+    // The device tree can only say the hart has Sstc; firmware must also
+    // have set menvcfg.STCE, which OpenSBI does whenever it sees it
+    if (cpu_has_feature(CPU_FEATURE_SSTC)) {
+        // Whatever firmware had armed for us is superseded
+        arch_timer_set_compare_sbi(UINT64_MAX);
+        dev->name = "riscv,sstc-timer";
+        // A CSR write: 1 us out is plenty
+        min_delta = freq / 1000000;
+    } else {
+        dev->name = "riscv,sbi-timer";
+        // Each program is an ecall into firmware, so keep the minimum
+        // above its round trip: at least 5 us out
+        min_delta = freq / 200000;
+    }
+
+    return clockevents_config_and_register(dev, freq, min_delta ? min_delta : 1, UINT64_MAX >> 2);
+}
@@ -0,0 +1,149 @@
+/*
+ * arch/riscv/kernel/vector.c
+ *
+ * Kernel-mode vector sections
+ */
+
+#include <arch_vector.h>
+#include <arch_string.h>
+#include <cpufeature.h>
+#include <percpu.h>
+#include <preempt.h>
+#include <spinlock.h>
+#include <panic.h>
+
+// Set by riscv_vector_init() when the string routines may use RVV;
+// string.S reads it on every memcpy/memset
+bool riscv_string_vector = false;
+
+#if CONFIG_RISCV_VECTOR
+
+// Open sections on this CPU: 0 with VS Off, 1 in a thread's or handler's
+// section, 2 in a handler's section that interrupted another
+static DEFINE_PER_CPU(int, vector_depth) = 0;
+
+// Registers of the section interrupted at each depth above the first
+static DEFINE_PER_CPU(struct riscv_vector_state, vector_saved[KERNEL_VECTOR_MAX_DEPTH - 1]);
+
+static size_t vector_vlenb = 0;
+static int vector_max_depth = 0;
+
+static inline uint64_t vector_get_state(void) {
+    uint64_t sstatus;
+
+    __asm__ volatile("csrr %0, sstatus" : "=r"(sstatus));
+    return sstatus & SSTATUS_VS_MASK;
+}
+
+// Interrupts must be off: a trap in between would see neither state
+static inline void vector_set_state(uint64_t vs) {
+    __asm__ volatile(
+        "csrc sstatus, %0\n\t"
+        "csrs sstatus, %1"
+        : : "r"(SSTATUS_VS_MASK), "r"(vs) : "memory");
+}
+
+void riscv_vector_init(void) {
+    irqflags_t flags;
+    uint64_t vlenb;
+
+    if (!cpu_has_feature(CPU_FEATURE_V)) {
+        return;
+    }
+
+    // vlenb is a vector CSR, so reading it needs VS on
+    flags = arch_local_irq_save();
+    vector_set_state(SSTATUS_VS_INITIAL);
+    __asm__ volatile("csrr %0, 0xc22" : "=r"(vlenb));    // vlenb
+    vector_set_state(SSTATUS_VS_OFF);
+    arch_local_irq_restore(flags);
+
+    vector_vlenb = vlenb;
+    vector_max_depth = vlenb <= RISCV_VECTOR_MAX_VLENB ? KERNEL_VECTOR_MAX_DEPTH : 1;
+    riscv_string_vector = true;
+}
+
+size_t riscv_vector_vlenb(void) {
+    return vector_vlenb;
+}
+
+bool kernel_vector_usable(void) {
+    return __this_cpu_read(vector_depth) < vector_max_depth;
+}
+
+void kernel_vector_begin(void) {
+    irqflags_t flags;
+    int depth;
+
+    preempt_disable();
+
+    flags = arch_local_irq_save();
+    depth = __this_cpu_read(vector_depth);
+    if (depth >= vector_max_depth) {
+        panic("kernel_vector_begin: no vector unit or sections nested too deeply");
+    }
+
+    if (depth == 0) {
+        vector_set_state(SSTATUS_VS_INITIAL);
+    } else {
+        struct riscv_vector_state *state = this_cpu_ptr(vector_saved[depth - 1]);
+
+        // VS still holds the interrupted section's state: Initial means
+        // it has not touched a vector register yet
+        state->saved = vector_get_state() == SSTATUS_VS_DIRTY;
+        if (state->saved) {
+            riscv_vector_save(state);
+        }
+    }
+    __this_cpu_write(vector_depth, depth + 1);
+    arch_local_irq_restore(flags);
+}
+
+void kernel_vector_end(void) {
+    irqflags_t flags;
+    int depth;
+
+    flags = arch_local_irq_save();
+    depth = __this_cpu_read(vector_depth) - 1;
+    if (depth < 0) {
+        panic("kernel_vector_end: no section open");
+    }
+
+    if (depth == 0) {
+        vector_set_state(SSTATUS_VS_OFF);
+    } else {
+        struct riscv_vector_state *state = this_cpu_ptr(vector_saved[depth - 1]);
+
+        // The interrupted VS comes back with sstatus on trap return
+        if (state->saved) {
+            riscv_vector_load(state);
+        }
+    }
+    __this_cpu_write(vector_depth, depth);
+    arch_local_irq_restore(flags);
+
+    preempt_enable();
+}
+
+#else /* !CONFIG_RISCV_VECTOR */
+
+void riscv_vector_init(void) {
+}
+
+size_t riscv_vector_vlenb(void) {
+    return 0;
+}
+
+bool kernel_vector_usable(void) {
+    return false;
+}
+
+void kernel_vector_begin(void) {
+    panic("kernel_vector_begin: kernel built without RISCV_VECTOR=1");
+}
+
+void kernel_vector_end(void) {
+    panic("kernel_vector_end: no section open");
+}
+
+#endif /* CONFIG_RISCV_VECTOR */
@@ -0,0 +1,52 @@
+/*
+ * arch/riscv/lib/crc32.c
+ *
+ * CRC-32 and CRC-32C with Zbc carry-less multiply
+ *
+ * Each 64-bit word (with the running CRC XORed into its low half) is
+ * reduced modulo the polynomial P by Barrett reduction. In the reflected
+ * bit order the CRCs use, the quotient of word * x^32 by P is the high
+ * half of word * QT, where QT = x^96 / P with its x^64 term left implicit
+ * (added back as the XOR of the word itself); the remainder is then the
+ * low 32 bits of quotient * P. On reflected operands clmul returns that
+ * high half one bit out of place, hence the shift.
+ *
+ * The instructions are spelled with .insn so the toolchain baseline can
+ * stay rv64imac.
+ */
+
+#include <arch_crc32.h>
+
+#define CRC32_POLY      0xedb88320UL
+#define CRC32C_POLY     0x82f63b78UL
+
+// x^96 / P, reflected, for each polynomial
+#define CRC32_QT        0x5a72d812fb808b20UL
+#define CRC32C_QT       0xa434f61c6f5389f8UL
+
+static inline uint32_t crc_zbc_word(uint64_t s, uint64_t qt, uint64_t poly) {
+    uint64_t t;
+
+    __asm__(".insn r 0x33, 1, 5, %0, %1, %2\n\t"       // clmul  t, s, qt
+            "slli %0, %0, 1\n\t"
+            "xor %0, %0, %1\n\t"
+            ".insn r 0x33, 2, 5, %0, %0, %3\n\t"       // clmulr t, t, poly << 32
+            "srli %0, %0, 32"
+            : "=&r"(t)
+            : "r"(s), "r"(qt), "r"(poly << 32));
+    return (uint32_t)t;
+}
+
+uint32_t arch_crc32_words(uint32_t crc, const uint64_t *p, size_t nwords) {
+    for (size_t i = 0; i < nwords; i++) {
+        crc = crc_zbc_word(p[i] ^ crc, CRC32_QT, CRC32_POLY);
+    }
+    return crc;
+}
+
+uint32_t arch_crc32c_words(uint32_t crc, const uint64_t *p, size_t nwords) {
+    for (size_t i = 0; i < nwords; i++) {
+        crc = crc_zbc_word(p[i] ^ crc, CRC32C_QT, CRC32C_POLY);
+    }
+    return crc;
+}
@@ -0,0 +1,87 @@
+/*
+ * arch/riscv/lib/string_vector.c
+ *
+ * RVV versions of memcpy, memset, memcmp and strlen
+ *
+ * Each opens a kernel_vector_begin() section around an inner loop from
+ * string_rvv.S when the work is large enough to pay for it, and uses the
+ * scalar code otherwise: always before riscv_vector_init() has found the
+ * V extension, and when a section cannot be opened here.
+ */
+
+#include <string.h>
+#include <arch_string.h>
+#include <arch_vector.h>
+#include <stdint.h>
+
+#if CONFIG_RISCV_VECTOR
+
+void __memcpy_rvv(void *dst, const void *src, size_t n);
+void __memset_rvv(void *s, int c, size_t n);
+int __memcmp_rvv(const void *a, const void *b, size_t n);
+size_t __strlen_rvv(const char *s);
+
+void *memcpy_large(void *dst, const void *src, size_t n) {
+    if (!kernel_vector_usable()) {
+        return __memcpy(dst, src, n);
+    }
+
+    kernel_vector_begin();
+    __memcpy_rvv(dst, src, n);
+    kernel_vector_end();
+    return dst;
+}
+
+void *memset_large(void *s, int c, size_t n) {
+    if (!kernel_vector_usable()) {
+        return __memset(s, c, n);
+    }
+
+    kernel_vector_begin();
+    __memset_rvv(s, c, n);
+    kernel_vector_end();
+    return s;
+}
+
+int memcmp(const void *a, const void *b, size_t n) {
+    const uint8_t *p = a;
+    const uint8_t *q = b;
+    int ret;
+
+    if (n >= MEMCMP_RVV_MIN && riscv_string_vector && kernel_vector_usable()) {
+        kernel_vector_begin();
+        ret = __memcmp_rvv(a, b, n);
+        kernel_vector_end();
+        return ret;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] != q[i]) {
+            return p[i] - q[i];
+        }
+    }
+    return 0;
+}
+
+// Most strings are short: look at the first few bytes before deciding a
+// section is worth opening
+size_t strlen(const char *s) {
+    size_t len;
+
+    for (len = 0; len < STRLEN_RVV_AFTER; len++) {
+        if (!s[len]) {
+            return len;
+        }
+    }
+
+    if (riscv_string_vector && kernel_vector_usable()) {
+        kernel_vector_begin();
+        len += __strlen_rvv(s + len);
+        kernel_vector_end();
+        return len;
+    }
+
+    return len + __strlen(s + len);
+}
+
+#endif /* CONFIG_RISCV_VECTOR */
@@ -9,6 +9,7 @@
 #include <memory/pmm.h>
 #include <memory/vmparam.h>
 #include <arch_mmu.h>
+#include <cpufeature.h>
 #include <mm/pte.h>
 #include <uart.h>
 #include <string.h>
@@ -180,8 +181,15 @@ static uint64_t riscv_attrs_to_pte(uint64_t attrs) {
     // Set accessed bit by default
     pte |= RISCV_PTE_A;
     
-    // Device memory doesn't have special PTE bits in RISC-V
-    // It's handled by Physical Memory Attributes (PMAs)
+    // Without Svpbmt the Physical Memory Attributes alone decide; with it
+    // the PTE can make RAM uncached. Firmware sets menvcfg.PBMTE.
+    if (cpu_has_feature(CPU_FEATURE_SVPBMT)) {
+        if (attrs & VMM_ATTR_DEVICE) {
+            pte |= RISCV_PTE_PBMT_IO;
+        } else if (attrs & VMM_ATTR_NOCACHE) {
+            pte |= RISCV_PTE_PBMT_NC;
+        }
+    }
     
     return pte;
 }
@@ -195,6 +203,12 @@ static uint64_t riscv_pte_to_attrs(uint64_t pte) {
     if (pte & RISCV_PTE_X) attrs |= VMM_ATTR_EXECUTE;
     if (pte & RISCV_PTE_U) attrs |= VMM_ATTR_USER;
     
+    if ((pte & RISCV_PTE_PBMT_MASK) == RISCV_PTE_PBMT_IO) {
+        attrs |= VMM_ATTR_DEVICE;
+    } else if ((pte & RISCV_PTE_PBMT_MASK) == RISCV_PTE_PBMT_NC) {
+        attrs |= VMM_ATTR_NOCACHE;
+    }
+    
     return attrs;
 }
 
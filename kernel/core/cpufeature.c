@@ -0,0 +1,35 @@
+/*
+ * kernel/core/cpufeature.c
+ *
+ * CPU feature bits and their static keys
+ */
+
+#include <cpufeature.h>
+#include <uart.h>
+
+uint64_t cpu_feature_bits = 0;
+struct static_key cpu_feature_keys[CPU_FEATURE_COUNT];
+
+void cpufeature_init(void) {
+    cpu_feature_bits = arch_cpufeature_detect();
+
+    for (unsigned int f = 0; f < CPU_FEATURE_COUNT; f++) {
+        if (cpu_has_feature(f)) {
+            static_key_enable(&cpu_feature_keys[f]);
+        }
+    }
+}
+
+void cpufeature_print(void) {
+    uart_puts("CPU features:");
+    for (unsigned int f = 0; f < CPU_FEATURE_COUNT; f++) {
+        if (cpu_has_feature(f)) {
+            uart_puts(" ");
+            uart_puts(cpu_feature_names[f]);
+        }
+    }
+    if (!cpu_feature_bits) {
+        uart_puts(" none");
+    }
+    uart_puts("\n");
+}
@@ -10,8 +10,13 @@
 #include <uart.h>
 #include <arch_interface.h>
 #include <panic.h>
+#include <cpufeature.h>
 #include <memory/pmm.h>
 #include <memory/memmap.h>
+#include <memory/clear_page.h>
+#include <memory/cpu_cache.h>
+#include <memory/dma.h>
+#include <lib/checksum.h>
 #include <exceptions/exceptions.h>
 #include <drivers/fdt.h>
 #include <drivers/fdt_mgr.h>
@@ -22,6 +27,17 @@
 #include <drivers/driver.h>
 #include <drivers/uart_drivers.h>
 #include <irqchip/irqchip.h>
+#include <irq/irq_stack.h>
+#include <smp.h>
+#include <percpu.h>
+#include <spinlock.h>
+#include <sched.h>
+#include <workqueue.h>
+#include <time/timekeeping.h>
+#include <time/tick.h>
+#ifdef __riscv
+#include <arch_vector.h>
+#endif
 // #include <tests/mmu_tests.h>
 // #include <tests/pmm_tests.h>
 // #include <tests/memory_tests.h>
@@ -37,6 +53,21 @@
 #include <tests/page_alloc_tests.h>
 #include <tests/page_alloc_stress.h>
 #include <tests/irq_tests.h>
+#include <tests/lock_bench.h>
+#include <tests/atomic_tests.h>
+#include <tests/rcu_tests.h>
+#include <tests/sched_tests.h>
+#include <tests/workqueue_tests.h>
+#include <tests/timer_tests.h>
+#include <tests/smp_tests.h>
+#include <tests/ring_tests.h>
+#include <tests/string_tests.h>
+#include <tests/fdt_string_bench.h>
+#include <tests/clear_page_bench.h>
+#include <tests/crc32_bench.h>
+#include <tests/bitops_tests.h>
+#include <tests/dma_tests.h>
+#include <tests/simd_tests.h>
 
 // External symbols from linker script
 extern char __kernel_start;
@@ -49,6 +80,24 @@ void kernel_main(void* dtb) {
         // Cannot output warning - UART not available yet
     }
     
+    // Optional ISA features; patches their static branches in while this
+    // is still the only CPU running
+    cpufeature_init();
+    
+    // Cache line size, and on RISC-V whether Zicbom range operations are needed
+    cpu_cache_init();
+    
+    // Pick DC ZVA / cbo.zero for page clearing before PMM hands out pages
+    clear_page_init();
+    
+    // CRC tables, before the first FDT integrity check
+    crc32_init();
+    
+#ifdef __riscv
+    // Vector unit for kernel_vector_begin() and the RVV string routines
+    riscv_vector_init();
+#endif
+    
     // Initialize memory subsystems 
     memmap_init();
     
@@ -58,6 +107,14 @@ void kernel_main(void* dtb) {
         panic("Failed to parse memory information from FDT");
     }
     
+    // RAM is what devices may DMA to; the DMA API asks memmap
+    for (int i = 0; i < mem_info.count; i++) {
+        memmap_add_region(mem_info.regions[i].base, mem_info.regions[i].size,
+                          MEM_TYPE_FREE,
+                          MEM_ATTR_CACHEABLE | MEM_ATTR_WRITE_BACK | MEM_ATTR_DMA_CAPABLE,
+                          "RAM");
+    }
+    
     // Initialize PMM
     pmm_init((uint64_t)&_kernel_end, (struct memory_info *)&mem_info);
     
@@ -80,6 +137,11 @@ void kernel_main(void* dtb) {
         panic("Failed to map FDT to virtual memory");
     }
     
+    // Enumerate CPUs and give each secondary its own per-CPU area.
+    // Must happen before the allocators start updating per-CPU counters.
+    smp_init_cpus(fdt_mgr_get_blob());
+    percpu_init();
+    
     // Initialize device subsystem (pool, tree parser, enumeration)
     int device_count = device_init(fdt_mgr_get_blob());
     if (device_count < 0) {
@@ -91,6 +153,9 @@ void kernel_main(void* dtb) {
     // Now devmap_init can use the discovered devices
     devmap_init();
     
+    // Bounce buffers and the uncached coherent pool, before drivers probe
+    dma_init();
+    
     // Initialize driver subsystem
     driver_init();
     
@@ -144,6 +209,16 @@ void kernel_main(void* dtb) {
     // Report FDT manager state
     fdt_mgr_print_info();
     
+    cpufeature_print();
+    
+    // System counter as the time base for ktime_get_ns(); before this
+    // every timestamp reads 0
+    uart_puts("\nInitializing timekeeping...\n");
+    timekeeping_init();
+    
+    // Interrupt handlers run on a stack of their own on every CPU
+    irq_stack_init();
+    
     // Initialize exception handling (architecture-agnostic)
     uart_puts("\nInitializing exception handling...\n");
     exception_init();
@@ -152,6 +227,19 @@ void kernel_main(void* dtb) {
     uart_puts("\nInitializing interrupt controllers...\n");
     irqchip_init();
     
+    // Run queues for every CPU; this context becomes CPU 0's first thread
+    sched_init();
+    
+    // Call queues and the IPI that kicks them, before any secondary runs
+    smp_ipi_init();
+    
+    // Bring up secondary CPUs (they idle until there is work for them)
+    uart_puts("\nStarting secondary CPUs...\n");
+    smp_boot_secondaries();
+    
+    // A worker thread on every online CPU for queue_work()/parallel_for()
+    workqueue_init();
+    
     // Print device mappings
     // devmap_print_mappings();
     
@@ -192,13 +280,80 @@ void kernel_main(void* dtb) {
     // Stress tests last (most intensive)
     // page_alloc_stress_tests();  
     
+    // Atomic operations (also exercised across all online CPUs)
+    // run_atomic_tests();
+    
+    // RCU grace periods and lockless readers (uses secondary CPUs if present)
+    // run_rcu_tests();
+    
+    // Spinlock contention benchmark (needs secondary CPUs, e.g. SMP=8)
+    // run_lock_benchmarks();
+    
     // Run all IRQ subsystem tests
     run_all_irq_tests();
+    
+    // Per-site lock statistics (only populated when built with LOCK_STAT=1)
+    // lock_stat_dump();
 
     uart_puts("\nKernel initialization complete!\n");
-    uart_puts("System halted.\n");
     
-    while (1) {
-        arch_cpu_wait();
-    }
+    // Clock events, hrtimers and the periodic tick. After the IRQ tests,
+    // which borrow the timer interrupt themselves.
+    tick_init();
+    
+    // Kernel threads, sleep/wakeup and preemption
+    // run_sched_tests();
+    
+    // Context switch latency benchmark
+    // run_sched_benchmarks();
+    
+    // Work-stealing workqueues and parallel_for (uses secondary CPUs if present)
+    // run_workqueue_tests();
+    
+    // Timekeeping, timer wheel and hrtimers
+    // run_timer_tests();
+    
+    // Cost of ktime_get_ns(), alone and on every CPU at once
+    // run_ktime_benchmarks();
+    
+    // Cost of reprogramming the timer (SBI against Sstc on RISC-V)
+    // run_clockevent_benchmarks();
+    
+    // IPIs, cross-CPU calls and TLB shootdown (needs secondary CPUs)
+    // run_smp_tests();
+    
+    // SPSC/MPSC ring buffers (stress tests need secondary CPUs)
+    // run_ring_tests();
+    
+    // Ring buffer throughput, same CPU and cross-CPU
+    // run_ring_benchmarks();
+    
+    // IRQ stack use and interrupt entry/exit cost (self-IPI round trip)
+    // run_irq_benchmarks();
+    
+    // memcpy/memmove/memset at every alignment, then throughput by size
+    // run_string_tests();
+    // run_string_benchmarks();
+    
+    // Device tree walk with byte-at-a-time and word-at-a-time strings
+    // run_fdt_string_benchmarks();
+    
+    // Page zeroing: DC ZVA / cbo.zero against the store loop, in GB/s
+    // run_clear_page_benchmarks();
+    
+    // CRC-32/CRC-32C: known answers, then instructions against the tables
+    // run_crc32_benchmarks();
+    
+    // ctz/clz/popcount and the bitmap searches against bit-by-bit loops
+    // run_bitops_tests();
+    
+    // DMA mapping: in-place maps, bounce buffers, scatter-gather, coherent pool
+    // run_dma_tests();
+    
+    // Kernel-mode SIMD sections and the bitmap/checksum/memcpy users
+    // run_simd_tests();
+    
+    // Nothing left for the boot thread; CPU 0 idles in the scheduler
+    uart_puts("Boot thread exiting.\n");
+    kthread_exit();
 }
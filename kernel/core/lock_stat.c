@@ -0,0 +1,88 @@
+/*
+ * kernel/core/lock_stat.c
+ *
+ * Spinlock statistics registry (CONFIG_LOCK_STAT)
+ */
+
+#include <spinlock.h>
+
+#if CONFIG_LOCK_STAT
+
+#include <atomic.h>
+#include <arch_cpu.h>
+#include <uart.h>
+
+// Distinct lock sites tracked; later sites share the overflow entry
+#define LOCK_STAT_MAX_SITES 64
+
+static struct lock_stat lock_stats[LOCK_STAT_MAX_SITES];
+static struct lock_stat lock_stat_overflow = { .site = "(other)" };
+static unsigned int lock_stat_count;
+
+// Raw lock: taking a spinlock_t here would recurse into the stats code
+static arch_spinlock_t lock_stat_lock = ARCH_SPINLOCK_INITIALIZER;
+
+struct lock_stat *lock_stat_lookup(const char *site) {
+    struct lock_stat *stat = NULL;
+    uint64_t flags = arch_save_interrupts();
+
+    arch_spin_lock(&lock_stat_lock);
+    for (unsigned int i = 0; i < lock_stat_count; i++) {
+        if (lock_stats[i].site == site) {
+            stat = &lock_stats[i];
+            break;
+        }
+    }
+    if (!stat) {
+        if (lock_stat_count < LOCK_STAT_MAX_SITES) {
+            stat = &lock_stats[lock_stat_count++];
+            stat->site = site;
+        } else {
+            stat = &lock_stat_overflow;
+        }
+    }
+    arch_spin_unlock(&lock_stat_lock);
+
+    arch_restore_interrupts(flags);
+    return stat;
+}
+
+static void lock_stat_print(struct lock_stat *stat) {
+    uint64_t acq = atomic64_read(&stat->acquisitions);
+
+    if (acq == 0) {
+        return;
+    }
+
+    uart_puts("  ");
+    uart_puts(stat->site);
+    uart_puts(": ");
+    uart_putdec(acq);
+    uart_puts(" acquired, ");
+    uart_putdec(atomic64_read(&stat->contended));
+    uart_puts(" contended, max hold ");
+    uart_putdec(atomic64_read(&stat->max_hold));
+    uart_puts(" ns\n");
+}
+
+void lock_stat_dump(void) {
+    uart_puts("\nLock statistics (by first acquiring function):\n");
+    for (unsigned int i = 0; i < lock_stat_count; i++) {
+        lock_stat_print(&lock_stats[i]);
+    }
+    lock_stat_print(&lock_stat_overflow);
+}
+
+// Zero the counters but keep the sites, so locks already bound stay valid
+void lock_stat_reset(void) {
+    for (unsigned int i = 0; i < lock_stat_count; i++) {
+        atomic64_set(&lock_stats[i].acquisitions, 0);
+        atomic64_set(&lock_stats[i].contended, 0);
+        atomic64_set(&lock_stats[i].max_hold, 0);
+    }
+    atomic64_set(&lock_stat_overflow.acquisitions, 0);
+    atomic64_set(&lock_stat_overflow.contended, 0);
+    atomic64_set(&lock_stat_overflow.max_hold, 0);
+}
+
+#endif /* CONFIG_LOCK_STAT */
@@ -0,0 +1,58 @@
+/*
+ * kernel/core/percpu.c
+ *
+ * Per-CPU data area setup
+ */
+
+#include <percpu.h>
+#include <smp.h>
+#include <memory/pmm.h>
+#include <memory/vmparam.h>
+#include <panic.h>
+#include <uart.h>
+#include <string.h>
+
+// Offset of each CPU's area from the .percpu template (CPU 0 uses it in place)
+uintptr_t __per_cpu_offset[NR_CPUS];
+
+DEFINE_PER_CPU(unsigned int, cpu_number) = 0;
+
+// Allocate per-CPU areas for the secondary CPUs
+//
+// Must run after smp_init_cpus() and vmm_create_dmap(), and before
+// anything updates per-CPU state on the boot CPU: the secondary areas
+// are copied from the template, which is also the boot CPU's live area.
+void percpu_init(void) {
+    size_t size = (size_t)(__per_cpu_end - __per_cpu_start);
+    size_t pages = (size + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE;
+
+    __per_cpu_offset[0] = 0;
+
+    if (size == 0) {
+        return;
+    }
+
+    for (unsigned int cpu = 1; cpu < nr_cpu_ids; cpu++) {
+        uint64_t phys = pmm_alloc_pages(pages);
+        if (phys == 0) {
+            panic("percpu: failed to allocate per-CPU area");
+        }
+
+        char *area = (char *)PHYS_TO_DMAP(phys);
+        memcpy(area, __per_cpu_start, size);
+
+        __per_cpu_offset[cpu] = (uintptr_t)area - (uintptr_t)__per_cpu_start;
+        per_cpu(cpu_number, cpu) = cpu;
+    }
+
+    uart_puts("PERCPU: ");
+    uart_putdec(size);
+    uart_puts(" bytes per CPU, ");
+    uart_putdec(nr_cpu_ids);
+    uart_puts(" area(s)\n");
+}
+
+// Load the per-CPU base register for the calling CPU
+void percpu_setup_cpu(unsigned int cpu) {
+    arch_set_percpu_offset(__per_cpu_offset[cpu]);
+}
@@ -0,0 +1,100 @@
+/*
+ * kernel/core/qspinlock.c
+ *
+ * Queued spinlock slow path
+ */
+
+#include <qspinlock.h>
+#include <percpu.h>
+#include <arch_timer.h>
+#include <stddef.h>
+
+struct qspin_node {
+    struct qspin_node *volatile next;
+    volatile uint32_t locked;       // Set by our predecessor on hand-off
+    uint32_t count;                 // Nodes in use on this CPU (node 0 only)
+};
+
+// One node per nesting level, so an interrupt handler that spins on a
+// lock while the interrupted code is queued on another gets its own node
+static DEFINE_PER_CPU_ALIGNED(struct qspin_node, qspin_nodes[QSPIN_MAX_NODES]);
+
+static inline uint32_t encode_tail(unsigned int cpu, unsigned int idx) {
+    return ((cpu + 1) << _Q_TAIL_CPU_OFFSET) | (idx << _Q_TAIL_IDX_OFFSET);
+}
+
+static inline struct qspin_node *decode_tail(uint32_t tail) {
+    unsigned int cpu = (tail >> _Q_TAIL_CPU_OFFSET) - 1;
+    unsigned int idx = (tail >> _Q_TAIL_IDX_OFFSET) & (QSPIN_MAX_NODES - 1);
+
+    return &(*per_cpu_ptr(qspin_nodes, cpu))[idx];
+}
+
+void queued_spin_lock_slowpath(qspinlock_t *lock) {
+    struct qspin_node *node = *this_cpu_ptr(qspin_nodes);
+    unsigned int idx = node->count++;
+    struct qspin_node *next;
+    uint32_t tail, old, prev, val;
+
+    // Nested deeper than we have nodes for: fall back to spinning on the
+    // lock word. Can only happen with exceptions nested beyond IRQs.
+    // qspin_lock() has already disabled preemption, so take the lock
+    // word directly rather than through qspin_trylock().
+    if (idx >= QSPIN_MAX_NODES) {
+        while (__atomic_load_n(&lock->val, __ATOMIC_RELAXED) != 0 ||
+               arch_spin_cmpxchg_acquire(&lock->val, 0, _Q_LOCKED_VAL) != 0) {
+            arch_cpu_relax();
+        }
+        goto release;
+    }
+
+    tail = encode_tail(smp_processor_id(), idx);
+    node += idx;
+    node->next = NULL;
+    node->locked = 0;
+
+    // Publish ourselves as the new tail, keeping the locked byte. The
+    // fully ordered swap makes the node initialisation visible before
+    // anyone can find it through the tail.
+    old = lock->val;
+    for (;;) {
+        prev = arch_spin_cmpxchg(&lock->val, old, (old & _Q_LOCKED_MASK) | tail);
+        if (prev == old) {
+            break;
+        }
+        old = prev;
+    }
+
+    // Link behind the previous tail and wait for it to hand us the queue head
+    if (old & _Q_TAIL_MASK) {
+        struct qspin_node *pred = decode_tail(old);
+
+        pred->next = node;
+        while (!__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE)) {
+            arch_cpu_relax();
+        }
+    }
+
+    // Queue head: wait for the holder to drop the locked byte
+    while ((val = __atomic_load_n(&lock->val, __ATOMIC_ACQUIRE)) & _Q_LOCKED_MASK) {
+        arch_cpu_relax();
+    }
+
+    // If nobody queued behind us, take the lock and empty the queue in one go
+    if ((val & _Q_TAIL_MASK) == tail &&
+        arch_spin_cmpxchg_acquire(&lock->val, val, _Q_LOCKED_VAL) == val) {
+        goto release;
+    }
+
+    // Otherwise just set the locked byte; with a non-empty tail nobody can
+    // take the lock from under us
+    lock->locked = _Q_LOCKED_VAL;
+
+    while ((next = node->next) == NULL) {
+        arch_cpu_relax();
+    }
+    __atomic_store_n(&next->locked, 1, __ATOMIC_RELEASE);
+
+release:
+    (*this_cpu_ptr(qspin_nodes))[0].count--;
+}
@@ -0,0 +1,154 @@
+/*
+ * kernel/core/rcu.c
+ *
+ * Quiescent-state based RCU
+ */
+
+#include <rcu.h>
+#include <atomic.h>
+#include <percpu.h>
+#include <smp.h>
+#include <arch_cpu.h>
+#include <arch_timer.h>
+#include <stddef.h>
+
+struct rcu_data {
+    volatile uint64_t qs_seq;       // Latest grace period this CPU has passed
+    volatile bool idle;             // In an extended quiescent state
+    struct rcu_head *next_list;     // Queued, no grace period started yet
+    struct rcu_head *wait_list;     // Waiting for wait_gp to end
+    uint64_t wait_gp;
+};
+
+static DEFINE_PER_CPU_ALIGNED(struct rcu_data, rcu_data);
+
+// Number of the most recently started grace period
+static atomic64_t rcu_gp_seq;
+
+static inline void rcu_mb(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// Record that this CPU has passed through a quiescent state. Reading the
+// sequence with acquire ordering means read-side sections that start
+// after this point see every update made before that grace period began.
+static void rcu_report_qs(struct rcu_data *rd) {
+    rcu_mb();
+    __atomic_store_n(&rd->qs_seq, (uint64_t)atomic64_read_acquire(&rcu_gp_seq),
+                     __ATOMIC_RELEASE);
+}
+
+// Has every online CPU passed a quiescent state since grace period gp began?
+static bool rcu_gp_done(uint64_t gp) {
+    unsigned int cpu;
+
+    rcu_mb();
+    for_each_online_cpu(cpu) {
+        struct rcu_data *rd = per_cpu_ptr(rcu_data, cpu);
+
+        if (__atomic_load_n(&rd->idle, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        if (__atomic_load_n(&rd->qs_seq, __ATOMIC_ACQUIRE) < gp) {
+            return false;
+        }
+    }
+    rcu_mb();
+    return true;
+}
+
+static void rcu_invoke_callbacks(struct rcu_head *list) {
+    while (list) {
+        struct rcu_head *next = list->next;
+        list->func(list);
+        list = next;
+    }
+}
+
+void synchronize_rcu(void) {
+    // Fully ordered: the caller's updates are visible before the new
+    // grace period number is
+    uint64_t gp = atomic64_inc_return(&rcu_gp_seq);
+
+    // The caller is outside any read-side section by definition. Keep
+    // reporting while waiting so a concurrent synchronize_rcu() on
+    // another CPU is not held up by this one.
+    struct rcu_data *rd = this_cpu_ptr(rcu_data);
+
+    rcu_report_qs(rd);
+    while (!rcu_gp_done(gp)) {
+        arch_cpu_relax();
+        rcu_report_qs(rd);
+    }
+}
+
+void call_rcu(struct rcu_head *head, rcu_callback_t func) {
+    uint64_t flags = arch_save_interrupts();
+    struct rcu_data *rd = this_cpu_ptr(rcu_data);
+
+    head->func = func;
+    head->next = rd->next_list;
+    rd->next_list = head;
+
+    arch_restore_interrupts(flags);
+}
+
+void rcu_quiescent_state(void) {
+    uint64_t flags = arch_save_interrupts();
+    struct rcu_data *rd = this_cpu_ptr(rcu_data);
+    struct rcu_head *done = NULL;
+
+    rcu_report_qs(rd);
+
+    // Collect the batch whose grace period has ended
+    if (rd->wait_list && rcu_gp_done(rd->wait_gp)) {
+        done = rd->wait_list;
+        rd->wait_list = NULL;
+    }
+
+    // Start a grace period for callbacks queued since the last one
+    if (!rd->wait_list && rd->next_list) {
+        rd->wait_list = rd->next_list;
+        rd->next_list = NULL;
+        rd->wait_gp = atomic64_inc_return(&rcu_gp_seq);
+        rcu_report_qs(rd);
+    }
+
+    arch_restore_interrupts(flags);
+
+    // Callbacks run with interrupts in the caller's state; they may
+    // queue further callbacks
+    rcu_invoke_callbacks(done);
+}
+
+void rcu_note_context_switch(void) {
+    rcu_report_qs(this_cpu_ptr(rcu_data));
+}
+
+bool rcu_pending(void) {
+    struct rcu_data *rd = this_cpu_ptr(rcu_data);
+    return rd->next_list != NULL || rd->wait_list != NULL;
+}
+
+void rcu_barrier(void) {
+    while (rcu_pending()) {
+        rcu_quiescent_state();
+        arch_cpu_relax();
+    }
+}
+
+void rcu_idle_enter(void) {
+    struct rcu_data *rd = this_cpu_ptr(rcu_data);
+
+    rcu_mb();
+    __atomic_store_n(&rd->idle, true, __ATOMIC_RELEASE);
+}
+
+void rcu_idle_exit(void) {
+    struct rcu_data *rd = this_cpu_ptr(rcu_data);
+
+    // Pairs with the barrier in rcu_gp_done(): either the updater sees
+    // us busy and waits, or our next reads see its update
+    __atomic_store_n(&rd->idle, false, __ATOMIC_RELAXED);
+    rcu_mb();
+}
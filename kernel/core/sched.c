@@ -0,0 +1,443 @@
+/*
+ * kernel/core/sched.c
+ *
+ * Per-CPU run queues, context switching and kernel threads
+ */
+
+#include <sched.h>
+#include <preempt.h>
+#include <rcu.h>
+#include <smp.h>
+#include <percpu.h>
+#include <arch_spinlock.h>
+#include <arch_cpu.h>
+#include <arch_timer.h>
+#include <time/timer.h>
+#include <time/tick.h>
+#include <memory/kmalloc.h>
+#include <memory/slab.h>
+#include <memory/pmm.h>
+#include <memory/vmparam.h>
+#include <lib/bitops.h>
+#include <panic.h>
+#include <uart.h>
+
+struct runqueue {
+    arch_spinlock_t lock;                   // Raw: spinlock_t would recurse into preempt_count
+    uint32_t bitmap;                        // Bit n set: queue[n] is not empty
+    struct list_head queue[SCHED_NR_PRIO];
+    struct task *curr;
+    struct task *idle;
+    unsigned int nr_running;                // Queued, not counting curr
+    volatile bool need_resched;
+    bool tick_qs;                           // Tick hit preemptible code
+    uint64_t nr_switches;
+};
+
+static DEFINE_PER_CPU_ALIGNED(struct runqueue, runqueues);
+
+DEFINE_PER_CPU(struct task *, current_task);
+DEFINE_PER_CPU(int, preempt_count);
+
+// kernel_main's context on the boot CPU
+static struct task boot_task = {
+    .state = TASK_RUNNING,
+    .prio = SCHED_PRIO_DEFAULT,
+    .flags = TASK_FLAG_STATIC,
+    .name = "kmain",
+};
+
+// Secondary CPUs' boot contexts become their idle tasks
+static struct task secondary_idle_tasks[NR_CPUS];
+
+static void rq_enqueue(struct runqueue *rq, struct task *task) {
+    list_add_tail(&task->run_list, &rq->queue[task->prio]);
+    rq->bitmap |= 1U << task->prio;
+    rq->nr_running++;
+    task->on_rq = true;
+}
+
+static void rq_dequeue(struct runqueue *rq, struct task *task) {
+    list_del(&task->run_list);
+    if (list_empty(&rq->queue[task->prio])) {
+        rq->bitmap &= ~(1U << task->prio);
+    }
+    rq->nr_running--;
+    task->on_rq = false;
+}
+
+// Highest-priority queued task, or idle. O(1): one find-first-set.
+static struct task *rq_pick_next(struct runqueue *rq) {
+    if (!rq->bitmap) {
+        return rq->idle;
+    }
+
+    int prio = ctz32(rq->bitmap);
+    struct task *next = list_entry(rq->queue[prio].next, struct task, run_list);
+    rq_dequeue(rq, next);
+    return next;
+}
+
+// Runs on the new task's stack right after every switch
+static void sched_finish_switch(struct task *prev) {
+    if (prev->state == TASK_DEAD && !(prev->flags & TASK_FLAG_STATIC)) {
+        pmm_free_pages(prev->stack_phys, KTHREAD_STACK_PAGES);
+        kfree(prev);
+    }
+}
+
+void schedule(void) {
+    struct runqueue *rq;
+    struct task *prev, *next;
+    uint64_t flags;
+
+    if (preempt_count_get() != 0) {
+        panic("schedule() called with preemption disabled");
+    }
+
+    flags = arch_save_interrupts();
+    rq = this_cpu_ptr(runqueues);
+    prev = rq->curr;
+
+    arch_spin_lock(&rq->lock);
+    rq->need_resched = false;
+    // A waker may already have queued prev if it raced with prev going
+    // to sleep; see wake_up_process()
+    if (prev->state == TASK_RUNNING && !prev->on_rq &&
+        !(prev->flags & TASK_FLAG_IDLE)) {
+        rq_enqueue(rq, prev);
+    }
+    next = rq_pick_next(rq);
+    rq->curr = next;
+    arch_spin_unlock(&rq->lock);
+
+    // Dropping the lock before the switch is safe: only this CPU takes
+    // tasks off its queue, so prev cannot be picked until it is saved
+    if (next != prev) {
+        next->timeslice = SCHED_TIMESLICE;
+        next->nr_switches++;
+        rq->nr_switches++;
+        __this_cpu_write(current_task, next);
+
+        // No preempt_disable() section spans a switch, so this CPU holds
+        // no RCU-protected pointers here
+        rcu_note_context_switch();
+
+        prev = arch_switch_to(prev, next);
+        sched_finish_switch(prev);
+    }
+
+    arch_restore_interrupts(flags);
+}
+
+void sched_yield(void) {
+    schedule();
+}
+
+bool wake_up_process(struct task *task) {
+    struct runqueue *rq = per_cpu_ptr(runqueues, task->cpu);
+    bool woken = false;
+    bool resched = false;
+    bool local = task->cpu == smp_processor_id();
+    uint64_t flags = arch_save_interrupts();
+
+    arch_spin_lock(&rq->lock);
+    if (task->state != TASK_RUNNING) {
+        task->state = TASK_RUNNING;
+        // Still current means it has not reached schedule() yet; it will
+        // see TASK_RUNNING there and stay runnable
+        if (!task->on_rq && task != rq->curr) {
+            rq_enqueue(rq, task);
+            if (task->prio < rq->curr->prio) {
+                rq->need_resched = true;
+                resched = true;
+            }
+        }
+        woken = true;
+    }
+    arch_spin_unlock(&rq->lock);
+
+    arch_restore_interrupts(flags);
+
+    if (!woken) {
+        return false;
+    }
+
+    if (!local) {
+        // Interrupt the CPU only if it has to switch: out of idle, or off
+        // a lower-priority thread. Otherwise it gets there by itself.
+        if (resched) {
+            smp_send_reschedule(task->cpu);
+        }
+    } else {
+        sched_preempt_point();
+    }
+    return true;
+}
+
+void sched_preempt_point(void) {
+    if (this_cpu_ptr(runqueues)->need_resched && preemptible()) {
+        schedule();
+    }
+}
+
+bool sched_cpu_has_work(void) {
+    return this_cpu_ptr(runqueues)->bitmap != 0;
+}
+
+static void kthread_entry(struct task *prev) {
+    struct task *self = get_current();
+
+    sched_finish_switch(prev);
+    arch_enable_interrupts();
+
+    self->fn(self->arg);
+    kthread_exit();
+}
+
+struct task *kthread_create_on_cpu(void (*fn)(void *), void *arg,
+                                   const char *name, unsigned int cpu) {
+    struct task *task;
+    uint64_t stack_phys;
+
+    if (cpu >= nr_cpu_ids || !cpu_online(cpu)) {
+        return NULL;
+    }
+
+    task = kmalloc(sizeof(struct task), KM_ZERO);
+    if (!task) {
+        return NULL;
+    }
+
+    stack_phys = pmm_alloc_pages(KTHREAD_STACK_PAGES);
+    if (stack_phys == 0) {
+        kfree(task);
+        return NULL;
+    }
+
+    arch_thread_init(&task->ctx,
+                     PHYS_TO_DMAP(stack_phys) + KTHREAD_STACK_PAGES * PMM_PAGE_SIZE,
+                     (uintptr_t)kthread_entry);
+    task->state = TASK_SLEEPING;
+    task->prio = SCHED_PRIO_DEFAULT;
+    task->cpu = cpu;
+    task->timeslice = SCHED_TIMESLICE;
+    task->fn = fn;
+    task->arg = arg;
+    task->stack_phys = stack_phys;
+    task->name = name;
+    list_init(&task->run_list);
+
+    return task;
+}
+
+struct task *kthread_create(void (*fn)(void *), void *arg, const char *name) {
+    return kthread_create_on_cpu(fn, arg, name, smp_processor_id());
+}
+
+struct task *kthread_run(void (*fn)(void *), void *arg, const char *name) {
+    struct task *task = kthread_create(fn, arg, name);
+
+    if (task) {
+        wake_up_process(task);
+    }
+    return task;
+}
+
+void kthread_set_prio(struct task *task, int prio) {
+    if (prio < 0) {
+        prio = 0;
+    } else if (prio > SCHED_PRIO_MIN) {
+        prio = SCHED_PRIO_MIN;
+    }
+    task->prio = prio;
+}
+
+void kthread_exit(void) {
+    set_current_state(TASK_DEAD);
+    schedule();
+    panic("kthread_exit: dead task was scheduled");
+    while (1) {
+    }
+}
+
+struct sleep_timer {
+    struct timer_list timer;
+    struct task *task;
+};
+
+static void sleep_timer_fn(struct timer_list *timer) {
+    wake_up_process(container_of(timer, struct sleep_timer, timer)->task);
+}
+
+void sleep_ticks(uint64_t ticks) {
+    struct sleep_timer st;
+
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    // Before the tick runs nothing would wake us: spin instead
+    if (!tick_is_running()) {
+        uint64_t end = ktime_get_ns() + ticks * TICK_NSEC;
+        while (ktime_get_ns() < end) {
+            arch_cpu_relax();
+        }
+        return;
+    }
+
+    timer_setup(&st.timer, sleep_timer_fn);
+    st.task = get_current();
+
+    // The current tick is already partly over: wait for one more so the
+    // sleep is never shorter than asked
+    set_current_state(TASK_SLEEPING);
+    mod_timer(&st.timer, jiffies + ticks + 1);
+
+    schedule();
+
+    // Woken early by someone else
+    del_timer_sync(&st.timer);
+}
+
+void msleep(uint64_t ms) {
+    sleep_ticks(msecs_to_jiffies(ms));
+}
+
+void sched_tick(void) {
+    struct runqueue *rq = this_cpu_ptr(runqueues);
+    struct task *curr = rq->curr;
+
+    if (!curr) {
+        return;
+    }
+
+    // The interrupted code was preemptible, so it held no RCU-protected
+    // pointers; reported at IRQ exit, once the handler's own are dropped
+    if (preempt_count_get() == 0) {
+        rq->tick_qs = true;
+    }
+
+    if (curr == rq->idle) {
+        if (rq->bitmap) {
+            rq->need_resched = true;
+        }
+        return;
+    }
+
+    if (--curr->timeslice <= 0) {
+        // Only switch if someone of the same or higher priority is waiting
+        if (rq->bitmap && (int)ctz32(rq->bitmap) <= curr->prio) {
+            rq->need_resched = true;
+        } else {
+            curr->timeslice = SCHED_TIMESLICE;
+        }
+    }
+}
+
+void sched_irq_exit(void) {
+    struct runqueue *rq = this_cpu_ptr(runqueues);
+
+    if (preempt_count_get() != 0) {
+        return;
+    }
+
+    if (rq->tick_qs) {
+        rq->tick_qs = false;
+        rcu_note_context_switch();
+    }
+
+    if (rq->need_resched) {
+        schedule();
+    }
+}
+
+// CPU 0's idle thread. Secondaries idle in secondary_start_kernel().
+static void sched_idle_loop(void *arg) {
+    struct runqueue *rq = this_cpu_ptr(runqueues);
+
+    (void)arg;
+
+    while (1) {
+        smp_poll_call_queue();
+        rcu_quiescent_state();
+
+        // Check and sleep with interrupts masked so a wakeup between the
+        // two cannot be lost; the interrupt is taken on restore
+        uint64_t flags = arch_save_interrupts();
+        if (!rq->need_resched && !rq->bitmap) {
+            tick_nohz_idle_enter();
+            rcu_idle_enter();
+            arch_cpu_idle();
+            rcu_idle_exit();
+            tick_nohz_idle_exit();
+        }
+        arch_restore_interrupts(flags);
+
+        if (rq->need_resched || rq->bitmap) {
+            schedule();
+        }
+    }
+}
+
+static void rq_init(struct runqueue *rq) {
+    arch_spin_lock_init(&rq->lock);
+    rq->bitmap = 0;
+    for (int prio = 0; prio < SCHED_NR_PRIO; prio++) {
+        list_init(&rq->queue[prio]);
+    }
+    rq->curr = NULL;
+    rq->idle = NULL;
+    rq->nr_running = 0;
+    rq->need_resched = false;
+    rq->tick_qs = false;
+    rq->nr_switches = 0;
+}
+
+void sched_init(void) {
+    unsigned int cpu;
+    struct runqueue *rq;
+    struct task *idle;
+
+    for_each_possible_cpu(cpu) {
+        rq_init(per_cpu_ptr(runqueues, cpu));
+    }
+
+    rq = this_cpu_ptr(runqueues);
+    list_init(&boot_task.run_list);
+    rq->curr = &boot_task;
+    __this_cpu_write(current_task, &boot_task);
+
+    idle = kthread_create_on_cpu(sched_idle_loop, NULL, "idle", 0);
+    if (!idle) {
+        panic("sched: cannot create idle thread");
+    }
+    idle->flags |= TASK_FLAG_IDLE;
+    idle->prio = SCHED_NR_PRIO;         // Below every real priority
+    idle->state = TASK_RUNNING;
+    rq->idle = idle;
+
+    uart_puts("SCHED: ");
+    uart_putdec(SCHED_NR_PRIO);
+    uart_puts(" priorities, ");
+    uart_putdec(HZ);
+    uart_puts(" Hz tick, ");
+    uart_putdec(SCHED_TIMESLICE);
+    uart_puts("-tick timeslice\n");
+}
+
+void sched_init_secondary(unsigned int cpu) {
+    struct runqueue *rq = this_cpu_ptr(runqueues);
+    struct task *idle = &secondary_idle_tasks[cpu];
+
+    idle->state = TASK_RUNNING;
+    idle->prio = SCHED_NR_PRIO;
+    idle->cpu = cpu;
+    idle->flags = TASK_FLAG_IDLE | TASK_FLAG_STATIC;
+    idle->name = "idle";
+    list_init(&idle->run_list);
+
+    rq->idle = idle;
+    rq->curr = idle;
+    __this_cpu_write(current_task, idle);
+}
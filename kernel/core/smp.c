@@ -0,0 +1,473 @@
+/*
+ * kernel/core/smp.c
+ *
+ * Secondary CPU enumeration and bring-up, inter-processor interrupts
+ * and cross-CPU function calls
+ */
+
+#include <smp.h>
+#include <percpu.h>
+#include <arch_smp.h>
+#include <arch_timer.h>
+#include <arch_cpu.h>
+#include <rcu.h>
+#include <sched.h>
+#include <preempt.h>
+#include <atomic.h>
+#include <spinlock.h>
+#include <time/hrtimer.h>
+#include <time/timekeeping.h>
+#include <time/tick.h>
+#include <drivers/fdt.h>
+#include <memory/pmm.h>
+#include <memory/vmparam.h>
+#include <uart.h>
+#include <string.h>
+
+#define SMP_DEBUG 0
+
+// How long to wait for a secondary CPU to check in
+#define SMP_BOOT_TIMEOUT_MS 1000
+
+unsigned int nr_cpu_ids = 1;
+uint64_t cpu_hwid[NR_CPUS];
+
+// Set by each CPU once it is running kernel code
+static volatile bool cpu_online_flag[NR_CPUS] = { [0] = true };
+
+// Set once the boot CPU's IPI is wired up. Until then, and for good if
+// it never is, idle secondaries poll their call queue instead.
+static bool ipi_ready;
+
+// Messages waiting for this CPU, one bit per enum ipi_msg_type
+struct ipi_data {
+    atomic_t pending;
+    uint64_t count[NR_IPI];
+};
+
+static DEFINE_PER_CPU_ALIGNED(struct ipi_data, ipi_data);
+
+// Calls queued for this CPU
+struct call_queue {
+    spinlock_t lock;
+    struct list_head list;
+};
+
+static DEFINE_PER_CPU_ALIGNED(struct call_queue, call_queue);
+
+// This CPU's slots for the calls it makes, one per target CPU
+struct call_function_data {
+    struct call_single_data csd[NR_CPUS];
+};
+
+static DEFINE_PER_CPU(struct call_function_data, cfd_data);
+
+#define CSD_FLAG_LOCK   0x1             // Queued or running: not reusable
+#define CSD_FLAG_WAIT   0x2             // Caller waits for func to return
+
+bool cpu_online(unsigned int cpu) {
+    if (cpu >= NR_CPUS) {
+        return false;
+    }
+    return __atomic_load_n(&cpu_online_flag[cpu], __ATOMIC_ACQUIRE);
+}
+
+cpumask_t cpu_online_mask(void) {
+    cpumask_t mask = 0;
+    unsigned int cpu;
+
+    for_each_online_cpu(cpu) {
+        mask |= cpumask_of(cpu);
+    }
+    return mask;
+}
+
+unsigned int num_online_cpus(void) {
+    unsigned int count = 0;
+    unsigned int cpu;
+
+    for_each_online_cpu(cpu) {
+        count++;
+    }
+    return count;
+}
+
+// Read a cell-encoded value from a property
+static uint64_t smp_read_cells(const uint32_t *cells, int count) {
+    uint64_t val = 0;
+    for (int i = 0; i < count; i++) {
+        val = (val << 32) | fdt32_to_cpu(cells[i]);
+    }
+    return val;
+}
+
+// Enumerate /cpus; the boot CPU is always logical CPU 0
+void smp_init_cpus(void *fdt) {
+    uint64_t boot_hwid = arch_smp_boot_hwid();
+
+    cpu_hwid[0] = boot_hwid;
+    nr_cpu_ids = 1;
+
+    if (!fdt) {
+        return;
+    }
+
+    int cpus = fdt_path_offset(fdt, "/cpus");
+    if (cpus < 0) {
+        return;
+    }
+
+    int addr_cells = 1;
+    const uint32_t *prop = fdt_getprop(fdt, cpus, "#address-cells", NULL);
+    if (prop) {
+        addr_cells = fdt32_to_cpu(*prop);
+    }
+
+    int node;
+    fdt_for_each_subnode(node, fdt, cpus) {
+        int len;
+        const char *type = fdt_getprop(fdt, node, "device_type", NULL);
+        if (!type || strcmp(type, "cpu") != 0) {
+            continue;
+        }
+
+        const char *status = fdt_getprop(fdt, node, "status", NULL);
+        if (status && strcmp(status, "okay") != 0) {
+            continue;
+        }
+
+        const uint32_t *reg = fdt_getprop(fdt, node, "reg", &len);
+        if (!reg || len < addr_cells * 4) {
+            continue;
+        }
+
+        uint64_t hwid = smp_read_cells(reg, addr_cells);
+        if (hwid == boot_hwid) {
+            continue;
+        }
+
+        if (nr_cpu_ids >= NR_CPUS) {
+            uart_puts("SMP: more CPUs than NR_CPUS, ignoring the rest\n");
+            break;
+        }
+        cpu_hwid[nr_cpu_ids++] = hwid;
+    }
+
+    arch_smp_init(fdt);
+}
+
+// Wait for a CPU to mark itself online
+static bool smp_wait_for_cpu(unsigned int cpu) {
+    uint64_t deadline = ktime_get_ns() + SMP_BOOT_TIMEOUT_MS * NSEC_PER_MSEC;
+
+    while (!cpu_online(cpu)) {
+        if (ktime_get_ns() > deadline) {
+            return false;
+        }
+        arch_cpu_relax();
+    }
+    return true;
+}
+
+// Start every secondary CPU, one at a time
+void smp_boot_secondaries(void) {
+    for (unsigned int cpu = 1; cpu < nr_cpu_ids; cpu++) {
+        uint64_t stack_phys = pmm_alloc_pages(SMP_STACK_PAGES);
+        if (stack_phys == 0) {
+            uart_puts("SMP: no memory for CPU stack\n");
+            break;
+        }
+        uintptr_t stack_top = PHYS_TO_DMAP(stack_phys) + SMP_STACK_PAGES * PMM_PAGE_SIZE;
+
+#if SMP_DEBUG
+        uart_puts("SMP: starting CPU ");
+        uart_putdec(cpu);
+        uart_puts(" hwid ");
+        uart_puthex(cpu_hwid[cpu]);
+        uart_puts("\n");
+#endif
+
+        if (arch_smp_boot_cpu(cpu, cpu_hwid[cpu], stack_top) != 0) {
+            uart_puts("SMP: firmware refused to start CPU ");
+            uart_putdec(cpu);
+            uart_puts("\n");
+            pmm_free_pages(stack_phys, SMP_STACK_PAGES);
+            continue;
+        }
+
+        // On timeout the stack is deliberately leaked: the CPU may still
+        // show up late and start using it
+        if (!smp_wait_for_cpu(cpu)) {
+            uart_puts("SMP: CPU ");
+            uart_putdec(cpu);
+            uart_puts(" did not come online\n");
+        }
+    }
+
+    uart_puts("SMP: ");
+    uart_putdec(num_online_cpus());
+    uart_puts(" of ");
+    uart_putdec(nr_cpu_ids);
+    uart_puts(" CPUs online\n");
+}
+
+void smp_ipi_init(void) {
+    unsigned int cpu;
+
+    for_each_possible_cpu(cpu) {
+        struct call_queue *q = per_cpu_ptr(call_queue, cpu);
+
+        spin_lock_init(&q->lock);
+        list_init(&q->list);
+    }
+
+    if (nr_cpu_ids < 2) {
+        return;
+    }
+
+    if (arch_ipi_init() != 0) {
+        uart_puts("SMP: no IPI, idle CPUs will poll for work\n");
+        return;
+    }
+    ipi_ready = true;
+}
+
+bool smp_ipi_available(void) {
+    return ipi_ready;
+}
+
+void smp_send_ipi_mask(cpumask_t mask, enum ipi_msg_type msg) {
+    cpumask_t raise = 0;
+    unsigned int cpu;
+
+    // Nothing to raise: idle CPUs poll, and WFE wakes on the event
+    if (!ipi_ready) {
+        arch_smp_send_event();
+        return;
+    }
+
+    for_each_online_cpu(cpu) {
+        if (!(mask & cpumask_of(cpu))) {
+            continue;
+        }
+        // Fully ordered, so whatever the message refers to is visible
+        // first. If other messages were already pending, their interrupt
+        // has not been taken yet and will pick this one up too.
+        if (atomic_fetch_or(1 << msg, &per_cpu_ptr(ipi_data, cpu)->pending) == 0) {
+            raise |= cpumask_of(cpu);
+        }
+    }
+
+    if (raise) {
+        arch_send_ipi_mask(raise);
+    }
+}
+
+void smp_send_ipi(unsigned int cpu, enum ipi_msg_type msg) {
+    smp_send_ipi_mask(cpumask_of(cpu), msg);
+}
+
+void smp_send_reschedule(unsigned int cpu) {
+    smp_send_ipi(cpu, IPI_RESCHEDULE);
+}
+
+uint64_t smp_ipi_count(unsigned int cpu, enum ipi_msg_type msg) {
+    return per_cpu_ptr(ipi_data, cpu)->count[msg];
+}
+
+static bool call_queue_pending(void) {
+    struct call_queue *q = this_cpu_ptr(call_queue);
+
+    return __atomic_load_n(&q->list.next, __ATOMIC_ACQUIRE) != &q->list;
+}
+
+// Run everything queued for this CPU. Interrupts are masked.
+static void call_queue_flush(void) {
+    struct call_queue *q = this_cpu_ptr(call_queue);
+    struct list_head list;
+
+    list_init(&list);
+    spin_lock(&q->lock);
+    list_splice_tail_init(&q->list, &list);
+    spin_unlock(&q->lock);
+
+    while (!list_empty(&list)) {
+        struct call_single_data *csd = list_first_entry(&list, struct call_single_data, node);
+        smp_call_func_t func = csd->func;
+        void *arg = csd->arg;
+
+        list_del(&csd->node);
+
+        // A waiting caller owns the slot until func returns; otherwise
+        // hand it back first, so the caller can queue its next call
+        if (csd->flags & CSD_FLAG_WAIT) {
+            func(arg);
+            __atomic_store_n(&csd->flags, 0, __ATOMIC_RELEASE);
+        } else {
+            __atomic_store_n(&csd->flags, 0, __ATOMIC_RELEASE);
+            func(arg);
+        }
+    }
+}
+
+static void csd_lock_wait(struct call_single_data *csd) {
+    while (__atomic_load_n(&csd->flags, __ATOMIC_ACQUIRE) & CSD_FLAG_LOCK) {
+        // With interrupts off this CPU cannot take the IPI of a CPU that
+        // is in turn waiting on it; serve its calls here instead
+        if (!arch_interrupts_enabled()) {
+            call_queue_flush();
+        }
+        arch_cpu_relax();
+    }
+}
+
+void smp_ipi_interrupt(void) {
+    struct ipi_data *ipi = this_cpu_ptr(ipi_data);
+    int pending = atomic_xchg(&ipi->pending, 0);
+
+    for (int msg = 0; msg < NR_IPI; msg++) {
+        if (pending & (1 << msg)) {
+            ipi->count[msg]++;
+        }
+    }
+
+    if (pending & (1 << IPI_CALL_FUNC)) {
+        call_queue_flush();
+    }
+    if (pending & (1 << IPI_TIMER)) {
+        hrtimer_ipi();
+    }
+    if (pending & (1 << IPI_TICK)) {
+        tick_ipi();
+    }
+    // IPI_RESCHEDULE needs nothing here: the interrupt return path
+    // switches if the waker asked for it, and an idle CPU is already
+    // out of its sleep
+}
+
+void smp_poll_call_queue(void) {
+    uint64_t flags;
+
+    if (ipi_ready || !call_queue_pending()) {
+        return;
+    }
+
+    flags = arch_save_interrupts();
+    call_queue_flush();
+    arch_restore_interrupts(flags);
+}
+
+int smp_call_function_many(cpumask_t mask, smp_call_func_t func,
+                           void *arg, bool wait) {
+    struct call_function_data *cfd;
+    cpumask_t queued = 0;
+    unsigned int cpu, self;
+    int count = 0;
+
+    // Stay on this CPU's slots until the calls are queued (and done)
+    preempt_disable();
+    self = smp_processor_id();
+    cfd = this_cpu_ptr(cfd_data);
+
+    for_each_online_cpu(cpu) {
+        if (cpu == self || !(mask & cpumask_of(cpu))) {
+            continue;
+        }
+
+        struct call_single_data *csd = &cfd->csd[cpu];
+        struct call_queue *q = per_cpu_ptr(call_queue, cpu);
+        unsigned long flags;
+
+        // The last call from here to that CPU must be off its queue
+        csd_lock_wait(csd);
+        csd->func = func;
+        csd->arg = arg;
+        csd->flags = CSD_FLAG_LOCK | (wait ? CSD_FLAG_WAIT : 0);
+
+        spin_lock_irqsave(&q->lock, flags);
+        list_add_tail(&csd->node, &q->list);
+        spin_unlock_irqrestore(&q->lock, flags);
+
+        queued |= cpumask_of(cpu);
+        count++;
+    }
+
+    // One interrupt per CPU at most, however many calls are queued
+    if (queued) {
+        smp_send_ipi_mask(queued, IPI_CALL_FUNC);
+    }
+
+    if (wait) {
+        for_each_online_cpu(cpu) {
+            if (queued & cpumask_of(cpu)) {
+                csd_lock_wait(&cfd->csd[cpu]);
+            }
+        }
+    }
+    preempt_enable();
+
+    return count;
+}
+
+int smp_call_function_single(unsigned int cpu, smp_call_func_t func,
+                             void *arg, bool wait) {
+    if (cpu == smp_processor_id() || !cpu_online(cpu)) {
+        return -1;
+    }
+    return smp_call_function_many(cpumask_of(cpu), func, arg, wait) == 1 ? 0 : -1;
+}
+
+// Secondary CPUs arrive here with their stack, per-CPU base and trap
+// vectors already set up by the arch entry code
+void secondary_start_kernel(unsigned int cpu) {
+    // This context becomes the CPU's idle task
+    sched_init_secondary(cpu);
+
+    // Accept IPIs; with interrupts masked they only end the sleep below
+    if (ipi_ready) {
+        arch_ipi_init_secondary();
+    }
+
+    // Idle from RCU's point of view before anyone can count this CPU
+    rcu_idle_enter();
+    __atomic_store_n(&cpu_online_flag[cpu], true, __ATOMIC_RELEASE);
+
+    // Interrupts stay masked here except for a moment after each sleep,
+    // in which the IPI that ended it is taken; its handler runs queued
+    // calls. Without IPIs the loop polls the call queue itself. Between
+    // calls the CPU holds no RCU-protected pointers, which makes the end
+    // of each call a quiescent state. Threads queued here run until they
+    // sleep, yield, exit or are preempted by an IPI.
+    while (1) {
+        if (call_queue_pending()) {
+            rcu_idle_exit();
+            call_queue_flush();
+            rcu_quiescent_state();
+            rcu_idle_enter();
+        } else if (sched_cpu_has_work()) {
+            rcu_idle_exit();
+            schedule();
+            rcu_quiescent_state();
+            rcu_idle_enter();
+        } else if (rcu_pending()) {
+            // Callbacks queued by the last call: keep polling until their
+            // grace period ends rather than sleeping on them
+            rcu_quiescent_state();
+            arch_cpu_relax();
+        } else if (ipi_ready) {
+            tick_nohz_idle_enter();
+            arch_cpu_idle();
+            tick_nohz_idle_exit();
+
+            rcu_idle_exit();
+            arch_enable_interrupts();
+            arch_disable_interrupts();
+            rcu_quiescent_state();
+            rcu_idle_enter();
+        } else {
+            tick_nohz_idle_enter();
+            arch_smp_wait_event();
+            tick_nohz_idle_exit();
+        }
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * kernel/core/static_key.c
+ *
+ * Static key switching
+ */
+
+#include <static_key.h>
+#include <smp.h>
+#include <panic.h>
+
+extern struct static_key_entry __static_keys_start[];
+extern struct static_key_entry __static_keys_end[];
+
+static void static_key_set(struct static_key *key, bool enable) {
+    struct static_key_entry *entry;
+
+    if (key->enabled == enable) {
+        return;
+    }
+    if (num_online_cpus() > 1) {
+        panic("static key switched with secondary CPUs running");
+    }
+
+    key->enabled = enable;
+    for (entry = __static_keys_start; entry < __static_keys_end; entry++) {
+        if (entry->key == (uintptr_t)key) {
+            arch_static_key_patch(entry, enable);
+        }
+    }
+    arch_static_key_sync();
+}
+
+void static_key_enable(struct static_key *key) {
+    static_key_set(key, true);
+}
+
+void static_key_disable(struct static_key *key) {
+    static_key_set(key, false);
+}
@@ -0,0 +1,52 @@
+/*
+ * kernel/core/wait.c
+ *
+ * Wait queues
+ */
+
+#include <wait.h>
+
+void init_waitqueue_head(struct wait_queue_head *wq) {
+    spin_lock_init(&wq->lock);
+    list_init(&wq->head);
+}
+
+void prepare_to_wait(struct wait_queue_head *wq, struct wait_queue_entry *wait) {
+    unsigned long flags;
+
+    spin_lock_irqsave(&wq->lock, flags);
+    if (list_empty(&wait->link)) {
+        list_add_tail(&wait->link, &wq->head);
+    }
+    // Before the caller tests its condition; pairs with wake_up() taking
+    // the same lock after the waker set the condition
+    set_current_state(TASK_SLEEPING);
+    spin_unlock_irqrestore(&wq->lock, flags);
+}
+
+void finish_wait(struct wait_queue_head *wq, struct wait_queue_entry *wait) {
+    unsigned long flags;
+
+    set_current_state(TASK_RUNNING);
+
+    spin_lock_irqsave(&wq->lock, flags);
+    if (!list_empty(&wait->link)) {
+        list_del(&wait->link);
+    }
+    spin_unlock_irqrestore(&wq->lock, flags);
+}
+
+void wake_up(struct wait_queue_head *wq) {
+    struct list_head *pos;
+    unsigned long flags;
+
+    spin_lock_irqsave(&wq->lock, flags);
+    list_for_each(pos, &wq->head) {
+        wake_up_process(list_entry(pos, struct wait_queue_entry, link)->task);
+    }
+    spin_unlock_irqrestore(&wq->lock, flags);
+
+    // Wakeups under the lock could not switch; a woken higher-priority
+    // thread runs now rather than at the next tick
+    sched_preempt_point();
+}
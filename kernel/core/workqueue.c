@@ -0,0 +1,370 @@
+/*
+ * kernel/core/workqueue.c
+ *
+ * Per-CPU work-stealing workqueues
+ */
+
+#include <workqueue.h>
+#include <sched.h>
+#include <smp.h>
+#include <percpu.h>
+#include <arch_cpu.h>
+#include <arch_timer.h>
+#include <lib/list.h>
+#include <panic.h>
+#include <uart.h>
+#include <stddef.h>
+
+#define WQ_DEQUE_SIZE           256         // Power of two
+#define WQ_DEQUE_MASK           (WQ_DEQUE_SIZE - 1)
+
+// parallel_for() splits a range into this many pieces per online CPU,
+// so a CPU that finishes early has something left to steal
+#define PARALLEL_FOR_SPLIT      4
+#define PARALLEL_FOR_MAX_CHUNKS 32
+
+/*
+ * Chase-Lev deque. The owner pushes and pops at bottom; thieves take
+ * from top. top only ever grows, and a thief or the owner popping the
+ * last item claims it by advancing top with a compare-and-swap.
+ */
+struct wq_deque {
+    atomic64_t top;
+    atomic64_t bottom;
+    struct work_struct *slots[WQ_DEQUE_SIZE];
+};
+
+struct wq_cpu {
+    struct wq_deque deque;
+    struct task *worker;
+    volatile bool idle;         // Worker is going to sleep or asleep
+};
+
+static DEFINE_PER_CPU_ALIGNED(struct wq_cpu, wq_cpus);
+
+static volatile bool wq_ready;
+
+// Rotates the choice of idle worker to wake
+static atomic_t wq_wake_rotor;
+
+static inline void wq_mb(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline struct work_struct *wq_slot_read(struct wq_deque *dq, int64_t idx) {
+    return __atomic_load_n(&dq->slots[idx & WQ_DEQUE_MASK], __ATOMIC_RELAXED);
+}
+
+// Owner only, interrupts disabled
+static bool wq_push(struct wq_deque *dq, struct work_struct *work) {
+    int64_t b = atomic64_read(&dq->bottom);
+    int64_t t = atomic64_read_acquire(&dq->top);
+
+    if (b - t >= WQ_DEQUE_SIZE) {
+        return false;
+    }
+
+    __atomic_store_n(&dq->slots[b & WQ_DEQUE_MASK], work, __ATOMIC_RELAXED);
+    // The slot is written before a thief can see the new bottom
+    atomic64_set_release(&dq->bottom, b + 1);
+    return true;
+}
+
+// Owner only, interrupts disabled
+static struct work_struct *wq_pop(struct wq_deque *dq) {
+    int64_t b = atomic64_read(&dq->bottom) - 1;
+    int64_t t;
+    struct work_struct *work;
+
+    // Claim the bottom slot before looking at top, so a thief either sees
+    // the smaller bottom or we see its larger top
+    atomic64_set(&dq->bottom, b);
+    wq_mb();
+    t = atomic64_read(&dq->top);
+
+    if (t > b) {
+        // Empty
+        atomic64_set(&dq->bottom, b + 1);
+        return NULL;
+    }
+
+    work = wq_slot_read(dq, b);
+    if (t == b) {
+        // Last item: race the thieves for it
+        if (atomic64_cmpxchg(&dq->top, t, t + 1) != t) {
+            work = NULL;
+        }
+        atomic64_set(&dq->bottom, b + 1);
+    }
+    return work;
+}
+
+// Any CPU. Retries when it loses a race to another thief, so NULL means
+// the deque was seen empty.
+static struct work_struct *wq_steal(struct wq_deque *dq) {
+    for (;;) {
+        int64_t t = atomic64_read_acquire(&dq->top);
+        wq_mb();
+        int64_t b = atomic64_read_acquire(&dq->bottom);
+
+        if (t >= b) {
+            return NULL;
+        }
+
+        struct work_struct *work = wq_slot_read(dq, t);
+        if (atomic64_cmpxchg(&dq->top, t, t + 1) == t) {
+            return work;
+        }
+        arch_cpu_relax();
+    }
+}
+
+static bool wq_deque_empty(struct wq_deque *dq) {
+    return atomic64_read_acquire(&dq->top) >= atomic64_read_acquire(&dq->bottom);
+}
+
+// This CPU's own work first, then other CPUs' in turn
+static struct work_struct *wq_find_work(void) {
+    unsigned int self, cpu;
+    struct work_struct *work;
+    uint64_t flags = arch_save_interrupts();
+
+    self = smp_processor_id();
+    work = wq_pop(&this_cpu_ptr(wq_cpus)->deque);
+    arch_restore_interrupts(flags);
+
+    if (work) {
+        return work;
+    }
+
+    for (unsigned int i = 1; i < nr_cpu_ids; i++) {
+        cpu = (self + i) % nr_cpu_ids;
+        if (!cpu_online(cpu)) {
+            continue;
+        }
+        work = wq_steal(&per_cpu_ptr(wq_cpus, cpu)->deque);
+        if (work) {
+            return work;
+        }
+    }
+    return NULL;
+}
+
+static bool wq_any_work(void) {
+    unsigned int cpu;
+
+    for_each_online_cpu(cpu) {
+        if (!wq_deque_empty(&per_cpu_ptr(wq_cpus, cpu)->deque)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void wq_run(struct work_struct *work) {
+    work->func(work);
+
+    // The handler is done with the item; after this the owner may reuse
+    // or free it
+    atomic_set_release(&work->pending, 0);
+}
+
+static bool wq_wake_worker(struct wq_cpu *wc) {
+    if (wc->worker && __atomic_load_n(&wc->idle, __ATOMIC_RELAXED)) {
+        return wake_up_process(wc->worker);
+    }
+    return false;
+}
+
+// New work is on this CPU's deque: make sure its worker will see it, and
+// get one idle worker elsewhere to come and steal
+static void wq_kick(void) {
+    unsigned int self = smp_processor_id();
+    unsigned int start, cpu;
+
+    // Pairs with the barrier in worker_thread() before it rechecks
+    wq_mb();
+
+    wq_wake_worker(this_cpu_ptr(wq_cpus));
+
+    start = (unsigned int)atomic_inc_return(&wq_wake_rotor);
+    for (unsigned int i = 0; i < nr_cpu_ids; i++) {
+        cpu = (start + i) % nr_cpu_ids;
+        if (cpu == self || !cpu_online(cpu)) {
+            continue;
+        }
+        if (wq_wake_worker(per_cpu_ptr(wq_cpus, cpu))) {
+            break;
+        }
+    }
+}
+
+bool queue_work(struct work_struct *work) {
+    uint64_t flags;
+    bool queued;
+
+    if (atomic_cmpxchg(&work->pending, 0, 1) != 0) {
+        return false;
+    }
+
+    if (!wq_ready) {
+        wq_run(work);
+        return true;
+    }
+
+    flags = arch_save_interrupts();
+    queued = wq_push(&this_cpu_ptr(wq_cpus)->deque, work);
+    arch_restore_interrupts(flags);
+
+    if (!queued) {
+        wq_run(work);
+        return true;
+    }
+
+    wq_kick();
+    return true;
+}
+
+void flush_work(struct work_struct *work) {
+    while (work_pending(work)) {
+        // Help rather than wait: the item may even be on our own deque
+        struct work_struct *other = wq_find_work();
+        if (other) {
+            wq_run(other);
+            continue;
+        }
+
+        // Running on another CPU. Poll rather than sleep so the wait does
+        // not depend on a cross-CPU wakeup: without IPIs that wakeup only
+        // lands at this CPU's next tick.
+        sched_yield();
+        arch_cpu_relax();
+    }
+}
+
+static void worker_thread(void *arg) {
+    struct wq_cpu *wc = this_cpu_ptr(wq_cpus);
+
+    (void)arg;
+
+    for (;;) {
+        struct work_struct *work = wq_find_work();
+        if (work) {
+            wq_run(work);
+            continue;
+        }
+
+        // Announce the sleep, then look once more: a queue_work() that
+        // missed the flag has already pushed its item where we will see it
+        set_current_state(TASK_SLEEPING);
+        __atomic_store_n(&wc->idle, true, __ATOMIC_RELAXED);
+        wq_mb();
+        if (!wq_any_work()) {
+            schedule();
+        } else {
+            set_current_state(TASK_RUNNING);
+        }
+        __atomic_store_n(&wc->idle, false, __ATOMIC_RELAXED);
+    }
+}
+
+struct parallel_for_chunk {
+    struct work_struct work;
+    uint64_t start;
+    uint64_t end;
+    parallel_for_fn fn;
+    void *arg;
+};
+
+static void parallel_for_work(struct work_struct *work) {
+    struct parallel_for_chunk *chunk = container_of(work, struct parallel_for_chunk, work);
+
+    chunk->fn(chunk->start, chunk->end, chunk->arg);
+}
+
+void parallel_for(uint64_t start, uint64_t end, parallel_for_fn fn, void *arg) {
+    struct parallel_for_chunk chunks[PARALLEL_FOR_MAX_CHUNKS];
+    uint64_t n, base, extra, pos;
+    unsigned int nchunks;
+
+    if (end <= start) {
+        return;
+    }
+
+    n = end - start;
+    nchunks = num_online_cpus() * PARALLEL_FOR_SPLIT;
+    if (!wq_ready || num_online_cpus() == 1) {
+        nchunks = 1;
+    }
+    if (nchunks > PARALLEL_FOR_MAX_CHUNKS) {
+        nchunks = PARALLEL_FOR_MAX_CHUNKS;
+    }
+    if (nchunks > n) {
+        nchunks = (unsigned int)n;
+    }
+
+    if (nchunks == 1) {
+        fn(start, end, arg);
+        return;
+    }
+
+    // The first extra chunks get one more element each
+    base = n / nchunks;
+    extra = n % nchunks;
+    pos = start;
+    for (unsigned int i = 0; i < nchunks; i++) {
+        uint64_t len = base + (i < extra ? 1 : 0);
+
+        INIT_WORK(&chunks[i].work, parallel_for_work);
+        chunks[i].start = pos;
+        chunks[i].end = pos + len;
+        chunks[i].fn = fn;
+        chunks[i].arg = arg;
+        pos += len;
+    }
+
+    // Queue all but the first and run that one here; the flushes then
+    // pick up whatever no other CPU has stolen yet
+    for (unsigned int i = 1; i < nchunks; i++) {
+        queue_work(&chunks[i].work);
+    }
+    fn(chunks[0].start, chunks[0].end, arg);
+
+    for (unsigned int i = 1; i < nchunks; i++) {
+        flush_work(&chunks[i].work);
+    }
+}
+
+void workqueue_init(void) {
+    unsigned int cpu;
+    unsigned int nr_workers = 0;
+
+    for_each_online_cpu(cpu) {
+        struct wq_cpu *wc = per_cpu_ptr(wq_cpus, cpu);
+        struct task *task;
+
+        atomic64_set(&wc->deque.top, 0);
+        atomic64_set(&wc->deque.bottom, 0);
+        wc->idle = false;
+
+        task = kthread_create_on_cpu(worker_thread, NULL, "kworker", cpu);
+        if (!task) {
+            panic("workqueue: cannot create worker thread");
+        }
+        wc->worker = task;
+        nr_workers++;
+    }
+
+    wq_ready = true;
+    wq_mb();
+
+    for_each_online_cpu(cpu) {
+        wake_up_process(per_cpu_ptr(wq_cpus, cpu)->worker);
+    }
+
+    uart_puts("WORKQUEUE: ");
+    uart_putdec(nr_workers);
+    uart_puts(" worker(s), ");
+    uart_putdec(WQ_DEQUE_SIZE);
+    uart_puts("-entry deques\n");
+}
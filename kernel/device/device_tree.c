@@ -157,6 +157,22 @@ bool device_tree_is_device_enabled(int node_offset) {
             strcmp(status, "ok") == 0);
 }
 
+// dma-coherent on the node or any ancestor: the device snoops CPU caches
+bool device_tree_is_dma_coherent(int node_offset) {
+    if (!fdt_blob) {
+        return false;
+    }
+    
+    while (node_offset >= 0) {
+        if (fdt_getprop(fdt_blob, node_offset, FDT_PROP_DMA_COHERENT, NULL)) {
+            return true;
+        }
+        node_offset = fdt_parent_offset(fdt_blob, node_offset);
+    }
+    
+    return false;
+}
+
 // Get node name
 const char *device_tree_get_node_name(int node_offset) {
     if (!fdt_blob) {
@@ -514,6 +530,8 @@ struct device *device_tree_create_device(int node_offset) {
     device_tree_parse_reg(dev, node_offset);
     device_tree_parse_interrupts(dev, node_offset);
     
+    dev->dma_coherent = device_tree_is_dma_coherent(node_offset);
+    
     return dev;
 }
 
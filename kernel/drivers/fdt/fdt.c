@@ -32,15 +32,6 @@ static const char *fdt_get_prop_name(void *fdt, uint32_t nameoff) {
     return fdt_get_strings(fdt) + nameoff;
 }
 
-/* Compare strings */
-static int fdt_strcmp(const char *s1, const char *s2) {
-    while (*s1 && (*s1 == *s2)) {
-        s1++;
-        s2++;
-    }
-    return *(const unsigned char *)s1 - *(const unsigned char *)s2;
-}
-
 /* Validate FDT header */
 bool fdt_valid(void *fdt) {
     fdt_header_t *header = (fdt_header_t *)fdt;
@@ -129,7 +120,7 @@ bool fdt_get_memory(void *fdt, memory_info_t *mem_info) {
             void *propval = (uint8_t *)p + sizeof(fdt_prop_t);
             
             /* Look for "reg" property in memory node */
-            if (in_memory_node && propname && fdt_strcmp(propname, "reg") == 0) {
+            if (in_memory_node && propname && strcmp(propname, "reg") == 0) {
                 /* Parse memory regions (pairs of base, size) */
                 uint64_t *cells = (uint64_t *)propval;
                 int num_regions = len / (2 * sizeof(uint64_t));
@@ -428,7 +419,7 @@ int fdt_subnode_offset(const void *fdt, int parentoffset, const char *name) {
     
     fdt_for_each_subnode(node, fdt, parentoffset) {
         const char *nodename = fdt_get_name(fdt, node, NULL);
-        if (nodename && fdt_strcmp(nodename, name) == 0) {
+        if (nodename && strcmp(nodename, name) == 0) {
             return node;
         }
     }
@@ -522,7 +513,7 @@ const void *fdt_getprop(const void *fdt, int nodeoffset, const char *name, int *
                 uint32_t nameoff = fdt32_to_cpu(prop->nameoff);
                 const char *propname = fdt_get_prop_name((void *)fdt, nameoff);
                 
-                if (fdt_strcmp(propname, name) == 0) {
+                if (strcmp(propname, name) == 0) {
                     /* Found the property */
                     if (lenp) {
                         *lenp = proplen;
@@ -11,6 +11,7 @@
 #include <memory/vmm.h>
 #include <memory/vmparam.h>
 #include <arch_vmparam.h>
+#include <lib/checksum.h>
 #include <uart.h>
 #include <string.h>
 
@@ -23,7 +24,8 @@ static fdt_mgr_state_t fdt_state = {
     .virt_addr = NULL,
     .size = 0,
     .is_mapped = false,
-    .is_relocated = false
+    .is_relocated = false,
+    .has_checksum = false
 };
 
 /* Initialize FDT manager with DTB from boot */
@@ -227,16 +229,9 @@ bool fdt_mgr_is_available(void) {
     return fdt_state.phys_addr != NULL && fdt_state.size > 0;
 }
 
-/* Calculate simple checksum of FDT for integrity checking */
+/* CRC-32C of the FDT for integrity checking */
 static uint32_t fdt_calculate_checksum(void *fdt, size_t size) {
-    uint32_t checksum = 0;
-    uint8_t *bytes = (uint8_t *)fdt;
-    
-    for (size_t i = 0; i < size; i++) {
-        checksum = ((checksum << 1) | (checksum >> 31)) ^ bytes[i];
-    }
-    
-    return checksum;
+    return crc32c(0, fdt, size);
 }
 
 /* Verify FDT integrity */
@@ -276,6 +271,16 @@ bool fdt_mgr_verify_integrity(void) {
         return false;
     }
     
+    /* Contents unchanged since the first check */
+    uint32_t checksum = fdt_calculate_checksum(fdt, totalsize);
+    if (!fdt_state.has_checksum) {
+        fdt_state.checksum = checksum;
+        fdt_state.has_checksum = true;
+    } else if (checksum != fdt_state.checksum) {
+        // uart_puts("FDT_MGR: Integrity check failed - contents changed\n");
+        return false;
+    }
+    
     return true;
 }
 
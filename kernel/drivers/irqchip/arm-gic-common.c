@@ -387,6 +387,14 @@ int gic_init(void) {
     return 0;
 }
 
+// Bring up the calling secondary CPU's interface to the GIC
+int gic_secondary_init(void) {
+    if (!gic_primary || !gic_primary->ops || !gic_primary->ops->secondary_init) {
+        return -1;
+    }
+    return gic_primary->ops->secondary_init(gic_primary);
+}
+
 // Probe GIC from device
 int gic_probe(struct device *dev) {
     struct gic_data *gic;
@@ -14,6 +14,8 @@
 #include <drivers/fdt.h>
 #include <drivers/fdt_mgr.h>
 #include <device/device.h>
+#include <smp.h>
+#include <percpu.h>
 #include <string.h>
 
 // GICv2-specific CPU interface register access
@@ -22,6 +24,13 @@
 #define gic_cpu_write(gic, offset, val) \
     mmio_write32((uint8_t*)(gic)->cpu_base + (offset), (val))
 
+// CPU interface bit of each logical CPU, as used in GICD_SGIR target lists
+static uint8_t gicv2_cpu_iface[NR_CPUS];
+
+// Last IAR value read on this CPU. For an SGI it carries the sending
+// CPU's number, which must be written back to GICC_EOIR with the ID.
+static DEFINE_PER_CPU(uint32_t, gicv2_iar);
+
 // Forward declarations
 static int gicv2_msi_init(struct gic_data *gic);
 static void gicv2_msi_compose_msg(struct gic_data *gic, uint32_t hwirq,
@@ -112,6 +121,14 @@ static int gicv2_cpu_init(struct gic_data *gic) {
     return 0;
 }
 
+// Record the calling CPU's interface bit. GICD_ITARGETSR0-7 are banked
+// and read back as that bit; they read as zero on a uniprocessor GIC.
+static void gicv2_record_cpu_iface(struct gic_data *gic) {
+    uint8_t iface = gic_dist_read(gic, GICD_ITARGETSR) & 0xFF;
+
+    gicv2_cpu_iface[smp_processor_id()] = iface ? iface : 0x01;
+}
+
 // GICv2 initialization
 static int gicv2_init(struct gic_data *gic) {
     uart_puts("GICv2: Initializing\n");
@@ -121,6 +138,7 @@ static int gicv2_init(struct gic_data *gic) {
     
     // Initialize CPU interface
     gicv2_cpu_init(gic);
+    gicv2_record_cpu_iface(gic);
     
     // Try to initialize MSI support
     gicv2_msi_init(gic);
@@ -129,13 +147,41 @@ static int gicv2_init(struct gic_data *gic) {
     return 0;
 }
 
+// GICv2 CPU interface and banked SGI/PPI state on a secondary CPU
+static int gicv2_secondary_init(struct gic_data *gic) {
+    uint32_t i;
+    
+    // SGIs and PPIs are banked per CPU: disabled, default priority
+    gic_dist_write(gic, GICD_ICENABLER, 0xFFFF0000);
+    for (i = 0; i < GIC_SPI_BASE; i += 4) {
+        gic_dist_write(gic, GICD_IPRIORITYR + i,
+                      (GIC_PRIORITY_DEFAULT << 24) |
+                      (GIC_PRIORITY_DEFAULT << 16) |
+                      (GIC_PRIORITY_DEFAULT << 8) |
+                      GIC_PRIORITY_DEFAULT);
+    }
+    
+    gicv2_cpu_init(gic);
+    gicv2_record_cpu_iface(gic);
+    return 0;
+}
+
 // GICv2 interrupt acknowledgment
 static uint32_t gicv2_acknowledge_irq(struct gic_data *gic) {
-    return gic_cpu_read(gic, GICC_IAR) & 0x3FF;
+    uint32_t iar = gic_cpu_read(gic, GICC_IAR);
+    
+    __this_cpu_write(gicv2_iar, iar);
+    return iar & 0x3FF;
 }
 
 // GICv2 end of interrupt
 static void gicv2_eoi(struct gic_data *gic, uint32_t hwirq) {
+    uint32_t iar = __this_cpu_read(gicv2_iar);
+    
+    // An SGI is only completed with the source CPU it was taken with
+    if (hwirq < GIC_PPI_BASE && (iar & 0x3FF) == hwirq) {
+        hwirq = iar & 0x1FFF;
+    }
     gic_cpu_write(gic, GICC_EOIR, hwirq);
 }
 
@@ -195,13 +241,21 @@ static void gicv2_set_target(struct gic_data *gic, uint32_t hwirq, uint32_t targ
 
 // GICv2 send Software Generated Interrupt
 static void gicv2_send_sgi(struct gic_data *gic, uint32_t sgi_id, uint32_t target) {
+    uint32_t list = 0;
+    
     if (sgi_id >= GIC_MAX_SGI) return;
     
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+        if (target & (1U << cpu)) {
+            list |= gicv2_cpu_iface[cpu];
+        }
+    }
+    
     // Write to GICD_SGIR to generate the interrupt
-    // Bits [25:24] = 0 (target list filter - use target_mask)
-    // Bits [23:16] = target_mask (CPU targets)
+    // Bits [25:24] = 0 (target list filter - use target list)
+    // Bits [23:16] = CPU interface target list
     // Bits [3:0] = sgi_id (interrupt ID)
-    uint32_t val = (target << 16) | sgi_id;
+    uint32_t val = (list << 16) | sgi_id;
     gic_dist_write(gic, GICD_SGIR, val);
 }
 
@@ -434,6 +488,7 @@ int gicv2_msi_test_doorbell(struct gic_data *gic, uint32_t spi_num) {
 const struct gic_ops gicv2_ops = {
     .init = gicv2_init,
     .cpu_init = gicv2_cpu_init,
+    .secondary_init = gicv2_secondary_init,
     .dist_init = gicv2_dist_init,
     .acknowledge_irq = gicv2_acknowledge_irq,
     .eoi = gicv2_eoi,
@@ -14,6 +14,8 @@
 #include <memory/kmalloc.h>
 #include <drivers/fdt.h>
 #include <drivers/fdt_mgr.h>
+#include <smp.h>
+#include <lib/bitops.h>
 
 // GICv3 Redistributor register access macros
 #define gic_redist_read(addr, offset) \
@@ -120,23 +122,20 @@ static int gicv3_redist_discover(struct gic_data *gic) {
     return 0;
 }
 
+// MPIDR affinity in the Aff3.Aff2.Aff1.Aff0 layout of GICR_TYPER[63:32]
+static uint32_t gicv3_mpidr_to_typer_aff(uint64_t mpidr) {
+    return (uint32_t)(((mpidr & MPIDR_AFF3_MASK) >> MPIDR_AFF3_SHIFT) << 24) |
+           mpidr_to_affinity(mpidr);
+}
+
 // Get redistributor for current CPU
 static struct gicv3_redist_data* gicv3_get_current_redist(void) {
-    uint64_t mpidr = read_mpidr();
-    uint32_t aff = mpidr_to_affinity(mpidr);
+    uint32_t aff = gicv3_mpidr_to_typer_aff(read_mpidr());
     
-    // TODO: Properly match MPIDR to redistributor
-    // This will be needed for multi-core support:
-    // for (uint32_t i = 0; i < nr_redistributors; i++) {
-    //     if ((redistributors[i].mpidr & MPIDR_AFFINITY_MASK) == 
-    //         (mpidr & MPIDR_AFFINITY_MASK)) {
-    //         return &redistributors[i];
-    //     }
-    // }
-    
-    // For now, just use redistributor 0 (single CPU)
-    if (nr_redistributors > 0) {
-        return &redistributors[0];
+    for (uint32_t i = 0; i < nr_redistributors; i++) {
+        if ((uint32_t)(redistributors[i].mpidr >> 32) == aff) {
+            return &redistributors[i];
+        }
     }
     
     return NULL;
@@ -348,6 +347,14 @@ static int gicv3_init(struct gic_data *gic) {
     return 0;
 }
 
+// GICv3 redistributor and CPU interface on a secondary CPU
+static int gicv3_secondary_init(struct gic_data *gic) {
+    if (gicv3_redist_init(gic) != 0) {
+        return -1;
+    }
+    return gicv3_cpu_init(gic);
+}
+
 // GICv3 interrupt acknowledgment
 static uint32_t gicv3_acknowledge_irq(struct gic_data *gic) {
     uint32_t irq = gicv3_read_iar1();
@@ -472,25 +479,34 @@ static void gicv3_set_target(struct gic_data *gic, uint32_t hwirq, uint32_t targ
 
 // GICv3 send Software Generated Interrupt
 static void gicv3_send_sgi(struct gic_data *gic, uint32_t sgi_id, uint32_t target) {
-    uint64_t val = 0;
+    uint32_t left = target;
     
     if (sgi_id >= GIC_MAX_SGI) return;
     
-    // Build SGI register value
-    // For now, simple implementation targeting specific CPUs
-    if (target == 0xFF) {
-        // Broadcast to all CPUs except self
-        val = ICC_SGI1R_IRM | (sgi_id << ICC_SGI1R_INTID_SHIFT);
-    } else {
-        // Target specific CPUs (simplified - assumes target is CPU 0)
-        val = (1ULL << ICC_SGI1R_TARGET_LIST_SHIFT) |  // Target list
-              (sgi_id << ICC_SGI1R_INTID_SHIFT);        // Interrupt ID
-        // Affinity values would be set based on target CPU MPIDR
+    // One write per group of 16 CPUs sharing Aff3.Aff2.Aff1, with Aff0
+    // as a bit in the target list
+    while (left) {
+        unsigned int first = ctz32(left);
+        uint64_t cluster = cpu_hwid[first] & ~(uint64_t)0x0F;
+        uint64_t val;
+        uint16_t list = 0;
+        
+        for (unsigned int cpu = first; cpu < NR_CPUS; cpu++) {
+            if ((left & (1U << cpu)) && (cpu_hwid[cpu] & ~(uint64_t)0x0F) == cluster) {
+                list |= 1U << (cpu_hwid[cpu] & 0x0F);
+                left &= ~(1U << cpu);
+            }
+        }
+        
+        val = ((uint64_t)list << ICC_SGI1R_TARGET_LIST_SHIFT) |
+              (((cluster >> MPIDR_AFF1_SHIFT) & 0xFF) << ICC_SGI1R_AFF1_SHIFT) |
+              ((uint64_t)sgi_id << ICC_SGI1R_INTID_SHIFT) |
+              (((cluster >> MPIDR_AFF2_SHIFT) & 0xFF) << ICC_SGI1R_AFF2_SHIFT) |
+              (((cluster & MPIDR_AFF0_MASK) >> 4) << ICC_SGI1R_RS_SHIFT) |
+              (((cluster >> MPIDR_AFF3_SHIFT) & 0xFF) << ICC_SGI1R_AFF3_SHIFT);
+        gicv3_write_sgi1r(val);
     }
     
-    // Send the SGI
-    gicv3_write_sgi1r(val);
-    
     // Ensure SGI is sent
     __asm__ volatile("isb");
 }
@@ -755,6 +771,7 @@ int gicv3_msi_test_doorbell(struct gic_data *gic, uint32_t spi_num) {
 const struct gic_ops gicv3_ops = {
     .init = gicv3_init,
     .cpu_init = gicv3_cpu_init,
+    .secondary_init = gicv3_secondary_init,
     .dist_init = gicv3_dist_init,
     .acknowledge_irq = gicv3_acknowledge_irq,
     .eoi = gicv3_eoi,
@@ -22,7 +22,7 @@
 #include <arch_io.h>
 #include <irq/irq_domain.h>
 #include <irq/msi.h>
-#include <lib/ffs.h>
+#include <lib/bitops.h>
 
 /* Primary controller storage */
 static struct imsic_data primary_imsic_data;
@@ -243,7 +243,7 @@ void imsic_handle_irq(void) {
     for (int i = 0; i < (imsic->num_ids + 31) / 32; i++) {
         uint32_t pending = imsic_read_reg(file, IMSIC_REG_EIP_BASE + i * 4);
         if (pending) {
-            hwirq = i * 32 + ffs(pending) - 1;
+            hwirq = i * 32 + ctz32(pending);
             break;
         }
     }
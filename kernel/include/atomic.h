@@ -0,0 +1,161 @@
+/*
+ * kernel/include/atomic.h
+ *
+ * Atomic integer operations
+ *
+ * atomic_t is a 32-bit and atomic64_t a 64-bit signed counter. Every
+ * read-modify-write comes in four orderings:
+ *
+ *   op()           fully ordered (a full barrier on both sides)
+ *   op_acquire()   later accesses stay after the operation
+ *   op_release()   earlier accesses stay before the operation
+ *   op_relaxed()   atomic, but no ordering
+ *
+ * The void operations (atomic_add, atomic_inc, ...) are relaxed; use
+ * them for statistics. Plain atomic_read/atomic_set are single-copy
+ * atomic loads and stores with no ordering.
+ *
+ * The instructions come from arch_atomic.h: LSE atomics or LDXR/STXR on
+ * ARM64 (picked at boot), A-extension AMOs and LR/SC on RISC-V.
+ */
+
+#ifndef _ATOMIC_H_
+#define _ATOMIC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch_atomic.h>
+
+typedef struct {
+    volatile int32_t counter;
+} atomic_t;
+
+typedef struct {
+    volatile int64_t counter;
+} atomic64_t;
+
+#define ATOMIC_INIT(i)      { (i) }
+#define ATOMIC64_INIT(i)    { (i) }
+
+/*
+ * Operations for one ordering suffix of one width:
+ *   pfx   - atomic / atomic64
+ *   arch  - arch_atomic32 / arch_atomic64
+ */
+#define __ATOMIC_ORDER_OPS(pfx, arch, T, A, sfx)                            \
+static inline T pfx##_fetch_add##sfx(T i, A *v) {                           \
+    return arch##_fetch_add##sfx(i, &v->counter);                           \
+}                                                                           \
+static inline T pfx##_fetch_sub##sfx(T i, A *v) {                           \
+    return arch##_fetch_sub##sfx(i, &v->counter);                           \
+}                                                                           \
+static inline T pfx##_fetch_and##sfx(T i, A *v) {                           \
+    return arch##_fetch_and##sfx(i, &v->counter);                           \
+}                                                                           \
+static inline T pfx##_fetch_or##sfx(T i, A *v) {                            \
+    return arch##_fetch_or##sfx(i, &v->counter);                            \
+}                                                                           \
+static inline T pfx##_fetch_xor##sfx(T i, A *v) {                           \
+    return arch##_fetch_xor##sfx(i, &v->counter);                           \
+}                                                                           \
+static inline T pfx##_fetch_inc##sfx(A *v) {                                \
+    return arch##_fetch_add##sfx(1, &v->counter);                           \
+}                                                                           \
+static inline T pfx##_fetch_dec##sfx(A *v) {                                \
+    return arch##_fetch_sub##sfx(1, &v->counter);                           \
+}                                                                           \
+static inline T pfx##_add_return##sfx(T i, A *v) {                          \
+    return arch##_fetch_add##sfx(i, &v->counter) + i;                       \
+}                                                                           \
+static inline T pfx##_sub_return##sfx(T i, A *v) {                          \
+    return arch##_fetch_sub##sfx(i, &v->counter) - i;                       \
+}                                                                           \
+static inline T pfx##_inc_return##sfx(A *v) {                               \
+    return arch##_fetch_add##sfx(1, &v->counter) + 1;                       \
+}                                                                           \
+static inline T pfx##_dec_return##sfx(A *v) {                               \
+    return arch##_fetch_sub##sfx(1, &v->counter) - 1;                       \
+}                                                                           \
+static inline T pfx##_xchg##sfx(A *v, T new) {                              \
+    return arch##_xchg##sfx(new, &v->counter);                              \
+}                                                                           \
+static inline T pfx##_cmpxchg##sfx(A *v, T old, T new) {                    \
+    return arch##_cmpxchg##sfx(&v->counter, old, new);                      \
+}                                                                           \
+/* On failure *old is updated to the value found, ready for a retry */      \
+static inline bool pfx##_try_cmpxchg##sfx(A *v, T *old, T new) {            \
+    T prev = arch##_cmpxchg##sfx(&v->counter, *old, new);                   \
+    if (prev == *old) {                                                     \
+        return true;                                                        \
+    }                                                                       \
+    *old = prev;                                                            \
+    return false;                                                           \
+}
+
+#define __ATOMIC_OPS(pfx, arch, T, A)                                       \
+static inline T pfx##_read(const A *v) {                                    \
+    return v->counter;                                                      \
+}                                                                           \
+static inline T pfx##_read_acquire(const A *v) {                            \
+    return __atomic_load_n(&v->counter, __ATOMIC_ACQUIRE);                  \
+}                                                                           \
+static inline void pfx##_set(A *v, T i) {                                   \
+    v->counter = i;                                                         \
+}                                                                           \
+static inline void pfx##_set_release(A *v, T i) {                           \
+    __atomic_store_n(&v->counter, i, __ATOMIC_RELEASE);                     \
+}                                                                           \
+__ATOMIC_ORDER_OPS(pfx, arch, T, A, _relaxed)                               \
+__ATOMIC_ORDER_OPS(pfx, arch, T, A, _acquire)                               \
+__ATOMIC_ORDER_OPS(pfx, arch, T, A, _release)                               \
+__ATOMIC_ORDER_OPS(pfx, arch, T, A, )                                       \
+static inline void pfx##_add(T i, A *v) {                                   \
+    (void)arch##_fetch_add_relaxed(i, &v->counter);                         \
+}                                                                           \
+static inline void pfx##_sub(T i, A *v) {                                   \
+    (void)arch##_fetch_sub_relaxed(i, &v->counter);                         \
+}                                                                           \
+static inline void pfx##_inc(A *v) {                                        \
+    (void)arch##_fetch_add_relaxed(1, &v->counter);                         \
+}                                                                           \
+static inline void pfx##_dec(A *v) {                                        \
+    (void)arch##_fetch_sub_relaxed(1, &v->counter);                         \
+}                                                                           \
+static inline void pfx##_and(T i, A *v) {                                   \
+    (void)arch##_fetch_and_relaxed(i, &v->counter);                         \
+}                                                                           \
+static inline void pfx##_or(T i, A *v) {                                    \
+    (void)arch##_fetch_or_relaxed(i, &v->counter);                          \
+}                                                                           \
+static inline void pfx##_xor(T i, A *v) {                                   \
+    (void)arch##_fetch_xor_relaxed(i, &v->counter);                         \
+}                                                                           \
+/* Fully ordered; true if the counter reached zero (reference drop) */     \
+static inline bool pfx##_dec_and_test(A *v) {                               \
+    return arch##_fetch_sub(1, &v->counter) == 1;                           \
+}                                                                           \
+static inline bool pfx##_sub_and_test(T i, A *v) {                          \
+    return arch##_fetch_sub(i, &v->counter) == i;                           \
+}                                                                           \
+/* Add a to v unless v is u; returns true if the add happened */            \
+static inline bool pfx##_add_unless(A *v, T a, T u) {                       \
+    T c = pfx##_read(v);                                                    \
+    do {                                                                    \
+        if (c == u) {                                                       \
+            return false;                                                   \
+        }                                                                   \
+    } while (!pfx##_try_cmpxchg(v, &c, c + a));                             \
+    return true;                                                            \
+}                                                                           \
+/* Take a reference only if the object is still live */                    \
+static inline bool pfx##_inc_not_zero(A *v) {                               \
+    return pfx##_add_unless(v, 1, 0);                                       \
+}
+
+__ATOMIC_OPS(atomic, arch_atomic32, int32_t, atomic_t)
+__ATOMIC_OPS(atomic64, arch_atomic64, int64_t, atomic64_t)
+
+#undef __ATOMIC_OPS
+#undef __ATOMIC_ORDER_OPS
+
+#endif /* _ATOMIC_H_ */
@@ -0,0 +1,48 @@
+/*
+ * kernel/include/cpufeature.h
+ *
+ * Optional ISA features of the CPUs the kernel is running on
+ *
+ * The image is built for the baseline ISA. cpufeature_init() finds out
+ * once at boot what the CPUs add on top (arch_cpufeature.h lists what is
+ * looked for) and switches a static key per feature, so hot paths can
+ * take the better instructions without testing anything:
+ *
+ *     if (cpu_feature_branch(CPU_FEATURE_LSE)) { ...LSE... } else { ... }
+ *
+ * Both paths must work: until cpufeature_init() every feature reads as
+ * absent. The boot CPU is probed and the others are assumed to match.
+ */
+
+#ifndef _CPUFEATURE_H_
+#define _CPUFEATURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <static_key.h>
+#include <arch_cpufeature.h>
+
+extern uint64_t cpu_feature_bits;
+extern struct static_key cpu_feature_keys[CPU_FEATURE_COUNT];
+
+// For init and slow paths
+static inline bool cpu_has_feature(enum cpu_feature f) {
+    return (cpu_feature_bits >> f) & 1;
+}
+
+// For hot paths; f must be a constant
+#define cpu_feature_branch(f)   static_branch(&cpu_feature_keys[f])
+
+// Probe the boot CPU and patch in the feature paths. Before any
+// secondary CPU starts, and after fdt_mgr_init(), which RISC-V reads the
+// ISA extensions from.
+void cpufeature_init(void);
+
+// One line listing the features found
+void cpufeature_print(void);
+
+// arch/*/kernel/cpufeature.c
+uint64_t arch_cpufeature_detect(void);
+extern const char *const cpu_feature_names[CPU_FEATURE_COUNT];
+
+#endif /* _CPUFEATURE_H_ */
@@ -78,6 +78,10 @@ struct device {
     // MSI support
     struct msi_device_data *msi_data;               // MSI descriptor data
     struct irq_domain      *msi_domain;             // MSI IRQ domain
+    
+    // DMA (memory/dma.h)
+    uint64_t            dma_mask;                   // Highest bus address, 0 = all 64 bits
+    bool                dma_coherent;               // Snoops CPU caches (dma-coherent)
 };
 
 // Device flags
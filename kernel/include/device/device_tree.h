@@ -26,6 +26,7 @@
 #define FDT_PROP_DEVICE_TYPE    "device_type"
 #define FDT_PROP_RANGES         "ranges"
 #define FDT_PROP_DMA_RANGES     "dma-ranges"
+#define FDT_PROP_DMA_COHERENT   "dma-coherent"
 #define FDT_PROP_ADDRESS_CELLS  "#address-cells"
 #define FDT_PROP_SIZE_CELLS     "#size-cells"
 
@@ -75,6 +76,7 @@ device_type_t device_tree_compatible_to_type(const char *compatible);
 uint64_t device_tree_translate_address(int node_offset, uint64_t addr);
 bool device_tree_get_dma_range(int node_offset, uint64_t *cpu_addr,
                               uint64_t *dma_addr, uint64_t *size);
+bool device_tree_is_dma_coherent(int node_offset);
 
 /* Phandle resolution */
 int device_tree_get_phandle(int node_offset);
@@ -26,6 +26,8 @@ typedef struct {
     size_t size;           /* Size of FDT blob */
     bool is_mapped;        /* Whether FDT is mapped to virtual memory */
     bool is_relocated;     /* Whether FDT was relocated by boot.S */
+    bool has_checksum;     /* Whether checksum has been recorded */
+    uint32_t checksum;     /* CRC-32C at the first integrity check */
 } fdt_mgr_state_t;
 
 /* Initialize FDT manager with DTB from boot */
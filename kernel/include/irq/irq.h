@@ -56,7 +56,7 @@ void msi_free_irqs(struct device *dev);
 // Initialize IRQ subsystem
 void irq_init(void);
 
-// Get IRQ descriptor
+// Get IRQ descriptor; call and use it under rcu_read_lock()
 struct irq_desc *irq_to_desc(uint32_t irq);
 
 // IRQ descriptor management
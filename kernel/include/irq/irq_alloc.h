@@ -9,7 +9,7 @@
 struct virq_allocator {
     uint32_t next_virq;
     uint32_t max_virq;
-    unsigned long *bitmap;      // Allocation bitmap
+    uint64_t *bitmap;           // Allocation bitmap (lib/bitmap.h)
     spinlock_t lock;
 };
 
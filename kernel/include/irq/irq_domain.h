@@ -4,15 +4,14 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <spinlock.h>
+#include <atomic.h>
+#include <lib/list.h>
 
 struct device_node;
 struct irq_desc;
 struct irq_chip;
 struct radix_tree_root;
 struct msi_msg;
-struct list_head {
-    struct list_head *next, *prev;
-};
 
 typedef void (*irq_handler_t)(void *);
 
@@ -142,8 +141,8 @@ struct irq_desc {
     uint32_t depth;             // Nested disable depth
     
     // Statistics
-    uint64_t count;
-    uint64_t spurious_count;
+    atomic64_t count;
+    atomic64_t spurious_count;
     uint64_t last_timestamp;
     
     // Synchronization
@@ -0,0 +1,41 @@
+/*
+ * kernel/include/irq/irq_stack.h
+ *
+ * Per-CPU interrupt stacks
+ *
+ * Interrupt handlers run on a stack of their own rather than on whatever
+ * thread they interrupted, so a kernel thread's stack only has to hold
+ * one interrupt frame on top of its own use. The entry code saves the
+ * caller-saved registers on the thread's stack, switches to the IRQ
+ * stack for the handler, and switches back before the reschedule point
+ * in sched_irq_exit(), which must run on the thread's stack.
+ */
+
+#ifndef _IRQ_STACK_H_
+#define _IRQ_STACK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <percpu.h>
+
+#define IRQ_STACK_PAGES     4
+#define IRQ_STACK_SIZE      (IRQ_STACK_PAGES * 4096)    // Mirrored in the entry code
+
+/* Top of this CPU's IRQ stack; 0 until irq_stack_init() */
+DECLARE_PER_CPU(uintptr_t, irq_stack_ptr);
+
+/*
+ * Allocate an IRQ stack for every possible CPU. Call after percpu_init()
+ * and before interrupts are enabled; until then handlers run on the
+ * interrupted stack.
+ */
+void irq_stack_init(void);
+
+/* True if sp is on the calling CPU's IRQ stack */
+static inline bool on_irq_stack(uintptr_t sp) {
+    uintptr_t top = this_cpu_read(irq_stack_ptr);
+
+    return top && sp < top && sp >= top - IRQ_STACK_SIZE;
+}
+
+#endif /* _IRQ_STACK_H_ */
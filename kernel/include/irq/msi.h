@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <spinlock.h>
+#include <atomic.h>
 #include <device/device.h>
 
 struct device_node;
@@ -89,7 +90,7 @@ struct msi_desc {
     void *chip_data;
     
     // Reference counting
-    uint32_t refcount;
+    atomic_t refcount;
 };
 
 // Per-device MSI information
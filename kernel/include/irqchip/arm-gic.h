@@ -29,6 +29,7 @@ struct gic_ops {
     // Initialization
     int (*init)(struct gic_data *gic);
     int (*cpu_init)(struct gic_data *gic);
+    int (*secondary_init)(struct gic_data *gic);   // On each secondary CPU
     void (*dist_init)(struct gic_data *gic);
     
     // Interrupt acknowledgment and EOI
@@ -44,7 +45,7 @@ struct gic_ops {
     // CPU targeting (v2) / Affinity routing (v3)
     void (*set_target)(struct gic_data *gic, uint32_t hwirq, uint32_t target);
     
-    // Software Generated Interrupts
+    // Software Generated Interrupts, target is a mask of logical CPUs
     void (*send_sgi)(struct gic_data *gic, uint32_t sgi_id, uint32_t target);
     
     // Enable/disable
@@ -225,6 +226,7 @@ void gic_msi_free_spi(struct gic_data *gic, uint32_t base_spi, uint32_t count);
 // GIC initialization and management
 int gic_init(void);
 int gic_probe(struct device *dev);
+int gic_secondary_init(void);
 void gic_enable(void);
 void gic_disable(void);
 
@@ -237,7 +239,7 @@ void gic_set_priority(uint32_t hwirq, uint8_t priority);
 void gic_set_target(uint32_t hwirq, uint8_t cpu_mask);
 void gic_set_config(uint32_t hwirq, uint32_t config);
 
-// Software Generated Interrupt
+// Software Generated Interrupt to a mask of logical CPUs (bit n for CPU n)
 void gic_send_sgi(uint32_t sgi_id, uint32_t target_mask);
 
 // Global GIC instance (for now, single GIC support)
@@ -0,0 +1,87 @@
+/*
+ * kernel/include/lib/bitmap.h
+ *
+ * Bitmap scanning
+ *
+ * Bit n of a map is bit n % 64 of word n / 64. The find helpers look at
+ * a word at a time and locate the bit with one ctz (lib/bitops.h).
+ */
+
+#ifndef _LIB_BITMAP_H
+#define _LIB_BITMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <lib/bitops.h>
+
+#define BITMAP_WORDS(nbits)     (((nbits) + 63) / 64)
+
+// Not atomic: callers hold whatever lock protects the map
+static inline void bitmap_set_bit(uint64_t *map, size_t bit) {
+    map[bit / 64] |= 1ULL << (bit % 64);
+}
+
+static inline void bitmap_clear_bit(uint64_t *map, size_t bit) {
+    map[bit / 64] &= ~(1ULL << (bit % 64));
+}
+
+static inline bool bitmap_test_bit(const uint64_t *map, size_t bit) {
+    return (map[bit / 64] >> (bit % 64)) & 1;
+}
+
+// First bit at or after start that differs from the bits of invert
+static inline size_t __bitmap_find_next(const uint64_t *map, size_t nbits,
+                                        size_t start, uint64_t invert) {
+    uint64_t word;
+
+    if (start >= nbits) {
+        return nbits;
+    }
+
+    word = (map[start / 64] ^ invert) & (~0ULL << (start % 64));
+    start -= start % 64;
+    while (!word) {
+        start += 64;
+        if (start >= nbits) {
+            return nbits;
+        }
+        word = map[start / 64] ^ invert;
+    }
+
+    start += ctz64(word);
+    return start < nbits ? start : nbits;
+}
+
+// First set bit of map[0, nbits) at or after start, or nbits if none
+static inline size_t bitmap_find_next_bit(const uint64_t *map, size_t nbits, size_t start) {
+    return __bitmap_find_next(map, nbits, start, 0);
+}
+
+// First clear bit of map[0, nbits) at or after start, or nbits if none
+static inline size_t bitmap_find_next_zero_bit(const uint64_t *map, size_t nbits, size_t start) {
+    return __bitmap_find_next(map, nbits, start, ~0ULL);
+}
+
+// First run of count clear bits of map[0, nbits) at or after start, or
+// nbits if there is none
+static inline size_t bitmap_find_next_zero_area(const uint64_t *map, size_t nbits,
+                                                size_t start, size_t count) {
+    start = bitmap_find_next_zero_bit(map, nbits, start);
+    while (count <= nbits && start <= nbits - count) {
+        size_t busy = bitmap_find_next_bit(map, start + count, start);
+
+        if (busy == start + count) {
+            return start;
+        }
+        start = bitmap_find_next_zero_bit(map, nbits, busy);
+    }
+    return nbits;
+}
+
+// Index of the first word of map[0, nwords) with a clear bit, or nwords
+// if every bit is set. Lets allocators skip full stretches a word at a
+// time, and with SIMD several words at a time.
+size_t bitmap_find_zero_word(const uint64_t *map, size_t nwords);
+
+#endif /* _LIB_BITMAP_H */
@@ -0,0 +1,107 @@
+/*
+ * kernel/include/lib/bitops.h
+ *
+ * Finding and counting set bits
+ *
+ * Where the CPU has the instruction (arch_bitops.h says which) these are
+ * compiler builtins and compile to it: CLZ and RBIT+CLZ on ARM64, Zbb
+ * clz/ctz/cpop on RISC-V kernels built with RISCV_ZBB=1. Elsewhere they
+ * are a few multiplies and shifts, never a call into libgcc, which the
+ * kernel does not link.
+ *
+ * ctz and clz of 0 are undefined, as with the builtins; ffs and fls are
+ * defined for 0 and count bits from 1.
+ */
+
+#ifndef _LIB_BITOPS_H
+#define _LIB_BITOPS_H
+
+#include <stdint.h>
+#include <arch_bitops.h>
+
+static inline unsigned int popcount64(uint64_t x) {
+#if ARCH_HAS_FAST_POPCOUNT
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (unsigned int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Trailing zeros; x must not be 0
+static inline unsigned int ctz64(uint64_t x) {
+#if ARCH_HAS_FAST_CTZ
+    return __builtin_ctzll(x);
+#else
+    // x & -x keeps the lowest set bit; the de Bruijn multiply puts a
+    // different 6-bit pattern in the top bits for each position
+    static const uint8_t debruijn[64] = {
+         0,  1,  2, 53,  3,  7, 54, 27,  4, 38, 41,  8, 34, 55, 48, 28,
+        62,  5, 39, 46, 44, 42, 22,  9, 24, 35, 59, 56, 49, 18, 29, 11,
+        63, 52,  6, 26, 37, 40, 33, 47, 61, 45, 43, 21, 23, 58, 17, 10,
+        51, 25, 36, 32, 60, 20, 57, 16, 50, 31, 19, 15, 30, 14, 13, 12,
+    };
+
+    return debruijn[((x & -x) * 0x022fdd63cc95386dULL) >> 58];
+#endif
+}
+
+// Leading zeros; x must not be 0
+static inline unsigned int clz64(uint64_t x) {
+#if ARCH_HAS_FAST_CLZ
+    return __builtin_clzll(x);
+#else
+    // Copy the top set bit into every bit below it
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+    x |= x >> 32;
+    return 64 - popcount64(x);
+#endif
+}
+
+// 32-bit values are zero-extended, which changes only the leading zeros
+static inline unsigned int popcount32(uint32_t x) {
+    return popcount64(x);
+}
+
+static inline unsigned int ctz32(uint32_t x) {
+    return ctz64(x);
+}
+
+static inline unsigned int clz32(uint32_t x) {
+    return clz64(x) - 32;
+}
+
+// First (lowest) set bit counting from 1, or 0 if none
+static inline unsigned int ffs64(uint64_t x) {
+    return x ? ctz64(x) + 1 : 0;
+}
+
+static inline unsigned int ffs32(uint32_t x) {
+    return x ? ctz32(x) + 1 : 0;
+}
+
+// Last (highest) set bit counting from 1, or 0 if none
+static inline unsigned int fls64(uint64_t x) {
+    return x ? 64 - clz64(x) : 0;
+}
+
+static inline unsigned int fls32(uint32_t x) {
+    return x ? 32 - clz32(x) : 0;
+}
+
+// First clear bit, from 0; x must have one
+static inline unsigned int ffz64(uint64_t x) {
+    return ctz64(~x);
+}
+
+static inline unsigned int ffz32(uint32_t x) {
+    return ctz32(~x);
+}
+
+#endif /* _LIB_BITOPS_H */
@@ -0,0 +1,31 @@
+/*
+ * kernel/include/lib/checksum.h
+ *
+ * Checksums
+ */
+
+#ifndef _LIB_CHECKSUM_H
+#define _LIB_CHECKSUM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Rotate left by one and XOR in the next byte. Catches stray writes to a
+// buffer that should not change; it is not a CRC.
+uint32_t csum_rotxor32(const void *buf, size_t len);
+
+// CRC-32 (IEEE 802.3, as zlib computes it) and CRC-32C (Castagnoli, as
+// used by iSCSI, ext4 and virtio). crc is the result for the data before
+// buf, or 0 to start, so a buffer may be fed in pieces. Both use the CPU's
+// CRC or carry-less multiply instructions when it has them.
+uint32_t crc32(uint32_t crc, const void *buf, size_t len);
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len);
+
+// The slicing-by-8 table versions, whatever the CPU has
+uint32_t crc32_sliced(uint32_t crc, const void *buf, size_t len);
+uint32_t crc32c_sliced(uint32_t crc, const void *buf, size_t len);
+
+// Build the tables. Until then the CRCs work a bit at a time.
+void crc32_init(void);
+
+#endif /* _LIB_CHECKSUM_H */
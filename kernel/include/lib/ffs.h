@@ -1,6 +0,0 @@
-#ifndef _LIB_FFS_H
-#define _LIB_FFS_H
-
-int ffs(int i);
-
-#endif /* _LIB_FFS_H */
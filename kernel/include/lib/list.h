@@ -0,0 +1,78 @@
+#ifndef _LIB_LIST_H
+#define _LIB_LIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Circular doubly linked list, embedded in the structures it links
+struct list_head {
+    struct list_head *next, *prev;
+};
+
+#define LIST_HEAD_INIT(name) { &(name), &(name) }
+
+#define container_of(ptr, type, member) \
+    ((type *)((char *)(ptr) - offsetof(type, member)))
+
+#define list_entry(ptr, type, member) container_of(ptr, type, member)
+
+static inline void list_init(struct list_head *list) {
+    list->next = list;
+    list->prev = list;
+}
+
+static inline void __list_add(struct list_head *new, struct list_head *prev,
+                              struct list_head *next) {
+    new->next = next;
+    new->prev = prev;
+    next->prev = new;
+    prev->next = new;
+}
+
+// Insert after head (stack order)
+static inline void list_add(struct list_head *new, struct list_head *head) {
+    __list_add(new, head, head->next);
+}
+
+// Insert before head (queue order)
+static inline void list_add_tail(struct list_head *new, struct list_head *head) {
+    __list_add(new, head->prev, head);
+}
+
+static inline void list_del(struct list_head *entry) {
+    entry->next->prev = entry->prev;
+    entry->prev->next = entry->next;
+    entry->next = entry;
+    entry->prev = entry;
+}
+
+static inline bool list_empty(const struct list_head *head) {
+    return head->next == head;
+}
+
+// Move entry from its list to the tail of head
+static inline void list_move_tail(struct list_head *entry, struct list_head *head) {
+    entry->next->prev = entry->prev;
+    entry->prev->next = entry->next;
+    list_add_tail(entry, head);
+}
+
+// Append all of list's entries to head and leave list empty
+static inline void list_splice_tail_init(struct list_head *list, struct list_head *head) {
+    if (list_empty(list)) {
+        return;
+    }
+    list->next->prev = head->prev;
+    head->prev->next = list->next;
+    list->prev->next = head;
+    head->prev = list->prev;
+    list_init(list);
+}
+
+#define list_first_entry(head, type, member) \
+    list_entry((head)->next, type, member)
+
+#define list_for_each(pos, head) \
+    for ((pos) = (head)->next; (pos) != (head); (pos) = (pos)->next)
+
+#endif /* _LIB_LIST_H */
@@ -5,6 +5,8 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <spinlock.h>
+#include <rcu.h>
+#include <lib/bitmap.h>
 
 #define RADIX_TREE_MAP_SHIFT    6
 #define RADIX_TREE_MAP_SIZE     (1UL << RADIX_TREE_MAP_SHIFT)
@@ -31,7 +33,8 @@ struct radix_tree_node {
     unsigned int count;
     struct radix_tree_node *parent;
     void *slots[RADIX_TREE_MAP_SIZE];
-    unsigned long tags[RADIX_TREE_TAG_MAX][(RADIX_TREE_MAP_SIZE + 63) / 64];
+    uint64_t tags[RADIX_TREE_TAG_MAX][BITMAP_WORDS(RADIX_TREE_MAP_SIZE)];
+    struct rcu_head rcu;        // Deferred free once unlinked
 };
 
 struct radix_tree_iter {
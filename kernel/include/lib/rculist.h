@@ -0,0 +1,51 @@
+#ifndef _LIB_RCULIST_H
+#define _LIB_RCULIST_H
+
+#include <lib/list.h>
+#include <rcu.h>
+
+/*
+ * List operations safe against concurrent lockless readers
+ *
+ * Writers still serialise among themselves with a lock. Readers walk
+ * forward only, inside rcu_read_lock()/rcu_read_unlock(), so only the
+ * next pointers need publishing; prev is never followed by a reader.
+ */
+
+static inline void __list_add_rcu(struct list_head *new, struct list_head *prev,
+                                  struct list_head *next) {
+    new->next = next;
+    new->prev = prev;
+    rcu_assign_pointer(prev->next, new);
+    next->prev = new;
+}
+
+static inline void list_add_rcu(struct list_head *new, struct list_head *head) {
+    __list_add_rcu(new, head, head->next);
+}
+
+static inline void list_add_tail_rcu(struct list_head *new, struct list_head *head) {
+    __list_add_rcu(new, head->prev, head);
+}
+
+/*
+ * Unlink entry. Its next pointer is left intact so a reader standing on
+ * it can carry on; the entry may only be freed or reused after a grace
+ * period (synchronize_rcu() or call_rcu()).
+ */
+static inline void list_del_rcu(struct list_head *entry) {
+    entry->next->prev = entry->prev;
+    RCU_INIT_POINTER(entry->prev->next, entry->next);
+    entry->prev = NULL;
+}
+
+#define list_for_each_rcu(pos, head) \
+    for ((pos) = rcu_dereference((head)->next); (pos) != (head); \
+         (pos) = rcu_dereference((pos)->next))
+
+#define list_for_each_entry_rcu(pos, head, member) \
+    for ((pos) = list_entry(rcu_dereference((head)->next), __typeof__(*(pos)), member); \
+         &(pos)->member != (head); \
+         (pos) = list_entry(rcu_dereference((pos)->member.next), __typeof__(*(pos)), member))
+
+#endif /* _LIB_RCULIST_H */
@@ -0,0 +1,129 @@
+/*
+ * kernel/include/lib/ring.h
+ *
+ * Lock-free ring buffers
+ *
+ * A ring holds a power-of-two number of fixed-size elements. There is
+ * always one consumer. There is one producer, or several when the ring is
+ * created with RING_F_MP (MPSC). Indices run freely and are masked on
+ * use, so the full size of the ring is usable.
+ *
+ * Each side publishes its index with a store-release. The other side reads
+ * it with a load-acquire, so element contents are visible before the index
+ * that covers them. The producer reuses a slot only after the consumer has
+ * released it.
+ *
+ * Elements go in and out either by copy (the batch calls move as many as
+ * fit) or in place. For in-place access, ring_reserve()/ring_commit() hand
+ * the producer a run of slots to fill, and ring_peek()/ring_release()
+ * hand the consumer a run to read. A run never wraps, so a reservation can
+ * be shorter than asked for.
+ *
+ * MPSC producers commit in the order they reserved. Between reserve and
+ * commit they keep interrupts masked (the reservation carries the saved
+ * flags), so an interrupt handler producing into the same ring never spins
+ * on a reservation it interrupted.
+ */
+
+#ifndef _LIB_RING_H
+#define _LIB_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define RING_F_MP           (1U << 0)   // Multiple producers
+
+#define RING_CACHE_LINE     64
+
+struct ring {
+    // Read-only after ring_init()
+    uint32_t size;
+    uint32_t mask;
+    uint32_t esize;                 // Bytes per element
+    unsigned int flags;
+    uint8_t *data;
+    bool allocated;                 // data came from ring_create()
+
+    // Producer side
+    uint32_t prod_head __attribute__((aligned(RING_CACHE_LINE)));  // Next slot to reserve
+    uint32_t prod_tail;             // Slots before this are readable
+
+    // Consumer side
+    uint32_t cons_tail __attribute__((aligned(RING_CACHE_LINE)));  // Slots before this are free
+};
+
+// A run of slots handed out by ring_reserve() or ring_peek()
+struct ring_resv {
+    void *ptr;                      // First slot
+    uint32_t head;                  // Index of the first slot
+    uint32_t count;                 // Slots in the run
+    unsigned long irqflags;         // MPSC producers only
+};
+
+/*
+ * Set up a ring over buf, which holds count elements of esize bytes.
+ * count must be a power of two. Returns -1 if it is not.
+ */
+int ring_init(struct ring *r, void *buf, uint32_t count, uint32_t esize, unsigned int flags);
+
+// ring_init() on a kmalloc'd ring and buffer; NULL on failure
+struct ring *ring_create(uint32_t count, uint32_t esize, unsigned int flags);
+void ring_destroy(struct ring *r);
+
+/*
+ * Copy in up to n elements from objs, as many as there is room for, and
+ * return how many. The dequeue side copies out up to n of those that
+ * are there.
+ */
+uint32_t ring_enqueue_batch(struct ring *r, const void *objs, uint32_t n);
+uint32_t ring_dequeue_batch(struct ring *r, void *objs, uint32_t n);
+
+static inline bool ring_enqueue(struct ring *r, const void *obj) {
+    return ring_enqueue_batch(r, obj, 1) == 1;
+}
+
+static inline bool ring_dequeue(struct ring *r, void *obj) {
+    return ring_dequeue_batch(r, obj, 1) == 1;
+}
+
+/*
+ * Producer: reserve up to n contiguous free slots. Returns the number
+ * reserved. If that is nonzero, fill resv->ptr and pass resv to
+ * ring_commit(). If it is 0, the ring is full and there is nothing to
+ * commit.
+ */
+uint32_t ring_reserve(struct ring *r, uint32_t n, struct ring_resv *resv);
+void ring_commit(struct ring *r, const struct ring_resv *resv);
+
+/*
+ * Consumer: look at up to n contiguous readable slots in place. Returns
+ * the number available. ring_release() frees the first resv->count of
+ * them; lower it first to keep some for later.
+ */
+uint32_t ring_peek(struct ring *r, uint32_t n, struct ring_resv *resv);
+void ring_release(struct ring *r, const struct ring_resv *resv);
+
+// Elements readable now; a snapshot when the other side is running
+static inline uint32_t ring_count(const struct ring *r) {
+    uint32_t cons = __atomic_load_n(&r->cons_tail, __ATOMIC_RELAXED);
+    return __atomic_load_n(&r->prod_tail, __ATOMIC_ACQUIRE) - cons;
+}
+
+static inline uint32_t ring_free_count(const struct ring *r) {
+    uint32_t prod = __atomic_load_n(&r->prod_head, __ATOMIC_RELAXED);
+    uint32_t used = prod - __atomic_load_n(&r->cons_tail, __ATOMIC_ACQUIRE);
+
+    // The two loads are not one snapshot; never report more than there is
+    return used > r->size ? 0 : r->size - used;
+}
+
+static inline bool ring_empty(const struct ring *r) {
+    return ring_count(r) == 0;
+}
+
+static inline bool ring_full(const struct ring *r) {
+    return ring_free_count(r) == 0;
+}
+
+#endif /* _LIB_RING_H */
@@ -0,0 +1,63 @@
+/*
+ * kernel/include/lib/word_at_a_time.h
+ *
+ * Finding a zero byte in a 64-bit word without looking at each byte
+ *
+ * Both architectures are little-endian, so the lowest flagged byte is the
+ * first one in memory. Callers only load aligned words: an aligned word
+ * never straddles a page, so reading the bytes after a terminator in the
+ * same word cannot fault even when the string ends just before an
+ * unmapped page.
+ */
+
+#ifndef _LIB_WORD_AT_A_TIME_H
+#define _LIB_WORD_AT_A_TIME_H
+
+#include <stdint.h>
+#include <arch_string.h>
+
+// Loads through this may alias the char arrays they read
+typedef uint64_t __attribute__((may_alias)) word_alias_t;
+
+#define WORD_ONES   0x0101010101010101UL
+#define WORD_LOW7   0x7f7f7f7f7f7f7f7fUL
+#define WORD_HIGHS  0x8080808080808080UL
+
+/*
+ * 0x80 in every byte of w that is zero, and nothing else. Adding 0x7f to
+ * the low seven bits of a byte carries into bit 7 unless all seven are
+ * clear; OR in the byte itself and only zero bytes are left without bit 7.
+ * No carry crosses a byte, so unlike the shorter (w - ONES) & ~w trick
+ * there are no false hits above the first zero.
+ */
+static inline uint64_t word_zero_bytes(uint64_t w) {
+#if ARCH_HAS_WORD_AT_A_TIME
+    if (arch_word_at_a_time_usable()) {
+        return arch_word_zero_bytes(w);
+    }
+#endif
+    return ~(((w & WORD_LOW7) + WORD_LOW7) | w | WORD_LOW7);
+}
+
+// Bytes of w equal to c
+static inline uint64_t word_match_bytes(uint64_t w, uint8_t c) {
+    return word_zero_bytes(w ^ (WORD_ONES * c));
+}
+
+// Index of the lowest byte flagged in a non-zero word_zero_bytes() mask.
+// The bytes below it become 0xff and the multiply sums one per byte into
+// the top byte, without needing a count-trailing-zeros instruction.
+static inline unsigned int word_first_byte(uint64_t mask) {
+    uint64_t below;
+
+#if ARCH_HAS_WORD_AT_A_TIME
+    if (arch_word_at_a_time_usable()) {
+        return arch_word_first_byte(mask);
+    }
+#endif
+    below = ((mask - 1) & ~mask) >> 7;
+
+    return (unsigned int)((below * 0x0001020304050608UL) >> 56);
+}
+
+#endif /* _LIB_WORD_AT_A_TIME_H */
@@ -0,0 +1,27 @@
+/*
+ * kernel/include/memory/clear_page.h
+ *
+ * Page zeroing
+ */
+
+#ifndef _CLEAR_PAGE_H_
+#define _CLEAR_PAGE_H_
+
+#include <stddef.h>
+
+// Pick the cache-block zeroing instruction if the CPU has a usable one
+// (DC ZVA on ARM64, Zicboz cbo.zero on RISC-V). Needs the device tree.
+// Until it runs, pages are cleared with ordinary stores.
+void clear_page_init(void);
+
+// Zero count pages starting at the page-aligned kernel address addr
+void clear_pages(void *addr, size_t count);
+
+static inline void clear_page(void *addr) {
+    clear_pages(addr, 1);
+}
+
+// Bytes zeroed per instruction, 0 when falling back to stores
+size_t clear_page_block_size(void);
+
+#endif // _CLEAR_PAGE_H_
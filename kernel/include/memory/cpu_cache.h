@@ -1,20 +1,26 @@
 /*
  * kernel/include/memory/cpu_cache.h
  *
- * ARM64 cache management functions
+ * Architecture-independent cache management
  */
 
 #ifndef _CPU_CACHE_H_
 #define _CPU_CACHE_H_
 
-#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// After fdt_mgr_init() and cpufeature_init(): RISC-V reads the cache block
+// size and Zicbom from the device tree
+void cpu_cache_init(void);
 
 /* Data cache operations */
-void dcache_clean_range(uint64_t start, uint64_t size);
-void dcache_invalidate_range(uint64_t start, uint64_t size);
-void dcache_clean_invalidate_range(uint64_t start, uint64_t size);
+void cpu_dcache_clean_range(void *addr, size_t size);
+void cpu_dcache_invalidate_range(void *addr, size_t size);
+void cpu_dcache_clean_invalidate_range(void *addr, size_t size);
+size_t cpu_dcache_line_size(void);
 
-/* Instruction cache operations */
-void icache_invalidate_all(void);
+// True when devices see the CPU's caches and the range operations do nothing
+bool cpu_dcache_coherent(void);
 
-#endif /* _CPU_CACHE_H_ */
\ No newline at end of file
+#endif /* _CPU_CACHE_H_ */
@@ -0,0 +1,106 @@
+/*
+ * kernel/include/memory/dma.h
+ *
+ * DMA mapping API
+ *
+ * Drivers hand buffers to devices through this rather than calling the
+ * cache maintenance routines themselves. Bus addresses are physical
+ * addresses; dma-ranges translation is not applied. Buffers passed to the
+ * streaming calls must be physically contiguous kernel memory: kmalloc
+ * or page allocations (the DMAP) or the kernel image.
+ *
+ * A streaming mapping belongs to the device between map and unmap (or
+ * between sync_for_device and sync_for_cpu); the CPU must not touch the
+ * buffer in that window. For a device that does not snoop the caches,
+ * map cleans the buffer and unmap invalidates it unless it went only to
+ * the device. Buffers the device cannot reach (above its dma_mask, or
+ * outside RAM that memmap marks DMA capable) are bounced through a pool
+ * of low memory, as are non-coherent receive buffers that share a cache
+ * line with anything else; align those to dma_get_cache_alignment() to
+ * avoid the copy.
+ */
+
+#ifndef _DMA_H_
+#define _DMA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+struct device;
+
+typedef uint64_t dma_addr_t;
+
+enum dma_data_direction {
+    DMA_BIDIRECTIONAL,
+    DMA_TO_DEVICE,
+    DMA_FROM_DEVICE,
+};
+
+#define DMA_BIT_MASK(n)     ((n) >= 64 ? ~0ULL : (1ULL << (n)) - 1)
+#define DMA_MAPPING_ERROR   (~(dma_addr_t)0)
+
+static inline bool dma_mapping_error(dma_addr_t addr) {
+    return addr == DMA_MAPPING_ERROR;
+}
+
+// One buffer of a scatter-gather list; dma_map_sg() fills dma_address
+struct dma_sg {
+    void        *addr;
+    size_t      length;
+    dma_addr_t  dma_address;
+};
+
+// Bounce buffer pool and, where devices may not snoop, the uncached
+// coherent pool. After devmap_init(), before drivers probe.
+void dma_init(void);
+
+// Highest bus address the device can reach; returns -1 and leaves the
+// mask alone if no memory, bounce buffers included, lies below it
+int dma_set_mask(struct device *dev, uint64_t mask);
+
+// Whether the device snoops CPU caches, so no maintenance is needed
+bool dma_is_coherent(struct device *dev);
+
+// Alignment and size granule that keeps a buffer off shared cache lines
+size_t dma_get_cache_alignment(void);
+
+// Zeroed memory both the CPU and the device can use at any time without
+// syncs. Uncached for non-coherent devices, so keep CPU access light.
+void *dma_alloc_coherent(struct device *dev, size_t size, dma_addr_t *dma_handle);
+void dma_free_coherent(struct device *dev, size_t size, void *cpu_addr,
+                       dma_addr_t dma_handle);
+
+// Streaming mappings of one buffer
+dma_addr_t dma_map_single(struct device *dev, void *ptr, size_t size,
+                          enum dma_data_direction dir);
+void dma_unmap_single(struct device *dev, dma_addr_t addr, size_t size,
+                      enum dma_data_direction dir);
+void dma_sync_single_for_cpu(struct device *dev, dma_addr_t addr, size_t size,
+                             enum dma_data_direction dir);
+void dma_sync_single_for_device(struct device *dev, dma_addr_t addr, size_t size,
+                                enum dma_data_direction dir);
+
+// Streaming mappings of a list. Cache maintenance for the whole list is
+// issued together, merging buffers that touch, and waited for once.
+// dma_map_sg() returns nents, or 0 with nothing mapped.
+int dma_map_sg(struct device *dev, struct dma_sg *sg, int nents,
+               enum dma_data_direction dir);
+void dma_unmap_sg(struct device *dev, struct dma_sg *sg, int nents,
+                  enum dma_data_direction dir);
+void dma_sync_sg_for_cpu(struct device *dev, struct dma_sg *sg, int nents,
+                         enum dma_data_direction dir);
+void dma_sync_sg_for_device(struct device *dev, struct dma_sg *sg, int nents,
+                            enum dma_data_direction dir);
+
+// Bounce buffer use, for tests and diagnostics
+struct dma_stats {
+    uint64_t bounce_maps;           // Streaming mappings that bounced
+    uint64_t bounce_bytes;          // Bytes copied to or from the pool
+    size_t swiotlb_free;            // Free bounce bytes
+    size_t coherent_pool_free;      // Free uncached coherent pool bytes
+};
+
+void dma_get_stats(struct dma_stats *stats);
+
+#endif // _DMA_H_
@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <seqlock.h>
 
 // Maximum length for type names
 #define MALLOC_TYPE_NAME_MAX    16
@@ -34,8 +35,10 @@ struct malloc_type {
     const char *name;             // Short name (e.g., "devbuf")
     const char *desc;             // Longer description
     
-    // Statistics
+    // Statistics. Updates from any CPU serialise on stats_lock; readers
+    // use malloc_type_get_stats() for a consistent copy.
     struct malloc_type_stats stats;
+    seqlock_t stats_lock;
     
     // Linked list of all types
     struct malloc_type *next;
@@ -57,6 +60,7 @@ struct malloc_type {
         .name = shortname, \
         .desc = longname, \
         .stats = {0}, \
+        .stats_lock = SEQLOCK_INITIALIZER, \
         .next = NULL, \
         .flags = MT_FLAGS_STATIC, \
         .private = NULL \
@@ -86,6 +90,7 @@ void malloc_type_unregister(struct malloc_type *type);
 // Statistics functions
 void malloc_type_update_alloc(struct malloc_type *type, size_t size);
 void malloc_type_update_free(struct malloc_type *type, size_t size);
+void malloc_type_update_failed(struct malloc_type *type);
 void malloc_type_dump_stats(void);
 void malloc_type_get_stats(struct malloc_type *type, struct malloc_type_stats *stats);
 
@@ -12,7 +12,10 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+// Same value as vmm.h; either may be included first
+#ifndef PAGE_SIZE
 #define PAGE_SIZE 4096
+#endif
 #define PAGE_SHIFT 12
 
 #define PAGE_ALLOC_MAX_ORDER 12
@@ -103,6 +106,8 @@ void page_alloc_dump_free_lists(void);
 void page_alloc_check_integrity(void);
 #endif
 
+// Internals, exposed for the tests. These do not take the allocator lock;
+// page_alloc() and page_free() are the thread-safe entry points.
 uint64_t page_alloc_chunk_from_pmm(size_t size);
 void page_alloc_return_chunk_to_pmm(struct page_chunk *chunk);
 void page_alloc_check_empty_chunks(void);
@@ -10,6 +10,8 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <smp.h>
+#include <seqlock.h>
 
 // Forward declarations
 struct kmem_cache;
@@ -46,6 +48,17 @@ struct kmem_slab {
 // Cache line size for ARM64 (typical)
 #define CACHE_LINE_SIZE 64
 
+// Most caches that can exist at once; each owns one statistics slot
+// in every CPU's per-CPU area
+#define SLAB_MAX_CACHES 64
+
+// Per-CPU statistics slot. Its CPU updates it inside seq so
+// kmem_cache_stats() reads it whole.
+struct kmem_cpu_stats {
+    seqcount_t seq;
+    struct kmem_stats stats;
+};
+
 // Slab cache structure - optimized for cache line alignment
 // Organized into hot, warm, and cold cache lines for better performance
 struct kmem_cache {
@@ -77,7 +90,8 @@ struct kmem_cache {
     };
     
     // Cold fields - rarely accessed (variable size, aligned)
-    struct kmem_stats stats;               // Statistics
+    // Statistics are kept per CPU and summed by kmem_cache_stats()
+    unsigned int stats_slot;              // Index into slab_cpu_stats
     void (*ctor)(void *obj);              // Object constructor
     void (*dtor)(void *obj);              // Object destructor
     char name_overflow[16];               // Extra space for longer names
@@ -0,0 +1,66 @@
+/*
+ * kernel/include/memory/tlbflush.h
+ *
+ * Kernel TLB shootdown
+ *
+ * After a kernel mapping is removed or changed, every CPU's TLB has to
+ * forget it. Where the architecture broadcasts invalidations (ARM64 TLBI
+ * ...IS) that is one instruction per page and a barrier. Elsewhere the
+ * local TLB is flushed and the other online CPUs are asked too, through
+ * firmware (SBI RFENCE) if it offers that, else by cross-CPU call. A
+ * batch collects the pages of one operation so they all go in a single
+ * round; past TLB_FLUSH_ALL_PAGES pages the whole TLB is flushed instead.
+ */
+
+#ifndef _MEMORY_TLBFLUSH_H_
+#define _MEMORY_TLBFLUSH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory/vmm.h>
+
+/* Above this many pages a range is cheaper to flush as the whole TLB */
+#define TLB_FLUSH_ALL_PAGES     64
+
+struct tlb_batch {
+    uintptr_t start;
+    uintptr_t end;
+    size_t nr_pages;
+};
+
+#define TLB_BATCH_INIT          { .start = UINTPTR_MAX, .end = 0, .nr_pages = 0 }
+
+/* Note a page whose mapping was just changed; nothing is flushed yet */
+static inline void tlb_batch_add(struct tlb_batch *batch, uintptr_t vaddr) {
+    if (vaddr < batch->start) {
+        batch->start = vaddr;
+    }
+    if (vaddr + PAGE_SIZE > batch->end) {
+        batch->end = vaddr + PAGE_SIZE;
+    }
+    batch->nr_pages++;
+}
+
+/* Flush everything added since the last flush, on every CPU */
+void tlb_batch_flush(struct tlb_batch *batch);
+
+/*
+ * Flush [start, end) of the kernel address space on every online CPU,
+ * returning once no CPU can use a stale entry. The page table writes
+ * must be done; the barrier that publishes them is taken here. Without
+ * broadcast invalidation this may wait on other CPUs, so it must not be
+ * called with interrupts masked under a lock they could be spinning on.
+ */
+void flush_tlb_kernel_range(uintptr_t start, uintptr_t end);
+
+struct tlb_flush_stats {
+    uint64_t flushes;                   // flush_tlb_kernel_range() calls
+    uint64_t pages;                     // Pages asked for
+    uint64_t full_flushes;              // Done as a whole-TLB flush
+    uint64_t firmware_rounds;           // Remote CPUs reached through SBI
+    uint64_t ipi_rounds;                // Remote CPUs reached by cross-CPU call
+};
+
+void tlb_flush_get_stats(struct tlb_flush_stats *stats);
+
+#endif /* _MEMORY_TLBFLUSH_H_ */
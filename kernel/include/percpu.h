@@ -0,0 +1,102 @@
+/*
+ * kernel/include/percpu.h
+ *
+ * Per-CPU data areas
+ *
+ * Variables defined with DEFINE_PER_CPU are placed in the .percpu linker
+ * section. The boot CPU uses that section in place; every secondary CPU
+ * gets a private copy allocated by percpu_init(). Each CPU keeps the
+ * offset of its copy from the template in an architecture register
+ * (TPIDR_EL1 on ARM64, tp on RISC-V), so this_cpu_ptr() is one register
+ * read and an add.
+ */
+
+#ifndef _PERCPU_H_
+#define _PERCPU_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <smp.h>
+#include <arch_percpu.h>
+#include <arch_cpu.h>
+
+/* Alignment of each per-CPU area (keeps CPUs off each other's lines) */
+#define PERCPU_ALIGN 64
+
+/* Define / declare a per-CPU variable */
+#define DEFINE_PER_CPU(type, name) \
+    __attribute__((section(".percpu"))) __typeof__(type) name
+
+#define DEFINE_PER_CPU_ALIGNED(type, name) \
+    __attribute__((section(".percpu"), aligned(PERCPU_ALIGN))) __typeof__(type) name
+
+#define DECLARE_PER_CPU(type, name) \
+    extern __typeof__(type) name
+
+/* Template bounds from the linker script */
+extern char __per_cpu_start[];
+extern char __per_cpu_end[];
+
+/* Offset of each CPU's area from the template */
+extern uintptr_t __per_cpu_offset[NR_CPUS];
+
+/* Logical CPU number, valid on every CPU once it has its area */
+DECLARE_PER_CPU(unsigned int, cpu_number);
+
+#define per_cpu_offset(cpu)     (__per_cpu_offset[(cpu)])
+
+#define SHIFT_PERCPU_PTR(ptr, off) \
+    ((__typeof__(ptr))((uintptr_t)(ptr) + (off)))
+
+/* Access another CPU's instance */
+#define per_cpu_ptr(var, cpu)   SHIFT_PERCPU_PTR(&(var), per_cpu_offset(cpu))
+#define per_cpu(var, cpu)       (*per_cpu_ptr(var, cpu))
+
+/* Access the calling CPU's instance */
+#define this_cpu_ptr(var)       SHIFT_PERCPU_PTR(&(var), arch_percpu_offset())
+
+/*
+ * Raw accessors - caller must already be safe against interrupts
+ * touching the same variable on this CPU
+ */
+#define __this_cpu_read(var)        (*this_cpu_ptr(var))
+#define __this_cpu_write(var, val)  do { *this_cpu_ptr(var) = (val); } while (0)
+#define __this_cpu_add(var, val)    do { *this_cpu_ptr(var) += (val); } while (0)
+#define __this_cpu_sub(var, val)    do { *this_cpu_ptr(var) -= (val); } while (0)
+#define __this_cpu_inc(var)         __this_cpu_add(var, 1)
+#define __this_cpu_dec(var)         __this_cpu_sub(var, 1)
+
+/*
+ * IRQ-safe accessors - the read-modify-write is done with interrupts
+ * masked so a handler on the same CPU cannot lose an update
+ */
+#define this_cpu_read(var)          __this_cpu_read(var)
+
+#define this_cpu_write(var, val) do { \
+    uint64_t __pcpu_flags = arch_save_interrupts(); \
+    __this_cpu_write(var, val); \
+    arch_restore_interrupts(__pcpu_flags); \
+} while (0)
+
+#define this_cpu_add(var, val) do { \
+    uint64_t __pcpu_flags = arch_save_interrupts(); \
+    __this_cpu_add(var, val); \
+    arch_restore_interrupts(__pcpu_flags); \
+} while (0)
+
+#define this_cpu_sub(var, val) do { \
+    uint64_t __pcpu_flags = arch_save_interrupts(); \
+    __this_cpu_sub(var, val); \
+    arch_restore_interrupts(__pcpu_flags); \
+} while (0)
+
+#define this_cpu_inc(var)           this_cpu_add(var, 1)
+#define this_cpu_dec(var)           this_cpu_sub(var, 1)
+
+/* Allocate and populate per-CPU areas for CPUs 1..nr_cpu_ids-1 */
+void percpu_init(void);
+
+/* Point the calling CPU at its per-CPU area */
+void percpu_setup_cpu(unsigned int cpu);
+
+#endif /* _PERCPU_H_ */
@@ -0,0 +1,41 @@
+/*
+ * kernel/include/preempt.h
+ *
+ * Preemption control
+ *
+ * The scheduler tick may switch threads when it interrupts code running
+ * with interrupts enabled. Code that must stay on the CPU without masking
+ * interrupts (spinlock holders, RCU readers) raises this CPU's
+ * preempt_count instead. The tick leaves such code alone and reschedules
+ * at the next tick after the count drops back to zero.
+ */
+
+#ifndef _PREEMPT_H_
+#define _PREEMPT_H_
+
+#include <stdbool.h>
+#include <percpu.h>
+
+DECLARE_PER_CPU(int, preempt_count);
+
+static inline void preempt_disable(void) {
+    // An interrupt between the load and the store leaves the count as
+    // it found it, so the plain per-CPU increment is safe
+    __this_cpu_inc(preempt_count);
+    __asm__ volatile("" ::: "memory");
+}
+
+static inline void preempt_enable(void) {
+    __asm__ volatile("" ::: "memory");
+    __this_cpu_dec(preempt_count);
+}
+
+static inline int preempt_count_get(void) {
+    return __this_cpu_read(preempt_count);
+}
+
+static inline bool preemptible(void) {
+    return preempt_count_get() == 0 && arch_interrupts_enabled();
+}
+
+#endif /* _PREEMPT_H_ */
@@ -0,0 +1,87 @@
+/*
+ * kernel/include/qspinlock.h
+ *
+ * Queued (MCS-style) spinlock
+ *
+ * A 32-bit lock word holding a "locked" byte and a tail that names the
+ * last CPU queued on the lock. Uncontended acquire and release are a
+ * single compare-and-swap and a single store-release. Under contention
+ * each waiter spins on a node in its own per-CPU area instead of on the
+ * shared lock word, so a release only touches the next waiter's cache
+ * line. Waiters are served in FIFO order. Like spin_lock(), holding or
+ * waiting for the lock disables preemption.
+ *
+ * Word layout:
+ *   bits  0-7   locked byte
+ *   bits 16-17  tail node index (nesting level on the queued CPU)
+ *   bits 18-31  tail CPU + 1 (0 means the queue is empty)
+ */
+
+#ifndef _QSPINLOCK_H_
+#define _QSPINLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <arch_spinlock.h>
+#include <preempt.h>
+
+typedef struct qspinlock {
+    union {
+        volatile uint32_t val;
+        struct {
+            volatile uint8_t locked;
+            volatile uint8_t reserved;
+            volatile uint16_t tail;
+        };
+    };
+} qspinlock_t;
+
+#define QSPINLOCK_INITIALIZER   { { 0 } }
+
+#define _Q_LOCKED_VAL           1U
+#define _Q_LOCKED_MASK          0xFFU
+#define _Q_TAIL_IDX_OFFSET      16
+#define _Q_TAIL_IDX_BITS        2
+#define _Q_TAIL_CPU_OFFSET      (_Q_TAIL_IDX_OFFSET + _Q_TAIL_IDX_BITS)
+#define _Q_TAIL_MASK            0xFFFF0000U
+
+// Queue nodes per CPU: task, IRQ and nested IRQ contexts, plus one spare
+#define QSPIN_MAX_NODES         (1 << _Q_TAIL_IDX_BITS)
+
+void queued_spin_lock_slowpath(qspinlock_t *lock);
+
+static inline void qspin_lock_init(qspinlock_t *lock) {
+    lock->val = 0;
+}
+
+static inline bool qspin_trylock(qspinlock_t *lock) {
+    if (lock->val != 0) {
+        return false;
+    }
+    preempt_disable();
+    if (arch_spin_cmpxchg_acquire(&lock->val, 0, _Q_LOCKED_VAL) != 0) {
+        preempt_enable();
+        return false;
+    }
+    return true;
+}
+
+static inline void qspin_lock(qspinlock_t *lock) {
+    preempt_disable();
+    if (arch_spin_cmpxchg_acquire(&lock->val, 0, _Q_LOCKED_VAL) == 0) {
+        return;
+    }
+    queued_spin_lock_slowpath(lock);
+}
+
+static inline void qspin_unlock(qspinlock_t *lock) {
+    // Only the locked byte is cleared; the tail belongs to the waiters
+    __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+    preempt_enable();
+}
+
+static inline bool qspin_is_locked(qspinlock_t *lock) {
+    return lock->val != 0;
+}
+
+#endif /* _QSPINLOCK_H_ */
@@ -0,0 +1,86 @@
+/*
+ * kernel/include/rcu.h
+ *
+ * Read-copy-update for read-mostly data
+ *
+ * Quiescent-state based: a CPU that reaches a point where it holds no
+ * RCU-protected pointers (the idle loop, a context switch, a call to
+ * rcu_quiescent_state(), its own synchronize_rcu()) has finished every
+ * read-side critical section it started before. Once every online CPU
+ * has done so after an update, the old version can be freed. Readers
+ * therefore pay almost nothing: rcu_read_lock() and rcu_read_unlock()
+ * only disable preemption, so the scheduler cannot switch away (a
+ * quiescent state) in the middle of a read-side section.
+ *
+ * Readers must not sleep or spin waiting for another CPU's quiescent
+ * state inside a read-side section.
+ */
+
+#ifndef _RCU_H_
+#define _RCU_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <preempt.h>
+
+struct rcu_head {
+    struct rcu_head *next;
+    void (*func)(struct rcu_head *head);
+};
+
+typedef void (*rcu_callback_t)(struct rcu_head *head);
+
+static inline void rcu_read_lock(void) {
+    preempt_disable();
+}
+
+static inline void rcu_read_unlock(void) {
+    preempt_enable();
+}
+
+/*
+ * Load an RCU-protected pointer. The address dependency orders the
+ * reads through it after the load on both ARM64 and RISC-V.
+ */
+#define rcu_dereference(p)  (*(volatile __typeof__(p) *)&(p))
+
+/* Publish a pointer: everything written to the object is visible first */
+#define rcu_assign_pointer(p, v) do { \
+    __typeof__(p) __rcu_v = (v); \
+    __atomic_store_n(&(p), __rcu_v, __ATOMIC_RELEASE); \
+} while (0)
+
+/* Store without ordering (NULL, or an object readers cannot reach yet) */
+#define RCU_INIT_POINTER(p, v) do { \
+    *(volatile __typeof__(p) *)&(p) = (v); \
+} while (0)
+
+/* Wait until every reader that might see the old version has finished */
+void synchronize_rcu(void);
+
+/* Run func(head) after a grace period; usable from any context */
+void call_rcu(struct rcu_head *head, rcu_callback_t func);
+
+/* Wait for every callback queued on this CPU to run */
+void rcu_barrier(void);
+
+/*
+ * Tell RCU this CPU holds no RCU-protected pointers, and run any of its
+ * callbacks whose grace period has ended
+ */
+void rcu_quiescent_state(void);
+
+/* Cheap quiescent-state report for the scheduler; runs no callbacks */
+void rcu_note_context_switch(void);
+
+/* True if this CPU has callbacks waiting for a grace period */
+bool rcu_pending(void);
+
+/*
+ * Mark an idle stretch (extended quiescent state). An idle CPU does not
+ * hold up grace periods, so it can sleep in WFE/WFI.
+ */
+void rcu_idle_enter(void);
+void rcu_idle_exit(void);
+
+#endif /* _RCU_H_ */
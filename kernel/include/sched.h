@@ -0,0 +1,135 @@
+/*
+ * kernel/include/sched.h
+ *
+ * Kernel threads and the scheduler
+ *
+ * Every CPU has its own run queue: one FIFO list per priority and a
+ * bitmap of the non-empty lists, so picking the next thread is a find-
+ * first-set and a list pop whatever the number of threads. Threads stay
+ * on the CPU they were created for. Priority 0 is the highest; threads
+ * of equal priority share the CPU round-robin, one timeslice each.
+ *
+ * The boot CPU's timer drives a periodic tick that preempts a thread
+ * whose timeslice has run out, unless it is inside a preempt_disable()
+ * section (spinlock, RCU read side). The boot CPU passes each tick on to
+ * the busy secondaries by IPI. Without IPIs secondaries get no tick and
+ * switch only when a thread sleeps, yields or exits.
+ */
+
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lib/list.h>
+#include <percpu.h>
+#include <arch_thread.h>
+#include <time/timer.h>
+
+/* Priorities: 0 is the highest */
+#define SCHED_NR_PRIO       32
+#define SCHED_PRIO_DEFAULT  16
+#define SCHED_PRIO_MIN      (SCHED_NR_PRIO - 1)
+
+/* Default timeslice */
+#define SCHED_TIMESLICE     5       // Ticks
+
+/* Stack given to each kernel thread */
+#define KTHREAD_STACK_PAGES 4
+
+/* Task states */
+#define TASK_RUNNING        0       // On a run queue or on a CPU
+#define TASK_SLEEPING       1       // Waiting for wake_up_process()
+#define TASK_DEAD           2       // Exited; freed by the next task to run
+
+/* Task flags */
+#define TASK_FLAG_IDLE      (1U << 0)   // Per-CPU idle task, never queued
+#define TASK_FLAG_STATIC    (1U << 1)   // Stack and struct not allocated by kthread_create()
+
+struct task {
+    struct arch_thread_context ctx;     // Must stay first: see arch_switch_to()
+    volatile int state;
+    int prio;
+    unsigned int cpu;
+    uint32_t flags;
+    bool on_rq;
+    int timeslice;                      // Ticks left before preemption
+    struct list_head run_list;
+    void (*fn)(void *arg);
+    void *arg;
+    uint64_t stack_phys;
+    const char *name;
+    uint64_t nr_switches;               // Times switched in
+};
+
+DECLARE_PER_CPU(struct task *, current_task);
+
+/* The task running on this CPU */
+static inline struct task *get_current(void) {
+    return __this_cpu_read(current_task);
+}
+
+/* Set the state the next schedule() acts on (see wait.h for the pattern) */
+static inline void set_current_state(int state) {
+    __atomic_store_n(&get_current()->state, state, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * Boot-time setup: run queues for every CPU, the calling context becomes
+ * CPU 0's first task and CPU 0 gets an idle thread. Call after
+ * percpu_init() and before smp_boot_secondaries().
+ */
+void sched_init(void);
+
+/* Adopt a secondary CPU's boot context as its idle task */
+void sched_init_secondary(unsigned int cpu);
+
+/* Called from the tick (time/tick.c) */
+void sched_tick(void);
+
+/* Called at the end of interrupt handling; switches if the tick asked to */
+void sched_irq_exit(void);
+
+/* Give up the CPU. Must not be called with preemption disabled. */
+void schedule(void);
+
+/* Let other threads of the same or higher priority run */
+void sched_yield(void);
+
+/* Make a sleeping or new task runnable; returns false if it already was */
+bool wake_up_process(struct task *task);
+
+/*
+ * Switch now if a higher-priority thread was woken on this CPU. A no-op
+ * with preemption or interrupts disabled; the next tick catches up.
+ */
+void sched_preempt_point(void);
+
+/* True if this CPU has a thread other than idle ready to run */
+bool sched_cpu_has_work(void);
+
+/* Sleep for at least the given number of ticks or milliseconds */
+void sleep_ticks(uint64_t ticks);
+void msleep(uint64_t ms);
+
+/*
+ * Create a kernel thread that will run fn(arg) on the given CPU (or the
+ * calling CPU for kthread_create). The thread starts sleeping; pass it
+ * to wake_up_process(), or use kthread_run() to do both.
+ * Returns NULL on allocation failure or an offline CPU.
+ */
+struct task *kthread_create_on_cpu(void (*fn)(void *), void *arg,
+                                   const char *name, unsigned int cpu);
+struct task *kthread_create(void (*fn)(void *), void *arg, const char *name);
+struct task *kthread_run(void (*fn)(void *), void *arg, const char *name);
+
+/* Change priority; only for threads that have not been woken yet */
+void kthread_set_prio(struct task *task, int prio);
+
+/* End the calling thread. Returning from the thread function does the same. */
+void kthread_exit(void) __attribute__((noreturn));
+
+/* Context switch primitive, implemented in arch switch.S */
+struct task *arch_switch_to(struct task *prev, struct task *next);
+
+#endif /* _SCHED_H_ */
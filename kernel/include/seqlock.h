@@ -0,0 +1,96 @@
+/*
+ * kernel/include/seqlock.h
+ *
+ * Sequence counters for lock-free readers
+ *
+ * A writer makes the count odd while it updates the data and even again
+ * when it is done. A reader copies the data between read_seqcount_begin()
+ * and read_seqcount_retry() and starts over if the count moved, so
+ * readers never write shared memory and never hold up the writer.
+ *
+ * Writers of a bare seqcount_t must be serialised by the caller, by a lock
+ * they already hold or by only ever writing per-CPU data. seqlock_t adds
+ * the lock for writers that have none. A reader that interrupts a writer
+ * on the same CPU would spin forever, so data that is read from interrupt
+ * context must be written with interrupts masked.
+ */
+
+#ifndef _SEQLOCK_H_
+#define _SEQLOCK_H_
+
+#include <stdbool.h>
+#include <arch_timer.h>
+#include <spinlock.h>
+
+typedef struct {
+    unsigned int sequence;
+} seqcount_t;
+
+#define SEQCNT_ZERO { .sequence = 0 }
+
+static inline void seqcount_init(seqcount_t *s) {
+    s->sequence = 0;
+}
+
+// Wait out a writer in progress and return the count to check against
+static inline unsigned int read_seqcount_begin(const seqcount_t *s) {
+    unsigned int seq;
+
+    while ((seq = __atomic_load_n(&s->sequence, __ATOMIC_ACQUIRE)) & 1) {
+        arch_cpu_relax();
+    }
+    return seq;
+}
+
+// True if a writer ran since read_seqcount_begin(): the copy is torn
+static inline bool read_seqcount_retry(const seqcount_t *s, unsigned int start) {
+    // Order the data loads before the second read of the count
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&s->sequence, __ATOMIC_RELAXED) != start;
+}
+
+static inline void write_seqcount_begin(seqcount_t *s) {
+    __atomic_store_n(&s->sequence, s->sequence + 1, __ATOMIC_RELAXED);
+    // The odd count is visible before any of the data stores
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void write_seqcount_end(seqcount_t *s) {
+    __atomic_store_n(&s->sequence, s->sequence + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Sequence count with its own writer lock. Writers take the lock with
+ * interrupts masked; readers never touch it.
+ */
+typedef struct {
+    seqcount_t seqcount;
+    spinlock_t lock;
+} seqlock_t;
+
+#define SEQLOCK_INITIALIZER { .seqcount = SEQCNT_ZERO, .lock = SPINLOCK_INITIALIZER }
+
+static inline void seqlock_init(seqlock_t *sl) {
+    seqcount_init(&sl->seqcount);
+    spin_lock_init(&sl->lock);
+}
+
+#define write_seqlock_irqsave(sl, flags) do { \
+    spin_lock_irqsave(&(sl)->lock, flags); \
+    write_seqcount_begin(&(sl)->seqcount); \
+} while (0)
+
+#define write_sequnlock_irqrestore(sl, flags) do { \
+    write_seqcount_end(&(sl)->seqcount); \
+    spin_unlock_irqrestore(&(sl)->lock, flags); \
+} while (0)
+
+static inline unsigned int read_seqbegin(const seqlock_t *sl) {
+    return read_seqcount_begin(&sl->seqcount);
+}
+
+static inline bool read_seqretry(const seqlock_t *sl, unsigned int start) {
+    return read_seqcount_retry(&sl->seqcount, start);
+}
+
+#endif /* _SEQLOCK_H_ */
@@ -0,0 +1,140 @@
+/*
+ * kernel/include/smp.h
+ *
+ * Symmetric multiprocessing support
+ * CPU enumeration from the device tree, secondary CPU bring-up and
+ * inter-processor interrupts
+ */
+
+#ifndef _SMP_H_
+#define _SMP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lib/list.h>
+
+/* Maximum number of CPUs supported by the kernel */
+#ifndef CONFIG_NR_CPUS
+#define CONFIG_NR_CPUS 8
+#endif
+
+#define NR_CPUS CONFIG_NR_CPUS
+
+#if NR_CPUS > 64
+#error "cpumask_t holds at most 64 CPUs"
+#endif
+
+/* A set of logical CPUs, bit n for CPU n */
+typedef uint64_t cpumask_t;
+
+#define cpumask_of(cpu)     (1ULL << (cpu))
+
+#include <percpu.h>
+
+/* Size of the stack given to each secondary CPU */
+#define SMP_STACK_PAGES 4
+
+/* Number of CPUs found in the device tree (capped at NR_CPUS) */
+extern unsigned int nr_cpu_ids;
+
+/* Hardware identifier of each logical CPU (MPIDR affinity or hart id) */
+extern uint64_t cpu_hwid[NR_CPUS];
+
+/* Iterate over every CPU that has a per-CPU area */
+#define for_each_possible_cpu(cpu) \
+    for ((cpu) = 0; (cpu) < nr_cpu_ids; (cpu)++)
+
+/* Iterate over every CPU that has come online */
+#define for_each_online_cpu(cpu) \
+    for ((cpu) = 0; (cpu) < nr_cpu_ids; (cpu)++) \
+        if (cpu_online(cpu))
+
+/* Logical number of the calling CPU (0 is always the boot CPU) */
+#define smp_processor_id()  __this_cpu_read(cpu_number)
+
+/* Check whether a CPU has finished bring-up */
+bool cpu_online(unsigned int cpu);
+
+/* Number of CPUs currently online */
+unsigned int num_online_cpus(void);
+
+/* Enumerate CPUs from the device tree (boot CPU becomes CPU 0) */
+void smp_init_cpus(void *fdt);
+
+/* Start all secondary CPUs found by smp_init_cpus() */
+void smp_boot_secondaries(void);
+
+/* Online CPUs, as a mask */
+cpumask_t cpu_online_mask(void);
+
+/*
+ * Inter-processor interrupts. Each CPU has one hardware IPI (a GIC SGI,
+ * or an SBI IPI on RISC-V) and a word of pending messages; a sender sets
+ * its bit and raises the interrupt only if no message was already
+ * pending, so a burst of messages costs the target one interrupt.
+ */
+enum ipi_msg_type {
+    IPI_RESCHEDULE,         // Look at the run queue; also ends an idle sleep
+    IPI_CALL_FUNC,          // Run the queued function calls
+    IPI_TIMER,              // Reprogram the clock event for the first hrtimer
+    IPI_TICK,               // Run the scheduler tick for the current thread
+    NR_IPI,
+};
+
+/* Set up the boot CPU's IPI; without one, idle CPUs fall back to polling */
+void smp_ipi_init(void);
+
+/* True once IPIs can be sent */
+bool smp_ipi_available(void);
+
+void smp_send_ipi(unsigned int cpu, enum ipi_msg_type msg);
+void smp_send_ipi_mask(cpumask_t mask, enum ipi_msg_type msg);
+
+/* Make an idle or preemptible CPU pick up newly queued work */
+void smp_send_reschedule(unsigned int cpu);
+
+/* Called by the arch IPI interrupt handler on the receiving CPU */
+void smp_ipi_interrupt(void);
+
+/*
+ * Without IPIs, run the calls queued for this CPU. The secondaries'
+ * idle loops poll their queues; the boot CPU calls this from its tick
+ * and its idle loop.
+ */
+void smp_poll_call_queue(void);
+
+/* IPIs of each type this CPU has taken */
+uint64_t smp_ipi_count(unsigned int cpu, enum ipi_msg_type msg);
+
+/* Function run on another CPU by smp_call_function_single() */
+typedef void (*smp_call_func_t)(void *arg);
+
+/* One queued call; locked from queueing until the target is done with it */
+struct call_single_data {
+    struct list_head node;
+    smp_call_func_t func;
+    void *arg;
+    volatile uint32_t flags;
+};
+
+/*
+ * Run func(arg) on another CPU, from its IPI handler (interrupts off) or
+ * its idle loop. Calls to one CPU run in the order they were queued.
+ * Waits for the previous call from this CPU to that CPU to be taken off
+ * the queue; with wait set, also waits for func to return.
+ * Returns 0, or -1 if the CPU is not online or is the caller.
+ */
+int smp_call_function_single(unsigned int cpu, smp_call_func_t func,
+                             void *arg, bool wait);
+
+/*
+ * Run func(arg) on every online CPU in mask except the caller, with one
+ * IPI per CPU at most. Returns the number of CPUs it was queued on.
+ */
+int smp_call_function_many(cpumask_t mask, smp_call_func_t func,
+                           void *arg, bool wait);
+
+/* C entry point for secondary CPUs, called from the arch boot code */
+void secondary_start_kernel(unsigned int cpu);
+
+#endif /* _SMP_H_ */
@@ -7,36 +7,187 @@
 #ifndef _SPINLOCK_H_
 #define _SPINLOCK_H_
 
+#include <stdint.h>
+#include <stddef.h>
+
 /* Get architecture-specific spinlock implementation */
 #include <arch_spinlock.h>
+#include <arch_cpu.h>
+#include <preempt.h>
 
 /* The architecture provides:
- * - spinlock_t type
- * - SPINLOCK_INITIALIZER macro
- * - spin_lock_init()
- * - spin_lock()
- * - spin_unlock()
- * - spin_trylock()
- * - spin_is_locked()
+ * - arch_spinlock_t type (a FIFO ticket lock)
+ * - ARCH_SPINLOCK_INITIALIZER macro
+ * - arch_spin_lock_init()
+ * - arch_spin_lock()
+ * - arch_spin_unlock()
+ * - arch_spin_trylock()
+ * - arch_spin_is_locked()
+ * - arch_spin_is_contended()
+ *
+ * See qspinlock.h for the queued lock used where many CPUs contend.
+ *
+ * spin_lock() disables preemption until the matching spin_unlock(), so a
+ * holder is never switched out while another thread on the same CPU spins.
  */
 
-/* Common spinlock variants with interrupt handling */
+/*
+ * Lock statistics (build with LOCK_STAT=1)
+ *
+ * Locks are grouped by the function that first takes them, so every
+ * irq_desc lock shows up as one entry rather than one per descriptor.
+ * Each entry counts acquisitions, acquisitions that had to wait, and the
+ * longest hold time in ns from ktime_get_ns(). lock_stat_dump() prints
+ * them.
+ */
+#ifndef CONFIG_LOCK_STAT
+#define CONFIG_LOCK_STAT 0
+#endif
+
+#if CONFIG_LOCK_STAT
+#include <atomic.h>
+#include <time/timekeeping.h>
+
+struct lock_stat {
+    const char *site;
+    atomic64_t acquisitions;
+    atomic64_t contended;
+    atomic64_t max_hold;        // ns
+};
+#endif
+
+typedef struct {
+    arch_spinlock_t raw;
+#if CONFIG_LOCK_STAT
+    struct lock_stat *stat;     // Looked up on first acquisition
+    uint64_t hold_start;
+#endif
+} spinlock_t;
+
+#define SPINLOCK_INITIALIZER { .raw = ARCH_SPINLOCK_INITIALIZER }
+
+static inline void spin_lock_init(spinlock_t *lock) {
+    arch_spin_lock_init(&lock->raw);
+#if CONFIG_LOCK_STAT
+    lock->stat = NULL;
+#endif
+}
+
+static inline int spin_is_locked(spinlock_t *lock) {
+    return arch_spin_is_locked(&lock->raw);
+}
+
+static inline int spin_is_contended(spinlock_t *lock) {
+    return arch_spin_is_contended(&lock->raw);
+}
+
+#if CONFIG_LOCK_STAT
+
+// Find or create the entry for a call site; never returns NULL
+struct lock_stat *lock_stat_lookup(const char *site);
+void lock_stat_dump(void);
+void lock_stat_reset(void);
+
+// Called with the lock held
+static inline void lock_stat_acquired(spinlock_t *lock, int contended,
+                                      const char *site) {
+    if (!lock->stat) {
+        lock->stat = lock_stat_lookup(site);
+    }
+    atomic64_inc(&lock->stat->acquisitions);
+    if (contended) {
+        atomic64_inc(&lock->stat->contended);
+    }
+    lock->hold_start = ktime_get_ns();
+}
+
+// Called just before the lock is dropped
+static inline void lock_stat_release(spinlock_t *lock) {
+    int64_t held = ktime_get_ns() - lock->hold_start;
+    int64_t max = atomic64_read(&lock->stat->max_hold);
+
+    while (held > max &&
+           !atomic64_try_cmpxchg_relaxed(&lock->stat->max_hold, &max, held)) {
+    }
+}
 
-// For now, we'll use simple implementations without actual interrupt control
-// These will be enhanced when interrupt controller is fully integrated
+static inline void __spin_lock(spinlock_t *lock, const char *site) {
+    int contended = 0;
+
+    preempt_disable();
+    if (!arch_spin_trylock(&lock->raw)) {
+        contended = 1;
+        arch_spin_lock(&lock->raw);
+    }
+    lock_stat_acquired(lock, contended, site);
+}
+
+static inline int __spin_trylock(spinlock_t *lock, const char *site) {
+    preempt_disable();
+    if (!arch_spin_trylock(&lock->raw)) {
+        preempt_enable();
+        return 0;
+    }
+    lock_stat_acquired(lock, 0, site);
+    return 1;
+}
+
+static inline void spin_unlock(spinlock_t *lock) {
+    lock_stat_release(lock);
+    arch_spin_unlock(&lock->raw);
+    preempt_enable();
+}
+
+#define spin_lock(lock)     __spin_lock(lock, __func__)
+#define spin_trylock(lock)  __spin_trylock(lock, __func__)
+
+#else /* !CONFIG_LOCK_STAT */
+
+static inline void spin_lock(spinlock_t *lock) {
+    preempt_disable();
+    arch_spin_lock(&lock->raw);
+}
+
+static inline int spin_trylock(spinlock_t *lock) {
+    preempt_disable();
+    if (!arch_spin_trylock(&lock->raw)) {
+        preempt_enable();
+        return 0;
+    }
+    return 1;
+}
+
+static inline void spin_unlock(spinlock_t *lock) {
+    arch_spin_unlock(&lock->raw);
+    preempt_enable();
+}
+
+static inline void lock_stat_dump(void) {
+}
+
+static inline void lock_stat_reset(void) {
+}
+
+#endif /* CONFIG_LOCK_STAT */
+
+/* Common spinlock variants with interrupt handling */
 
 typedef unsigned long irqflags_t;
 
+// Mask interrupts on this CPU (DAIF.I on ARM64, sstatus.SIE on RISC-V)
+// and return the previous state
 static inline irqflags_t arch_local_irq_save(void) {
-    // Placeholder - will be implemented with actual interrupt control
-    return 0;
+    return arch_save_interrupts();
 }
 
 static inline void arch_local_irq_restore(irqflags_t flags) {
-    // Placeholder - will be implemented with actual interrupt control
-    (void)flags;
+    arch_restore_interrupts(flags);
 }
 
+/*
+ * Interrupts are masked before the lock is taken, so a handler on this
+ * CPU cannot spin on a lock the interrupted code already holds
+ */
 #define spin_lock_irqsave(lock, flags) do { \
     (flags) = arch_local_irq_save(); \
     spin_lock(lock); \
@@ -47,4 +198,4 @@ static inline void arch_local_irq_restore(irqflags_t flags) {
     arch_local_irq_restore(flags); \
 } while (0)
 
-#endif /* _SPINLOCK_H_ */
\ No newline at end of file
+#endif /* _SPINLOCK_H_ */
@@ -0,0 +1,56 @@
+/*
+ * kernel/include/static_key.h
+ *
+ * Static keys: branches patched into the code at boot
+ *
+ * static_branch(&key) compiles to a single no-op at the branch site and
+ * is false. static_key_enable() rewrites every site of the key into an
+ * unconditional jump to the true path, so a hot path picks between two
+ * implementations without loading a flag or testing it.
+ *
+ * Each site records its address, the true path and the key in the
+ * .static_keys section. Patching writes kernel text in place, which is
+ * only safe while one CPU is running: keys are switched during boot,
+ * before smp_boot_secondaries().
+ */
+
+#ifndef _STATIC_KEY_H_
+#define _STATIC_KEY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct static_key {
+    bool enabled;
+};
+
+// One branch site; filled in by arch_static_branch()
+struct static_key_entry {
+    uintptr_t code;
+    uintptr_t target;
+    uintptr_t key;
+};
+
+#define DEFINE_STATIC_KEY(name)     struct static_key name = { .enabled = false }
+#define DECLARE_STATIC_KEY(name)    extern struct static_key name
+
+#include <arch_static_key.h>
+
+// key must be a link-time constant: the address of a static key
+#define static_branch(key)          arch_static_branch(key)
+
+// For slow paths and code that may run before its key is switched
+static inline bool static_key_enabled(const struct static_key *key) {
+    return key->enabled;
+}
+
+// Patch every site of key. Boot CPU only, before secondaries start.
+void static_key_enable(struct static_key *key);
+void static_key_disable(struct static_key *key);
+
+// arch/*/kernel/static_key.c: turn one site into a jump to its target or
+// back into a no-op; arch_static_key_sync() runs once after a batch.
+void arch_static_key_patch(const struct static_key_entry *entry, bool enable);
+void arch_static_key_sync(void);
+
+#endif /* _STATIC_KEY_H_ */
@@ -13,9 +13,11 @@
 void* memcpy(void* dest, const void* src, size_t n);
 void* memset(void* s, int c, size_t n);
 void* memmove(void* dest, const void* src, size_t n);
+int memcmp(const void* s1, const void* s2, size_t n);
 
 // String manipulation functions
 size_t strlen(const char* s);
+size_t __strlen(const char* s);     // Word-at-a-time, without arch overrides
 char* strcpy(char* dest, const char* src);
 char* strncpy(char* dest, const char* src, size_t n);
 int strcmp(const char* s1, const char* s2);
@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/atomic_tests.h
+ *
+ * Atomic operations test interface
+ */
+
+#ifndef _ATOMIC_TESTS_H_
+#define _ATOMIC_TESTS_H_
+
+void run_atomic_tests(void);
+
+#endif // _ATOMIC_TESTS_H_
@@ -0,0 +1,67 @@
+/*
+ * kernel/include/tests/bench_cycles.h
+ *
+ * CPU cycle counter for the benchmarks
+ *
+ * PMCCNTR_EL0 on ARM64, enabled here for EL1 if the CPU has a PMU, and
+ * the cycle CSR on RISC-V. bench_cycles_init() says whether counts from
+ * bench_cycles_read() mean anything; they are per CPU, so read both
+ * ends on the same one.
+ */
+
+#ifndef _BENCH_CYCLES_H_
+#define _BENCH_CYCLES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cpufeature.h>
+
+#if defined(__aarch64__)
+static inline bool bench_cycles_init(void) {
+    uint64_t dfr0, pmcr;
+    unsigned int pmuver;
+
+    __asm__ volatile("mrs %0, id_aa64dfr0_el1" : "=r"(dfr0));
+    pmuver = ID_FIELD(dfr0, 8);
+    if (pmuver == 0 || pmuver == 0xF) {
+        return false;
+    }
+
+    __asm__ volatile("mrs %0, pmcr_el0" : "=r"(pmcr));
+    pmcr |= (1UL << 6) | 1;                             // LC, E
+    __asm__ volatile("msr pmcr_el0, %0" : : "r"(pmcr));
+    __asm__ volatile("msr pmccfiltr_el0, xzr");
+    __asm__ volatile("msr pmcntenset_el0, %0" : : "r"(1UL << 31));
+    __asm__ volatile("isb");
+    return true;
+}
+
+static inline uint64_t bench_cycles_read(void) {
+    uint64_t c;
+
+    __asm__ volatile("isb; mrs %0, pmccntr_el0" : "=r"(c));
+    return c;
+}
+#elif defined(__riscv)
+// SBI firmware lets S-mode read cycle
+static inline bool bench_cycles_init(void) {
+    return true;
+}
+
+static inline uint64_t bench_cycles_read(void) {
+    uint64_t c;
+
+    __asm__ volatile("rdcycle %0" : "=r"(c));
+    return c;
+}
+#else
+static inline bool bench_cycles_init(void) {
+    return false;
+}
+
+static inline uint64_t bench_cycles_read(void) {
+    return 0;
+}
+#endif
+
+#endif // _BENCH_CYCLES_H_
@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/bitops_tests.h
+ *
+ * Bit operation and bitmap search tests interface
+ */
+
+#ifndef _BITOPS_TESTS_H_
+#define _BITOPS_TESTS_H_
+
+void run_bitops_tests(void);
+
+#endif // _BITOPS_TESTS_H_
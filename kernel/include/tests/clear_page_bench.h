@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/clear_page_bench.h
+ *
+ * Page zeroing check and throughput benchmark interface
+ */
+
+#ifndef _CLEAR_PAGE_BENCH_H_
+#define _CLEAR_PAGE_BENCH_H_
+
+void run_clear_page_benchmarks(void);
+
+#endif // _CLEAR_PAGE_BENCH_H_
@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/crc32_bench.h
+ *
+ * CRC-32/CRC-32C check and throughput benchmark interface
+ */
+
+#ifndef _CRC32_BENCH_H_
+#define _CRC32_BENCH_H_
+
+void run_crc32_benchmarks(void);
+
+#endif // _CRC32_BENCH_H_
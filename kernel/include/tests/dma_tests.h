@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/dma_tests.h
+ *
+ * DMA mapping API tests interface
+ */
+
+#ifndef _DMA_TESTS_H_
+#define _DMA_TESTS_H_
+
+void run_dma_tests(void);
+
+#endif // _DMA_TESTS_H_
@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/fdt_string_bench.h
+ *
+ * Device tree enumeration string benchmark interface
+ */
+
+#ifndef _FDT_STRING_BENCH_H_
+#define _FDT_STRING_BENCH_H_
+
+void run_fdt_string_benchmarks(void);
+
+#endif // _FDT_STRING_BENCH_H_
@@ -58,4 +58,7 @@ int test_msi_spi_allocation(void);
 // MSI vector allocation tests
 void test_msi_allocation_runner(void);
 
+// IRQ stack checks and interrupt entry/exit cost
+void run_irq_benchmarks(void);
+
 #endif /* _IRQ_TESTS_H */
\ No newline at end of file
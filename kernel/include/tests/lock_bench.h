@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/lock_bench.h
+ *
+ * Spinlock contention benchmark interface
+ */
+
+#ifndef _LOCK_BENCH_H_
+#define _LOCK_BENCH_H_
+
+void run_lock_benchmarks(void);
+
+#endif // _LOCK_BENCH_H_
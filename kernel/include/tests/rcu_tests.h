@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/rcu_tests.h
+ *
+ * RCU test interface
+ */
+
+#ifndef _RCU_TESTS_H_
+#define _RCU_TESTS_H_
+
+void run_rcu_tests(void);
+
+#endif // _RCU_TESTS_H_
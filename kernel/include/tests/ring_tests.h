@@ -0,0 +1,13 @@
+/*
+ * kernel/include/tests/ring_tests.h
+ *
+ * Ring buffer tests and throughput benchmark interface
+ */
+
+#ifndef _RING_TESTS_H_
+#define _RING_TESTS_H_
+
+void run_ring_tests(void);
+void run_ring_benchmarks(void);
+
+#endif // _RING_TESTS_H_
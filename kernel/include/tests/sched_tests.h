@@ -0,0 +1,13 @@
+/*
+ * kernel/include/tests/sched_tests.h
+ *
+ * Scheduler tests and context-switch benchmark interface
+ */
+
+#ifndef _SCHED_TESTS_H_
+#define _SCHED_TESTS_H_
+
+void run_sched_tests(void);
+void run_sched_benchmarks(void);
+
+#endif // _SCHED_TESTS_H_
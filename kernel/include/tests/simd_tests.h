@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/simd_tests.h
+ *
+ * Kernel-mode SIMD section and SIMD-accelerated routine tests interface
+ */
+
+#ifndef _SIMD_TESTS_H_
+#define _SIMD_TESTS_H_
+
+void run_simd_tests(void);
+
+#endif // _SIMD_TESTS_H_
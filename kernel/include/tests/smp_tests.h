@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/smp_tests.h
+ *
+ * IPI, cross-CPU call and TLB shootdown tests interface
+ */
+
+#ifndef _SMP_TESTS_H_
+#define _SMP_TESTS_H_
+
+void run_smp_tests(void);
+
+#endif // _SMP_TESTS_H_
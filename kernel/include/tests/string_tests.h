@@ -0,0 +1,13 @@
+/*
+ * kernel/include/tests/string_tests.h
+ *
+ * memcpy/memmove/memset tests and throughput benchmark interface
+ */
+
+#ifndef _STRING_TESTS_H_
+#define _STRING_TESTS_H_
+
+void run_string_tests(void);
+void run_string_benchmarks(void);
+
+#endif // _STRING_TESTS_H_
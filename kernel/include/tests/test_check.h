@@ -0,0 +1,24 @@
+/*
+ * kernel/include/tests/test_check.h
+ *
+ * Pass/fail bookkeeping shared by the test suites
+ *
+ * A suite brackets its checks with test_suite_begin() and
+ * test_suite_end(). Suites run one at a time from the boot CPU.
+ */
+
+#ifndef _TEST_CHECK_H_
+#define _TEST_CHECK_H_
+
+#include <stdbool.h>
+
+// Reset the counters and print the suite banner
+void test_suite_begin(const char *title);
+
+// Record and print one result
+void test_check(const char *name, bool ok);
+
+// Print "<label>: passed/run passed" and return the number of failures
+int test_suite_end(const char *label);
+
+#endif // _TEST_CHECK_H_
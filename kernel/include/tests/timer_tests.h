@@ -0,0 +1,14 @@
+/*
+ * kernel/include/tests/timer_tests.h
+ *
+ * Timekeeping, timer wheel and hrtimer tests and timer benchmark interface
+ */
+
+#ifndef _TIMER_TESTS_H_
+#define _TIMER_TESTS_H_
+
+void run_timer_tests(void);
+void run_ktime_benchmarks(void);
+void run_clockevent_benchmarks(void);
+
+#endif // _TIMER_TESTS_H_
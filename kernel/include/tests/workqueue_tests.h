@@ -0,0 +1,12 @@
+/*
+ * kernel/include/tests/workqueue_tests.h
+ *
+ * Workqueue and parallel_for tests interface
+ */
+
+#ifndef _WORKQUEUE_TESTS_H_
+#define _WORKQUEUE_TESTS_H_
+
+void run_workqueue_tests(void);
+
+#endif // _WORKQUEUE_TESTS_H_
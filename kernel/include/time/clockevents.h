@@ -0,0 +1,72 @@
+/*
+ * kernel/include/time/clockevents.h
+ *
+ * Clock event devices: one-shot timer interrupts at an absolute time
+ *
+ * Each architecture describes its per-CPU timer (ARM generic timer,
+ * RISC-V SBI timer) as a clock_event_device. The core programs it with
+ * an absolute ktime_get_ns() deadline, converts the distance to counter
+ * ticks with a precomputed mult/shift, and gets a callback when the
+ * deadline passes; the hrtimer queue is the only user.
+ */
+
+#ifndef _TIME_CLOCKEVENTS_H_
+#define _TIME_CLOCKEVENTS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct clock_event_device {
+    const char *name;
+    uint32_t freq;                      // Counter ticks per second
+
+    // ticks = (ns * mult) >> shift
+    uint32_t mult;
+    uint32_t shift;
+
+    // Smallest and largest deadline distance the hardware accepts
+    uint64_t min_delta_ns;
+    uint64_t max_delta_ns;
+
+    // Fire once, delta counter ticks from now
+    void (*set_next_event)(struct clock_event_device *dev, uint64_t delta);
+    // Stop the timer; no interrupt until the next set_next_event()
+    void (*set_state_shutdown)(struct clock_event_device *dev);
+
+    // Set by the core; called from the timer interrupt
+    void (*event_handler)(struct clock_event_device *dev);
+
+    uint32_t virq;                      // Mapped timer interrupt
+    unsigned int cpu;                   // The CPU whose timer this is
+    uint64_t next_event;                // Programmed deadline in ns, UINT64_MAX if off
+    uint64_t nr_events;                 // Interrupts taken
+    uint64_t nr_programmed;             // set_next_event() calls
+};
+
+/*
+ * Work out the conversion for a timer counting at freq that accepts
+ * deltas of min_delta to max_delta ticks, then register it and claim its
+ * interrupt. Returns 0 or -1.
+ */
+int clockevents_config_and_register(struct clock_event_device *dev, uint32_t freq,
+                                    uint64_t min_delta, uint64_t max_delta);
+
+/*
+ * Program the next interrupt for an absolute ktime_get_ns() value.
+ * Deadlines in the past or too close fire after min_delta_ns; far ones
+ * are clamped to max_delta_ns, and the handler simply finds nothing due.
+ */
+void clockevents_program_event(struct clock_event_device *dev, uint64_t deadline);
+
+void clockevents_shutdown(struct clock_event_device *dev);
+
+/* The boot CPU's clock event device, or NULL before registration */
+struct clock_event_device *clockevents_get_device(void);
+
+/*
+ * Implemented per architecture: describe and register the CPU timer.
+ * Returns 0, or -1 if no interrupt could be mapped.
+ */
+int arch_clockevent_init(void);
+
+#endif /* _TIME_CLOCKEVENTS_H_ */
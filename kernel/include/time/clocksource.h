@@ -0,0 +1,64 @@
+/*
+ * kernel/include/time/clocksource.h
+ *
+ * Free-running counters used as the kernel's time base
+ *
+ * Each architecture describes its system counter (ARM generic timer
+ * CNTPCT_EL0, RISC-V time CSR) as a clocksource. Registering it works out
+ * a multiplier and shift once, so turning counter ticks into nanoseconds
+ * is a multiply and a shift rather than a division:
+ *
+ *     ns = (cycles * mult) >> shift
+ *
+ * Nothing outside kernel/time reads the clocksource directly; use
+ * ktime_get_ns() from time/timekeeping.h.
+ */
+
+#ifndef _TIME_CLOCKSOURCE_H_
+#define _TIME_CLOCKSOURCE_H_
+
+#include <stdint.h>
+
+/* Mask for a counter that is bits wide */
+#define CLOCKSOURCE_MASK(bits)  ((bits) >= 64 ? UINT64_MAX : (1ULL << (bits)) - 1)
+
+/* Longest counter delta, in seconds, that mult is chosen to convert */
+#define CLOCKSOURCE_MAX_SEC     600
+
+struct clocksource {
+    const char *name;
+    uint64_t (*read)(struct clocksource *cs);
+    uint64_t mask;                      // Counter width, CLOCKSOURCE_MASK()
+    uint32_t freq;                      // Ticks per second
+
+    // Filled in by clocksource_register_hz()
+    uint32_t mult;
+    uint32_t shift;
+    uint64_t max_cycles;                // Largest delta cycles * mult holds
+};
+
+/*
+ * Pick mult and shift to convert from "from" Hz to "to" Hz as
+ * (x * mult) >> shift, as precisely as possible while a value covering
+ * maxsec seconds still cannot overflow 64 bits. shift is at most 32.
+ */
+void clocks_calc_mult_shift(uint32_t *mult, uint32_t *shift, uint32_t from,
+                            uint32_t to, uint32_t maxsec);
+
+static inline uint64_t clocksource_cyc2ns(uint64_t cycles, uint32_t mult, uint32_t shift) {
+    return (cycles * mult) >> shift;
+}
+
+/*
+ * Work out the conversion for a counter running at hz and make it the
+ * time base. Returns 0, or -1 if the description is incomplete.
+ */
+int clocksource_register_hz(struct clocksource *cs, uint32_t hz);
+
+/*
+ * Implemented per architecture: describe and register the system
+ * counter. Returns 0 or -1.
+ */
+int arch_clocksource_init(void);
+
+#endif /* _TIME_CLOCKSOURCE_H_ */
@@ -0,0 +1,65 @@
+/*
+ * kernel/include/time/hrtimer.h
+ *
+ * High-resolution timers
+ *
+ * Unlike timer_list, which fires on a tick, an hrtimer fires at an exact
+ * ktime_get_ns() time: pending hrtimers sit in one queue sorted by expiry and
+ * the clock event device is programmed for the first. The periodic tick
+ * is itself an hrtimer. Meant for few, precise timers; arming is linear
+ * in the number queued.
+ *
+ * Only the boot CPU has a clock event device. An hrtimer armed on
+ * another CPU ahead of everything queued is passed to it with an
+ * IPI_TIMER IPI, or noticed at the next tick if there are no IPIs.
+ */
+
+#ifndef _TIME_HRTIMER_H_
+#define _TIME_HRTIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lib/list.h>
+
+enum hrtimer_restart {
+    HRTIMER_NORESTART,
+    HRTIMER_RESTART,                    // Callback moved expires forward
+};
+
+struct hrtimer {
+    struct list_head node;              // Empty when not queued
+    uint64_t expires;                   // Absolute ktime_get_ns() value
+    enum hrtimer_restart (*function)(struct hrtimer *timer);
+};
+
+void hrtimer_init(struct hrtimer *timer, enum hrtimer_restart (*function)(struct hrtimer *));
+
+/* Queue (or requeue) the timer to fire when ktime_get_ns() reaches expires */
+void hrtimer_start(struct hrtimer *timer, uint64_t expires);
+
+/* Dequeue the timer. Returns 1 if it was queued, else 0. */
+int hrtimer_try_to_cancel(struct hrtimer *timer);
+
+/* As above, and wait for a running callback. Not from the callback itself. */
+int hrtimer_cancel(struct hrtimer *timer);
+
+static inline bool hrtimer_is_queued(const struct hrtimer *timer) {
+    return !list_empty(&timer->node);
+}
+
+/*
+ * Move expires forward by whole intervals until it is after now, for
+ * periodic timers. Returns the number of intervals added.
+ */
+uint64_t hrtimer_forward(struct hrtimer *timer, uint64_t now, uint64_t interval);
+
+/* Take over the clock event device; called once it is registered */
+void hrtimers_init(void);
+
+/*
+ * IPI_TIMER handler: another CPU queued a timer ahead of the one the
+ * device is programmed for, on this CPU, which owns the device
+ */
+void hrtimer_ipi(void);
+
+#endif /* _TIME_HRTIMER_H_ */
@@ -0,0 +1,67 @@
+/*
+ * kernel/include/time/tick.h
+ *
+ * The periodic tick
+ *
+ * An hrtimer on the boot CPU fires HZ times a second. Each tick folds the
+ * elapsed time into the timekeeper, advances jiffies, expires timer_list
+ * timers and runs the scheduler tick. It then sends IPI_TICK to every
+ * other CPU that is not idle, which runs the scheduler tick there.
+ *
+ * Idle loops bracket each sleep with tick_nohz_idle_enter()/exit(). On
+ * the tick CPU that stops the tick, or pushes it out to the first
+ * pending timer_list expiry, so an idle CPU with nothing due takes no
+ * timer interrupts at all; hrtimers keep firing on time. The tick stays
+ * on while RCU callbacks are queued and while any other CPU is busy. A
+ * CPU that leaves idle with the tick stopped brings jiffies up to date
+ * and restarts the tick with an IPI; other work reaches the tick CPU by
+ * IPI too. Without IPIs the tick stays on whenever other CPUs are
+ * online. Every CPU also accounts its idle residency.
+ */
+
+#ifndef _TIME_TICK_H_
+#define _TIME_TICK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time/timer.h>
+#include <time/timekeeping.h>
+
+/* Length of a tick in nanoseconds */
+#define TICK_NSEC           (NSEC_PER_SEC / HZ)
+
+/*
+ * Bring up the clock event device and hrtimers and start the tick.
+ * Needs the interrupt controller; enables interrupts on this CPU.
+ */
+void tick_init(void);
+
+/* True once the tick is running; before that nothing advances jiffies */
+bool tick_is_running(void);
+
+/* IPI_TICK handler: the scheduler tick for a CPU other than the tick CPU */
+void tick_ipi(void);
+
+struct idle_stats {
+    uint64_t sleeps;                    // Idle sleeps, and so wakeups
+    uint64_t idle_ns;                   // Total residency
+    uint64_t max_idle_ns;               // Longest single sleep
+    uint64_t ticks;                     // Tick interrupts taken
+    uint64_t idle_ticks;                // ...of them landing in the idle task
+    uint64_t tick_stops;                // Sleeps with the tick stopped or deferred
+};
+
+/*
+ * Called by the idle loops with interrupts masked, immediately around
+ * the wait-for-interrupt (or event)
+ */
+void tick_nohz_idle_enter(void);
+void tick_nohz_idle_exit(void);
+
+/* Consistent snapshot of one CPU's idle statistics */
+void tick_idle_get_stats(unsigned int cpu, struct idle_stats *stats);
+
+/* Print every online CPU's idle statistics */
+void tick_idle_print_stats(void);
+
+#endif /* _TIME_TICK_H_ */
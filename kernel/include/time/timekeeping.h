@@ -0,0 +1,51 @@
+/*
+ * kernel/include/time/timekeeping.h
+ *
+ * Monotonic kernel time
+ *
+ * ktime_get_ns() is nanoseconds since timekeeping_init(), from the
+ * registered clocksource. It takes no lock: the timekeeper is published
+ * under a sequence count, so readers on every CPU run in parallel and
+ * only retry if they overlap an update. It never goes backwards, and may
+ * be called from any context, including interrupt handlers and with
+ * spinlocks held. Before timekeeping_init() it returns 0.
+ *
+ * Use this for every timestamp and interval; the raw counter and its
+ * frequency are for the timer drivers only.
+ */
+
+#ifndef _TIME_TIMEKEEPING_H_
+#define _TIME_TIMEKEEPING_H_
+
+#include <stdint.h>
+
+#define NSEC_PER_USEC   1000ULL
+#define NSEC_PER_MSEC   1000000ULL
+#define NSEC_PER_SEC    1000000000ULL
+
+struct clocksource;
+
+uint64_t ktime_get_ns(void);
+
+static inline uint64_t ktime_get_us(void) {
+    return ktime_get_ns() / NSEC_PER_USEC;
+}
+
+static inline uint64_t ktime_get_ms(void) {
+    return ktime_get_ns() / NSEC_PER_MSEC;
+}
+
+/* Register the architecture's clocksource and start counting from zero */
+void timekeeping_init(void);
+
+/*
+ * Fold the time elapsed since the last update into the timekeeper, which
+ * keeps the delta readers convert small. Called from the tick; harmless
+ * to call more often.
+ */
+void timekeeping_update(void);
+
+/* Switch to a newly registered clocksource without a jump in time */
+void timekeeping_set_clocksource(struct clocksource *cs);
+
+#endif /* _TIME_TIMEKEEPING_H_ */
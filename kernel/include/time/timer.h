@@ -0,0 +1,72 @@
+/*
+ * kernel/include/time/timer.h
+ *
+ * Tick-resolution timers on a hierarchical timer wheel
+ *
+ * Expiry times are in jiffies. The wheel has a 256-slot first level, one
+ * slot per tick, and four 64-slot levels above it, each slot covering a
+ * whole turn of the level below. Adding or cancelling a timer is a list
+ * insert or delete whatever the number of timers; timers further out
+ * than the first level are moved down as the wheel turns.
+ *
+ * Callbacks run from the tick interrupt on the boot CPU, with interrupts
+ * disabled, and may re-arm their own timer. Every function here may be
+ * called from interrupt context.
+ */
+
+#ifndef _TIME_TIMER_H_
+#define _TIME_TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lib/list.h>
+
+/* Tick rate */
+#define HZ                  100
+
+struct timer_list {
+    struct list_head entry;             // Empty when not pending
+    uint64_t expires;                   // In jiffies
+    void (*function)(struct timer_list *timer);
+};
+
+/* Ticks since the tick started, advanced by the boot CPU */
+extern volatile uint64_t jiffies;
+
+void timer_setup(struct timer_list *timer, void (*function)(struct timer_list *));
+
+static inline bool timer_pending(const struct timer_list *timer) {
+    return !list_empty(&timer->entry);
+}
+
+/* Start a timer that is not pending, for timer->expires */
+void add_timer(struct timer_list *timer);
+
+/* (Re)start a timer for expires. Returns 1 if it was pending, else 0. */
+int mod_timer(struct timer_list *timer, uint64_t expires);
+
+/* Cancel a timer. Returns 1 if it was pending, else 0. */
+int del_timer(struct timer_list *timer);
+
+/*
+ * Cancel a timer and wait for its callback if it is running elsewhere.
+ * Must not be called from the timer's own callback.
+ */
+int del_timer_sync(struct timer_list *timer);
+
+/* Expire due timers; called from the tick */
+void run_timers(void);
+
+/*
+ * Jiffy of the earliest pending timer, UINT64_MAX if there is none.
+ * Walks every slot and every timer not on the first level: meant for
+ * the idle path, not for frequent use.
+ */
+uint64_t timer_next_expiry(void);
+
+/* Round up, so a timeout is never shorter than asked */
+static inline uint64_t msecs_to_jiffies(uint64_t ms) {
+    return (ms * HZ + 999) / 1000;
+}
+
+#endif /* _TIME_TIMER_H_ */
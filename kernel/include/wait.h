@@ -0,0 +1,63 @@
+/*
+ * kernel/include/wait.h
+ *
+ * Wait queues: sleep until a condition becomes true
+ *
+ * A waiter marks itself sleeping before testing the condition, and the
+ * waker makes the condition true before calling wake_up(). Whichever
+ * order the two race in, either the waiter sees the condition or the
+ * waker sees the waiter and makes it runnable again.
+ */
+
+#ifndef _WAIT_H_
+#define _WAIT_H_
+
+#include <stdbool.h>
+#include <spinlock.h>
+#include <sched.h>
+#include <lib/list.h>
+
+struct wait_queue_head {
+    spinlock_t lock;
+    struct list_head head;
+};
+
+struct wait_queue_entry {
+    struct task *task;
+    struct list_head link;
+};
+
+#define WAIT_QUEUE_HEAD_INIT(name) { \
+    .lock = SPINLOCK_INITIALIZER, \
+    .head = LIST_HEAD_INIT((name).head) \
+}
+
+#define DECLARE_WAIT_QUEUE_HEAD(name) \
+    struct wait_queue_head name = WAIT_QUEUE_HEAD_INIT(name)
+
+void init_waitqueue_head(struct wait_queue_head *wq);
+
+/* Queue the entry (once) and mark the caller sleeping */
+void prepare_to_wait(struct wait_queue_head *wq, struct wait_queue_entry *wait);
+
+/* Mark the caller running and take the entry off the queue */
+void finish_wait(struct wait_queue_head *wq, struct wait_queue_entry *wait);
+
+/* Wake every task waiting on the queue */
+void wake_up(struct wait_queue_head *wq);
+
+/* Sleep until cond is true; cond is re-evaluated after every wakeup */
+#define wait_event(wq, cond) do { \
+    struct wait_queue_entry __wait = { .task = get_current() }; \
+    list_init(&__wait.link); \
+    for (;;) { \
+        prepare_to_wait(&(wq), &__wait); \
+        if (cond) { \
+            break; \
+        } \
+        schedule(); \
+    } \
+    finish_wait(&(wq), &__wait); \
+} while (0)
+
+#endif /* _WAIT_H_ */
@@ -0,0 +1,74 @@
+/*
+ * kernel/include/workqueue.h
+ *
+ * Deferred and parallel work on per-CPU worker threads
+ *
+ * Each online CPU has a worker thread and a Chase-Lev deque. queue_work()
+ * pushes onto the calling CPU's deque; its worker pops from the same end
+ * (most recent first, still warm in cache) while idle workers on other
+ * CPUs steal from the far end. Only the owning CPU pushes and pops, so
+ * the common path takes no lock; thieves race each other with a single
+ * compare-and-swap.
+ *
+ * A work item is pending from queue_work() until its handler has
+ * returned. It must stay valid until then, so a handler must not free
+ * its own work item; flush_work() is the way to know it is done.
+ */
+
+#ifndef _WORKQUEUE_H_
+#define _WORKQUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <atomic.h>
+
+struct work_struct;
+
+typedef void (*work_func_t)(struct work_struct *work);
+
+struct work_struct {
+    work_func_t func;
+    atomic_t pending;           // Queued or running
+};
+
+#define WORK_INITIALIZER(f) { .func = (f), .pending = ATOMIC_INIT(0) }
+
+#define DECLARE_WORK(name, f) \
+    struct work_struct name = WORK_INITIALIZER(f)
+
+static inline void INIT_WORK(struct work_struct *work, work_func_t func) {
+    work->func = func;
+    atomic_set(&work->pending, 0);
+}
+
+static inline bool work_pending(struct work_struct *work) {
+    return atomic_read_acquire(&work->pending) != 0;
+}
+
+/* Start a worker thread on every online CPU. Call after smp_boot_secondaries(). */
+void workqueue_init(void);
+
+/*
+ * Queue work on this CPU. Returns false if it was already pending.
+ * Before workqueue_init(), or if this CPU's deque is full, the handler
+ * runs immediately in the caller.
+ */
+bool queue_work(struct work_struct *work);
+
+/*
+ * Wait until work is no longer pending. The caller runs other queued
+ * work while it waits, so flushing from a handler cannot deadlock, and
+ * otherwise polls; meant for short waits such as parallel_for().
+ */
+void flush_work(struct work_struct *work);
+
+typedef void (*parallel_for_fn)(uint64_t start, uint64_t end, void *arg);
+
+/*
+ * Call fn over [start, end) split into sub-ranges run on all online CPUs,
+ * and return once every sub-range is done. The caller runs one of them
+ * itself. fn may be called with any sub-range, in any order.
+ */
+void parallel_for(uint64_t start, uint64_t end, parallel_for_fn fn, void *arg);
+
+#endif /* _WORKQUEUE_H_ */
@@ -3,12 +3,12 @@
 #include <memory/kmalloc.h>
 #include <memory/slab.h>
 #include <string.h>
+#include <lib/bitmap.h>
 #include <panic.h>
 #include <uart.h>
 
 #define MAX_VIRQ        1024
-#define BITS_PER_LONG   64
-#define BITMAP_SIZE     ((MAX_VIRQ + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define BITMAP_SIZE     BITMAP_WORDS(MAX_VIRQ)
 
 static struct virq_allocator virq_alloc_data = {
     .next_virq = 1,     // Start from 1, 0 is reserved as invalid
@@ -17,48 +17,20 @@ static struct virq_allocator virq_alloc_data = {
     .lock = SPINLOCK_INITIALIZER
 };
 
-// Helper functions for bitmap operations
-static inline void bitmap_set_bit(unsigned long *bitmap, uint32_t bit) {
-    bitmap[bit / BITS_PER_LONG] |= (1UL << (bit % BITS_PER_LONG));
-}
+// Find range of consecutive clear bits: each free run is found with two
+// word-at-a-time scans rather than bit by bit
+static uint32_t bitmap_find_zero_range(const uint64_t *bitmap, uint32_t max_bits, uint32_t count) {
+    size_t start = bitmap_find_next_zero_bit(bitmap, max_bits, 0);
 
-static inline void bitmap_clear_bit(unsigned long *bitmap, uint32_t bit) {
-    bitmap[bit / BITS_PER_LONG] &= ~(1UL << (bit % BITS_PER_LONG));
-}
+    while (start < max_bits) {
+        size_t end = bitmap_find_next_bit(bitmap, max_bits, start);
 
-static inline bool bitmap_test_bit(unsigned long *bitmap, uint32_t bit) {
-    return (bitmap[bit / BITS_PER_LONG] & (1UL << (bit % BITS_PER_LONG))) != 0;
-}
-
-// Find first clear bit in bitmap
-static uint32_t bitmap_find_first_zero(unsigned long *bitmap, uint32_t max_bits) {
-    for (uint32_t i = 0; i < max_bits; i++) {
-        if (!bitmap_test_bit(bitmap, i)) {
-            return i;
+        if (end - start >= count) {
+            return start;
         }
+        start = bitmap_find_next_zero_bit(bitmap, max_bits, end);
     }
-    return max_bits;  // No free bit found
-}
 
-// Find range of consecutive clear bits
-static uint32_t bitmap_find_zero_range(unsigned long *bitmap, uint32_t max_bits, uint32_t count) {
-    uint32_t start = 0;
-    uint32_t consecutive = 0;
-    
-    for (uint32_t i = 0; i < max_bits; i++) {
-        if (!bitmap_test_bit(bitmap, i)) {
-            if (consecutive == 0) {
-                start = i;
-            }
-            consecutive++;
-            if (consecutive == count) {
-                return start;
-            }
-        } else {
-            consecutive = 0;
-        }
-    }
-    
     return max_bits;  // No suitable range found
 }
 
@@ -68,7 +40,7 @@ void virq_allocator_init(void) {
     spin_lock_irqsave(&virq_alloc_data.lock, flags);
     
     if (virq_alloc_data.bitmap == NULL) {
-        virq_alloc_data.bitmap = kmalloc(BITMAP_SIZE * sizeof(unsigned long), KM_ZERO);
+        virq_alloc_data.bitmap = kmalloc(BITMAP_SIZE * sizeof(uint64_t), KM_ZERO);
         if (!virq_alloc_data.bitmap) {
             panic("Failed to allocate virtual IRQ bitmap");
         }
@@ -93,7 +65,7 @@ uint32_t virq_alloc(void) {
     spin_lock_irqsave(&virq_alloc_data.lock, flags);
     
     // Find first available virq
-    virq = bitmap_find_first_zero(virq_alloc_data.bitmap, virq_alloc_data.max_virq);
+    virq = bitmap_find_next_zero_bit(virq_alloc_data.bitmap, virq_alloc_data.max_virq, 0);
     
     if (virq >= virq_alloc_data.max_virq) {
         spin_unlock_irqrestore(&virq_alloc_data.lock, flags);
@@ -229,10 +201,9 @@ uint32_t virq_get_allocated_count(void) {
     
     spin_lock_irqsave(&virq_alloc_data.lock, flags);
     
-    for (uint32_t i = 0; i < virq_alloc_data.max_virq; i++) {
-        if (bitmap_test_bit(virq_alloc_data.bitmap, i)) {
-            count++;
-        }
+    // max_virq is a whole number of words
+    for (uint32_t i = 0; i < BITMAP_WORDS(virq_alloc_data.max_virq); i++) {
+        count += popcount64(virq_alloc_data.bitmap[i]);
     }
     
     spin_unlock_irqrestore(&virq_alloc_data.lock, flags);
@@ -250,9 +221,11 @@ uint32_t virq_get_max_allocated(void) {
     
     spin_lock_irqsave(&virq_alloc_data.lock, flags);
     
-    for (uint32_t i = virq_alloc_data.max_virq - 1; i > 0; i--) {
-        if (bitmap_test_bit(virq_alloc_data.bitmap, i)) {
-            max_allocated = i;
+    // Highest set bit of the last non-empty word; virq 0 is always set
+    // and reports as 0, as before
+    for (uint32_t i = BITMAP_WORDS(virq_alloc_data.max_virq); i-- > 0; ) {
+        if (virq_alloc_data.bitmap[i]) {
+            max_allocated = i * 64 + fls64(virq_alloc_data.bitmap[i]) - 1;
             break;
         }
     }
@@ -1,5 +1,6 @@
 #include <irq/irq_domain.h>
 #include <irq/irq.h>
+#include <rcu.h>
 #include <string.h>
 
 // Default chip operations (no-op implementations)
@@ -67,8 +68,11 @@ void generic_handle_irq(uint32_t irq) {
     struct irq_action *action;
     unsigned long flags;
     
+    rcu_read_lock();
+    
     desc = irq_to_desc(irq);
     if (!desc) {
+        rcu_read_unlock();
         return;
     }
     
@@ -77,6 +81,7 @@ void generic_handle_irq(uint32_t irq) {
     // Check if interrupt is disabled
     if (desc->status & IRQ_DISABLED) {
         spin_unlock_irqrestore(&desc->lock, flags);
+        rcu_read_unlock();
         return;
     }
     
@@ -89,7 +94,7 @@ void generic_handle_irq(uint32_t irq) {
     }
     
     // Update statistics
-    desc->count++;
+    atomic64_inc(&desc->count);
     
     // Get action chain
     action = desc->action;
@@ -115,6 +120,7 @@ void generic_handle_irq(uint32_t irq) {
     }
     
     spin_unlock_irqrestore(&desc->lock, flags);
+    rcu_read_unlock();
 }
 
 // Handle domain interrupt
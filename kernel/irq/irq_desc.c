@@ -5,10 +5,12 @@
 #include <memory/slab.h>
 #include <string.h>
 #include <panic.h>
+#include <rcu.h>
 
 #define MAX_IRQ_DESC    1024
 
-// Static descriptor array
+// Static descriptor array; entries are published and retired under
+// irq_desc_lock but read locklessly (RCU)
 static struct irq_desc *irq_desc_array[MAX_IRQ_DESC];
 static spinlock_t irq_desc_lock = SPINLOCK_INITIALIZER;
 
@@ -35,19 +37,19 @@ void irq_init(void) {
 }
 
 // Get IRQ descriptor by virtual IRQ number
+//
+// Lockless, since every interrupt goes through here. The descriptor is
+// freed only after a grace period, so callers must hold rcu_read_lock()
+// from the lookup until they are done with the pointer. Code that owns
+// the mapping, because it created it and is the only one that will
+// dispose of it (the irq_domain core, the domain map/unmap callbacks),
+// may keep the pointer without.
 struct irq_desc *irq_to_desc(uint32_t irq) {
-    unsigned long flags;
-    struct irq_desc *desc = NULL;
-    
     if (irq >= MAX_IRQ_DESC) {
         return NULL;
     }
     
-    spin_lock_irqsave(&irq_desc_lock, flags);
-    desc = irq_desc_array[irq];
-    spin_unlock_irqrestore(&irq_desc_lock, flags);
-    
-    return desc;
+    return rcu_dereference(irq_desc_array[irq]);
 }
 
 // Allocate a new IRQ descriptor
@@ -86,14 +88,14 @@ struct irq_desc *irq_desc_alloc(uint32_t irq) {
     desc->trigger_type = IRQ_TYPE_NONE;
     desc->cpu_mask = 0xFFFFFFFF;  // All CPUs
     desc->depth = 1;  // Start disabled
-    desc->count = 0;
-    desc->spurious_count = 0;
+    atomic64_set(&desc->count, 0);
+    atomic64_set(&desc->spurious_count, 0);
     desc->last_timestamp = 0;
     spin_lock_init(&desc->lock);
     desc->name = NULL;
     
-    // Store in array
-    irq_desc_array[irq] = desc;
+    // Publish only once fully initialised
+    rcu_assign_pointer(irq_desc_array[irq], desc);
     
     // Update statistics
     irq_desc_allocated++;
@@ -136,12 +138,13 @@ void irq_desc_free(struct irq_desc *desc) {
     }
     
     // Remove from array
-    irq_desc_array[irq] = NULL;
+    RCU_INIT_POINTER(irq_desc_array[irq], NULL);
     irq_desc_allocated--;
     
     spin_unlock_irqrestore(&irq_desc_lock, flags);
     
-    // Free memory
+    // Wait out any CPU that looked the descriptor up before it was removed
+    synchronize_rcu();
     kfree(desc);
 }
 
@@ -156,11 +159,6 @@ int request_irq(uint32_t irq, irq_handler_t handler,
         return -1;
     }
     
-    desc = irq_to_desc(irq);
-    if (!desc) {
-        return -1;
-    }
-    
     // Allocate new action
     action = kmalloc(sizeof(struct irq_action), 0);
     if (!action) {
@@ -173,12 +171,22 @@ int request_irq(uint32_t irq, irq_handler_t handler,
     action->dev_data = dev;
     action->next = NULL;
     
+    rcu_read_lock();
+    
+    desc = irq_to_desc(irq);
+    if (!desc) {
+        rcu_read_unlock();
+        kfree(action);
+        return -1;
+    }
+    
     spin_lock_irqsave(&desc->lock, irqflags);
     
     // Check if shared interrupt
     if (desc->action != NULL) {
         if (!(desc->action->flags & IRQF_SHARED) || !(flags & IRQF_SHARED)) {
             spin_unlock_irqrestore(&desc->lock, irqflags);
+            rcu_read_unlock();
             kfree(action);
             return -1;  // Cannot share
         }
@@ -214,6 +222,7 @@ int request_irq(uint32_t irq, irq_handler_t handler,
     }
     
     spin_unlock_irqrestore(&desc->lock, irqflags);
+    rcu_read_unlock();
     
     return 0;
 }
@@ -228,8 +237,11 @@ void free_irq(uint32_t irq, void *dev) {
         return;
     }
     
+    rcu_read_lock();
+    
     desc = irq_to_desc(irq);
     if (!desc) {
+        rcu_read_unlock();
         return;
     }
     
@@ -253,6 +265,7 @@ void free_irq(uint32_t irq, void *dev) {
             }
             
             spin_unlock_irqrestore(&desc->lock, flags);
+            rcu_read_unlock();
             kfree(action);
             return;
         }
@@ -261,6 +274,7 @@ void free_irq(uint32_t irq, void *dev) {
     }
     
     spin_unlock_irqrestore(&desc->lock, flags);
+    rcu_read_unlock();
 }
 
 // Enable an interrupt
@@ -268,8 +282,11 @@ void enable_irq(uint32_t irq) {
     struct irq_desc *desc;
     unsigned long flags;
     
+    rcu_read_lock();
+    
     desc = irq_to_desc(irq);
     if (!desc) {
+        rcu_read_unlock();
         return;
     }
     
@@ -286,6 +303,7 @@ void enable_irq(uint32_t irq) {
     }
     
     spin_unlock_irqrestore(&desc->lock, flags);
+    rcu_read_unlock();
 }
 
 // Disable an interrupt (wait for handlers to complete)
@@ -293,8 +311,11 @@ void disable_irq(uint32_t irq) {
     struct irq_desc *desc;
     unsigned long flags;
     
+    rcu_read_lock();
+    
     desc = irq_to_desc(irq);
     if (!desc) {
+        rcu_read_unlock();
         return;
     }
     
@@ -314,6 +335,8 @@ void disable_irq(uint32_t irq) {
     while (desc->status & IRQ_INPROGRESS) {
         // Spin wait - in real implementation would yield CPU
     }
+    
+    rcu_read_unlock();
 }
 
 // Disable an interrupt without waiting
@@ -321,8 +344,11 @@ void disable_irq_nosync(uint32_t irq) {
     struct irq_desc *desc;
     unsigned long flags;
     
+    rcu_read_lock();
+    
     desc = irq_to_desc(irq);
     if (!desc) {
+        rcu_read_unlock();
         return;
     }
     
@@ -337,4 +363,5 @@ void disable_irq_nosync(uint32_t irq) {
     desc->depth++;
     
     spin_unlock_irqrestore(&desc->lock, flags);
+    rcu_read_unlock();
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <memory/kmalloc.h>
 #include <memory/slab.h>
 #include <lib/radix_tree.h>
+#include <lib/rculist.h>
+#include <rcu.h>
 #include <string.h>
 #include <panic.h>
 #include <uart.h>
@@ -11,41 +13,14 @@
 // Special marker for reserved but unmapped hwirq slots
 #define HWIRQ_RESERVED_MARKER ((void *)0x1)
 
-// Global domain list management
-static struct list_head irq_domain_list = {
-    .next = &irq_domain_list,
-    .prev = &irq_domain_list
-};
+// Global domain list: writers take the lock, readers walk it under RCU
+static struct list_head irq_domain_list = LIST_HEAD_INIT(irq_domain_list);
 static spinlock_t irq_domain_list_lock = SPINLOCK_INITIALIZER;
 static uint32_t next_domain_id = 1;
 
 // Default domain for quick lookups
 static struct irq_domain *irq_default_domain = NULL;
 
-// List manipulation helpers
-static inline void list_init(struct list_head *list) {
-    list->next = list;
-    list->prev = list;
-}
-
-static inline void list_add(struct list_head *new, struct list_head *head) {
-    new->next = head->next;
-    new->prev = head;
-    head->next->prev = new;
-    head->next = new;
-}
-
-static inline void list_del(struct list_head *entry) {
-    entry->next->prev = entry->prev;
-    entry->prev->next = entry->next;
-    entry->next = entry;
-    entry->prev = entry;
-}
-
-static inline bool list_empty(struct list_head *head) {
-    return head->next == head;
-}
-
 // Helper to allocate and initialize base domain structure
 static struct irq_domain *irq_domain_alloc(struct device_node *node,
                                            const struct irq_domain_ops *ops,
@@ -78,11 +53,11 @@ static void irq_domain_register(struct irq_domain *domain) {
     unsigned long flags;
     
     spin_lock_irqsave(&irq_domain_list_lock, flags);
-    list_add(&domain->link, &irq_domain_list);
+    list_add_rcu(&domain->link, &irq_domain_list);
     
     // Set as default if first domain
     if (!irq_default_domain) {
-        irq_default_domain = domain;
+        rcu_assign_pointer(irq_default_domain, domain);
     }
     
     spin_unlock_irqrestore(&irq_domain_list_lock, flags);
@@ -257,8 +232,8 @@ uint32_t irq_create_mapping(struct irq_domain *domain, uint32_t hwirq) {
             return IRQ_INVALID;
         }
         
-        // Store in linear map
-        domain->linear_map[hwirq] = desc;
+        // Store in linear map; irq_find_mapping() reads it locklessly
+        rcu_assign_pointer(domain->linear_map[hwirq], desc);
         
         // Update reverse map
         if (hwirq < domain->revmap_size) {
@@ -315,7 +290,7 @@ uint32_t irq_create_mapping(struct irq_domain *domain, uint32_t hwirq) {
             
             if (parent_virq == IRQ_INVALID) {
                 // Clean up child mapping
-                domain->linear_map[hwirq] = NULL;
+                RCU_INIT_POINTER(domain->linear_map[hwirq], NULL);
                 if (hwirq < domain->revmap_size) {
                     domain->revmap[hwirq] = IRQ_INVALID;
                 }
@@ -354,24 +329,34 @@ uint32_t irq_create_mapping(struct irq_domain *domain, uint32_t hwirq) {
 }
 
 // Find existing mapping from hardware IRQ to virtual IRQ
+//
+// Lockless: this sits on the interrupt entry path. Descriptors and the
+// default domain are published with rcu_assign_pointer() and only freed
+// after a grace period, so everything read here stays valid until the
+// caller next passes a quiescent state.
 uint32_t irq_find_mapping(struct irq_domain *domain, uint32_t hwirq) {
     uint32_t virq = IRQ_INVALID;
-    unsigned long flags;
+    
+    rcu_read_lock();
     
     if (!domain) {
-        domain = irq_default_domain;
+        domain = rcu_dereference(irq_default_domain);
         if (!domain) {
+            rcu_read_unlock();
             return IRQ_INVALID;
         }
     }
     
-    spin_lock_irqsave(&domain->lock, flags);
-    
     if (domain->type == DOMAIN_LINEAR || domain->type == DOMAIN_HIERARCHY) {
-        if (hwirq < domain->size && domain->linear_map[hwirq]) {
-            virq = domain->linear_map[hwirq]->irq;
+        struct irq_desc *desc = NULL;
+        
+        if (hwirq < domain->size) {
+            desc = rcu_dereference(domain->linear_map[hwirq]);
+        }
+        if (desc) {
+            virq = desc->irq;
         } else if (hwirq < domain->revmap_size) {
-            virq = domain->revmap[hwirq];
+            virq = __atomic_load_n(&domain->revmap[hwirq], __ATOMIC_RELAXED);
         }
     } else if (domain->type == DOMAIN_TREE) {
         // Look up in radix tree
@@ -381,7 +366,7 @@ uint32_t irq_find_mapping(struct irq_domain *domain, uint32_t hwirq) {
         }
     }
     
-    spin_unlock_irqrestore(&domain->lock, flags);
+    rcu_read_unlock();
     
     return virq;
 }
@@ -426,7 +411,7 @@ void irq_dispose_mapping(uint32_t virq) {
     // Remove from domain mapping
     if (domain->type == DOMAIN_LINEAR || domain->type == DOMAIN_HIERARCHY) {
         if (hwirq < domain->size && domain->linear_map[hwirq] == desc) {
-            domain->linear_map[hwirq] = NULL;
+            RCU_INIT_POINTER(domain->linear_map[hwirq], NULL);
         }
         if (hwirq < domain->revmap_size) {
             domain->revmap[hwirq] = IRQ_INVALID;
@@ -484,21 +469,23 @@ void irq_domain_remove(struct irq_domain *domain) {
     
     // Remove from global list
     spin_lock_irqsave(&irq_domain_list_lock, flags);
-    list_del(&domain->link);
+    list_del_rcu(&domain->link);
     
     // Clear default if this was it
     if (irq_default_domain == domain) {
-        irq_default_domain = NULL;
+        RCU_INIT_POINTER(irq_default_domain, NULL);
         // Try to find another domain as default
         if (!list_empty(&irq_domain_list)) {
-            struct list_head *first = irq_domain_list.next;
-            irq_default_domain = (struct irq_domain *)((char *)first - 
-                                offsetof(struct irq_domain, link));
+            rcu_assign_pointer(irq_default_domain,
+                               list_entry(irq_domain_list.next, struct irq_domain, link));
         }
     }
     
     spin_unlock_irqrestore(&irq_domain_list_lock, flags);
     
+    // Lockless readers may still be walking the domain or its maps
+    synchronize_rcu();
+    
     // Free domain resources
     if (domain->type == DOMAIN_LINEAR || domain->type == DOMAIN_HIERARCHY) {
         if (domain->linear_map) {
@@ -518,21 +505,18 @@ void irq_domain_remove(struct irq_domain *domain) {
 
 // Find domain by device tree node
 struct irq_domain *irq_find_host(struct device_node *node) {
-    struct irq_domain *domain = NULL;
-    struct list_head *pos;
-    unsigned long flags;
+    struct irq_domain *domain;
     
-    spin_lock_irqsave(&irq_domain_list_lock, flags);
+    rcu_read_lock();
     
-    for (pos = irq_domain_list.next; pos != &irq_domain_list; pos = pos->next) {
-        domain = (struct irq_domain *)((char *)pos - offsetof(struct irq_domain, link));
+    list_for_each_entry_rcu(domain, &irq_domain_list, link) {
         if (domain->of_node == node) {
-            spin_unlock_irqrestore(&irq_domain_list_lock, flags);
+            rcu_read_unlock();
             return domain;
         }
     }
     
-    spin_unlock_irqrestore(&irq_domain_list_lock, flags);
+    rcu_read_unlock();
     
     return NULL;
 }
@@ -0,0 +1,31 @@
+/*
+ * kernel/irq/irq_stack.c
+ *
+ * Per-CPU interrupt stack allocation
+ */
+
+#include <irq/irq_stack.h>
+#include <memory/pmm.h>
+#include <memory/vmparam.h>
+#include <smp.h>
+#include <panic.h>
+#include <uart.h>
+
+DEFINE_PER_CPU(uintptr_t, irq_stack_ptr) = 0;
+
+void irq_stack_init(void) {
+    for (unsigned int cpu = 0; cpu < nr_cpu_ids; cpu++) {
+        uint64_t phys = pmm_alloc_pages(IRQ_STACK_PAGES);
+        if (phys == 0) {
+            panic("irq: failed to allocate IRQ stack");
+        }
+
+        // The entry code pushes before it calls, so any 16-byte aligned
+        // top will do
+        per_cpu(irq_stack_ptr, cpu) = PHYS_TO_DMAP(phys) + IRQ_STACK_SIZE;
+    }
+
+    uart_puts("IRQ: ");
+    uart_putdec(IRQ_STACK_SIZE);
+    uart_puts(" byte interrupt stack per CPU\n");
+}
@@ -18,7 +18,7 @@ static struct msi_desc *msi_desc_alloc_internal(void) {
     // Initialize list head
     desc->list.next = &desc->list;
     desc->list.prev = &desc->list;
-    desc->refcount = 1;
+    atomic_set(&desc->refcount, 1);
     
     return desc;
 }
@@ -53,8 +53,7 @@ void msi_desc_free(struct msi_desc *desc) {
         return;
     }
     
-    desc->refcount--;
-    if (desc->refcount > 0) {
+    if (!atomic_dec_and_test(&desc->refcount)) {
         return;
     }
     
@@ -96,7 +95,7 @@ int msi_desc_list_add_locked(struct msi_device_data *msi_data, struct msi_desc *
     msi_data->list.prev = &desc->list;
     
     msi_data->num_vectors++;
-    desc->refcount++;
+    atomic_inc(&desc->refcount);
     
     return 0;
 }
@@ -148,8 +147,7 @@ void msi_device_cleanup(struct device *dev) {
         desc->list.next->prev = desc->list.prev;
         desc->list.prev->next = desc->list.next;
         
-        desc->refcount--;
-        if (desc->refcount == 0) {
+        if (atomic_dec_and_test(&desc->refcount)) {
             kfree(desc);
         }
         
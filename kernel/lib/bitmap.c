@@ -0,0 +1,29 @@
+/*
+ * kernel/lib/bitmap.c
+ *
+ * Bitmap scanning
+ */
+
+#include <lib/bitmap.h>
+#include <arch_simd.h>
+
+// A clear bit close by is the common case; only a longer full run is
+// worth a SIMD section
+#define BITMAP_SCALAR_WORDS 8
+
+size_t bitmap_find_zero_word(const uint64_t *map, size_t nwords) {
+    size_t i = 0;
+
+    for (; i < nwords && i < BITMAP_SCALAR_WORDS; i++) {
+        if (map[i] != ~0ULL) {
+            return i;
+        }
+    }
+#if ARCH_HAS_SIMD_BITMAP
+    i += arch_bitmap_skip_full_words(map + i, nwords - i);
+#endif
+    while (i < nwords && map[i] == ~0ULL) {
+        i++;
+    }
+    return i;
+}
@@ -0,0 +1,160 @@
+/*
+ * kernel/lib/checksum.c
+ *
+ * Checksums
+ */
+
+#include <lib/checksum.h>
+#include <lib/word_at_a_time.h>
+#include <arch_simd.h>
+#include <arch_crc32.h>
+#include <stdbool.h>
+
+uint32_t csum_rotxor32(const void *buf, size_t len) {
+    const uint8_t *bytes = buf;
+    uint32_t csum = 0;
+
+#if ARCH_HAS_SIMD_CSUM
+    if (arch_csum_rotxor32(buf, len, &csum)) {
+        return csum;
+    }
+#endif
+    for (size_t i = 0; i < len; i++) {
+        csum = ((csum << 1) | (csum >> 31)) ^ bytes[i];
+    }
+    return csum;
+}
+
+/*
+ * Both CRCs are bit-reflected, like the hardware instructions: the least
+ * significant bit of each byte comes first, and the running value is kept
+ * inverted between the public entry points.
+ */
+#define CRC32_POLY      0xedb88320U     // 0x04c11db7 reflected
+#define CRC32C_POLY     0x82f63b78U     // 0x1edc6f41 reflected
+
+// table[k][b] is the CRC of byte b followed by k zero bytes, so eight
+// lookups fold in a whole 64-bit word at once
+typedef uint32_t crc_table_t[8][256];
+
+static crc_table_t crc32_table;
+static crc_table_t crc32c_table;
+static bool crc_tables_ready = false;
+
+static void crc_build_table(crc_table_t table, uint32_t poly) {
+    for (unsigned int b = 0; b < 256; b++) {
+        uint32_t crc = b;
+
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (poly & -(crc & 1));
+        }
+        table[0][b] = crc;
+    }
+    for (unsigned int b = 0; b < 256; b++) {
+        for (int k = 1; k < 8; k++) {
+            uint32_t prev = table[k - 1][b];
+
+            table[k][b] = (prev >> 8) ^ table[0][prev & 0xff];
+        }
+    }
+}
+
+void crc32_init(void) {
+    crc_build_table(crc32_table, CRC32_POLY);
+    crc_build_table(crc32c_table, CRC32C_POLY);
+    crc_tables_ready = true;
+}
+
+// Odd bytes at either end, and everything before crc32_init()
+static uint32_t crc_bytes(uint32_t crc, const uint8_t *p, size_t len,
+                          const crc_table_t table, uint32_t poly) {
+    if (!crc_tables_ready) {
+        while (len--) {
+            crc ^= *p++;
+            for (int i = 0; i < 8; i++) {
+                crc = (crc >> 1) ^ (poly & -(crc & 1));
+            }
+        }
+        return crc;
+    }
+
+    while (len--) {
+        crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xff];
+    }
+    return crc;
+}
+
+// Bytes up to the first 8-byte boundary
+static inline size_t crc_head_len(const uint8_t *p, size_t len) {
+    size_t head = -(uintptr_t)p & 7;
+
+    return head < len ? head : len;
+}
+
+static uint32_t crc_sliced(uint32_t crc, const uint8_t *p, size_t len,
+                           const crc_table_t table, uint32_t poly) {
+    size_t head = crc_head_len(p, len);
+
+    if (!crc_tables_ready) {
+        return crc_bytes(crc, p, len, table, poly);
+    }
+
+    crc = crc_bytes(crc, p, head, table, poly);
+    p += head;
+    len -= head;
+
+    // Little-endian: the lowest byte is first and has seven more after it
+    for (; len >= 8; len -= 8, p += 8) {
+        uint64_t w = *(const word_alias_t *)p ^ crc;
+
+        crc = table[7][w & 0xff] ^ table[6][(w >> 8) & 0xff] ^
+              table[5][(w >> 16) & 0xff] ^ table[4][(w >> 24) & 0xff] ^
+              table[3][(w >> 32) & 0xff] ^ table[2][(w >> 40) & 0xff] ^
+              table[1][(w >> 48) & 0xff] ^ table[0][w >> 56];
+    }
+    return crc_bytes(crc, p, len, table, poly);
+}
+
+#if ARCH_HAS_CRC32
+// The instructions take the aligned words; the table the ends
+static uint32_t crc_arch(uint32_t crc, const uint8_t *p, size_t len,
+                         const crc_table_t table, uint32_t poly,
+                         uint32_t (*words)(uint32_t, const uint64_t *, size_t)) {
+    size_t head = crc_head_len(p, len);
+
+    crc = crc_bytes(crc, p, head, table, poly);
+    p += head;
+    len -= head;
+
+    crc = words(crc, (const uint64_t *)p, len / 8);
+    p += len & ~7UL;
+
+    return crc_bytes(crc, p, len & 7, table, poly);
+}
+#endif
+
+uint32_t crc32_sliced(uint32_t crc, const void *buf, size_t len) {
+    return ~crc_sliced(~crc, buf, len, crc32_table, CRC32_POLY);
+}
+
+uint32_t crc32c_sliced(uint32_t crc, const void *buf, size_t len) {
+    return ~crc_sliced(~crc, buf, len, crc32c_table, CRC32C_POLY);
+}
+
+uint32_t crc32(uint32_t crc, const void *buf, size_t len) {
+#if ARCH_HAS_CRC32
+    if (arch_crc32_usable()) {
+        return ~crc_arch(~crc, buf, len, crc32_table, CRC32_POLY, arch_crc32_words);
+    }
+#endif
+    return crc32_sliced(crc, buf, len);
+}
+
+uint32_t crc32c(uint32_t crc, const void *buf, size_t len) {
+#if ARCH_HAS_CRC32
+    if (arch_crc32_usable()) {
+        return ~crc_arch(~crc, buf, len, crc32c_table, CRC32C_POLY, arch_crc32c_words);
+    }
+#endif
+    return crc32c_sliced(crc, buf, len);
+}
@@ -2,9 +2,14 @@
  * kernel/lib/radix_tree.c
  *
  * Generic radix tree implementation for sparse mappings
+ *
+ * Updates and tag operations serialise on root->lock. radix_tree_lookup()
+ * takes no lock: nodes and items are published with rcu_assign_pointer()
+ * and unlinked nodes are freed only after an RCU grace period.
  */
 
 #include <lib/radix_tree.h>
+#include <lib/list.h>
 #include <memory/kmalloc.h>
 #include <string.h>
 #include <panic.h>
@@ -42,25 +47,34 @@ static struct radix_tree_node *radix_tree_node_create(void) {
     return node;
 }
 
+static void radix_tree_node_rcu_free(struct rcu_head *head) {
+    radix_tree_node_free(container_of(head, struct radix_tree_node, rcu));
+}
+
+// Free a node that lockless lookups may still be walking through
+static void radix_tree_node_retire(struct radix_tree_node *node) {
+    call_rcu(&node->rcu, radix_tree_node_rcu_free);
+}
+
 static inline void tag_set(struct radix_tree_node *node, unsigned int tag,
                           int offset) {
-    unsigned long *addr = &node->tags[tag][offset / 64];
-    unsigned long mask = 1UL << (offset % 64);
-    *addr |= mask;
+    bitmap_set_bit(node->tags[tag], offset);
 }
 
 static inline void tag_clear(struct radix_tree_node *node, unsigned int tag,
                             int offset) {
-    unsigned long *addr = &node->tags[tag][offset / 64];
-    unsigned long mask = 1UL << (offset % 64);
-    *addr &= ~mask;
+    bitmap_clear_bit(node->tags[tag], offset);
 }
 
 static inline int tag_get(struct radix_tree_node *node, unsigned int tag,
                          int offset) {
-    unsigned long *addr = &node->tags[tag][offset / 64];
-    unsigned long mask = 1UL << (offset % 64);
-    return (*addr & mask) != 0;
+    return bitmap_test_bit(node->tags[tag], offset);
+}
+
+// First slot at or after offset with tag set, or RADIX_TREE_MAP_SIZE
+static inline int tag_find_next(struct radix_tree_node *node, unsigned int tag,
+                                int offset) {
+    return bitmap_find_next_bit(node->tags[tag], RADIX_TREE_MAP_SIZE, offset);
 }
 
 static int any_tag_set(struct radix_tree_node *node, unsigned int tag) {
@@ -85,7 +99,7 @@ static int radix_tree_extend(struct radix_tree_root *root, uint32_t index) {
         if (!node)
             return -1;
         node->height = 0;
-        root->rnode = node;
+        rcu_assign_pointer(root->rnode, node);
         root->height = 1;
     }
 
@@ -111,7 +125,7 @@ static int radix_tree_extend(struct radix_tree_root *root, uint32_t index) {
             }
         }
 
-        root->rnode = node;
+        rcu_assign_pointer(root->rnode, node);
         root->height++;
     }
 
@@ -149,7 +163,7 @@ int radix_tree_insert(struct radix_tree_root *root, uint32_t index, void *item)
             }
             node->height = height - 1;
             node->parent = parent;
-            parent->slots[offset] = node;
+            rcu_assign_pointer(parent->slots[offset], node);
             parent->count++;
         }
         
@@ -162,7 +176,7 @@ int radix_tree_insert(struct radix_tree_root *root, uint32_t index, void *item)
         return -1;
     }
 
-    node->slots[offset] = item;
+    rcu_assign_pointer(node->slots[offset], item);
     node->count++;
     
     if (index > root->max_key)
@@ -172,40 +186,33 @@ int radix_tree_insert(struct radix_tree_root *root, uint32_t index, void *item)
     return 0;
 }
 
+// Lockless. Each node records its own height, so a walk that races with
+// the tree growing or shrinking stays self-consistent. The returned item is
+// whatever the caller's own lifetime rules make it; the nodes themselves
+// are safe to touch until the caller's next quiescent state.
 void *radix_tree_lookup(struct radix_tree_root *root, uint32_t index) {
     struct radix_tree_node *node;
-    unsigned int height;
-    int offset;
-
-    spin_lock(&root->lock);
+    void *ret;
 
-    if (!root->rnode || root->height == 0) {
-        spin_unlock(&root->lock);
-        return NULL;
-    }
+    rcu_read_lock();
 
-    if (index > radix_tree_maxindex(root->height)) {
-        spin_unlock(&root->lock);
+    node = rcu_dereference(root->rnode);
+    if (!node || index > radix_tree_maxindex(node->height + 1)) {
+        rcu_read_unlock();
         return NULL;
     }
 
-    node = root->rnode;
-    height = root->height - 1;
-
-    while (height > 0) {
-        offset = radix_tree_get_slot(index, height);
-        node = node->slots[offset];
+    while (node->height > 0) {
+        node = rcu_dereference(node->slots[radix_tree_get_slot(index, node->height)]);
         if (!node) {
-            spin_unlock(&root->lock);
+            rcu_read_unlock();
             return NULL;
         }
-        height--;
     }
 
-    offset = radix_tree_get_slot(index, 0);
-    void *ret = node->slots[offset];
-    
-    spin_unlock(&root->lock);
+    ret = rcu_dereference(node->slots[radix_tree_get_slot(index, 0)]);
+
+    rcu_read_unlock();
     return ret;
 }
 
@@ -223,7 +230,7 @@ void radix_tree_shrink(struct radix_tree_root *root) {
         if (!node->slots[0])
             break;
 
-        root->rnode = node->slots[0];
+        rcu_assign_pointer(root->rnode, node->slots[0]);
         root->height--;
         
         if (root->rnode) {
@@ -231,16 +238,16 @@ void radix_tree_shrink(struct radix_tree_root *root) {
             child->parent = NULL;
         }
         
-        radix_tree_node_free(node);
+        radix_tree_node_retire(node);
     }
 
     if (root->height == 1 && root->rnode) {
         node = root->rnode;
         if (node->count == 0) {
-            root->rnode = NULL;
+            RCU_INIT_POINTER(root->rnode, NULL);
             root->height = 0;
             root->max_key = 0;
-            radix_tree_node_free(node);
+            radix_tree_node_retire(node);
         }
     }
 }
@@ -285,28 +292,28 @@ void *radix_tree_delete(struct radix_tree_root *root, uint32_t index) {
         return NULL;
     }
 
-    node->slots[offset] = NULL;
+    RCU_INIT_POINTER(node->slots[offset], NULL);
     node->count--;
 
     while (node && node->count == 0) {
         parent = node->parent;
         if (!parent) {
-            root->rnode = NULL;
+            RCU_INIT_POINTER(root->rnode, NULL);
             root->height = 0;
             root->max_key = 0;
-            radix_tree_node_free(node);
+            radix_tree_node_retire(node);
             break;
         }
 
         for (offset = 0; offset < RADIX_TREE_MAP_SIZE; offset++) {
             if (parent->slots[offset] == node) {
-                parent->slots[offset] = NULL;
+                RCU_INIT_POINTER(parent->slots[offset], NULL);
                 parent->count--;
                 break;
             }
         }
         
-        radix_tree_node_free(node);
+        radix_tree_node_retire(node);
         node = parent;
     }
 
@@ -356,7 +363,7 @@ void *radix_tree_replace(struct radix_tree_root *root, uint32_t index, void *ite
 
     offset = radix_tree_get_slot(index, 0);
     old = node->slots[offset];
-    node->slots[offset] = item;
+    rcu_assign_pointer(node->slots[offset], item);
     
     spin_unlock(&root->lock);
     return old;
@@ -684,10 +691,8 @@ void *radix_tree_next_tagged(struct radix_tree_root *root,
             // Look for a tagged child starting from offset
             int found = 0;
             int i;
-            for (i = offset; i < RADIX_TREE_MAP_SIZE; i++) {
-                if (!tag_get(node, tag, i))
-                    continue;
-                
+            for (i = tag_find_next(node, tag, offset); i < RADIX_TREE_MAP_SIZE;
+                 i = tag_find_next(node, tag, i + 1)) {
                 child = node->slots[i];
                 if (child) {
                     if (i > offset) {
@@ -720,9 +725,10 @@ void *radix_tree_next_tagged(struct radix_tree_root *root,
             continue;
 
         // At leaf level, find tagged entry
-        for (offset = radix_tree_get_slot(index, 0); 
-             offset < RADIX_TREE_MAP_SIZE; offset++) {
-            if (tag_get(node, tag, offset) && node->slots[offset]) {
+        for (offset = tag_find_next(node, tag, radix_tree_get_slot(index, 0));
+             offset < RADIX_TREE_MAP_SIZE;
+             offset = tag_find_next(node, tag, offset + 1)) {
+            if (node->slots[offset]) {
                 iter->index = (index & ~RADIX_TREE_MAP_MASK) | offset;
                 // Handle wraparound when index is 0xFFFFFFFF
                 if (iter->index == 0xFFFFFFFF) {
@@ -0,0 +1,263 @@
+/*
+ * kernel/lib/ring.c
+ *
+ * Lock-free SPSC and MPSC ring buffers
+ *
+ * prod_head is where the next reservation starts, and prod_tail is how
+ * far the consumer may read. A single producer moves both itself. MPSC
+ * producers claim slots by moving prod_head with a compare-and-swap.
+ * Each one then waits for prod_tail to reach its own head before it
+ * publishes, so the consumer always sees a gap-free run of filled slots.
+ */
+
+#include <lib/ring.h>
+#include <memory/kmalloc.h>
+#include <spinlock.h>
+#include <arch_timer.h>
+#include <string.h>
+
+static inline bool ring_is_pow2(uint32_t n) {
+    return n && !(n & (n - 1));
+}
+
+static inline uint8_t *ring_slot(const struct ring *r, uint32_t idx) {
+    return r->data + (size_t)(idx & r->mask) * r->esize;
+}
+
+// Whole 64-bit words when everything lines up; most elements are
+// pointers or small records
+static void ring_copy(void *dst, const void *src, uint32_t n, uint32_t esize) {
+    size_t bytes = (size_t)n * esize;
+
+    if (!(((uintptr_t)dst | (uintptr_t)src | bytes) & 7)) {
+        uint64_t *d = dst;
+        const uint64_t *s = src;
+        for (size_t i = 0; i < bytes / 8; i++) {
+            d[i] = s[i];
+        }
+    } else {
+        memcpy(dst, src, bytes);
+    }
+}
+
+int ring_init(struct ring *r, void *buf, uint32_t count, uint32_t esize, unsigned int flags) {
+    // Half the index space at most, so head - tail never looks negative
+    if (!r || !buf || !esize || !ring_is_pow2(count) || count > (1U << 31)) {
+        return -1;
+    }
+
+    r->size = count;
+    r->mask = count - 1;
+    r->esize = esize;
+    r->flags = flags;
+    r->data = buf;
+    r->allocated = false;
+    r->prod_head = 0;
+    r->prod_tail = 0;
+    r->cons_tail = 0;
+    return 0;
+}
+
+struct ring *ring_create(uint32_t count, uint32_t esize, unsigned int flags) {
+    struct ring *r;
+    void *buf;
+
+    if (!ring_is_pow2(count) || !esize || esize > UINT32_MAX / count) {
+        return NULL;
+    }
+
+    r = kmalloc(sizeof(*r), KM_ZERO);
+    if (!r) {
+        return NULL;
+    }
+    buf = kmalloc((size_t)count * esize, 0);
+    if (!buf || ring_init(r, buf, count, esize, flags) != 0) {
+        kfree(buf);
+        kfree(r);
+        return NULL;
+    }
+    r->allocated = true;
+    return r;
+}
+
+void ring_destroy(struct ring *r) {
+    if (!r || !r->allocated) {
+        return;
+    }
+    kfree(r->data);
+    kfree(r);
+}
+
+/*
+ * Claim up to n free slots for this producer, at most up to the end of the
+ * buffer if contiguous is set. Returns the number claimed, starting at *head.
+ */
+static uint32_t ring_prod_claim(struct ring *r, uint32_t n, bool contiguous, uint32_t *headp) {
+    uint32_t head = __atomic_load_n(&r->prod_head, __ATOMIC_RELAXED);
+    uint32_t want;
+
+    for (;;) {
+        // Acquire: the consumer has finished reading the slots before cons_tail
+        uint32_t cons = __atomic_load_n(&r->cons_tail, __ATOMIC_ACQUIRE);
+        uint32_t used = head - cons;
+
+        if (used > r->size) {
+            // Stale head, older than the consumer's last release: reread
+            head = __atomic_load_n(&r->prod_head, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        want = n;
+        if (want > r->size - used) {
+            want = r->size - used;
+        }
+        if (contiguous && want > r->size - (head & r->mask)) {
+            want = r->size - (head & r->mask);
+        }
+        if (want == 0) {
+            return 0;
+        }
+
+        if (!(r->flags & RING_F_MP)) {
+            __atomic_store_n(&r->prod_head, head + want, __ATOMIC_RELAXED);
+            break;
+        }
+        // On failure head is reloaded with the winner's value
+        if (__atomic_compare_exchange_n(&r->prod_head, &head, head + want, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+        arch_cpu_relax();
+    }
+
+    *headp = head;
+    return want;
+}
+
+static void ring_prod_publish(struct ring *r, uint32_t head, uint32_t n) {
+    if (r->flags & RING_F_MP) {
+        // Earlier reservations go first. Acquire so their slot stores are
+        // ordered before ours are published as well.
+        while (__atomic_load_n(&r->prod_tail, __ATOMIC_ACQUIRE) != head) {
+            arch_cpu_relax();
+        }
+    }
+    // Release: the slot contents are visible before the new tail
+    __atomic_store_n(&r->prod_tail, head + n, __ATOMIC_RELEASE);
+}
+
+// Readable slots from cons_tail on, at most n; consumer only
+static uint32_t ring_cons_avail(struct ring *r, uint32_t n, bool contiguous, uint32_t *tailp) {
+    uint32_t tail = r->cons_tail;
+    // Acquire: pairs with the release in ring_prod_publish()
+    uint32_t avail = __atomic_load_n(&r->prod_tail, __ATOMIC_ACQUIRE) - tail;
+
+    if (n > avail) {
+        n = avail;
+    }
+    if (contiguous && n > r->size - (tail & r->mask)) {
+        n = r->size - (tail & r->mask);
+    }
+    *tailp = tail;
+    return n;
+}
+
+static void ring_cons_free(struct ring *r, uint32_t tail, uint32_t n) {
+    // Release: our reads of the slots finish before a producer reuses them
+    __atomic_store_n(&r->cons_tail, tail + n, __ATOMIC_RELEASE);
+}
+
+uint32_t ring_enqueue_batch(struct ring *r, const void *objs, uint32_t n) {
+    bool mp = r->flags & RING_F_MP;
+    irqflags_t flags = 0;
+    uint32_t head, first;
+
+    if (mp) {
+        flags = arch_local_irq_save();
+    }
+
+    n = ring_prod_claim(r, n, false, &head);
+    if (n) {
+        // Up to the end of the buffer, then the rest from the start
+        first = r->size - (head & r->mask);
+        if (first > n) {
+            first = n;
+        }
+        ring_copy(ring_slot(r, head), objs, first, r->esize);
+        ring_copy(r->data, (const uint8_t *)objs + (size_t)first * r->esize,
+                  n - first, r->esize);
+        ring_prod_publish(r, head, n);
+    }
+
+    if (mp) {
+        arch_local_irq_restore(flags);
+    }
+    return n;
+}
+
+uint32_t ring_dequeue_batch(struct ring *r, void *objs, uint32_t n) {
+    uint32_t tail, first;
+
+    n = ring_cons_avail(r, n, false, &tail);
+    if (!n) {
+        return 0;
+    }
+
+    first = r->size - (tail & r->mask);
+    if (first > n) {
+        first = n;
+    }
+    ring_copy(objs, ring_slot(r, tail), first, r->esize);
+    ring_copy((uint8_t *)objs + (size_t)first * r->esize, r->data, n - first, r->esize);
+    ring_cons_free(r, tail, n);
+    return n;
+}
+
+uint32_t ring_reserve(struct ring *r, uint32_t n, struct ring_resv *resv) {
+    bool mp = r->flags & RING_F_MP;
+    uint32_t head;
+
+    resv->irqflags = 0;
+    if (mp) {
+        resv->irqflags = arch_local_irq_save();
+    }
+
+    n = ring_prod_claim(r, n, true, &head);
+    if (!n) {
+        if (mp) {
+            arch_local_irq_restore(resv->irqflags);
+        }
+        resv->ptr = NULL;
+        resv->count = 0;
+        return 0;
+    }
+
+    resv->ptr = ring_slot(r, head);
+    resv->head = head;
+    resv->count = n;
+    return n;
+}
+
+void ring_commit(struct ring *r, const struct ring_resv *resv) {
+    ring_prod_publish(r, resv->head, resv->count);
+    if (r->flags & RING_F_MP) {
+        arch_local_irq_restore(resv->irqflags);
+    }
+}
+
+uint32_t ring_peek(struct ring *r, uint32_t n, struct ring_resv *resv) {
+    uint32_t tail;
+
+    n = ring_cons_avail(r, n, true, &tail);
+    resv->ptr = n ? ring_slot(r, tail) : NULL;
+    resv->head = tail;
+    resv->count = n;
+    resv->irqflags = 0;
+    return n;
+}
+
+void ring_release(struct ring *r, const struct ring_resv *resv) {
+    if (resv->count) {
+        ring_cons_free(r, resv->head, resv->count);
+    }
+}
@@ -5,26 +5,30 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <arch_string.h>
+#include <lib/word_at_a_time.h>
 
 // Import uart functions for debugging
 extern void uart_puts(const char *str);
 extern void uart_puthex(unsigned long val);
 
+// Portable fallbacks; architectures with their own say so in arch_string.h
+
+#if !ARCH_HAS_MEMCPY
 void *memcpy(void *dest, const void *src, size_t n) {
     unsigned char *d = dest;
     const unsigned char *s = src;
     
-    // Check for NULL pointers
-    if (!dest || !src) {
-        return dest;
-    }
-    
     while (n--) {
         *d++ = *s++;
     }
     return dest;
 }
+#endif
 
+#if !ARCH_HAS_MEMSET
 void *memset(void *s, int c, size_t n) {
     unsigned char *p = s;
     while (n--) {
@@ -32,7 +36,9 @@ void *memset(void *s, int c, size_t n) {
     }
     return s;
 }
+#endif
 
+#if !ARCH_HAS_MEMMOVE
 void *memmove(void *dest, const void *src, size_t n) {
     unsigned char *d = dest;
     const unsigned char *s = src;
@@ -53,15 +59,60 @@ void *memmove(void *dest, const void *src, size_t n) {
     
     return dest;
 }
+#endif
 
-size_t strlen(const char* s) {
-    size_t len = 0;
-    while (*s++) {
-        len++;
+#if !ARCH_HAS_MEMCMP
+int memcmp(const void *s1, const void *s2, size_t n) {
+    const unsigned char *a = s1;
+    const unsigned char *b = s2;
+
+    while (n--) {
+        if (*a != *b) {
+            return *a - *b;
+        }
+        a++;
+        b++;
     }
-    return len;
+    return 0;
+}
+#endif
+
+/*
+ * The string routines below step a byte at a time to an 8-byte boundary
+ * and then read whole aligned words, testing eight bytes for the
+ * terminator at once. See lib/word_at_a_time.h for why reading the rest
+ * of the word past a terminator is safe.
+ */
+
+static inline int str_aligned(const void *p) {
+    return ((uintptr_t)p & (sizeof(uint64_t) - 1)) == 0;
 }
 
+size_t __strlen(const char* s) {
+    const char *p = s;
+    const word_alias_t *w;
+    uint64_t mask;
+
+    while (!str_aligned(p)) {
+        if (!*p) {
+            return p - s;
+        }
+        p++;
+    }
+
+    w = (const word_alias_t *)p;
+    while (!(mask = word_zero_bytes(*w))) {
+        w++;
+    }
+    return (const char *)w - s + word_first_byte(mask);
+}
+
+#if !ARCH_HAS_STRLEN
+size_t strlen(const char* s) {
+    return __strlen(s);
+}
+#endif
+
 char* strcpy(char* dest, const char* src) {
     char* d = dest;
     while ((*d++ = *src++) != '\0');
@@ -84,24 +135,84 @@ char* strncpy(char* dest, const char* src, size_t n) {
     return dest;
 }
 
-int strcmp(const char* s1, const char* s2) {
-    while (*s1 && *s2 && *s1 == *s2) {
-        s1++;
-        s2++;
-    }
-    return *(unsigned char*)s1 - *(unsigned char*)s2;
-}
+/*
+ * Compare at most n bytes; strcmp passes SIZE_MAX. Words of s1 are read
+ * aligned. When s2 is aligned differently each of its words is put
+ * together from two aligned loads, and the second is only loaded once
+ * the bytes left in the first are known not to end the string, so s2 is
+ * never read past the aligned word holding its terminator either.
+ */
+static int str_compare(const char *s1, const char *s2, size_t n) {
+    const unsigned char *a = (const unsigned char *)s1;
+    const unsigned char *b = (const unsigned char *)s2;
 
-int strncmp(const char* s1, const char* s2, size_t n) {
-    while (n && *s1 && *s2 && *s1 == *s2) {
-        s1++;
-        s2++;
+    while (n && !str_aligned(a)) {
+        if (*a != *b || !*a) {
+            return *a - *b;
+        }
+        a++;
+        b++;
         n--;
     }
-    if (n == 0) {
-        return 0;
+
+    if (str_aligned(b)) {
+        const word_alias_t *wa = (const word_alias_t *)a;
+        const word_alias_t *wb = (const word_alias_t *)b;
+
+        for (; n >= 8; n -= 8) {
+            uint64_t x = *wa;
+
+            if (x != *wb || word_zero_bytes(x)) {
+                break;
+            }
+            wa++;
+            wb++;
+        }
+        a = (const unsigned char *)wa;
+        b = (const unsigned char *)wb;
+    } else {
+        unsigned int shift = ((uintptr_t)b & 7) * 8;
+        const word_alias_t *wa = (const word_alias_t *)a;
+        const word_alias_t *wb = (const word_alias_t *)((uintptr_t)b & ~7UL);
+        uint64_t lo = *wb;
+
+        for (; n >= 8; n -= 8) {
+            uint64_t x = *wa;
+            uint64_t hi;
+
+            // The bytes of s2 still in lo, with the rest made non-zero
+            if (word_zero_bytes((lo >> shift) | (~0UL << (64 - shift)))) {
+                break;
+            }
+            hi = wb[1];
+            if (x != ((lo >> shift) | (hi << (64 - shift))) || word_zero_bytes(x)) {
+                break;
+            }
+            wa++;
+            wb++;
+            lo = hi;
+        }
+        a = (const unsigned char *)wa;
+        b = (const unsigned char *)wb + shift / 8;
+    }
+
+    // The word that stopped the loop, or what n leaves
+    for (; n; n--) {
+        if (*a != *b || !*a) {
+            return *a - *b;
+        }
+        a++;
+        b++;
     }
-    return *(unsigned char*)s1 - *(unsigned char*)s2;
+    return 0;
+}
+
+int strcmp(const char* s1, const char* s2) {
+    return str_compare(s1, s2, SIZE_MAX);
+}
+
+int strncmp(const char* s1, const char* s2, size_t n) {
+    return str_compare(s1, s2, n);
 }
 
 char* strstr(const char* haystack, const char* needle) {
@@ -120,23 +231,38 @@ char* strstr(const char* haystack, const char* needle) {
 }
 
 char* strchr(const char* s, int c) {
+    const word_alias_t *w;
+    char ch = (char)c;
+
     if (!s) {
         return NULL;
     }
-    
-    while (*s) {
-        if (*s == (char)c) {
+
+    // Checking for c before the terminator finds the terminator when c is 0
+    while (!str_aligned(s)) {
+        if (*s == ch) {
             return (char*)s;
         }
+        if (!*s) {
+            return NULL;
+        }
         s++;
     }
-    
-    // Check for null terminator if c is 0
-    if (c == 0) {
-        return (char*)s;
+
+    w = (const word_alias_t *)s;
+    while (!(word_zero_bytes(*w) | word_match_bytes(*w, (uint8_t)ch))) {
+        w++;
+    }
+
+    // One of the next eight bytes is c or the terminator
+    for (s = (const char *)w; ; s++) {
+        if (*s == ch) {
+            return (char*)s;
+        }
+        if (!*s) {
+            return NULL;
+        }
     }
-    
-    return NULL;
 }
 
 // Simple number to string conversion helper
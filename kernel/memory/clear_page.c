@@ -0,0 +1,38 @@
+/*
+ * kernel/memory/clear_page.c
+ *
+ * Page zeroing with the architecture's cache-block zero instruction,
+ * falling back to memset's store loop
+ */
+
+#include <memory/clear_page.h>
+#include <memory/pmm.h>
+#include <arch_cache.h>
+#include <string.h>
+
+// 0 until clear_page_init(), and when there is no usable instruction
+static size_t clear_block_size;
+
+void clear_page_init(void) {
+    size_t block;
+
+    arch_cache_zero_init();
+    block = arch_cache_zero_block_size();
+
+    // A page must be a whole number of blocks; blocks are powers of two
+    if (block && block <= PMM_PAGE_SIZE) {
+        clear_block_size = block;
+    }
+}
+
+void clear_pages(void *addr, size_t count) {
+    if (clear_block_size) {
+        arch_cache_zero(addr, count * PMM_PAGE_SIZE);
+    } else {
+        memset(addr, 0, count * PMM_PAGE_SIZE);
+    }
+}
+
+size_t clear_page_block_size(void) {
+    return clear_block_size;
+}
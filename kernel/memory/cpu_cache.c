@@ -22,4 +22,12 @@ void cpu_dcache_invalidate_range(void *addr, size_t size) {
 
 void cpu_dcache_clean_invalidate_range(void *addr, size_t size) {
     arch_cache_flush(addr, size);
-}
\ No newline at end of file
+}
+
+size_t cpu_dcache_line_size(void) {
+    return arch_cache_get_line_size();
+}
+
+bool cpu_dcache_coherent(void) {
+    return arch_cache_coherent();
+}
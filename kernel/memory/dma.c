@@ -0,0 +1,539 @@
+/*
+ * kernel/memory/dma.c
+ *
+ * DMA mapping: cache maintenance for devices that do not snoop, bounce
+ * buffers (a swiotlb) for memory a device cannot reach, and an uncached
+ * pool for coherent allocations
+ *
+ * Before the device reads a buffer its dirty lines are cleaned to memory.
+ * Every direction is cleaned, not only DMA_TO_DEVICE, so no dirty line can
+ * be evicted on top of what the device writes. Once the device is done,
+ * lines it may have written are invalidated, dropping anything the CPU
+ * fetched speculatively meanwhile. Maintenance runs on the DMAP alias of
+ * the buffer, which the data cache treats as the same lines.
+ */
+
+#include <memory/dma.h>
+#include <memory/memmap.h>
+#include <memory/devmap.h>
+#include <memory/pmm.h>
+#include <memory/vmparam.h>
+#include <device/device.h>
+#include <lib/bitmap.h>
+#include <arch_cache.h>
+#include <atomic.h>
+#include <spinlock.h>
+#include <string.h>
+#include <uart.h>
+
+// Bounce buffers, handed out in slots no smaller than a cache line so
+// two mappings never share one
+#define SWIOTLB_SIZE        (2 * 1024 * 1024)
+#define SWIOTLB_SLOT_SHIFT  11
+#define SWIOTLB_SLOT_SIZE   (1UL << SWIOTLB_SLOT_SHIFT)
+#define SWIOTLB_SLOTS       (SWIOTLB_SIZE >> SWIOTLB_SLOT_SHIFT)
+#define SWIOTLB_PAGES       (SWIOTLB_SIZE / PMM_PAGE_SIZE)
+
+// Uncached memory for dma_alloc_coherent() on devices that do not snoop,
+// handed out by page
+#define DMA_POOL_SIZE       (1024 * 1024)
+#define DMA_POOL_PAGES      (DMA_POOL_SIZE / PMM_PAGE_SIZE)
+
+// Linker symbols bounding the kernel image
+extern char __kernel_start;
+extern char _kernel_end;
+
+static struct {
+    spinlock_t lock;
+    uint64_t phys;                              // 0 when there is no pool
+    uint8_t *virt;                              // DMAP address of the pool
+    uint64_t map[BITMAP_WORDS(SWIOTLB_SLOTS)];
+    uint8_t *orig[SWIOTLB_SLOTS];               // CPU bytes each slot stands in for
+    size_t free_slots;
+    atomic64_t bounce_maps;
+    atomic64_t bounce_bytes;
+} swiotlb = {
+    .lock = SPINLOCK_INITIALIZER,
+};
+
+static struct {
+    spinlock_t lock;
+    uint64_t phys;                              // 0 when there is no pool
+    uint8_t *virt;                              // Uncached devmap address
+    uint64_t map[BITMAP_WORDS(DMA_POOL_PAGES)];
+    size_t free_pages;
+} coherent_pool = {
+    .lock = SPINLOCK_INITIALIZER,
+};
+
+static inline uint64_t dma_mask(struct device *dev) {
+    return dev->dma_mask ? dev->dma_mask : DMA_BIT_MASK(64);
+}
+
+bool dma_is_coherent(struct device *dev) {
+    return arch_cache_coherent() || dev->dma_coherent;
+}
+
+size_t dma_get_cache_alignment(void) {
+    return arch_cache_get_line_size();
+}
+
+// Physical address of kernel memory mapped by the DMAP or the kernel image
+static uint64_t dma_virt_to_phys(const void *ptr) {
+    uint64_t phys = DMAP_TO_PHYS(ptr);
+
+    if (phys) {
+        return phys;
+    }
+    if ((const char *)ptr >= &__kernel_start && (const char *)ptr < &_kernel_end) {
+        return VIRT_TO_PHYS(ptr);
+    }
+    return 0;
+}
+
+static inline void *dma_phys_to_virt(uint64_t phys) {
+    return (void *)PHYS_TO_DMAP(phys);
+}
+
+// The device can address all of [phys, phys + size) and memmap says
+// DMA may target it
+static bool dma_capable(struct device *dev, uint64_t phys, size_t size) {
+    uint64_t last = phys + size - 1;
+
+    return last >= phys && last <= dma_mask(dev) &&
+           memmap_is_dma_capable(phys) && memmap_is_dma_capable(last);
+}
+
+// Invalidating a partial line would also drop the CPU's writes to
+// whatever shares it, so such receive buffers bounce instead
+static bool dma_shares_lines(struct device *dev, uint64_t phys, size_t size,
+                             enum dma_data_direction dir) {
+    uint64_t line = arch_cache_get_line_size();
+
+    return dir != DMA_TO_DEVICE && !dma_is_coherent(dev) &&
+           ((phys | size) & (line - 1)) != 0;
+}
+
+int dma_set_mask(struct device *dev, uint64_t mask) {
+    // Buffers above the mask bounce, so either the bounce buffers or all
+    // of RAM must be below it
+    bool pool_reachable = swiotlb.phys && swiotlb.phys + SWIOTLB_SIZE - 1 <= mask;
+
+    if (!pool_reachable && pmm_get_memory_end() - 1 > mask) {
+        return -1;
+    }
+    dev->dma_mask = mask;
+    return 0;
+}
+
+/* Bounce buffers */
+
+static bool swiotlb_owns(dma_addr_t addr) {
+    return swiotlb.phys && addr >= swiotlb.phys && addr < swiotlb.phys + SWIOTLB_SIZE;
+}
+
+// Copy size bytes at bounce address addr to or from the CPU buffer
+static void swiotlb_bounce(dma_addr_t addr, size_t size, bool to_device) {
+    uint64_t offset = addr - swiotlb.phys;
+    uint8_t *bounce = swiotlb.virt + offset;
+    uint8_t *cpu = swiotlb.orig[offset >> SWIOTLB_SLOT_SHIFT] +
+                   (offset & (SWIOTLB_SLOT_SIZE - 1));
+
+    if (to_device) {
+        memcpy(bounce, cpu, size);
+    } else {
+        memcpy(cpu, bounce, size);
+    }
+    atomic64_add((int64_t)size, &swiotlb.bounce_bytes);
+}
+
+// Slots for ptr within the device's reach, filled from ptr; the copy is
+// made even for DMA_FROM_DEVICE so a short device write cannot expose
+// what the slots held before
+static dma_addr_t swiotlb_map(struct device *dev, void *ptr, size_t size) {
+    size_t count = (size + SWIOTLB_SLOT_SIZE - 1) >> SWIOTLB_SLOT_SHIFT;
+    irqflags_t flags;
+    dma_addr_t addr;
+    size_t slot;
+
+    if (!swiotlb.phys || !dma_capable(dev, swiotlb.phys, SWIOTLB_SIZE)) {
+        return DMA_MAPPING_ERROR;
+    }
+
+    spin_lock_irqsave(&swiotlb.lock, flags);
+    slot = bitmap_find_next_zero_area(swiotlb.map, SWIOTLB_SLOTS, 0, count);
+    if (slot == SWIOTLB_SLOTS) {
+        spin_unlock_irqrestore(&swiotlb.lock, flags);
+        return DMA_MAPPING_ERROR;
+    }
+    for (size_t i = 0; i < count; i++) {
+        bitmap_set_bit(swiotlb.map, slot + i);
+        swiotlb.orig[slot + i] = (uint8_t *)ptr + i * SWIOTLB_SLOT_SIZE;
+    }
+    swiotlb.free_slots -= count;
+    spin_unlock_irqrestore(&swiotlb.lock, flags);
+
+    addr = swiotlb.phys + (slot << SWIOTLB_SLOT_SHIFT);
+    swiotlb_bounce(addr, size, true);
+    atomic64_inc(&swiotlb.bounce_maps);
+    return addr;
+}
+
+static void swiotlb_unmap(dma_addr_t addr, size_t size) {
+    size_t count = (size + SWIOTLB_SLOT_SIZE - 1) >> SWIOTLB_SLOT_SHIFT;
+    size_t slot = (addr - swiotlb.phys) >> SWIOTLB_SLOT_SHIFT;
+    irqflags_t flags;
+
+    spin_lock_irqsave(&swiotlb.lock, flags);
+    for (size_t i = 0; i < count; i++) {
+        bitmap_clear_bit(swiotlb.map, slot + i);
+        swiotlb.orig[slot + i] = NULL;
+    }
+    swiotlb.free_slots += count;
+    spin_unlock_irqrestore(&swiotlb.lock, flags);
+}
+
+/* Streaming mappings */
+
+static void dma_cache_for_device(struct device *dev, dma_addr_t addr, size_t size) {
+    if (!dma_is_coherent(dev)) {
+        arch_cache_clean_nosync(dma_phys_to_virt(addr), size);
+    }
+}
+
+static void dma_cache_for_cpu(struct device *dev, dma_addr_t addr, size_t size,
+                              enum dma_data_direction dir) {
+    if (dir != DMA_TO_DEVICE && !dma_is_coherent(dev)) {
+        arch_cache_invalidate_nosync(dma_phys_to_virt(addr), size);
+    }
+}
+
+// Pick the bus address, bouncing if need be, without cache maintenance
+static dma_addr_t dma_map_nosync(struct device *dev, void *ptr, size_t size,
+                                 enum dma_data_direction dir) {
+    uint64_t phys = dma_virt_to_phys(ptr);
+
+    if (!phys || size == 0) {
+        return DMA_MAPPING_ERROR;
+    }
+    if (dma_capable(dev, phys, size) && !dma_shares_lines(dev, phys, size, dir)) {
+        return phys;
+    }
+    return swiotlb_map(dev, ptr, size);
+}
+
+// Copy a bounced buffer back and free its slots; cache maintenance for
+// the bounce slots must already have completed
+static void dma_unmap_nosync(dma_addr_t addr, size_t size, enum dma_data_direction dir) {
+    if (swiotlb_owns(addr)) {
+        if (dir != DMA_TO_DEVICE) {
+            swiotlb_bounce(addr, size, false);
+        }
+        swiotlb_unmap(addr, size);
+    }
+}
+
+dma_addr_t dma_map_single(struct device *dev, void *ptr, size_t size,
+                          enum dma_data_direction dir) {
+    dma_addr_t addr = dma_map_nosync(dev, ptr, size, dir);
+
+    if (!dma_mapping_error(addr)) {
+        dma_cache_for_device(dev, addr, size);
+        arch_cache_barrier();
+    }
+    return addr;
+}
+
+void dma_unmap_single(struct device *dev, dma_addr_t addr, size_t size,
+                      enum dma_data_direction dir) {
+    dma_cache_for_cpu(dev, addr, size, dir);
+    arch_cache_barrier();
+    dma_unmap_nosync(addr, size, dir);
+}
+
+void dma_sync_single_for_cpu(struct device *dev, dma_addr_t addr, size_t size,
+                             enum dma_data_direction dir) {
+    dma_cache_for_cpu(dev, addr, size, dir);
+    arch_cache_barrier();
+    if (swiotlb_owns(addr) && dir != DMA_TO_DEVICE) {
+        swiotlb_bounce(addr, size, false);
+    }
+}
+
+void dma_sync_single_for_device(struct device *dev, dma_addr_t addr, size_t size,
+                                enum dma_data_direction dir) {
+    if (swiotlb_owns(addr) && dir != DMA_FROM_DEVICE) {
+        swiotlb_bounce(addr, size, true);
+    }
+    dma_cache_for_device(dev, addr, size);
+    arch_cache_barrier();
+}
+
+/* Scatter-gather */
+
+// Cache maintenance over a list: entries whose bus ranges touch become
+// one range, so lines at the seams are done once, and the caller waits
+// for all of it with a single arch_cache_barrier()
+static void dma_sg_cache(struct device *dev, struct dma_sg *sg, int nents,
+                         enum dma_data_direction dir, bool for_device) {
+    dma_addr_t start = 0;
+    size_t len = 0;
+
+    if (dma_is_coherent(dev) || (!for_device && dir == DMA_TO_DEVICE)) {
+        return;
+    }
+
+    for (int i = 0; i <= nents; i++) {
+        if (i < nents && len && sg[i].dma_address == start + len) {
+            len += sg[i].length;
+            continue;
+        }
+        if (len) {
+            if (for_device) {
+                arch_cache_clean_nosync(dma_phys_to_virt(start), len);
+            } else {
+                arch_cache_invalidate_nosync(dma_phys_to_virt(start), len);
+            }
+        }
+        if (i < nents) {
+            start = sg[i].dma_address;
+            len = sg[i].length;
+        }
+    }
+}
+
+int dma_map_sg(struct device *dev, struct dma_sg *sg, int nents,
+               enum dma_data_direction dir) {
+    for (int i = 0; i < nents; i++) {
+        sg[i].dma_address = dma_map_nosync(dev, sg[i].addr, sg[i].length, dir);
+        if (dma_mapping_error(sg[i].dma_address)) {
+            // Nothing reached the device yet: give back the slots
+            // without copying anything back
+            while (--i >= 0) {
+                dma_unmap_nosync(sg[i].dma_address, sg[i].length, DMA_TO_DEVICE);
+            }
+            return 0;
+        }
+    }
+
+    dma_sg_cache(dev, sg, nents, dir, true);
+    arch_cache_barrier();
+    return nents;
+}
+
+void dma_unmap_sg(struct device *dev, struct dma_sg *sg, int nents,
+                  enum dma_data_direction dir) {
+    dma_sg_cache(dev, sg, nents, dir, false);
+    arch_cache_barrier();
+    for (int i = 0; i < nents; i++) {
+        dma_unmap_nosync(sg[i].dma_address, sg[i].length, dir);
+    }
+}
+
+void dma_sync_sg_for_cpu(struct device *dev, struct dma_sg *sg, int nents,
+                         enum dma_data_direction dir) {
+    dma_sg_cache(dev, sg, nents, dir, false);
+    arch_cache_barrier();
+    if (dir == DMA_TO_DEVICE) {
+        return;
+    }
+    for (int i = 0; i < nents; i++) {
+        if (swiotlb_owns(sg[i].dma_address)) {
+            swiotlb_bounce(sg[i].dma_address, sg[i].length, false);
+        }
+    }
+}
+
+void dma_sync_sg_for_device(struct device *dev, struct dma_sg *sg, int nents,
+                            enum dma_data_direction dir) {
+    if (dir != DMA_FROM_DEVICE) {
+        for (int i = 0; i < nents; i++) {
+            if (swiotlb_owns(sg[i].dma_address)) {
+                swiotlb_bounce(sg[i].dma_address, sg[i].length, true);
+            }
+        }
+    }
+    dma_sg_cache(dev, sg, nents, dir, true);
+    arch_cache_barrier();
+}
+
+/* Coherent allocations */
+
+static void *coherent_pool_alloc(size_t pages, dma_addr_t *dma_handle) {
+    irqflags_t flags;
+    size_t first;
+
+    spin_lock_irqsave(&coherent_pool.lock, flags);
+    first = bitmap_find_next_zero_area(coherent_pool.map, DMA_POOL_PAGES, 0, pages);
+    if (first == DMA_POOL_PAGES) {
+        spin_unlock_irqrestore(&coherent_pool.lock, flags);
+        return NULL;
+    }
+    for (size_t i = 0; i < pages; i++) {
+        bitmap_set_bit(coherent_pool.map, first + i);
+    }
+    coherent_pool.free_pages -= pages;
+    spin_unlock_irqrestore(&coherent_pool.lock, flags);
+
+    *dma_handle = coherent_pool.phys + first * PMM_PAGE_SIZE;
+    return coherent_pool.virt + first * PMM_PAGE_SIZE;
+}
+
+static bool coherent_pool_owns(const void *cpu_addr) {
+    const uint8_t *p = cpu_addr;
+
+    return coherent_pool.phys && p >= coherent_pool.virt &&
+           p < coherent_pool.virt + DMA_POOL_SIZE;
+}
+
+static void coherent_pool_free(void *cpu_addr, size_t pages) {
+    size_t first = ((uint8_t *)cpu_addr - coherent_pool.virt) / PMM_PAGE_SIZE;
+    irqflags_t flags;
+
+    spin_lock_irqsave(&coherent_pool.lock, flags);
+    for (size_t i = 0; i < pages; i++) {
+        bitmap_clear_bit(coherent_pool.map, first + i);
+    }
+    coherent_pool.free_pages += pages;
+    spin_unlock_irqrestore(&coherent_pool.lock, flags);
+}
+
+void *dma_alloc_coherent(struct device *dev, size_t size, dma_addr_t *dma_handle) {
+    size_t pages = (size + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE;
+    void *cpu_addr;
+
+    if (pages == 0 || !dma_handle) {
+        return NULL;
+    }
+
+    // A device that snoops can share ordinary cached pages
+    if (dma_is_coherent(dev)) {
+        uint64_t phys = pmm_alloc_pages(pages);
+
+        // Already zeroed by the PMM
+        if (phys && dma_capable(dev, phys, pages * PMM_PAGE_SIZE)) {
+            *dma_handle = phys;
+            return dma_phys_to_virt(phys);
+        }
+        if (phys) {
+            pmm_free_pages(phys, pages);
+        }
+    }
+
+    // Otherwise the uncached pool, which also serves snooping devices
+    // whose mask ordinary pages fell outside
+    if (!coherent_pool.phys ||
+        !dma_capable(dev, coherent_pool.phys, DMA_POOL_SIZE)) {
+        return NULL;
+    }
+    cpu_addr = coherent_pool_alloc(pages, dma_handle);
+    if (cpu_addr) {
+        memset(cpu_addr, 0, pages * PMM_PAGE_SIZE);
+    }
+    return cpu_addr;
+}
+
+void dma_free_coherent(struct device *dev, size_t size, void *cpu_addr,
+                       dma_addr_t dma_handle) {
+    size_t pages = (size + PMM_PAGE_SIZE - 1) / PMM_PAGE_SIZE;
+
+    (void)dev;
+    if (!cpu_addr || pages == 0) {
+        return;
+    }
+    if (coherent_pool_owns(cpu_addr)) {
+        coherent_pool_free(cpu_addr, pages);
+    } else {
+        pmm_free_pages(dma_handle, pages);
+    }
+}
+
+/* Setup */
+
+// Pages for a pool, checked against memmap
+static uint64_t dma_pool_pages(size_t pages, const char *name) {
+    uint64_t phys = pmm_alloc_pages(pages);
+
+    if (!phys) {
+        uart_puts("DMA: cannot allocate ");
+        uart_puts(name);
+        uart_puts("\n");
+        return 0;
+    }
+    if (!memmap_is_dma_capable(phys) ||
+        !memmap_is_dma_capable(phys + pages * PMM_PAGE_SIZE - 1)) {
+        uart_puts("DMA: ");
+        uart_puts(name);
+        uart_puts(" is not in DMA capable memory\n");
+        pmm_free_pages(phys, pages);
+        return 0;
+    }
+    return phys;
+}
+
+static void swiotlb_init(void) {
+    uint64_t phys = dma_pool_pages(SWIOTLB_PAGES, "bounce buffers");
+
+    if (!phys) {
+        return;
+    }
+    memset(swiotlb.map, 0, sizeof(swiotlb.map));
+    swiotlb.virt = dma_phys_to_virt(phys);
+    swiotlb.free_slots = SWIOTLB_SLOTS;
+    swiotlb.phys = phys;
+
+    uart_puts("DMA: ");
+    uart_putdec(SWIOTLB_SIZE / 1024);
+    uart_puts(" KiB of bounce buffers at ");
+    uart_puthex(phys);
+    uart_puts("\n");
+    if (phys + SWIOTLB_SIZE - 1 > DMA_BIT_MASK(32)) {
+        uart_puts("DMA: bounce buffers are above 4 GiB; 32-bit devices cannot use them\n");
+    }
+}
+
+static void coherent_pool_init(void) {
+    uint64_t phys;
+    void *virt;
+
+    // Only needed if some device might not snoop, and only possible if
+    // the MMU can map RAM uncached
+    if (arch_cache_coherent()) {
+        return;
+    }
+    if (!arch_cache_nocache_mappings()) {
+        uart_puts("DMA: no uncached mappings; non-coherent devices get no coherent memory\n");
+        return;
+    }
+
+    phys = dma_pool_pages(DMA_POOL_PAGES, "coherent pool");
+    if (!phys) {
+        return;
+    }
+    // Nothing may be left in the cache through the DMAP alias once the
+    // uncached alias is in use
+    arch_cache_flush(dma_phys_to_virt(phys), DMA_POOL_SIZE);
+
+    virt = devmap_map_device(phys, DMA_POOL_SIZE, DEVMAP_ATTR_NOCACHE);
+    if (!virt) {
+        uart_puts("DMA: cannot map coherent pool\n");
+        pmm_free_pages(phys, DMA_POOL_PAGES);
+        return;
+    }
+    memset(coherent_pool.map, 0, sizeof(coherent_pool.map));
+    coherent_pool.virt = virt;
+    coherent_pool.free_pages = DMA_POOL_PAGES;
+    coherent_pool.phys = phys;
+}
+
+void dma_init(void) {
+    swiotlb_init();
+    coherent_pool_init();
+}
+
+void dma_get_stats(struct dma_stats *stats) {
+    stats->bounce_maps = (uint64_t)atomic64_read(&swiotlb.bounce_maps);
+    stats->bounce_bytes = (uint64_t)atomic64_read(&swiotlb.bounce_bytes);
+    stats->swiotlb_free = swiotlb.free_slots * SWIOTLB_SLOT_SIZE;
+    stats->coherent_pool_free = coherent_pool.free_pages * PMM_PAGE_SIZE;
+}
@@ -8,10 +8,14 @@
 #include <memory/size_classes.h>
 #include <memory/pmm.h>
 #include <memory/page_alloc.h>
+#include <memory/clear_page.h>
 #include <memory/vmparam.h>
 #include <memory/vmm.h>
 #include <memory/malloc_types.h>
 #include <memory/slab_lookup.h>
+#include <percpu.h>
+#include <spinlock.h>
+#include <seqlock.h>
 #include <uart.h>
 #include <string.h>
 
@@ -28,8 +32,66 @@
 static struct kmem_cache *size_caches[KMALLOC_NUM_CLASSES];
 static int kmalloc_initialized = 0;
 
-// Global statistics
-static struct kmalloc_stats global_stats = {0};
+// Per-CPU statistics, summed by kmalloc_get_stats()
+// Gauges (active_*, large_bytes) may go "negative" on one CPU when memory is
+// freed on a different CPU than it was allocated on; the unsigned wrap
+// cancels out in the sum. Each allocation or free updates its CPU's block
+// in one seqcount write section, so readers see all of it or none.
+struct kmalloc_cpu_stats {
+    seqcount_t seq;
+    struct kmalloc_stats stats;
+};
+
+static DEFINE_PER_CPU_ALIGNED(struct kmalloc_cpu_stats, kmalloc_cpu_stats);
+
+static inline struct kmalloc_stats *kmalloc_stats_begin(irqflags_t *flags) {
+    struct kmalloc_cpu_stats *pcs;
+
+    *flags = arch_local_irq_save();
+    pcs = this_cpu_ptr(kmalloc_cpu_stats);
+    write_seqcount_begin(&pcs->seq);
+    return &pcs->stats;
+}
+
+static inline void kmalloc_stats_end(irqflags_t flags) {
+    write_seqcount_end(&this_cpu_ptr(kmalloc_cpu_stats)->seq);
+    arch_local_irq_restore(flags);
+}
+
+static void kmalloc_stats_alloc(size_t bytes, bool large) {
+    irqflags_t flags;
+    struct kmalloc_stats *st = kmalloc_stats_begin(&flags);
+
+    st->total_allocs++;
+    st->active_allocs++;
+    st->total_bytes += bytes;
+    st->active_bytes += bytes;
+    if (large) {
+        st->large_allocs++;
+        st->large_bytes += bytes;
+    }
+    kmalloc_stats_end(flags);
+}
+
+static void kmalloc_stats_free(size_t bytes, bool large) {
+    irqflags_t flags;
+    struct kmalloc_stats *st = kmalloc_stats_begin(&flags);
+
+    st->total_frees++;
+    st->active_allocs--;
+    st->active_bytes -= bytes;
+    if (large) {
+        st->large_bytes -= bytes;
+    }
+    kmalloc_stats_end(flags);
+}
+
+static void kmalloc_stats_failed(void) {
+    irqflags_t flags;
+
+    kmalloc_stats_begin(&flags)->failed_allocs++;
+    kmalloc_stats_end(flags);
+}
 
 // Initialize kmalloc subsystem
 void kmalloc_init(void) {
@@ -119,19 +181,24 @@ void *kmalloc(size_t size, int flags) {
         }
         
         uint64_t phys_addr;
+        size_t pages_zero = 0;
         
         // Check if we should use page allocator or direct PMM
         if (pages_needed <= (1UL << PAGE_ALLOC_MAX_ORDER)) {
             // Use page allocator for allocations up to 16MB (order 12 = 4096 pages)
             uint32_t order = page_get_order_for_size(total_size);
             phys_addr = page_alloc(order);
+            // Freed blocks are reused as they are; only PMM pages come zeroed
+            if (flags & KM_ZERO) {
+                pages_zero = pages_needed;
+            }
         } else {
             // For allocations >16MB, go directly to PMM
             phys_addr = pmm_alloc_pages(pages_needed);
         }
         
         if (!phys_addr) {
-            global_stats.failed_allocs++;
+            kmalloc_stats_failed();
             return NULL;
         }
         
@@ -139,10 +206,14 @@ void *kmalloc(size_t size, int flags) {
         void *virt_addr = (void *)PHYS_TO_DMAP(phys_addr);
         if (!virt_addr) {
             pmm_free_pages(phys_addr, pages_needed);
-            global_stats.failed_allocs++;
+            kmalloc_stats_failed();
             return NULL;
         }
         
+        if (pages_zero) {
+            clear_pages(virt_addr, pages_zero);
+        }
+        
         // Set up header
         struct kmalloc_large_header *header = (struct kmalloc_large_header *)virt_addr;
         header->size = size;
@@ -150,12 +221,7 @@ void *kmalloc(size_t size, int flags) {
         header->flags = flags;
         
         // Update statistics
-        global_stats.total_allocs++;
-        global_stats.active_allocs++;
-        global_stats.total_bytes += size;
-        global_stats.active_bytes += size;
-        global_stats.large_allocs++;
-        global_stats.large_bytes += size;
+        kmalloc_stats_alloc(size, true);
         
         // Return pointer after header
         return (char *)virt_addr + KMALLOC_LARGE_HEADER_SIZE;
@@ -168,11 +234,11 @@ void *kmalloc(size_t size, int flags) {
         uart_puts("[KMALLOC] ERROR: size ");
         uart_putdec(size);
         uart_puts(" not handled by is_large check but has no size class\n");
-        global_stats.failed_allocs++;
+        kmalloc_stats_failed();
         return NULL;
     }
     if (!size_caches[class]) {
-        global_stats.failed_allocs++;
+        kmalloc_stats_failed();
         return NULL;
     }
     
@@ -182,7 +248,7 @@ void *kmalloc(size_t size, int flags) {
     // Allocate from slab cache - NO HEADER!
     void *obj = kmem_cache_alloc(size_caches[class], flags);
     if (!obj) {
-        global_stats.failed_allocs++;
+        kmalloc_stats_failed();
         return NULL;
     }
     
@@ -202,10 +268,7 @@ void *kmalloc(size_t size, int flags) {
     }
     
     // Update statistics with actual allocated size
-    global_stats.total_allocs++;
-    global_stats.active_allocs++;
-    global_stats.total_bytes += actual_size;
-    global_stats.active_bytes += actual_size;
+    kmalloc_stats_alloc(actual_size, false);
     
     // Return pointer directly - no header!
     return obj;
@@ -235,9 +298,7 @@ void kfree(void *ptr) {
         size_t obj_size = cache->hot.object_size - (2 * KMALLOC_REDZONE_SIZE);
         
         // Update statistics
-        global_stats.total_frees++;
-        global_stats.active_allocs--;
-        global_stats.active_bytes -= obj_size;
+        kmalloc_stats_free(obj_size, false);
         
         // Free to cache
         kmem_cache_free(cache, obj_to_free);
@@ -259,10 +320,7 @@ void kfree(void *ptr) {
         header->magic = KMALLOC_LARGE_FREE;
         
         // Update statistics
-        global_stats.total_frees++;
-        global_stats.active_allocs--;
-        global_stats.active_bytes -= size;
-        global_stats.large_bytes -= size;
+        kmalloc_stats_free(size, true);
         
         // Free pages
         size_t total_size = size + KMALLOC_LARGE_HEADER_SIZE;
@@ -395,9 +453,7 @@ void *kmalloc_type(size_t size, struct malloc_type *type, int flags) {
         malloc_type_update_alloc(type, actual_size);
     } else {
         // Update failed allocation count
-        if (type) {
-            type->stats.failed_allocs++;
-        }
+        malloc_type_update_failed(type);
     }
     
     return ptr;
@@ -427,32 +483,59 @@ void kfree_type(void *ptr, struct malloc_type *type) {
     }
 }
 
-// Get statistics
+// Get statistics (sum of all per-CPU counters, each CPU's read consistently)
 void kmalloc_get_stats(struct kmalloc_stats *stats) {
-    if (stats) {
-        *stats = global_stats;
+    if (!stats) {
+        return;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    
+    unsigned int cpu;
+    for_each_possible_cpu(cpu) {
+        struct kmalloc_cpu_stats *pcs = per_cpu_ptr(kmalloc_cpu_stats, cpu);
+        struct kmalloc_stats snap;
+        struct kmalloc_stats *s = &snap;
+        unsigned int seq;
+        
+        do {
+            seq = read_seqcount_begin(&pcs->seq);
+            snap = pcs->stats;
+        } while (read_seqcount_retry(&pcs->seq, seq));
+        
+        stats->total_allocs += s->total_allocs;
+        stats->total_frees += s->total_frees;
+        stats->active_allocs += s->active_allocs;
+        stats->total_bytes += s->total_bytes;
+        stats->active_bytes += s->active_bytes;
+        stats->large_allocs += s->large_allocs;
+        stats->large_bytes += s->large_bytes;
+        stats->failed_allocs += s->failed_allocs;
     }
 }
 
 // Dump statistics
 void kmalloc_dump_stats(void) {
+    struct kmalloc_stats stats;
+    kmalloc_get_stats(&stats);
+    
     uart_puts("\n=== Kmalloc Statistics ===\n");
     uart_puts("Total allocations: ");
-    uart_putdec(global_stats.total_allocs);
+    uart_putdec(stats.total_allocs);
     uart_puts("\nTotal frees: ");
-    uart_putdec(global_stats.total_frees);
+    uart_putdec(stats.total_frees);
     uart_puts("\nActive allocations: ");
-    uart_putdec(global_stats.active_allocs);
+    uart_putdec(stats.active_allocs);
     uart_puts("\nTotal bytes allocated: ");
-    uart_putdec(global_stats.total_bytes);
+    uart_putdec(stats.total_bytes);
     uart_puts("\nActive bytes: ");
-    uart_putdec(global_stats.active_bytes);
+    uart_putdec(stats.active_bytes);
     uart_puts("\nLarge allocations: ");
-    uart_putdec(global_stats.large_allocs);
+    uart_putdec(stats.large_allocs);
     uart_puts("\nLarge bytes: ");
-    uart_putdec(global_stats.large_bytes);
+    uart_putdec(stats.large_bytes);
     uart_puts("\nFailed allocations: ");
-    uart_putdec(global_stats.failed_allocs);
+    uart_putdec(stats.failed_allocs);
     uart_puts("\n\n");
     
     // Dump per-cache statistics
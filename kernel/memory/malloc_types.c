@@ -102,6 +102,7 @@ void malloc_type_register(struct malloc_type *type) {
     // Initialize statistics if not already done
     if (type->stats.allocs == 0 && type->stats.frees == 0) {
         memset(&type->stats, 0, sizeof(type->stats));
+        seqlock_init(&type->stats_lock);
     }
     
     spin_unlock(&type_list_lock);
@@ -154,7 +155,9 @@ void malloc_type_update_alloc(struct malloc_type *type, size_t size) {
         return;
     }
     
-    // Update statistics atomically (in real kernel, use atomic ops)
+    unsigned long flags;
+    write_seqlock_irqsave(&type->stats_lock, flags);
+    
     type->stats.allocs++;
     type->stats.bytes_allocated += size;
     type->stats.current_allocs++;
@@ -167,6 +170,8 @@ void malloc_type_update_alloc(struct malloc_type *type, size_t size) {
     if (type->stats.current_bytes > type->stats.peak_bytes) {
         type->stats.peak_bytes = type->stats.current_bytes;
     }
+    
+    write_sequnlock_irqrestore(&type->stats_lock, flags);
 }
 
 // Update free statistics
@@ -175,7 +180,11 @@ void malloc_type_update_free(struct malloc_type *type, size_t size) {
         return;
     }
     
-    // Update statistics atomically
+    unsigned long flags;
+    bool no_alloc = false, size_mismatch = false;
+    
+    write_seqlock_irqsave(&type->stats_lock, flags);
+    
     type->stats.frees++;
     type->stats.bytes_freed += size;
     
@@ -183,21 +192,43 @@ void malloc_type_update_free(struct malloc_type *type, size_t size) {
     if (type->stats.current_allocs > 0) {
         type->stats.current_allocs--;
     } else {
-        uart_puts("[MALLOC_TYPE] WARNING: Free without alloc for type ");
-        uart_puts(type->name);
-        uart_puts("\n");
+        no_alloc = true;
     }
     
     if (type->stats.current_bytes >= size) {
         type->stats.current_bytes -= size;
     } else {
+        size_mismatch = true;
+        type->stats.current_bytes = 0;
+    }
+    
+    write_sequnlock_irqrestore(&type->stats_lock, flags);
+    
+    // Report outside the lock
+    if (no_alloc) {
+        uart_puts("[MALLOC_TYPE] WARNING: Free without alloc for type ");
+        uart_puts(type->name);
+        uart_puts("\n");
+    }
+    if (size_mismatch) {
         uart_puts("[MALLOC_TYPE] WARNING: Free size mismatch for type ");
         uart_puts(type->name);
         uart_puts("\n");
-        type->stats.current_bytes = 0;
     }
 }
 
+// Count a failed allocation
+void malloc_type_update_failed(struct malloc_type *type) {
+    if (!type) {
+        return;
+    }
+    
+    unsigned long flags;
+    write_seqlock_irqsave(&type->stats_lock, flags);
+    type->stats.failed_allocs++;
+    write_sequnlock_irqrestore(&type->stats_lock, flags);
+}
+
 // Find type by name
 struct malloc_type *malloc_type_find(const char *name) {
     if (!name) {
@@ -242,8 +273,12 @@ void malloc_type_get_stats(struct malloc_type *type, struct malloc_type_stats *s
         return;
     }
     
-    // Copy statistics atomically
-    *stats = type->stats;
+    // Lockless; retried if an update ran while copying
+    unsigned int seq;
+    do {
+        seq = read_seqbegin(&type->stats_lock);
+        *stats = type->stats;
+    } while (read_seqretry(&type->stats_lock, seq));
 }
 
 // Helper function for formatted decimal output (if not available in uart)
@@ -281,6 +316,9 @@ void malloc_type_dump_stats(void) {
     
     struct malloc_type *type = NULL;
     while ((type = malloc_type_iterate(type)) != NULL) {
+        struct malloc_type_stats st;
+        malloc_type_get_stats(type, &st);
+        
         // Print type name (left-aligned, max 13 chars)
         uart_puts(type->name);
         int name_len = strlen(type->name);
@@ -289,34 +327,37 @@ void malloc_type_dump_stats(void) {
         }
         
         // Print active allocations
-        uart_putdec_width(type->stats.current_allocs, 7);
+        uart_putdec_width(st.current_allocs, 7);
         uart_putc(' ');
         
         // Print current bytes
-        uart_putdec_width(type->stats.current_bytes, 8);
+        uart_putdec_width(st.current_bytes, 8);
         uart_putc(' ');
         
         // Print total allocations
-        uart_putdec_width(type->stats.allocs, 7);
+        uart_putdec_width(st.allocs, 7);
         uart_putc(' ');
         
         // Print peak allocations
-        uart_putdec_width(type->stats.peak_allocs, 7);
+        uart_putdec_width(st.peak_allocs, 7);
         uart_putc(' ');
         
         // Print total frees
-        uart_putdec_width(type->stats.frees, 7);
+        uart_putdec_width(st.frees, 7);
         uart_putc(' ');
         
         // Print failed allocations
-        uart_putdec_width(type->stats.failed_allocs, 7);
+        uart_putdec_width(st.failed_allocs, 7);
         uart_puts("\n");
     }
     
     uart_puts("\nType Details:\n");
     type = NULL;
     while ((type = malloc_type_iterate(type)) != NULL) {
-        if (type->stats.current_allocs > 0 || type->stats.allocs > 0) {
+        struct malloc_type_stats st;
+        malloc_type_get_stats(type, &st);
+        
+        if (st.current_allocs > 0 || st.allocs > 0) {
             uart_puts("  ");
             uart_puts(type->name);
             uart_puts(": ");
@@ -324,27 +365,27 @@ void malloc_type_dump_stats(void) {
             uart_puts("\n");
             
             uart_puts("    Current: ");
-            uart_putdec(type->stats.current_allocs);
+            uart_putdec(st.current_allocs);
             uart_puts(" allocations, ");
-            uart_putdec(type->stats.current_bytes);
+            uart_putdec(st.current_bytes);
             uart_puts(" bytes\n");
             
             uart_puts("    Peak:    ");
-            uart_putdec(type->stats.peak_allocs);
+            uart_putdec(st.peak_allocs);
             uart_puts(" allocations, ");
-            uart_putdec(type->stats.peak_bytes);
+            uart_putdec(st.peak_bytes);
             uart_puts(" bytes\n");
             
             uart_puts("    Total:   ");
-            uart_putdec(type->stats.bytes_allocated);
+            uart_putdec(st.bytes_allocated);
             uart_puts(" bytes allocated, ");
-            uart_putdec(type->stats.bytes_freed);
+            uart_putdec(st.bytes_freed);
             uart_puts(" bytes freed\n");
             
             // Check for leaks
-            if (type->stats.current_allocs > 0) {
+            if (st.current_allocs > 0) {
                 uart_puts("    WARNING: Possible memory leak - ");
-                uart_putdec(type->stats.current_allocs);
+                uart_putdec(st.current_allocs);
                 uart_puts(" active allocations\n");
             }
             
@@ -8,12 +8,67 @@
 #include <memory/page_alloc.h>
 #include <memory/pmm.h>
 #include <memory/vmparam.h>
+#include <percpu.h>
+#include <spinlock.h>
+#include <seqlock.h>
 #include <uart.h>
 #include <string.h>
 #include <stdbool.h>
 
 static struct page_allocator g_page_alloc = {0};
-static struct page_alloc_stats g_stats = {0};
+
+// Protects the chunk list, free lists and block tables. PMM frees made
+// with it held take pmm_lock inside it, never the other way round. PMM
+// allocations clear their pages, so they are made without it.
+static spinlock_t page_alloc_lock = SPINLOCK_INITIALIZER;
+
+// Per-CPU statistics, summed by page_alloc_get_stats(). A CPU changes its
+// own block inside seq with interrupts masked, so a reader never sees an
+// allocation counted without its current_allocated.
+struct page_alloc_cpu_stats {
+    seqcount_t seq;
+    struct page_alloc_stats stats;
+};
+
+static DEFINE_PER_CPU_ALIGNED(struct page_alloc_cpu_stats, page_alloc_cpu_stats);
+
+static inline struct page_alloc_stats *page_stats_begin(irqflags_t *flags) {
+    struct page_alloc_cpu_stats *pcs;
+
+    *flags = arch_local_irq_save();
+    pcs = this_cpu_ptr(page_alloc_cpu_stats);
+    write_seqcount_begin(&pcs->seq);
+    return &pcs->stats;
+}
+
+static inline void page_stats_end(irqflags_t flags) {
+    write_seqcount_end(&this_cpu_ptr(page_alloc_cpu_stats)->seq);
+    arch_local_irq_restore(flags);
+}
+
+#define page_stat_inc(field) do { \
+    irqflags_t __stat_flags; \
+    page_stats_begin(&__stat_flags)->field++; \
+    page_stats_end(__stat_flags); \
+} while (0)
+
+static void page_stats_alloc(uint32_t order) {
+    irqflags_t flags;
+    struct page_alloc_stats *st = page_stats_begin(&flags);
+
+    st->allocations[order]++;
+    st->current_allocated[order]++;
+    page_stats_end(flags);
+}
+
+static void page_stats_free(uint32_t order) {
+    irqflags_t flags;
+    struct page_alloc_stats *st = page_stats_begin(&flags);
+
+    st->frees[order]++;
+    st->current_allocated[order]--;
+    page_stats_end(flags);
+}
 
 #define PAGE_ALLOC_DEBUG 0
 
@@ -277,7 +332,7 @@ void page_alloc_split_block(struct page_block *block, uint32_t target_order) {
         
         if (buddy) {
             page_alloc_add_to_free_list(buddy, buddy->order);
-            g_stats.splits[current_order]++;
+            page_stat_inc(splits[current_order]);
         }
     }
 }
@@ -305,25 +360,23 @@ struct page_block *page_alloc_coalesce_blocks(struct page_block *block1, struct
     right->order = 0;
     right->flags = 0;
     
-    g_stats.coalesces[left->order - 1]++;
+    page_stat_inc(coalesces[left->order - 1]);
     
     return left;
 }
 
-uint64_t page_alloc_chunk_from_pmm(size_t size) {
+// Take size bytes (page aligned) for a new chunk from the PMM
+static uint64_t page_alloc_take_from_pmm(size_t size) {
     if (!pmm_is_initialized()) {
         uart_puts("page_alloc: PMM not initialized\n");
         return 0;
     }
     
-    size = align_up(size, PAGE_SIZE);
-    size_t pages = size / PAGE_SIZE;
-    
-    uint64_t phys_addr = pmm_alloc_pages(pages);
-    if (phys_addr == 0) {
-        return 0;  // Don't print error - caller will handle it
-    }
-    
+    return pmm_alloc_pages(size / PAGE_SIZE);  // Caller reports failure
+}
+
+// Carve memory fresh from the PMM into blocks and link it in as a chunk
+static void page_alloc_add_chunk(uint64_t phys_addr, size_t size) {
     void *chunk_mem = (void *)PHYS_TO_DMAP(phys_addr);
     struct page_chunk *chunk = (struct page_chunk *)chunk_mem;
     
@@ -405,30 +458,49 @@ uint64_t page_alloc_chunk_from_pmm(size_t size) {
     
     g_page_alloc.chunks = chunk;
     g_page_alloc.total_chunks++;
-    g_stats.pmm_chunks_allocated++;
+    page_stat_inc(pmm_chunks_allocated);
     
     page_debug_hex("Allocated chunk from PMM", phys_addr);
+}
+
+uint64_t page_alloc_chunk_from_pmm(size_t size) {
+    size = align_up(size, PAGE_SIZE);
+    
+    uint64_t phys_addr = page_alloc_take_from_pmm(size);
+    if (phys_addr != 0) {
+        page_alloc_add_chunk(phys_addr, size);
+    }
     
     return phys_addr;
 }
 
-uint64_t page_alloc(uint32_t order) {
-    if (!g_page_alloc.initialized) {
-        uart_puts("page_alloc: not initialized\n");
-        return 0;
+// Size of the chunk to take from the PMM when no block of order is free
+static size_t page_alloc_chunk_size(uint32_t order) {
+    // Use smarter sizing strategy based on allocation pattern
+    size_t needed_size = 1UL << (order + PAGE_SHIFT);
+    size_t chunk_size;
+    
+    if (order >= PAGE_ALLOC_LARGE_ORDER_THRESHOLD) {
+        // For very large allocations, allocate exactly what's needed plus overhead
+        chunk_size = align_up(needed_size + PAGE_SIZE, PAGE_SIZE);
+    } else if (order >= PAGE_ALLOC_MEDIUM_ORDER_THRESHOLD) {
+        // For medium allocations, use medium-sized chunks
+        chunk_size = PAGE_ALLOC_MEDIUM_CHUNK_SIZE;
+    } else {
+        // For small allocations, use minimum chunk size
+        chunk_size = PAGE_ALLOC_MIN_CHUNK_SIZE;
     }
     
-    // For order-12 and above, go directly to PMM to avoid alignment issues
-    if (order >= PAGE_ALLOC_MAX_ORDER) {
-        size_t pages = 1UL << order;
-        uint64_t phys_addr = pmm_alloc_pages(pages);
-        if (phys_addr) {
-            g_stats.allocations[PAGE_ALLOC_MAX_ORDER]++;  // Track as max order
-            g_stats.current_allocated[PAGE_ALLOC_MAX_ORDER]++;
-        }
-        return phys_addr;
+    // Ensure chunk is large enough for the requested allocation
+    if (chunk_size < needed_size + PAGE_SIZE) {
+        chunk_size = align_up(needed_size + PAGE_SIZE, PAGE_SIZE);
     }
     
+    return chunk_size;
+}
+
+// Take a free block of order, or return 0 if none is free
+static uint64_t __page_alloc(uint32_t order) {
     // Try to find a free block of the requested order or larger
     // We only create blocks up to order 11 in chunks
     uint32_t max_chunk_order = (PAGE_ALLOC_MAX_ORDER > 0) ? PAGE_ALLOC_MAX_ORDER - 1 : 0;
@@ -457,54 +529,71 @@ uint64_t page_alloc(uint32_t order) {
             
             size_t pages = 1UL << order;
             g_page_alloc.free_pages -= pages;
-            g_stats.allocations[order]++;
-            g_stats.current_allocated[order]++;
+            page_stats_alloc(order);
             
             page_debug_hex("Allocated block", block->phys_addr);
             return block->phys_addr;
         }
     }
     
-    // No free blocks available, need to allocate a new chunk from PMM
-    // Use smarter sizing strategy based on allocation pattern
-    size_t needed_size = 1UL << (order + PAGE_SHIFT);
-    size_t chunk_size;
-    
-    if (order >= PAGE_ALLOC_LARGE_ORDER_THRESHOLD) {
-        // For very large allocations, allocate exactly what's needed plus overhead
-        chunk_size = align_up(needed_size + PAGE_SIZE, PAGE_SIZE);
-    } else if (order >= PAGE_ALLOC_MEDIUM_ORDER_THRESHOLD) {
-        // For medium allocations, use medium-sized chunks
-        chunk_size = PAGE_ALLOC_MEDIUM_CHUNK_SIZE;
-    } else {
-        // For small allocations, use minimum chunk size
-        chunk_size = PAGE_ALLOC_MIN_CHUNK_SIZE;
-    }
+    return 0;
+}
+
+uint64_t page_alloc(uint32_t order) {
+    unsigned long flags;
+    uint64_t phys_addr;
     
-    // Ensure chunk is large enough for the requested allocation
-    if (chunk_size < needed_size + PAGE_SIZE) {
-        chunk_size = align_up(needed_size + PAGE_SIZE, PAGE_SIZE);
+    if (!g_page_alloc.initialized) {
+        uart_puts("page_alloc: not initialized\n");
+        return 0;
     }
     
-    // Try to allocate the chunk
-    uint64_t chunk_addr = page_alloc_chunk_from_pmm(chunk_size);
-    if (chunk_addr == 0 && chunk_size > PAGE_ALLOC_MIN_CHUNK_SIZE) {
-        // If allocation failed, try minimum size
-        chunk_size = PAGE_ALLOC_MIN_CHUNK_SIZE;
-        if (chunk_size >= needed_size + PAGE_SIZE) {
-            chunk_addr = page_alloc_chunk_from_pmm(chunk_size);
+    // For order-12 and above, go directly to PMM to avoid alignment issues
+    if (order >= PAGE_ALLOC_MAX_ORDER) {
+        size_t pages = 1UL << order;
+        phys_addr = pmm_alloc_pages(pages);
+        if (phys_addr) {
+            page_stats_alloc(PAGE_ALLOC_MAX_ORDER);  // Track as max order
         }
+        return phys_addr;
     }
     
-    if (chunk_addr == 0) {
-        return 0;
+    for (;;) {
+        spin_lock_irqsave(&page_alloc_lock, flags);
+        phys_addr = __page_alloc(order);
+        spin_unlock_irqrestore(&page_alloc_lock, flags);
+        
+        if (phys_addr != 0) {
+            return phys_addr;
+        }
+        
+        // No free blocks available, need a new chunk from the PMM. It
+        // clears the pages, which takes a while for a large chunk, so
+        // this is done without the lock.
+        size_t needed_size = 1UL << (order + PAGE_SHIFT);
+        size_t chunk_size = page_alloc_chunk_size(order);
+        uint64_t chunk_addr = page_alloc_take_from_pmm(chunk_size);
+        if (chunk_addr == 0 && chunk_size > PAGE_ALLOC_MIN_CHUNK_SIZE) {
+            // If allocation failed, try minimum size
+            chunk_size = PAGE_ALLOC_MIN_CHUNK_SIZE;
+            if (chunk_size >= needed_size + PAGE_SIZE) {
+                chunk_addr = page_alloc_take_from_pmm(chunk_size);
+            }
+        }
+        
+        if (chunk_addr == 0) {
+            return 0;
+        }
+        
+        spin_lock_irqsave(&page_alloc_lock, flags);
+        page_alloc_add_chunk(chunk_addr, chunk_size);
+        spin_unlock_irqrestore(&page_alloc_lock, flags);
+        
+        // Go round again: another CPU may take the new blocks first
     }
-    
-    // Recursively try allocation now that we have a new chunk
-    return page_alloc(order);
 }
 
-void page_free(uint64_t phys_addr, uint32_t order) {
+static void __page_free(uint64_t phys_addr, uint32_t order) {
     if (!g_page_alloc.initialized) {
         uart_puts("page_free: not initialized\n");
         return;
@@ -525,8 +614,7 @@ void page_free(uint64_t phys_addr, uint32_t order) {
     if (order >= PAGE_ALLOC_MAX_ORDER) {
         size_t pages = 1UL << order;
         pmm_free_pages(phys_addr, pages);
-        g_stats.frees[PAGE_ALLOC_MAX_ORDER]++;  // Track as max order
-        g_stats.current_allocated[PAGE_ALLOC_MAX_ORDER]--;
+        page_stats_free(PAGE_ALLOC_MAX_ORDER);  // Track as max order
         return;
     }
     
@@ -585,8 +673,7 @@ void page_free(uint64_t phys_addr, uint32_t order) {
     
     size_t pages = 1UL << order;
     g_page_alloc.free_pages += pages;
-    g_stats.frees[order]++;
-    g_stats.current_allocated[order]--;
+    page_stats_free(order);
     
     // Try to coalesce with buddies
     while (order < PAGE_ALLOC_MAX_ORDER) {
@@ -631,6 +718,14 @@ void page_free(uint64_t phys_addr, uint32_t order) {
     }
 }
 
+void page_free(uint64_t phys_addr, uint32_t order) {
+    unsigned long flags;
+    
+    spin_lock_irqsave(&page_alloc_lock, flags);
+    __page_free(phys_addr, order);
+    spin_unlock_irqrestore(&page_alloc_lock, flags);
+}
+
 void page_alloc_return_chunk_to_pmm(struct page_chunk *chunk) {
     if (!chunk) return;
     
@@ -653,7 +748,7 @@ void page_alloc_return_chunk_to_pmm(struct page_chunk *chunk) {
     
     // Update statistics
     g_page_alloc.total_chunks--;
-    g_stats.pmm_chunks_freed++;
+    page_stat_inc(pmm_chunks_freed);
     
     // Return pages to PMM
     pmm_free_pages(phys_addr, pages);
@@ -695,7 +790,7 @@ void page_alloc_check_empty_chunks(void) {
             
             // Update statistics
             g_page_alloc.total_chunks--;
-            g_stats.pmm_chunks_freed++;
+            page_stat_inc(pmm_chunks_freed);
             
             // Calculate size and return to PMM
             size_t total_size = chunk->size + PAGE_SIZE;
@@ -783,13 +878,41 @@ void page_free_multiple(uint64_t phys_addr, size_t num_pages) {
     page_free(phys_addr, order);
 }
 
+// Sum the per-CPU counters, taking a consistent copy of each CPU's block.
+// The struct is all uint64_t, so add it word by word; current_allocated
+// may wrap on a CPU that freed more than it allocated, which cancels out
+// in the total.
 void page_alloc_get_stats(struct page_alloc_stats *stats) {
-    if (stats) {
-        memcpy(stats, &g_stats, sizeof(struct page_alloc_stats));
+    if (!stats) {
+        return;
+    }
+    
+    uint64_t *dst = (uint64_t *)stats;
+    size_t words = sizeof(struct page_alloc_stats) / sizeof(uint64_t);
+    unsigned int cpu;
+    
+    memset(stats, 0, sizeof(struct page_alloc_stats));
+    for_each_possible_cpu(cpu) {
+        struct page_alloc_cpu_stats *pcs = per_cpu_ptr(page_alloc_cpu_stats, cpu);
+        struct page_alloc_stats snap;
+        unsigned int seq;
+        
+        do {
+            seq = read_seqcount_begin(&pcs->seq);
+            snap = pcs->stats;
+        } while (read_seqcount_retry(&pcs->seq, seq));
+        
+        const uint64_t *src = (const uint64_t *)&snap;
+        for (size_t i = 0; i < words; i++) {
+            dst[i] += src[i];
+        }
     }
 }
 
 void page_alloc_print_stats(void) {
+    struct page_alloc_stats stats;
+    page_alloc_get_stats(&stats);
+    
     uart_puts("\nPage Allocator Statistics:\n");
     uart_puts("========================\n");
     uart_puts("Total chunks: ");
@@ -810,20 +933,20 @@ void page_alloc_print_stats(void) {
         uart_puts("   | ");
         uart_putdec(1UL << i);
         uart_puts("     | ");
-        uart_putdec(g_stats.allocations[i]);
+        uart_putdec(stats.allocations[i]);
         uart_puts("      | ");
-        uart_putdec(g_stats.frees[i]);
+        uart_putdec(stats.frees[i]);
         uart_puts("     | ");
-        uart_putdec(g_stats.current_allocated[i]);
+        uart_putdec(stats.current_allocated[i]);
         uart_puts("       | ");
         uart_putdec(g_page_alloc.free_lists[i].count);
         uart_puts("\n");
     }
     
     uart_puts("\nPMM chunks allocated: ");
-    uart_putdec(g_stats.pmm_chunks_allocated);
+    uart_putdec(stats.pmm_chunks_allocated);
     uart_puts("\nPMM chunks freed: ");
-    uart_putdec(g_stats.pmm_chunks_freed);
+    uart_putdec(stats.pmm_chunks_freed);
     uart_puts("\n");
 }
 
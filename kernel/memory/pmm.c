@@ -8,11 +8,15 @@
 #include <memory/vmparam.h>
 #include <memory/vmm.h>
 #include <memory/pmm_bootstrap.h>
+#include <memory/clear_page.h>
+#include <lib/bitmap.h>
 #include <drivers/fdt.h>
 #include <uart.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <boot_config.h>
+#include <spinlock.h>
+#include <seqlock.h>
 
 // External symbols from linker script
 extern char _kernel_end;
@@ -21,8 +25,14 @@ extern char _kernel_end;
 static pmm_region_t pmm_regions[PMM_MAX_REGIONS];
 static int pmm_region_count = 0;
 
-// Memory statistics
-static pmm_stats_t pmm_stats = {0};
+// Protects the region bitmaps, per-region free counts and pmm_stats
+static spinlock_t pmm_lock = SPINLOCK_INITIALIZER;
+
+// Memory statistics. Changed inside pmm_stats_seq, under pmm_lock once
+// other CPUs are up, so pmm_get_stats() copies a consistent set without
+// taking the lock: free + allocated + reserved always adds up to total.
+static pmm_stats_t pmm_stats;
+static seqcount_t pmm_stats_seq = SEQCNT_ZERO;
 
 // Initialization flag
 static bool pmm_initialized = false;
@@ -161,8 +171,10 @@ void pmm_init(uint64_t kernel_end, struct memory_info *mem_info) {
         region->next = NULL;
         
         // Update global statistics
+        write_seqcount_begin(&pmm_stats_seq);
         pmm_stats.total_pages += region->total_pages;
         pmm_stats.free_pages += region->free_pages;
+        write_seqcount_end(&pmm_stats_seq);
         
         uart_puts("  Region ");
         uart_puthex(pmm_region_count);
@@ -211,37 +223,51 @@ void pmm_init(uint64_t kernel_end, struct memory_info *mem_info) {
     uart_puts(" MB)\n");
 }
 
-// Allocate a single page
-uint64_t pmm_alloc_page(void) {
+// Find and mark count contiguous free pages. Called with pmm_lock held.
+static uint64_t pmm_claim_pages(size_t count, bool page_table) {
     // Try each region in order
     for (int i = 0; i < pmm_region_count; i++) {
         pmm_region_t *region = &pmm_regions[i];
         
-        // Find first free page in this region
+        // Find contiguous free pages
+        uint64_t start = 0;
+        uint64_t found = 0;
+        
         for (uint64_t page = 0; page < region->total_pages; page++) {
-            if (!pmm_test_bit(region, page)) {
-                pmm_set_bit(region, page);
-                region->free_pages--;
-                pmm_stats.free_pages--;
-                pmm_stats.allocated_pages++;
-                
-                uint64_t pa = page_to_addr(region, page);
+            // Outside a free run, skip whole words with no free page
+            if (found == 0 && (page % 64) == 0) {
+                size_t word = page / 64;
+                size_t nwords = (region->total_pages + 63) / 64;
                 
-                // Clear the page - use DMAP if available, otherwise use identity mapping
-                uint64_t va;
-                if (vmm_is_dmap_ready()) {
-                    va = PHYS_TO_DMAP(pa);
-                } else {
-                    // Use identity mapping (physical address directly)
-                    va = pa;
+                page = (word + bitmap_find_zero_word(region->bitmap + word, nwords - word)) * 64;
+                if (page >= region->total_pages) {
+                    break;
                 }
-                
-                uint64_t* page_ptr = (uint64_t*)va;
-                for (size_t j = 0; j < PMM_PAGE_SIZE / sizeof(uint64_t); j++) {
-                    page_ptr[j] = 0;
+            }
+            
+            if (pmm_test_bit(region, page)) {
+                found = 0;
+                continue;
+            }
+            
+            if (found == 0) start = page;
+            found++;
+            
+            if (found == count) {
+                // Mark all pages as allocated
+                for (uint64_t j = start; j < start + count; j++) {
+                    pmm_set_bit(region, j);
+                }
+                region->free_pages -= count;
+                write_seqcount_begin(&pmm_stats_seq);
+                pmm_stats.free_pages -= count;
+                pmm_stats.allocated_pages += count;
+                if (page_table) {
+                    pmm_stats.page_table_pages += count;
                 }
+                write_seqcount_end(&pmm_stats_seq);
                 
-                return pa;
+                return page_to_addr(region, start);
             }
         }
     }
@@ -249,77 +275,53 @@ uint64_t pmm_alloc_page(void) {
     return 0;  // Out of memory
 }
 
-// Allocate a single page for page table use
-uint64_t pmm_alloc_page_table(void) {
-    uint64_t pa = pmm_alloc_page();
+// Clear freshly allocated pages. Done outside pmm_lock: the pages are
+// already ours and clearing is most of the cost of an allocation.
+static void pmm_clear_pages(uint64_t pa, size_t count) {
+    // Use DMAP if available, otherwise use identity mapping
+    uint64_t va;
+    if (vmm_is_dmap_ready()) {
+        va = PHYS_TO_DMAP(pa);
+    } else {
+        va = pa;
+    }
+    
+    clear_pages((void *)va, count);
+}
+
+// Allocate a single page
+uint64_t pmm_alloc_page(void) {
+    return pmm_alloc_pages(1);
+}
+
+static uint64_t __pmm_alloc_pages(size_t count, bool page_table) {
+    unsigned long flags;
+    uint64_t pa;
+    
+    if (count == 0) return 0;
+    
+    spin_lock_irqsave(&pmm_lock, flags);
+    pa = pmm_claim_pages(count, page_table);
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    
     if (pa) {
-        pmm_stats.page_table_pages++;
+        pmm_clear_pages(pa, count);
     }
     return pa;
 }
 
+// Allocate a single page for page table use
+uint64_t pmm_alloc_page_table(void) {
+    return __pmm_alloc_pages(1, true);
+}
+
 // Allocate multiple contiguous pages
 uint64_t pmm_alloc_pages(size_t count) {
-    if (count == 0) return 0;
-    if (count == 1) return pmm_alloc_page();
-    
-    // Try each region in order
-    for (int i = 0; i < pmm_region_count; i++) {
-        pmm_region_t *region = &pmm_regions[i];
-        
-        // Find contiguous free pages
-        uint64_t start = 0;
-        uint64_t found = 0;
-        
-        for (uint64_t page = 0; page < region->total_pages; page++) {
-            if (!pmm_test_bit(region, page)) {
-                if (found == 0) start = page;
-                found++;
-                
-                // Check if we have enough pages
-                if (found == count) {
-                    // Check if they don't exceed bounds
-                    if ((start + count) <= region->total_pages) {
-                        // Mark all pages as allocated
-                        for (uint64_t j = start; j < start + count; j++) {
-                            pmm_set_bit(region, j);
-                        }
-                        region->free_pages -= count;
-                        pmm_stats.free_pages -= count;
-                        pmm_stats.allocated_pages += count;
-                        
-                        uint64_t pa = page_to_addr(region, start);
-                        
-                        // Clear the pages
-                        uint64_t va;
-                        if (vmm_is_dmap_ready()) {
-                            va = PHYS_TO_DMAP(pa);
-                        } else {
-                            va = pa;
-                        }
-                        
-                        uint64_t* page_ptr = (uint64_t*)va;
-                        for (size_t j = 0; j < (PMM_PAGE_SIZE * count) / sizeof(uint64_t); j++) {
-                            page_ptr[j] = 0;
-                        }
-                        
-                        return pa;
-                    } else {
-                        // Boundary check failed, reset search
-                        found = 0;
-                    }
-                }
-            } else {
-                found = 0;
-            }
-        }
-    }
-    
-    return 0;  // Allocation failed
+    return __pmm_alloc_pages(count, false);
 }
 
-// Free a page
-void pmm_free_page(uint64_t pa) {
+// Free a page. Called with pmm_lock held.
+static void pmm_release_page(uint64_t pa) {
     pmm_region_t *region = pmm_find_region(pa);
     if (!region) {
         return;  // Invalid address
@@ -336,23 +338,37 @@ void pmm_free_page(uint64_t pa) {
     
     pmm_clear_bit(region, page);
     region->free_pages++;
+    write_seqcount_begin(&pmm_stats_seq);
     pmm_stats.free_pages++;
     pmm_stats.allocated_pages--;
+    write_seqcount_end(&pmm_stats_seq);
+}
+
+// Free a page
+void pmm_free_page(uint64_t pa) {
+    pmm_free_pages(pa, 1);
 }
 
 // Free multiple contiguous pages
 void pmm_free_pages(uint64_t pa, size_t count) {
+    unsigned long flags;
+    
+    spin_lock_irqsave(&pmm_lock, flags);
     for (size_t i = 0; i < count; i++) {
-        pmm_free_page(pa + i * PMM_PAGE_SIZE);
+        pmm_release_page(pa + i * PMM_PAGE_SIZE);
     }
+    spin_unlock_irqrestore(&pmm_lock, flags);
 }
 
 // Mark region as reserved
 void pmm_reserve_region(uint64_t base, uint64_t size, const char* name) {
     (void)name; // Name is now tracked by memmap module
     
+    unsigned long flags;
     uint64_t end = base + size;
     
+    spin_lock_irqsave(&pmm_lock, flags);
+    
     // Check each memory region for overlap
     for (int i = 0; i < pmm_region_count; i++) {
         pmm_region_t *region = &pmm_regions[i];
@@ -380,11 +396,14 @@ void pmm_reserve_region(uint64_t base, uint64_t size, const char* name) {
             if (!pmm_test_bit(region, page)) {
                 pmm_set_bit(region, page);
                 region->free_pages--;
+                write_seqcount_begin(&pmm_stats_seq);
                 pmm_stats.free_pages--;
                 pmm_stats.reserved_pages++;
+                write_seqcount_end(&pmm_stats_seq);
             }
         }
     }
+    spin_unlock_irqrestore(&pmm_lock, flags);
 }
 
 // Reserve a single page
@@ -397,20 +416,33 @@ void pmm_reserve_page(uint64_t pa) {
     // Align to page boundary
     pa = pa & ~(PMM_PAGE_SIZE - 1);
     
+    unsigned long flags;
     uint64_t page = addr_to_page(region, pa);
+    
+    spin_lock_irqsave(&pmm_lock, flags);
     if (page < region->total_pages && !pmm_test_bit(region, page)) {
         pmm_set_bit(region, page);
         region->free_pages--;
+        write_seqcount_begin(&pmm_stats_seq);
         pmm_stats.free_pages--;
         pmm_stats.reserved_pages++;
+        write_seqcount_end(&pmm_stats_seq);
     }
+    spin_unlock_irqrestore(&pmm_lock, flags);
 }
 
 // Get memory statistics
 void pmm_get_stats(pmm_stats_t* stats) {
-    if (stats) {
-        *stats = pmm_stats;
+    unsigned int seq;
+    
+    if (!stats) {
+        return;
     }
+    
+    do {
+        seq = read_seqcount_begin(&pmm_stats_seq);
+        *stats = pmm_stats;
+    } while (read_seqcount_retry(&pmm_stats_seq, seq));
 }
 
 // Check if address is available
@@ -482,23 +514,26 @@ void pmm_print_stats(void) {
         uart_puts(" MB)\n");
     }
     
+    pmm_stats_t stats;
+    pmm_get_stats(&stats);
+    
     uart_puts("\nTotal Statistics:\n");
     uart_puts("Total Pages: ");
-    uart_puthex(pmm_stats.total_pages);
+    uart_puthex(stats.total_pages);
     uart_puts(" (");
-    uart_puthex(pmm_stats.total_pages * PMM_PAGE_SIZE / 1024 / 1024);
+    uart_puthex(stats.total_pages * PMM_PAGE_SIZE / 1024 / 1024);
     uart_puts(" MB)\n");
     
     uart_puts("Free Pages:  ");
-    uart_puthex(pmm_stats.free_pages);
+    uart_puthex(stats.free_pages);
     uart_puts(" (");
-    uart_puthex(pmm_stats.free_pages * PMM_PAGE_SIZE / 1024 / 1024);
+    uart_puthex(stats.free_pages * PMM_PAGE_SIZE / 1024 / 1024);
     uart_puts(" MB)\n");
     
     uart_puts("Used Pages:  ");
-    uart_puthex(pmm_stats.allocated_pages + pmm_stats.reserved_pages);
+    uart_puthex(stats.allocated_pages + stats.reserved_pages);
     uart_puts(" (");
-    uart_puthex((pmm_stats.allocated_pages + pmm_stats.reserved_pages) * PMM_PAGE_SIZE / 1024 / 1024);
+    uart_puthex((stats.allocated_pages + stats.reserved_pages) * PMM_PAGE_SIZE / 1024 / 1024);
     uart_puts(" MB)\n");
     
     uart_puts("\nBitmap Usage:\n");
@@ -10,6 +10,8 @@
 #include <memory/vmparam.h>
 #include <memory/vmm.h>
 #include <memory/slab_lookup.h>
+#include <lib/bitmap.h>
+#include <percpu.h>
 #include <uart.h>
 #include <string.h>
 #include <stddef.h>
@@ -45,6 +47,27 @@ static void slab_print_hex(uint64_t num) {
 static struct slab_list_node cache_list;
 static int slab_initialized = 0;
 
+// Statistics slots, one per cache per CPU. Slots live in the per-CPU
+// areas so a cache descriptor stays a few lines whatever NR_CPUS is.
+static DEFINE_PER_CPU_ALIGNED(struct kmem_cpu_stats[SLAB_MAX_CACHES], slab_cpu_stats);
+static uint64_t slab_stats_slots[BITMAP_WORDS(SLAB_MAX_CACHES)];
+
+// Open this CPU's statistics slot for a cache. Changes made before
+// slab_stats_end() reach kmem_cache_stats() together.
+static inline struct kmem_stats *slab_stats_begin(struct kmem_cache *cache, irqflags_t *flags) {
+    struct kmem_cpu_stats *cs;
+
+    *flags = arch_local_irq_save();
+    cs = &__this_cpu_read(slab_cpu_stats)[cache->stats_slot];
+    write_seqcount_begin(&cs->seq);
+    return &cs->stats;
+}
+
+static inline void slab_stats_end(struct kmem_cache *cache, irqflags_t flags) {
+    write_seqcount_end(&__this_cpu_read(slab_cpu_stats)[cache->stats_slot].seq);
+    arch_local_irq_restore(flags);
+}
+
 // Helper function to align value up
 static inline size_t align_up(size_t value, size_t align) {
     return (value + align - 1) & ~(align - 1);
@@ -151,8 +174,11 @@ static struct kmem_slab *slab_create(struct kmem_cache *cache) {
     slab->freelist_head = 0;
     
     // Update cache statistics
-    cache->stats.total_slabs++;
-    cache->stats.total_objs += cache->hot.objects_per_slab;
+    irqflags_t flags;
+    struct kmem_stats *st = slab_stats_begin(cache, &flags);
+    st->total_slabs++;
+    st->total_objs += cache->hot.objects_per_slab;
+    slab_stats_end(cache, flags);
     
     // Add to hash table for fast lookup (unless NOTRACK flag is set)
     if (!(cache->hot.flags & KMEM_CACHE_NOTRACK)) {
@@ -174,8 +200,11 @@ static void slab_destroy(struct kmem_slab *slab) {
     }
     
     // Update statistics
-    cache->stats.total_slabs--;
-    cache->stats.total_objs -= slab->num_objects;
+    irqflags_t flags;
+    struct kmem_stats *st = slab_stats_begin(cache, &flags);
+    st->total_slabs--;
+    st->total_objs -= slab->num_objects;
+    slab_stats_end(cache, flags);
     
     // Convert back to physical address and free
     uint64_t phys_addr = DMAP_TO_PHYS((uint64_t)slab);
@@ -204,6 +233,12 @@ struct kmem_cache *kmem_cache_create(const char *name, size_t size,
     }
     size = align_up(size, align);
     
+    size_t slot = bitmap_find_next_zero_bit(slab_stats_slots, SLAB_MAX_CACHES, 0);
+    if (slot == SLAB_MAX_CACHES) {
+        slab_debug("No free statistics slot\n");
+        return NULL;
+    }
+    
     // Allocate cache structure (bootstrap: use PMM directly)
     uint64_t cache_phys = pmm_alloc_pages(1);
     if (cache_phys == 0) {
@@ -215,6 +250,14 @@ struct kmem_cache *kmem_cache_create(const char *name, size_t size,
     
     // Initialize cache
     memset(cache, 0, sizeof(*cache));
+    
+    // Claim a statistics slot; a destroyed cache may have left counts
+    bitmap_set_bit(slab_stats_slots, slot);
+    cache->stats_slot = slot;
+    unsigned int cpu;
+    for_each_possible_cpu(cpu) {
+        memset(&per_cpu(slab_cpu_stats, cpu)[slot], 0, sizeof(struct kmem_cpu_stats));
+    }
     strncpy(cache->warm.name, name, sizeof(cache->warm.name) - 1);
     cache->hot.object_size = size;
     cache->hot.align = align;
@@ -272,6 +315,8 @@ void kmem_cache_destroy(struct kmem_cache *cache) {
     // Remove from global cache list
     SLAB_LIST_REMOVE(&cache->warm.cache_link);
     
+    bitmap_clear_bit(slab_stats_slots, cache->stats_slot);
+    
     // Free cache structure
     uint64_t cache_phys = DMAP_TO_PHYS((uint64_t)cache);
     pmm_free_pages(cache_phys, 1);
@@ -282,6 +327,9 @@ void *kmem_cache_alloc(struct kmem_cache *cache, int flags) {
     if (!cache) return NULL;
     
     struct kmem_slab *slab = NULL;
+    bool slab_activated = false;
+    irqflags_t stat_flags;
+    struct kmem_stats *st;
     
     // Try partial slabs first
     if (!SLAB_LIST_EMPTY(&cache->hot.partial_slabs)) {
@@ -292,7 +340,7 @@ void *kmem_cache_alloc(struct kmem_cache *cache, int flags) {
         slab = (struct kmem_slab *)cache->warm.empty_slabs.next;
         SLAB_LIST_REMOVE(&slab->slab_link);
         SLAB_LIST_INSERT_HEAD(&cache->hot.partial_slabs, &slab->slab_link);
-        cache->stats.active_slabs++;
+        slab_activated = true;
     }
     // Need to allocate a new slab
     else {
@@ -304,7 +352,7 @@ void *kmem_cache_alloc(struct kmem_cache *cache, int flags) {
             return NULL;
         }
         SLAB_LIST_INSERT_HEAD(&cache->hot.partial_slabs, &slab->slab_link);
-        cache->stats.active_slabs++;
+        slab_activated = true;
     }
     
     // Allocate object from slab
@@ -331,8 +379,13 @@ void *kmem_cache_alloc(struct kmem_cache *cache, int flags) {
     }
     
     // Update statistics
-    cache->stats.allocs++;
-    cache->stats.active_objs++;
+    st = slab_stats_begin(cache, &stat_flags);
+    st->allocs++;
+    st->active_objs++;
+    if (slab_activated) {
+        st->active_slabs++;
+    }
+    slab_stats_end(cache, stat_flags);
     
     return obj;
 }
@@ -379,8 +432,11 @@ void kmem_cache_free(struct kmem_cache *cache, void *obj) {
     slab->num_free++;
     
     // Update statistics
-    cache->stats.frees++;
-    cache->stats.active_objs--;
+    irqflags_t stat_flags;
+    struct kmem_stats *st = slab_stats_begin(cache, &stat_flags);
+    st->frees++;
+    st->active_objs--;
+    slab_stats_end(cache, stat_flags);
     
     // Move slab between lists if needed
     if (slab->num_free == 1) {
@@ -398,7 +454,8 @@ void kmem_cache_free(struct kmem_cache *cache, void *obj) {
         // Now empty
         SLAB_LIST_REMOVE(&slab->slab_link);
         SLAB_LIST_INSERT_HEAD(&cache->warm.empty_slabs, &slab->slab_link);
-        cache->stats.active_slabs--;
+        slab_stats_begin(cache, &stat_flags)->active_slabs--;
+        slab_stats_end(cache, stat_flags);
         
         // Optionally destroy empty slabs if NOREAP not set
         if (!(cache->hot.flags & KMEM_CACHE_NOREAP)) {
@@ -417,13 +474,37 @@ void kmem_cache_free(struct kmem_cache *cache, void *obj) {
 // Get cache statistics
 void kmem_cache_stats(struct kmem_cache *cache, struct kmem_stats *stats) {
     if (!cache || !stats) return;
-    *stats = cache->stats;
+    
+    memset(stats, 0, sizeof(*stats));
+    
+    unsigned int cpu;
+    for_each_possible_cpu(cpu) {
+        struct kmem_cpu_stats *cs = &per_cpu(slab_cpu_stats, cpu)[cache->stats_slot];
+        struct kmem_stats snap;
+        struct kmem_stats *s = &snap;
+        unsigned int seq;
+        
+        do {
+            seq = read_seqcount_begin(&cs->seq);
+            snap = cs->stats;
+        } while (read_seqcount_retry(&cs->seq, seq));
+        
+        stats->allocs += s->allocs;
+        stats->frees += s->frees;
+        stats->active_objs += s->active_objs;
+        stats->total_objs += s->total_objs;
+        stats->active_slabs += s->active_slabs;
+        stats->total_slabs += s->total_slabs;
+    }
 }
 
 // Debug: dump cache information
 void kmem_cache_dump(struct kmem_cache *cache) {
     if (!cache) return;
     
+    struct kmem_stats stats;
+    kmem_cache_stats(cache, &stats);
+    
     uart_puts("\nCache: ");
     uart_puts(cache->warm.name);
     uart_puts("\n  Object size: ");
@@ -434,17 +515,17 @@ void kmem_cache_dump(struct kmem_cache *cache) {
     uart_putdec(cache->hot.objects_per_slab);
     uart_puts("\n  Statistics:\n");
     uart_puts("    Allocations: ");
-    uart_putdec(cache->stats.allocs);
+    uart_putdec(stats.allocs);
     uart_puts("\n    Frees: ");
-    uart_putdec(cache->stats.frees);
+    uart_putdec(stats.frees);
     uart_puts("\n    Active objects: ");
-    uart_putdec(cache->stats.active_objs);
+    uart_putdec(stats.active_objs);
     uart_puts("\n    Total objects: ");
-    uart_putdec(cache->stats.total_objs);
+    uart_putdec(stats.total_objs);
     uart_puts("\n    Active slabs: ");
-    uart_putdec(cache->stats.active_slabs);
+    uart_putdec(stats.active_slabs);
     uart_puts("\n    Total slabs: ");
-    uart_putdec(cache->stats.total_slabs);
+    uart_putdec(stats.total_slabs);
     uart_puts("\n");
     
     // Count slabs in each list
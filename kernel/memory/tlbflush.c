@@ -0,0 +1,101 @@
+/*
+ * kernel/memory/tlbflush.c
+ *
+ * Kernel TLB shootdown across CPUs
+ */
+
+#include <memory/tlbflush.h>
+#include <memory/vmm.h>
+#include <smp.h>
+#include <preempt.h>
+#include <atomic.h>
+#include <arch_mmu.h>
+#include <arch_smp.h>
+
+static struct {
+    atomic64_t flushes;
+    atomic64_t pages;
+    atomic64_t full_flushes;
+    atomic64_t firmware_rounds;
+    atomic64_t ipi_rounds;
+} tlb_stats;
+
+// Flush [start, end) from this CPU's TLB, or all of it if end is 0
+static void tlb_flush_local(uintptr_t start, uintptr_t end) {
+    if (end == 0) {
+        arch_mmu_flush_all();
+    } else {
+        arch_mmu_invalidate_range(start, end);
+    }
+}
+
+#if !ARCH_HAS_BROADCAST_TLBI
+struct tlb_flush_range {
+    uintptr_t start;
+    uintptr_t end;
+};
+
+static void tlb_flush_ipi(void *arg) {
+    struct tlb_flush_range *range = arg;
+
+    tlb_flush_local(range->start, range->end);
+}
+#endif
+
+void flush_tlb_kernel_range(uintptr_t start, uintptr_t end) {
+    size_t nr_pages = (end - start) / PAGE_SIZE;
+    bool full = nr_pages > TLB_FLUSH_ALL_PAGES;
+
+    atomic64_inc(&tlb_stats.flushes);
+    atomic64_add(nr_pages, &tlb_stats.pages);
+    if (full) {
+        atomic64_inc(&tlb_stats.full_flushes);
+        start = 0;
+        end = 0;
+    }
+
+    // Page table writes before any walk the invalidation allows
+    arch_mmu_barrier();
+
+#if ARCH_HAS_BROADCAST_TLBI
+    tlb_flush_local(start, end);
+#else
+    cpumask_t others;
+
+    // Stay here so "others" stays true
+    preempt_disable();
+    others = cpu_online_mask() & ~cpumask_of(smp_processor_id());
+    tlb_flush_local(start, end);
+
+    if (others) {
+        if (arch_flush_tlb_remote(others, start, end ? end : UINTPTR_MAX) == 0) {
+            atomic64_inc(&tlb_stats.firmware_rounds);
+        } else {
+            struct tlb_flush_range range = { .start = start, .end = end };
+
+            smp_call_function_many(others, tlb_flush_ipi, &range, true);
+            atomic64_inc(&tlb_stats.ipi_rounds);
+        }
+    }
+    preempt_enable();
+#endif
+}
+
+void tlb_batch_flush(struct tlb_batch *batch) {
+    if (batch->nr_pages == 0) {
+        return;
+    }
+    flush_tlb_kernel_range(batch->start, batch->end);
+
+    batch->start = UINTPTR_MAX;
+    batch->end = 0;
+    batch->nr_pages = 0;
+}
+
+void tlb_flush_get_stats(struct tlb_flush_stats *stats) {
+    stats->flushes = atomic64_read(&tlb_stats.flushes);
+    stats->pages = atomic64_read(&tlb_stats.pages);
+    stats->full_flushes = atomic64_read(&tlb_stats.full_flushes);
+    stats->firmware_rounds = atomic64_read(&tlb_stats.firmware_rounds);
+    stats->ipi_rounds = atomic64_read(&tlb_stats.ipi_rounds);
+}
@@ -9,6 +9,7 @@
 #include <memory/vmm_arch.h>
 #include <memory/pmm.h>
 #include <memory/vmparam.h>
+#include <memory/tlbflush.h>
 #include <drivers/fdt.h>
 #include <uart.h>
 #include <string.h>
@@ -106,9 +107,8 @@ uint64_t* vmm_alloc_page_table(void) {
         return NULL;
     }
     
-    /* Convert to virtual address and clear */
+    /* pmm_alloc_page() has already zeroed it */
     uint64_t *table = (uint64_t*)vmm_pt_phys_to_virt(phys);
-    memset(table, 0, PAGE_SIZE);
     
     return table;
 }
@@ -254,32 +254,38 @@ bool vmm_map_range(vmm_context_t *ctx, uint64_t vaddr, uint64_t paddr,
     return true;
 }
 
-/* Unmap a single page */
-bool vmm_unmap_page(vmm_context_t *ctx, uint64_t vaddr) {
-    if (!ctx || (vaddr & (PAGE_SIZE - 1))) {
-        return false;
-    }
-    
+/* Clear the leaf PTE for a page; the caller flushes the TLB */
+static bool vmm_clear_page(vmm_context_t *ctx, uint64_t vaddr) {
     /* Walk page tables without creating */
     uint64_t *pte = vmm_arch_ops.walk_create((struct vmm_context *)ctx, vaddr, ARCH_PT_LEAF_LEVEL, false);
     if (!pte || !vmm_arch_ops.is_pte_valid(*pte)) {
         return false;
     }
     
-    /* Clear PTE */
     *pte = 0;
+    return true;
+}
+
+/* Unmap a single page */
+bool vmm_unmap_page(vmm_context_t *ctx, uint64_t vaddr) {
+    if (!ctx || (vaddr & (PAGE_SIZE - 1))) {
+        return false;
+    }
     
-    /* Ensure write is visible */
-    vmm_arch_ops.barrier();
+    if (!vmm_clear_page(ctx, vaddr)) {
+        return false;
+    }
     
-    /* Invalidate TLB */
-    vmm_flush_tlb_page(vaddr);
+    /* Publish the cleared PTE and invalidate it on every CPU */
+    flush_tlb_kernel_range(vaddr, vaddr + PAGE_SIZE);
     
     return true;
 }
 
-/* Unmap a range of pages */
+/* Unmap a range of pages, with one TLB shootdown for all of them */
 bool vmm_unmap_range(vmm_context_t *ctx, uint64_t vaddr, size_t size) {
+    struct tlb_batch batch = TLB_BATCH_INIT;
+    
     if (!ctx || (vaddr & (PAGE_SIZE - 1)) || (size & (PAGE_SIZE - 1))) {
         return false;
     }
@@ -287,10 +293,14 @@ bool vmm_unmap_range(vmm_context_t *ctx, uint64_t vaddr, size_t size) {
     uint64_t end_vaddr = vaddr + size;
     
     while (vaddr < end_vaddr) {
-        vmm_unmap_page(ctx, vaddr);
+        if (vmm_clear_page(ctx, vaddr)) {
+            tlb_batch_add(&batch, vaddr);
+        }
         vaddr += PAGE_SIZE;
     }
     
+    tlb_batch_flush(&batch);
+    
     return true;
 }
 
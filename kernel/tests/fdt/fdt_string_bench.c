@@ -0,0 +1,224 @@
+/*
+ * kernel/tests/fdt/fdt_string_bench.c
+ *
+ * Device tree enumeration with byte-at-a-time and word-at-a-time strings
+ *
+ * Walks the boot device tree the way enumeration does: the length of each
+ * node name and the '@' before its unit address, every property name
+ * looked up in a table of the ones drivers ask for, and every string of
+ * each compatible list matched against a table of driver compatibles,
+ * exactly and by vendor prefix. The walk runs once with plain byte loops,
+ * which is what fdt.c and driver_core.c did before, and once with the
+ * library strlen/strchr/strcmp/strncmp. Both must agree on every result.
+ */
+
+#include <tests/fdt_string_bench.h>
+#include <drivers/fdt.h>
+#include <drivers/fdt_mgr.h>
+#include <string.h>
+#include <time/timekeeping.h>
+#include <uart.h>
+#ifdef __riscv
+#include <cpufeature.h>
+#endif
+
+#define FDT_BENCH_PASSES    200
+
+struct fdt_string_ops {
+    size_t (*strlen)(const char *s);
+    char *(*strchr)(const char *s, int c);
+    int (*strcmp)(const char *s1, const char *s2);
+    int (*strncmp)(const char *s1, const char *s2, size_t n);
+};
+
+// Property names drivers and the FDT code look up
+static const char *const bench_props[] = {
+    "compatible", "reg", "interrupts", "interrupts-extended",
+    "interrupt-parent", "interrupt-controller", "#interrupt-cells",
+    "#address-cells", "#size-cells", "status", "clocks", "ranges",
+    "device_type", "phandle", "msi-parent", "riscv,isa",
+};
+
+// Compatibles the drivers match, in the order they are tried
+static const char *const bench_compatibles[] = {
+    "arm,gic-v3", "arm,gic-400", "arm,cortex-a15-gic", "arm,gic-v2m-frame",
+    "arm,armv8-timer", "arm,pl011", "arm,pl061", "arm,psci-1.0",
+    "riscv,plic0", "sifive,plic-1.0.0", "riscv,aplic", "riscv,imsics",
+    "riscv,cpu-intc", "riscv,clint0", "ns16550a", "virtio,mmio",
+    "syscon-poweroff", "google,goldfish-rtc", "pci-host-ecam-generic",
+};
+
+#define ARRAY_LEN(a)    (sizeof(a) / sizeof((a)[0]))
+
+static size_t byte_strlen(const char *s) {
+    size_t len = 0;
+
+    while (s[len]) {
+        len++;
+    }
+    return len;
+}
+
+static char *byte_strchr(const char *s, int c) {
+    for (; *s; s++) {
+        if (*s == (char)c) {
+            return (char *)s;
+        }
+    }
+    return c == 0 ? (char *)s : NULL;
+}
+
+static int byte_strcmp(const char *s1, const char *s2) {
+    while (*s1 && *s1 == *s2) {
+        s1++;
+        s2++;
+    }
+    return *(const unsigned char *)s1 - *(const unsigned char *)s2;
+}
+
+static int byte_strncmp(const char *s1, const char *s2, size_t n) {
+    while (n && *s1 && *s1 == *s2) {
+        s1++;
+        s2++;
+        n--;
+    }
+    return n ? *(const unsigned char *)s1 - *(const unsigned char *)s2 : 0;
+}
+
+static const struct fdt_string_ops byte_ops = {
+    byte_strlen, byte_strchr, byte_strcmp, byte_strncmp,
+};
+
+static const struct fdt_string_ops word_ops = {
+    strlen, strchr, strcmp, strncmp,
+};
+
+static uint32_t be32(const void *p) {
+    return fdt32_to_cpu(*(const uint32_t *)p);
+}
+
+// Match one compatible list; the result folds in which entries hit
+static uint64_t bench_compatible(const struct fdt_string_ops *ops,
+                                 const char *list, uint32_t len) {
+    uint64_t sum = 0;
+    uint32_t off = 0;
+
+    while (off < len) {
+        const char *compat = list + off;
+        size_t clen = ops->strlen(compat);
+        const char *comma = ops->strchr(compat, ',');
+
+        for (unsigned int i = 0; i < ARRAY_LEN(bench_compatibles); i++) {
+            if (ops->strcmp(compat, bench_compatibles[i]) == 0) {
+                sum += 1000 + i;
+                break;
+            }
+            // Same vendor, as driver_core.c falls back to
+            if (comma && ops->strncmp(compat, bench_compatibles[i],
+                                      comma - compat + 1) == 0) {
+                sum += i;
+            }
+        }
+        off += clen + 1;
+    }
+    return sum;
+}
+
+// One walk of the structure block; returns a value both walks must share
+static uint64_t bench_walk(const struct fdt_string_ops *ops, const void *fdt) {
+    const fdt_header_t *hdr = fdt;
+    const char *structs = (const char *)fdt + fdt32_to_cpu(hdr->off_dt_struct);
+    const char *strings = (const char *)fdt + fdt32_to_cpu(hdr->off_dt_strings);
+    uint32_t size = fdt32_to_cpu(hdr->size_dt_struct);
+    uint64_t sum = 0;
+    uint32_t off = 0;
+
+    while (off + 4 <= size) {
+        uint32_t token = be32(structs + off);
+
+        off += 4;
+        if (token == FDT_BEGIN_NODE) {
+            const char *name = structs + off;
+            size_t len = ops->strlen(name);
+            const char *at = ops->strchr(name, '@');
+
+            sum += len + (at ? (uint64_t)(at - name) << 16 : 0);
+            off += (len + 1 + 3) & ~3U;
+        } else if (token == FDT_PROP) {
+            uint32_t len = be32(structs + off);
+            const char *pname = strings + be32(structs + off + 4);
+            const char *data = structs + off + 8;
+
+            for (unsigned int i = 0; i < ARRAY_LEN(bench_props); i++) {
+                if (ops->strcmp(pname, bench_props[i]) == 0) {
+                    sum += (uint64_t)(i + 1) << 24;
+                    if (i == 0) {
+                        sum += bench_compatible(ops, data, len);
+                    }
+                    break;
+                }
+            }
+            off += 8 + ((len + 3) & ~3U);
+        } else if (token == FDT_END) {
+            break;
+        }
+    }
+    return sum;
+}
+
+static uint64_t bench_time(const struct fdt_string_ops *ops, const void *fdt,
+                           uint64_t *result) {
+    uint64_t start = ktime_get_ns();
+
+    for (int i = 0; i < FDT_BENCH_PASSES; i++) {
+        *result = bench_walk(ops, fdt);
+        __asm__ volatile("" ::: "memory");
+    }
+    return (ktime_get_ns() - start) / FDT_BENCH_PASSES;
+}
+
+void run_fdt_string_benchmarks(void) {
+    void *fdt = fdt_mgr_get_blob();
+    uint64_t byte_ns, word_ns, byte_sum, word_sum;
+
+    uart_puts("\n=== Device Tree Enumeration String Benchmark ===\n");
+
+    if (!fdt || !fdt_valid(fdt)) {
+        uart_puts("[SKIP] no device tree\n");
+        return;
+    }
+
+    // Warm the caches and check both walks see the same tree
+    byte_sum = bench_walk(&byte_ops, fdt);
+    word_sum = bench_walk(&word_ops, fdt);
+    if (byte_sum != word_sum) {
+        uart_puts("[FAIL] word-at-a-time walk disagrees with the byte walk\n");
+        return;
+    }
+
+    byte_ns = bench_time(&byte_ops, fdt, &byte_sum);
+    word_ns = bench_time(&word_ops, fdt, &word_sum);
+
+    uart_puts("Per walk of ");
+    uart_putdec(fdt32_to_cpu(((fdt_header_t *)fdt)->size_dt_struct));
+    uart_puts(" structure bytes:\n");
+    uart_puts("  byte at a time: ");
+    uart_putdec(byte_ns);
+    uart_puts(" ns\n");
+    uart_puts("  word at a time: ");
+    uart_putdec(word_ns);
+    uart_puts(" ns");
+#ifdef __riscv
+    if (cpu_has_feature(CPU_FEATURE_ZBB)) {
+        uart_puts(" (Zbb orc.b)");
+    }
+#endif
+    uart_puts("\n");
+    if (word_ns) {
+        uart_puts("  speedup: ");
+        uart_putdec(byte_ns / word_ns);
+        uart_puts(".");
+        uart_putdec(byte_ns * 10 / word_ns % 10);
+        uart_puts("x\n");
+    }
+}
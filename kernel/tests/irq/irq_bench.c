@@ -0,0 +1,142 @@
+/*
+ * kernel/tests/irq/irq_bench.c
+ *
+ * Interrupt entry and exit cost
+ *
+ * Checks that handlers run on the per-CPU IRQ stack and that the thread
+ * they interrupted is back on its own stack afterwards. It then times
+ * self-IPIs that carry no work: each one is a full trip through the
+ * vector, the controller's acknowledge and EOI, the IPI dispatch and the
+ * reschedule check, with the switch itself not taken. The cost is
+ * reported in CPU cycles where the cycle counter can be read, and in ns.
+ * Run after tick_init() with interrupts enabled.
+ *
+ * A kernel built with make IRQ_FULL_FRAME=1 has the previous entry, which
+ * saves the full exception frame and runs handlers on the interrupted
+ * stack; the same run there gives the figures to compare against.
+ */
+
+#include <tests/irq_tests.h>
+#include <tests/test_check.h>
+#include <tests/bench_cycles.h>
+#include <irq/irq_stack.h>
+#include <arch_exceptions.h>
+#include <time/hrtimer.h>
+#include <time/timekeeping.h>
+#include <smp.h>
+#include <arch_cpu.h>
+#include <arch_timer.h>
+#include <uart.h>
+
+#define IRQ_BENCH_ITERS         10000
+#define IRQ_BENCH_TIMEOUT_MS    1000
+
+static struct {
+    volatile bool fired;
+    bool on_irq_stack;
+} probe;
+
+static enum hrtimer_restart irq_stack_probe(struct hrtimer *timer) {
+    (void)timer;
+    probe.on_irq_stack = on_irq_stack((uintptr_t)__builtin_frame_address(0));
+    __atomic_store_n(&probe.fired, true, __ATOMIC_RELEASE);
+    return HRTIMER_NORESTART;
+}
+
+static void test_irq_stack(void) {
+    struct hrtimer timer;
+    uint64_t deadline;
+
+    hrtimer_init(&timer, irq_stack_probe);
+    probe.fired = false;
+    hrtimer_start(&timer, ktime_get_ns() + NSEC_PER_MSEC);
+
+    deadline = ktime_get_ns() + IRQ_BENCH_TIMEOUT_MS * NSEC_PER_MSEC;
+    while (!__atomic_load_n(&probe.fired, __ATOMIC_ACQUIRE) && ktime_get_ns() < deadline) {
+        arch_cpu_relax();
+    }
+    hrtimer_cancel(&timer);
+
+    test_check("timer callback ran", probe.fired);
+#if CONFIG_IRQ_FULL_FRAME
+    test_check("handler ran on the interrupted stack", probe.fired && !probe.on_irq_stack);
+#else
+    test_check("handler ran on the IRQ stack", probe.fired && probe.on_irq_stack);
+#endif
+    test_check("interrupted thread is back on its own stack",
+               !on_irq_stack((uintptr_t)__builtin_frame_address(0)));
+}
+
+// Average cycles and ns from raising a self-IPI to being back here
+// after it
+static void bench_self_ipi(void) {
+    unsigned int me = smp_processor_id();
+    bool cycles_usable = bench_cycles_init();
+    uint64_t start, elapsed, deadline, c0, cycles;
+    int done = 0;
+
+    start = ktime_get_ns();
+    c0 = cycles_usable ? bench_cycles_read() : 0;
+    deadline = start + IRQ_BENCH_TIMEOUT_MS * NSEC_PER_MSEC;
+    for (; done < IRQ_BENCH_ITERS; done++) {
+        uint64_t seen = smp_ipi_count(me, IPI_RESCHEDULE);
+
+        smp_send_ipi(me, IPI_RESCHEDULE);
+        while (smp_ipi_count(me, IPI_RESCHEDULE) == seen && ktime_get_ns() < deadline) {
+            arch_cpu_relax();
+        }
+        if (smp_ipi_count(me, IPI_RESCHEDULE) == seen) {
+            break;
+        }
+    }
+    cycles = cycles_usable ? bench_cycles_read() - c0 : 0;
+    elapsed = ktime_get_ns() - start;
+
+    test_check("every self-IPI was taken", done == IRQ_BENCH_ITERS);
+    if (done == 0) {
+        return;
+    }
+
+    uart_puts("  Self-IPI round trip: ");
+    if (cycles_usable) {
+        uart_putdec(cycles / done);
+        uart_puts(" cycles, ");
+    }
+    uart_putdec(elapsed / done);
+    uart_puts(".");
+    uart_putdec((elapsed * 10 / done) % 10);
+    uart_puts(" ns/interrupt over ");
+    uart_putdec(done);
+    uart_puts("\n");
+}
+
+void run_irq_benchmarks(void) {
+    test_suite_begin("Interrupt Entry/Exit Benchmark");
+
+#if CONFIG_IRQ_FULL_FRAME
+    uart_puts("  IRQ entry: full frame (IRQ_FULL_FRAME=1), ");
+#else
+    uart_puts("  IRQ entry: caller-saved frame, IRQ stack, ");
+#endif
+    uart_putdec(IRQ_ENTRY_FRAME_SIZE);
+    uart_puts(" bytes saved per interrupt (full frame ");
+    uart_putdec(IRQ_FULL_FRAME_SIZE);
+    uart_puts(", short frame ");
+    uart_putdec(sizeof(struct irq_frame));
+    uart_puts(")\n");
+
+    if (!arch_interrupts_enabled()) {
+        uart_puts("[SKIP] interrupts are masked\n");
+        return;
+    }
+
+    test_irq_stack();
+
+    if (smp_ipi_available()) {
+        bench_self_ipi();
+    } else {
+        uart_puts("[SKIP] self-IPI timing needs an IPI\n");
+    }
+
+    test_suite_end("IRQ entry tests");
+}
@@ -1095,8 +1095,8 @@ static void test_statistics_tracking(void) {
     TEST_ASSERT(desc != NULL, "No descriptor");
     
     // Initial stats should be zero
-    TEST_ASSERT(desc->count == 0, "Count not zero");
-    TEST_ASSERT(desc->spurious_count == 0, "Spurious not zero");
+    TEST_ASSERT(atomic64_read(&desc->count) == 0, "Count not zero");
+    TEST_ASSERT(atomic64_read(&desc->spurious_count) == 0, "Spurious not zero");
     
     // Register handler and simulate interrupts
     request_irq(virq, test_gpio_handler, 0, "test", NULL);
@@ -1105,11 +1105,11 @@ static void test_statistics_tracking(void) {
     for (int i = 0; i < 10; i++) {
         if (desc->action && desc->action->handler) {
             desc->action->handler(desc->action->dev_data);
-            desc->count++;
+            atomic64_inc(&desc->count);
         }
     }
     
-    TEST_ASSERT(desc->count == 10, "Count not updated");
+    TEST_ASSERT(atomic64_read(&desc->count) == 10, "Count not updated");
     
     free_irq(virq, NULL);
     irq_dispose_mapping(virq);
@@ -62,8 +62,8 @@ static void test_descriptor_allocation(void) {
     TEST_ASSERT(desc->action == NULL, "Initial action");
     TEST_ASSERT(desc->status & IRQ_DISABLED, "Initially disabled");
     TEST_ASSERT(desc->depth == 1, "Initial depth");
-    TEST_ASSERT(desc->count == 0, "Initial count");
-    TEST_ASSERT(desc->spurious_count == 0, "Initial spurious count");
+    TEST_ASSERT(atomic64_read(&desc->count) == 0, "Initial count");
+    TEST_ASSERT(atomic64_read(&desc->spurious_count) == 0, "Initial spurious count");
     TEST_PASS("Descriptor initialization correct");
     
     // Test double allocation returns same descriptor
@@ -352,34 +352,34 @@ static void test_descriptor_stats(void) {
     request_irq(virq, mock_handler, 0, "stats", &data);
     
     // Initial stats
-    TEST_ASSERT(desc->count == 0, "Initial count is 0");
-    TEST_ASSERT(desc->spurious_count == 0, "Initial spurious is 0");
+    TEST_ASSERT(atomic64_read(&desc->count) == 0, "Initial count is 0");
+    TEST_ASSERT(atomic64_read(&desc->spurious_count) == 0, "Initial spurious is 0");
     TEST_ASSERT(desc->last_timestamp == 0, "Initial timestamp is 0");
     TEST_PASS("Initial statistics");
     
     // Simulate interrupts
     handler_call_count = 0;
     generic_handle_irq(virq);
-    TEST_ASSERT(desc->count == 1, "Count incremented");
+    TEST_ASSERT(atomic64_read(&desc->count) == 1, "Count incremented");
     TEST_ASSERT(handler_call_count == 1, "Handler called");
     
     generic_handle_irq(virq);
     generic_handle_irq(virq);
-    TEST_ASSERT(desc->count == 3, "Count is 3");
+    TEST_ASSERT(atomic64_read(&desc->count) == 3, "Count is 3");
     TEST_ASSERT(handler_call_count == 3, "Handler called 3 times");
     TEST_PASS("Interrupt counting");
     
     // Test with disabled IRQ (should not call handler)
     disable_irq_nosync(virq);
     generic_handle_irq(virq);
-    TEST_ASSERT(desc->count == 3, "Count unchanged when disabled");
+    TEST_ASSERT(atomic64_read(&desc->count) == 3, "Count unchanged when disabled");
     TEST_ASSERT(handler_call_count == 3, "Handler not called when disabled");
     TEST_PASS("Disabled interrupt handling");
     
     // Re-enable and test
     enable_irq(virq);
     generic_handle_irq(virq);
-    TEST_ASSERT(desc->count == 4, "Count incremented after enable");
+    TEST_ASSERT(atomic64_read(&desc->count) == 4, "Count incremented after enable");
     TEST_ASSERT(handler_call_count == 4, "Handler called after enable");
     TEST_PASS("Re-enabled interrupt handling");
     
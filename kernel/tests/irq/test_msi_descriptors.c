@@ -136,7 +136,7 @@ static int test_msi_desc_alloc(void) {
     struct msi_desc *desc1 = msi_desc_alloc(dev, 1);
     TEST_ASSERT(desc1 != NULL, "Failed to allocate descriptor for 1 vector");
     TEST_ASSERT(desc1->dev == dev, "Device not set correctly");
-    TEST_ASSERT_EQ(desc1->refcount, 1, "Initial refcount should be 1");
+    TEST_ASSERT_EQ(atomic_read(&desc1->refcount), 1, "Initial refcount should be 1");
     TEST_ASSERT_EQ(desc1->multiple, 0, "Multiple should be 0 for 1 vector");
     
     // Allocate descriptor for 4 vectors
@@ -189,7 +189,7 @@ static int test_msi_desc_list_ops(void) {
     ret = msi_desc_list_add(dev->msi_data, desc1);
     TEST_ASSERT_EQ(ret, 0, "Failed to add first descriptor");
     TEST_ASSERT_EQ(dev->msi_data->num_vectors, 1, "Vector count should be 1");
-    TEST_ASSERT_EQ(desc1->refcount, 2, "Refcount should increase to 2");
+    TEST_ASSERT_EQ(atomic_read(&desc1->refcount), 2, "Refcount should increase to 2");
     
     ret = msi_desc_list_add(dev->msi_data, desc2);
     TEST_ASSERT_EQ(ret, 0, "Failed to add second descriptor");
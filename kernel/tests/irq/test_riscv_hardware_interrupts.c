@@ -217,8 +217,9 @@ static void test_software_interrupt(void) {
     uart_putdec(soft_virq);
     uart_puts("\n");
     
-    // Request software interrupt
-    int ret = request_irq(soft_virq, real_software_handler, 0, "soft_test", NULL);
+    // Request software interrupt (shared: it also carries IPIs)
+    int ret = request_irq(soft_virq, real_software_handler, IRQF_SHARED, "soft_test",
+                          (void *)&software_fired);
     if (ret) {
         TEST_FAIL("Failed to request software IRQ");
         return;
@@ -234,7 +235,7 @@ static void test_software_interrupt(void) {
     TEST_INFO("Software interrupt ready (trigger mechanism needed)");
     
     // Clean up
-    free_irq(soft_virq, NULL);
+    free_irq(soft_virq, (void *)&software_fired);
     TEST_PASS("Software interrupt test complete");
 #else
     TEST_INFO("Software interrupt test not available on this architecture");
@@ -0,0 +1,143 @@
+/*
+ * kernel/tests/lib/bitops_tests.c
+ *
+ * Tests for lib/bitops.h and the lib/bitmap.h searches
+ *
+ * Every count is checked against a bit-by-bit loop, for each single bit,
+ * each run of low and high ones, and a stream of pseudo-random values.
+ * The bitmap searches are checked against bitmap_test_bit() from every
+ * start position, over a map whose length is not a whole number of words.
+ */
+
+#include <tests/bitops_tests.h>
+#include <tests/test_check.h>
+#include <lib/bitops.h>
+#include <lib/bitmap.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <uart.h>
+
+#define BITOPS_TEST_BITS    300
+
+// References, one bit at a time
+static unsigned int ref_popcount(uint64_t x) {
+    unsigned int n = 0;
+
+    for (int i = 0; i < 64; i++) {
+        n += (x >> i) & 1;
+    }
+    return n;
+}
+
+static unsigned int ref_ctz(uint64_t x) {
+    unsigned int n = 0;
+
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static unsigned int ref_clz(uint64_t x) {
+    unsigned int n = 0;
+
+    while (!(x >> 63)) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+}
+
+// Each count of x, 64- and 32-bit, against the references
+static bool check_value(uint64_t x) {
+    uint32_t lo = (uint32_t)x;
+
+    if (popcount64(x) != ref_popcount(x) || popcount32(lo) != ref_popcount(lo)) {
+        return false;
+    }
+    if (x && (ctz64(x) != ref_ctz(x) || clz64(x) != ref_clz(x) ||
+              ffs64(x) != ref_ctz(x) + 1 || fls64(x) != 64 - ref_clz(x))) {
+        return false;
+    }
+    if (lo && (ctz32(lo) != ref_ctz(lo) || clz32(lo) != ref_clz(lo) - 32 ||
+               ffs32(lo) != ref_ctz(lo) + 1 || fls32(lo) != 64 - ref_clz(lo))) {
+        return false;
+    }
+    if (~x && ffz64(x) != ref_ctz(~x)) {
+        return false;
+    }
+    if (lo != 0xffffffffU && ffz32(lo) != ref_ctz(~(uint64_t)lo)) {
+        return false;
+    }
+    return true;
+}
+
+static void test_counts(void) {
+    bool single = true, runs = true, random = true;
+    uint64_t seed = 1;
+
+    for (int i = 0; i < 64; i++) {
+        if (!check_value(1ULL << i)) {
+            single = false;
+        }
+        if (!check_value(~0ULL >> i) || !check_value(~0ULL << i)) {
+            runs = false;
+        }
+    }
+    for (int i = 0; i < 10000; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        // Sparse values too, so long runs of zeros come up
+        if (!check_value(seed) || !check_value(seed & (seed >> 17) & (seed >> 31))) {
+            random = false;
+        }
+    }
+    test_check("bitops: each single bit", single);
+    test_check("bitops: runs of low and high ones", runs);
+    test_check("bitops: pseudo-random values", random);
+    test_check("bitops: ffs/fls of 0 are 0", ffs64(0) == 0 && fls64(0) == 0 &&
+                                             ffs32(0) == 0 && fls32(0) == 0);
+}
+
+static void test_bitmap_find(void) {
+    static uint64_t map[BITMAP_WORDS(BITOPS_TEST_BITS)];
+    uint64_t seed = 7;
+    bool set = true, zero = true;
+
+    for (int pass = 0; pass < 8; pass++) {
+        // Sparse, dense, empty and full maps
+        for (unsigned int w = 0; w < BITMAP_WORDS(BITOPS_TEST_BITS); w++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            map[w] = pass == 0 ? 0 : pass == 1 ? ~0ULL :
+                     pass & 1 ? seed & (seed >> 13) : seed | (seed >> 7);
+        }
+
+        for (size_t start = 0; start <= BITOPS_TEST_BITS; start++) {
+            size_t next = start, next_zero = start;
+
+            while (next < BITOPS_TEST_BITS && !bitmap_test_bit(map, next)) {
+                next++;
+            }
+            while (next_zero < BITOPS_TEST_BITS && bitmap_test_bit(map, next_zero)) {
+                next_zero++;
+            }
+            if (bitmap_find_next_bit(map, BITOPS_TEST_BITS, start) != next) {
+                set = false;
+            }
+            if (bitmap_find_next_zero_bit(map, BITOPS_TEST_BITS, start) != next_zero) {
+                zero = false;
+            }
+        }
+    }
+    test_check("bitmap_find_next_bit: from every start", set);
+    test_check("bitmap_find_next_zero_bit: from every start, stops at nbits", zero);
+}
+
+void run_bitops_tests(void) {
+    test_suite_begin("bitops Tests");
+
+    test_counts();
+    test_bitmap_find();
+
+    test_suite_end("bitops tests");
+}
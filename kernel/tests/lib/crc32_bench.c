@@ -0,0 +1,201 @@
+/*
+ * kernel/tests/lib/crc32_bench.c
+ *
+ * CRC-32/CRC-32C checks and throughput
+ *
+ * Checks the published check values (RFC 3720 for CRC-32C), that the
+ * instruction path agrees with the slicing-by-8 tables at every length
+ * and alignment, and that feeding a buffer in pieces gives the CRC of the
+ * whole. Then times both paths from 64 bytes to 1 MiB, in bytes per
+ * cycle where the cycle counter can be read and in GB/s, plus the FDT
+ * integrity check against the rotate-xor checksum it used to run.
+ */
+
+#include <tests/crc32_bench.h>
+#include <tests/test_check.h>
+#include <tests/bench_cycles.h>
+#include <lib/checksum.h>
+#include <cpufeature.h>
+#include <arch_crc32.h>
+#include <drivers/fdt_mgr.h>
+#include <memory/pmm.h>
+#include <memory/vmparam.h>
+#include <time/timekeeping.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <uart.h>
+
+#define CRC_BENCH_MAX       (1024 * 1024)
+#define CRC_BENCH_PAGES     (CRC_BENCH_MAX / PMM_PAGE_SIZE)
+#define CRC_BENCH_BYTES     (16 * 1024 * 1024)      // Per measurement
+
+enum crc_bench_op {
+    BENCH_CRC32,
+    BENCH_CRC32_SLICED,
+    BENCH_CRC32C,
+    BENCH_CRC32C_SLICED,
+    BENCH_ROTXOR,
+};
+
+static bool cycles_usable;
+
+static void crc_checks(uint8_t *buf) {
+    static const char digits[] = "123456789";
+    uint8_t bytes[32];
+    bool same = true, pieces = true;
+
+    test_check("crc32(\"123456789\") == 0xcbf43926", crc32(0, digits, 9) == 0xcbf43926);
+    test_check("crc32c(\"123456789\") == 0xe3069283", crc32c(0, digits, 9) == 0xe3069283);
+
+    for (int i = 0; i < 32; i++) {
+        bytes[i] = 0;
+    }
+    test_check("crc32c(32 x 0x00) == 0x8a9136aa", crc32c(0, bytes, 32) == 0x8a9136aa);
+    for (int i = 0; i < 32; i++) {
+        bytes[i] = 0xff;
+    }
+    test_check("crc32c(32 x 0xff) == 0x62a8ab43", crc32c(0, bytes, 32) == 0x62a8ab43);
+    for (int i = 0; i < 32; i++) {
+        bytes[i] = (uint8_t)i;
+    }
+    test_check("crc32c(0..31) == 0x46dd794e", crc32c(0, bytes, 32) == 0x46dd794e);
+
+    for (size_t i = 0; i < 512; i++) {
+        buf[i] = (uint8_t)(i * 131 + 7);
+    }
+    for (size_t off = 0; off < 8; off++) {
+        for (size_t len = 0; len <= 300; len++) {
+            const uint8_t *p = buf + off;
+            uint32_t whole32 = crc32_sliced(0, p, len);
+            uint32_t whole32c = crc32c_sliced(0, p, len);
+            size_t cut = len / 3;
+
+            if (crc32(0, p, len) != whole32 || crc32c(0, p, len) != whole32c) {
+                same = false;
+            }
+            if (crc32(crc32(0, p, cut), p + cut, len - cut) != whole32 ||
+                crc32c(crc32c(0, p, cut), p + cut, len - cut) != whole32c) {
+                pieces = false;
+            }
+        }
+    }
+    test_check("instructions match the tables, every length and alignment", same);
+    test_check("CRC of pieces == CRC of the whole", pieces);
+}
+
+// Hundredths of bytes per cycle (cycles) or of GB/s (ns)
+static void bench_one(enum crc_bench_op op, const uint8_t *buf, size_t n,
+                      uint64_t *per_cycle, uint64_t *gbps) {
+    uint64_t iters = CRC_BENCH_BYTES / n;
+    uint64_t start, ns, c0, cycles;
+    volatile uint32_t sink = 0;
+
+    if (iters == 0) {
+        iters = 1;
+    }
+    // The table path is slow enough that a quarter of the work will do
+    if (op != BENCH_CRC32 && op != BENCH_CRC32C && iters >= 4) {
+        iters /= 4;
+    }
+
+    start = ktime_get_ns();
+    c0 = cycles_usable ? bench_cycles_read() : 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        switch (op) {
+        case BENCH_CRC32:
+            sink = crc32(0, buf, n);
+            break;
+        case BENCH_CRC32_SLICED:
+            sink = crc32_sliced(0, buf, n);
+            break;
+        case BENCH_CRC32C:
+            sink = crc32c(0, buf, n);
+            break;
+        case BENCH_CRC32C_SLICED:
+            sink = crc32c_sliced(0, buf, n);
+            break;
+        case BENCH_ROTXOR:
+            sink = csum_rotxor32(buf, n);
+            break;
+        }
+    }
+    cycles = cycles_usable ? bench_cycles_read() - c0 : 0;
+    ns = ktime_get_ns() - start;
+    (void)sink;
+
+    *per_cycle = cycles ? iters * n * 100 / cycles : 0;
+    *gbps = ns ? iters * n * 100 / ns : 0;
+}
+
+static void print_centi(uint64_t centi) {
+    uart_putdec(centi / 100);
+    uart_puts(".");
+    if (centi % 100 < 10) {
+        uart_puts("0");
+    }
+    uart_putdec(centi % 100);
+}
+
+static void bench_print(const char *name, enum crc_bench_op op,
+                        const uint8_t *buf, size_t n) {
+    uint64_t per_cycle, gbps;
+
+    bench_one(op, buf, n, &per_cycle, &gbps);
+    uart_puts(name);
+    if (cycles_usable) {
+        print_centi(per_cycle);
+        uart_puts(" B/cycle, ");
+    }
+    print_centi(gbps);
+    uart_puts(" GB/s");
+}
+
+void run_crc32_benchmarks(void) {
+    static const size_t sizes[] = { 64, 512, 4096, 64 * 1024, CRC_BENCH_MAX };
+    void *fdt = fdt_mgr_get_blob();
+    uint64_t phys;
+    uint8_t *buf;
+
+    test_suite_begin("CRC-32/CRC-32C Benchmark");
+    uart_puts(cpu_has_feature(ARCH_CRC32_FEATURE) ? "Using " ARCH_CRC32_INSNS "\n"
+                                                  : "No CRC instructions: tables only\n");
+
+    phys = pmm_alloc_pages(CRC_BENCH_PAGES);
+    if (!phys) {
+        uart_puts("[SKIP] cannot allocate 1 MiB\n");
+        return;
+    }
+    buf = (uint8_t *)PHYS_TO_DMAP(phys);
+
+    crc_checks(buf);
+    test_suite_end("CRC tests");
+
+    cycles_usable = bench_cycles_init();
+    for (size_t i = 0; i < CRC_BENCH_MAX; i++) {
+        buf[i] = (uint8_t)(i * 131 + 7);
+    }
+
+    for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uart_putdec(sizes[i]);
+        uart_puts(" bytes:\n");
+        bench_print("  crc32   ", BENCH_CRC32, buf, sizes[i]);
+        bench_print(" | sliced ", BENCH_CRC32_SLICED, buf, sizes[i]);
+        uart_puts("\n");
+        bench_print("  crc32c  ", BENCH_CRC32C, buf, sizes[i]);
+        bench_print(" | sliced ", BENCH_CRC32C_SLICED, buf, sizes[i]);
+        uart_puts("\n");
+    }
+
+    if (fdt && fdt_mgr_get_size()) {
+        size_t size = fdt_mgr_get_size();
+
+        uart_puts("FDT integrity check (");
+        uart_putdec(size);
+        uart_puts(" bytes):\n");
+        bench_print("  crc32c  ", BENCH_CRC32C, fdt, size);
+        bench_print(" | rotxor ", BENCH_ROTXOR, fdt, size);
+        uart_puts("\n");
+    }
+
+    pmm_free_pages(phys, CRC_BENCH_PAGES);
+}
@@ -0,0 +1,170 @@
+/*
+ * kernel/tests/lib/ring_bench.c
+ *
+ * Ring buffer throughput
+ *
+ * First the cost per element of an enqueue and dequeue on one CPU, one at
+ * a time and in batches, through both an SPSC and an MPSC ring. Then
+ * elements per millisecond streamed from CPU 1 to this CPU at several
+ * batch sizes, and from every other CPU at once into one MPSC ring. Run
+ * under QEMU with SMP=4 or more.
+ */
+
+#include <tests/ring_tests.h>
+#include <lib/ring.h>
+#include <smp.h>
+#include <atomic.h>
+#include <time/timekeeping.h>
+#include <arch_timer.h>
+#include <uart.h>
+
+#define RING_BENCH_SIZE         1024
+#define RING_BENCH_LOCAL_ITEMS  200000
+#define RING_BENCH_XCPU_ITEMS   1000000
+#define RING_BENCH_MAX_BATCH    64
+
+static struct {
+    struct ring ring;
+    uint64_t buf[RING_BENCH_SIZE];
+    uint64_t items;                 // Per producer
+    uint32_t batch;
+    volatile bool start;
+    atomic_t producers_done;
+} bench;
+
+static void ring_bench_report(const char *name, uint32_t batch, uint64_t items, uint64_t ns) {
+    uart_puts("  ");
+    uart_puts(name);
+    uart_puts(", batch ");
+    uart_putdec(batch);
+    uart_puts(": ");
+    if (ns >= items) {
+        uart_putdec(ns / items);
+        uart_puts(" ns/elem, ");
+    }
+    uart_putdec(ns ? items * NSEC_PER_MSEC / ns : 0);
+    uart_puts(" elem/ms\n");
+}
+
+// Enqueue then dequeue on this CPU; measures the bare cost of the calls
+static void bench_local(const char *name, unsigned int flags, uint32_t batch) {
+    uint64_t vals[RING_BENCH_MAX_BATCH] = { 0 };
+    uint64_t start;
+
+    ring_init(&bench.ring, bench.buf, RING_BENCH_SIZE, sizeof(uint64_t), flags);
+
+    start = ktime_get_ns();
+    for (uint64_t i = 0; i < RING_BENCH_LOCAL_ITEMS; i += batch) {
+        ring_enqueue_batch(&bench.ring, vals, batch);
+        ring_dequeue_batch(&bench.ring, vals, batch);
+    }
+    ring_bench_report(name, batch, RING_BENCH_LOCAL_ITEMS, ktime_get_ns() - start);
+}
+
+static void bench_producer(void *arg) {
+    uint64_t vals[RING_BENCH_MAX_BATCH] = { 0 };
+    uint64_t sent = 0;
+
+    (void)arg;
+    while (!__atomic_load_n(&bench.start, __ATOMIC_ACQUIRE)) {
+        arch_cpu_relax();
+    }
+
+    while (sent < bench.items) {
+        uint32_t n = bench.batch;
+        if (n > bench.items - sent) {
+            n = bench.items - sent;
+        }
+        n = ring_enqueue_batch(&bench.ring, vals, n);
+        if (n) {
+            sent += n;
+        } else {
+            arch_cpu_relax();
+        }
+    }
+    atomic_inc(&bench.producers_done);
+}
+
+// Stream items from the CPUs in mask to this one; returns elapsed ns
+static uint64_t bench_stream(cpumask_t mask, unsigned int flags, uint32_t batch,
+                             uint64_t per_producer, uint64_t *total) {
+    uint64_t vals[RING_BENCH_MAX_BATCH];
+    uint64_t got = 0, start;
+    int nproducers;
+
+    ring_init(&bench.ring, bench.buf, RING_BENCH_SIZE, sizeof(uint64_t), flags);
+    bench.items = per_producer;
+    bench.batch = batch;
+    bench.start = false;
+    atomic_set(&bench.producers_done, 0);
+
+    nproducers = smp_call_function_many(mask, bench_producer, NULL, false);
+    *total = (uint64_t)nproducers * per_producer;
+
+    start = ktime_get_ns();
+    __atomic_store_n(&bench.start, true, __ATOMIC_RELEASE);
+
+    while (got < *total) {
+        uint32_t n = ring_dequeue_batch(&bench.ring, vals, batch);
+        if (n) {
+            got += n;
+        } else {
+            arch_cpu_relax();
+        }
+    }
+
+    uint64_t ns = ktime_get_ns() - start;
+    while (atomic_read(&bench.producers_done) < nproducers) {
+        arch_cpu_relax();
+    }
+    return ns;
+}
+
+void run_ring_benchmarks(void) {
+    static const uint32_t batches[] = { 1, 8, 32, RING_BENCH_MAX_BATCH };
+    unsigned int me = smp_processor_id();
+    cpumask_t others = cpu_online_mask() & ~cpumask_of(me);
+    unsigned int cpu, first_other = NR_CPUS;
+    uint64_t total, ns;
+
+    uart_puts("\n=== Ring Buffer Benchmark ===\n");
+
+    uart_puts("Same CPU, enqueue + dequeue:\n");
+    for (unsigned int i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        bench_local("SPSC", 0, batches[i]);
+    }
+    for (unsigned int i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        bench_local("MPSC", RING_F_MP, batches[i]);
+    }
+
+    if (!others) {
+        uart_puts("[SKIP] cross-CPU throughput needs a secondary CPU\n");
+        return;
+    }
+
+    for_each_online_cpu(cpu) {
+        if (cpu != me) {
+            first_other = cpu;
+            break;
+        }
+    }
+
+    uart_puts("CPU ");
+    uart_putdec(first_other);
+    uart_puts(" to CPU ");
+    uart_putdec(me);
+    uart_puts(":\n");
+    for (unsigned int i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        ns = bench_stream(cpumask_of(first_other), 0, batches[i], RING_BENCH_XCPU_ITEMS, &total);
+        ring_bench_report("SPSC", batches[i], total, ns);
+    }
+
+    uart_puts("All other CPUs to CPU ");
+    uart_putdec(me);
+    uart_puts(":\n");
+    for (unsigned int i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        ns = bench_stream(others, RING_F_MP, batches[i],
+                          RING_BENCH_XCPU_ITEMS / (num_online_cpus() - 1), &total);
+        ring_bench_report("MPSC", batches[i], total, ns);
+    }
+}
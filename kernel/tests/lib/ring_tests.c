@@ -0,0 +1,347 @@
+/*
+ * kernel/tests/lib/ring_tests.c
+ *
+ * Tests for the SPSC and MPSC ring buffers
+ *
+ * The single-CPU tests cover full and empty rings, wraparound of both the
+ * buffer and the 32-bit indices, batches that only partly fit, and
+ * in-place reserve/commit and peek/release. The stress tests need
+ * secondary CPUs. One of them has CPU 1 stream a counter through a small
+ * ring to this CPU. The other has every other CPU produce into one MPSC
+ * ring. The consumer checks that each producer's values arrive complete
+ * and in order.
+ */
+
+#include <tests/ring_tests.h>
+#include <tests/test_check.h>
+#include <lib/ring.h>
+#include <smp.h>
+#include <atomic.h>
+#include <time/timekeeping.h>
+#include <arch_timer.h>
+#include <uart.h>
+
+#define RING_TEST_SIZE          16
+#define RING_STRESS_SIZE        64
+#define RING_STRESS_ITEMS       200000
+#define RING_STRESS_TIMEOUT_MS  5000
+
+static uint64_t test_buf[RING_TEST_SIZE];
+
+static void test_init(void) {
+    struct ring r;
+
+    test_check("non-power-of-two size is refused", ring_init(&r, test_buf, 12, 8, 0) == -1);
+    test_check("zero size is refused", ring_init(&r, test_buf, 0, 8, 0) == -1);
+    test_check("zero element size is refused", ring_init(&r, test_buf, 16, 0, 0) == -1);
+    test_check("power-of-two size is accepted",
+               ring_init(&r, test_buf, RING_TEST_SIZE, 8, 0) == 0 &&
+               ring_empty(&r) && ring_free_count(&r) == RING_TEST_SIZE);
+}
+
+static void test_fill_drain(void) {
+    struct ring r;
+    uint64_t v;
+    bool ok = true;
+
+    ring_init(&r, test_buf, RING_TEST_SIZE, sizeof(uint64_t), 0);
+
+    for (uint64_t i = 0; i < RING_TEST_SIZE; i++) {
+        if (!ring_enqueue(&r, &i)) {
+            ok = false;
+        }
+    }
+    test_check("every slot can be filled", ok && ring_full(&r) && ring_count(&r) == RING_TEST_SIZE);
+
+    v = 99;
+    test_check("full ring refuses another element", !ring_enqueue(&r, &v));
+
+    ok = true;
+    for (uint64_t i = 0; i < RING_TEST_SIZE; i++) {
+        if (!ring_dequeue(&r, &v) || v != i) {
+            ok = false;
+        }
+    }
+    test_check("elements come out in order", ok);
+    test_check("drained ring is empty", ring_empty(&r) && !ring_dequeue(&r, &v));
+}
+
+// Batches of 5 through a ring of 16 start at every offset and wrap
+static void test_batch_wrap(void) {
+    struct ring r;
+    uint64_t in[5], out[5];
+    uint64_t next_in = 0, next_out = 0;
+    bool ok = true;
+
+    ring_init(&r, test_buf, RING_TEST_SIZE, sizeof(uint64_t), 0);
+
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 5; i++) {
+            in[i] = next_in++;
+        }
+        if (ring_enqueue_batch(&r, in, 5) != 5) {
+            ok = false;
+        }
+        if (ring_dequeue_batch(&r, out, 5) != 5) {
+            ok = false;
+        }
+        for (int i = 0; i < 5; i++) {
+            if (out[i] != next_out++) {
+                ok = false;
+            }
+        }
+    }
+    test_check("batches wrap around the buffer intact", ok);
+
+    // 14 queued, 2 free: a batch of 5 only partly fits
+    for (int i = 0; i < 14; i++) {
+        ring_enqueue(&r, &next_in);
+        next_in++;
+    }
+    for (int i = 0; i < 5; i++) {
+        in[i] = next_in + i;
+    }
+    test_check("batch into a nearly full ring takes what fits",
+               ring_enqueue_batch(&r, in, 5) == 2 && ring_full(&r));
+
+    uint64_t drain[RING_TEST_SIZE * 2];
+    uint32_t n = ring_dequeue_batch(&r, drain, RING_TEST_SIZE * 2);
+    ok = n == RING_TEST_SIZE;
+    for (uint32_t i = 0; i < n; i++) {
+        if (drain[i] != next_out++) {
+            ok = false;
+        }
+    }
+    test_check("batch out of the ring returns only what is there", ok && ring_empty(&r));
+}
+
+// Indices are free-running: start them just short of 2^32
+static void test_index_wrap(void) {
+    static uint64_t buf[RING_TEST_SIZE];
+    struct ring r;
+    uint64_t v;
+    bool ok = true;
+
+    ring_init(&r, buf, RING_TEST_SIZE, sizeof(uint64_t), RING_F_MP);
+    r.prod_head = r.prod_tail = r.cons_tail = UINT32_MAX - 20;
+
+    for (uint64_t i = 0; i < 100; i++) {
+        if (!ring_enqueue(&r, &i)) {
+            ok = false;
+        }
+        if (ring_count(&r) != 1 || !ring_dequeue(&r, &v) || v != i) {
+            ok = false;
+        }
+    }
+    test_check("counts and order hold across index overflow", ok && ring_empty(&r));
+}
+
+static void test_reserve_commit(void) {
+    static uint32_t buf[RING_TEST_SIZE];
+    struct ring r;
+    struct ring_resv resv;
+    uint32_t *slots;
+    bool ok = true;
+
+    ring_init(&r, buf, RING_TEST_SIZE, sizeof(uint32_t), 0);
+
+    // Move the indices to 12, four slots from the end
+    for (int i = 0; i < 12; i++) {
+        uint32_t v = 0;
+        ring_enqueue(&r, &v);
+        ring_dequeue(&r, &v);
+    }
+
+    test_check("reservation stops at the end of the buffer",
+               ring_reserve(&r, 8, &resv) == 4 && resv.ptr == &buf[12]);
+    slots = resv.ptr;
+    for (uint32_t i = 0; i < resv.count; i++) {
+        slots[i] = 100 + i;
+    }
+    test_check("reserved slots are not readable before commit", ring_empty(&r));
+    ring_commit(&r, &resv);
+    test_check("committed slots are readable", ring_count(&r) == 4);
+
+    test_check("next reservation starts at the front",
+               ring_reserve(&r, 8, &resv) == 8 && resv.ptr == &buf[0]);
+    slots = resv.ptr;
+    for (uint32_t i = 0; i < resv.count; i++) {
+        slots[i] = 104 + i;
+    }
+    ring_commit(&r, &resv);
+
+    // Consumer side in place: 4 at the end, then 8 from the front
+    uint32_t expect = 100;
+    test_check("peek stops at the end of the buffer", ring_peek(&r, 32, &resv) == 4);
+    slots = resv.ptr;
+    for (uint32_t i = 0; i < resv.count; i++) {
+        if (slots[i] != expect++) {
+            ok = false;
+        }
+    }
+
+    // Release only half; the rest must still be there
+    resv.count = 2;
+    ring_release(&r, &resv);
+    test_check("partial release keeps the rest", ring_count(&r) == 10);
+
+    expect = 102;
+    while (ring_peek(&r, 3, &resv)) {
+        slots = resv.ptr;
+        for (uint32_t i = 0; i < resv.count; i++) {
+            if (slots[i] != expect++) {
+                ok = false;
+            }
+        }
+        ring_release(&r, &resv);
+    }
+    test_check("in-place reads see every value in order", ok && expect == 112);
+
+    // A full ring hands out nothing
+    for (uint32_t v = 0; v < RING_TEST_SIZE; v++) {
+        ring_enqueue(&r, &v);
+    }
+    test_check("reserve on a full ring returns 0", ring_reserve(&r, 1, &resv) == 0);
+}
+
+static void test_odd_element_size(void) {
+    static uint8_t buf[8 * 3];
+    struct ring r;
+    uint8_t in[3 * 5], out[3 * 5];
+    bool ok = true;
+
+    ring_init(&r, buf, 8, 3, 0);
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < (int)sizeof(in); i++) {
+            in[i] = (uint8_t)(round * 31 + i);
+        }
+        if (ring_enqueue_batch(&r, in, 5) != 5 || ring_dequeue_batch(&r, out, 5) != 5) {
+            ok = false;
+        }
+        for (int i = 0; i < (int)sizeof(in); i++) {
+            if (out[i] != in[i]) {
+                ok = false;
+            }
+        }
+    }
+    test_check("3-byte elements survive wraparound", ok);
+}
+
+// Cross-CPU stress
+
+static struct {
+    struct ring ring;
+    uint64_t buf[RING_STRESS_SIZE];
+    uint64_t items;                 // Per producer
+    volatile bool abort;
+    atomic_t producers_done;
+} stress;
+
+// Producer values are (cpu << 32) | sequence
+static void stress_producer(void *arg) {
+    uint64_t cpu = smp_processor_id();
+    uint64_t seq = 0;
+
+    (void)arg;
+    while (seq < stress.items && !stress.abort) {
+        uint64_t v = (cpu << 32) | seq;
+        if (ring_enqueue(&stress.ring, &v)) {
+            seq++;
+        } else {
+            arch_cpu_relax();
+        }
+    }
+    atomic_inc(&stress.producers_done);
+}
+
+static bool stress_consume(unsigned int nproducers) {
+    uint64_t next[NR_CPUS] = { 0 };
+    uint64_t total = nproducers * stress.items;
+    uint64_t got = 0;
+    uint64_t deadline = ktime_get_ns() + RING_STRESS_TIMEOUT_MS * NSEC_PER_MSEC;
+    uint64_t vals[16];
+    bool ok = true;
+
+    while (got < total) {
+        uint32_t n = ring_dequeue_batch(&stress.ring, vals, 16);
+        if (!n) {
+            if (ktime_get_ns() > deadline) {
+                uart_puts("       timed out after ");
+                uart_putdec(got);
+                uart_puts(" items\n");
+                ok = false;
+                break;
+            }
+            arch_cpu_relax();
+            continue;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            unsigned int cpu = vals[i] >> 32;
+            uint64_t seq = vals[i] & 0xFFFFFFFF;
+            if (cpu >= NR_CPUS || seq != next[cpu]) {
+                ok = false;
+            } else {
+                next[cpu]++;
+            }
+        }
+        got += n;
+    }
+
+    stress.abort = true;
+    while (atomic_read(&stress.producers_done) < (int)nproducers) {
+        arch_cpu_relax();
+    }
+    return ok && ring_empty(&stress.ring);
+}
+
+static void stress_setup(unsigned int flags, uint64_t items) {
+    ring_init(&stress.ring, stress.buf, RING_STRESS_SIZE, sizeof(uint64_t), flags);
+    stress.items = items;
+    stress.abort = false;
+    atomic_set(&stress.producers_done, 0);
+}
+
+static void test_spsc_stress(void) {
+    unsigned int cpu, producer = NR_CPUS;
+
+    for_each_online_cpu(cpu) {
+        if (cpu != smp_processor_id()) {
+            producer = cpu;
+            break;
+        }
+    }
+
+    stress_setup(0, RING_STRESS_ITEMS);
+    smp_call_function_single(producer, stress_producer, NULL, false);
+    test_check("SPSC: every item arrives once and in order", stress_consume(1));
+}
+
+static void test_mpsc_stress(void) {
+    cpumask_t others = cpu_online_mask() & ~cpumask_of(smp_processor_id());
+    int nproducers;
+
+    stress_setup(RING_F_MP, RING_STRESS_ITEMS / 4);
+    nproducers = smp_call_function_many(others, stress_producer, NULL, false);
+    test_check("MPSC: every producer's items arrive once and in order",
+               nproducers > 0 && stress_consume(nproducers));
+}
+
+void run_ring_tests(void) {
+    test_suite_begin("Ring Buffer Tests");
+
+    test_init();
+    test_fill_drain();
+    test_batch_wrap();
+    test_index_wrap();
+    test_reserve_commit();
+    test_odd_element_size();
+
+    if (num_online_cpus() >= 2) {
+        test_spsc_stress();
+        test_mpsc_stress();
+    } else {
+        uart_puts("[SKIP] cross-CPU stress needs a secondary CPU\n");
+    }
+
+    test_suite_end("Ring buffer tests");
+}
@@ -0,0 +1,215 @@
+/*
+ * kernel/tests/lib/simd_tests.c
+ *
+ * Tests for kernel-mode SIMD sections and the routines that use them
+ *
+ * bitmap_find_zero_word(), csum_rotxor32() and large memcpy() are checked
+ * against plain loops at sizes on both sides of the point where they
+ * switch to SIMD. On ARM64 the section itself is checked: FP/SIMD is
+ * trapped outside, and a section opened by an interrupt handler leaves
+ * the interrupted section's registers as they were.
+ */
+
+#include <tests/simd_tests.h>
+#include <tests/test_check.h>
+#include <lib/bitmap.h>
+#include <lib/checksum.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <uart.h>
+#ifdef __aarch64__
+#include <arch_fpsimd.h>
+#include <arch_timer.h>
+#include <time/hrtimer.h>
+#include <time/timekeeping.h>
+#endif
+
+#define SIMD_TEST_WORDS     512
+#define SIMD_TEST_BYTES     (20 * 1024)
+#define SIMD_TEST_GUARD     16
+
+static uint64_t words[SIMD_TEST_WORDS];
+static uint8_t src_buf[SIMD_TEST_BYTES + 2 * SIMD_TEST_GUARD];
+static uint8_t dst_buf[SIMD_TEST_BYTES + 2 * SIMD_TEST_GUARD];
+
+static uint32_t pattern_seed;
+
+static void fill_pattern(uint8_t *buf, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        pattern_seed = pattern_seed * 1103515245 + 12345;
+        buf[i] = (uint8_t)(pattern_seed >> 16);
+    }
+}
+
+// Every length up to the whole array, with the first clear bit at each
+// position in turn (and nowhere)
+static void test_bitmap_find_zero_word(void) {
+    bool ok = true;
+
+    for (size_t zero = 0; zero <= SIMD_TEST_WORDS && ok; zero += 7) {
+        for (size_t i = 0; i < SIMD_TEST_WORDS; i++) {
+            words[i] = ~0ULL;
+        }
+        if (zero < SIMD_TEST_WORDS) {
+            words[zero] = ~(1ULL << (zero % 64));
+        }
+
+        for (size_t n = 0; n <= SIMD_TEST_WORDS; n++) {
+            size_t expect = zero < n ? zero : n;
+            if (bitmap_find_zero_word(words, n) != expect) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    test_check("bitmap_find_zero_word: every length and position", ok);
+}
+
+static uint32_t ref_csum(const uint8_t *buf, size_t len) {
+    uint32_t csum = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        csum = ((csum << 1) | (csum >> 31)) ^ buf[i];
+    }
+    return csum;
+}
+
+static void test_csum(void) {
+    bool ok = true;
+
+    fill_pattern(src_buf, sizeof(src_buf));
+    for (size_t len = 0; len <= 1100 && ok; len++) {
+        for (size_t off = 0; off < 4; off++) {
+            if (csum_rotxor32(src_buf + off, len) != ref_csum(src_buf + off, len)) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    test_check("csum_rotxor32: matches the byte loop, 0-1100 bytes", ok);
+    test_check("csum_rotxor32: matches the byte loop, 20 KiB",
+               csum_rotxor32(src_buf, SIMD_TEST_BYTES) == ref_csum(src_buf, SIMD_TEST_BYTES));
+}
+
+static bool copy_one(size_t len, size_t so, size_t d) {
+    volatile uint8_t *dst = dst_buf + SIMD_TEST_GUARD + d;
+    const uint8_t *src = src_buf + SIMD_TEST_GUARD + so;
+
+    fill_pattern(src_buf, sizeof(src_buf));
+    for (size_t i = 0; i < sizeof(dst_buf); i++) {
+        ((volatile uint8_t *)dst_buf)[i] = 0xEE;
+    }
+
+    if (memcpy((void *)dst, src, len) != (void *)dst) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(dst_buf); i++) {
+        bool inside = i >= SIMD_TEST_GUARD + d && i < SIMD_TEST_GUARD + d + len;
+        if (dst_buf[i] != (inside ? src[i - SIMD_TEST_GUARD - d] : 0xEE)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_memcpy_large(void) {
+    bool ok = true;
+
+    for (size_t len = 4032; len <= 4160 && ok; len += 3) {
+        for (size_t off = 0; off < 16; off += 5) {
+            if (!copy_one(len, off, 15 - off)) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    test_check("memcpy: around the SIMD threshold, guards intact", ok);
+    test_check("memcpy: 20 KiB - 1, unaligned", copy_one(SIMD_TEST_BYTES - 1, 1, 0));
+}
+
+#ifdef __aarch64__
+
+static uint64_t cpacr_fpen(void) {
+    uint64_t cpacr;
+    __asm__ volatile("mrs %0, cpacr_el1" : "=r"(cpacr));
+    return cpacr & CPACR_EL1_FPEN_MASK;
+}
+
+// Only inside a section: the compiler never touches V16 here, being
+// built with -mgeneral-regs-only
+static inline void write_v16(uint64_t v) {
+    __asm__ volatile("fmov d16, %0" : : "r"(v));
+}
+
+static inline uint64_t read_v16(void) {
+    uint64_t v;
+    __asm__ volatile("fmov %0, d16" : "=r"(v));
+    return v;
+}
+
+static struct {
+    volatile bool fired;
+    bool usable;
+    uint64_t seen;
+} nested;
+
+static enum hrtimer_restart neon_in_handler(struct hrtimer *timer) {
+    (void)timer;
+    nested.usable = kernel_neon_usable();
+    if (nested.usable) {
+        kernel_neon_begin();
+        write_v16(0x1111111111111111ULL);
+        nested.seen = read_v16();
+        kernel_neon_end();
+    }
+    __atomic_store_n(&nested.fired, true, __ATOMIC_RELEASE);
+    return HRTIMER_NORESTART;
+}
+
+static void test_neon_sections(void) {
+    const uint64_t pattern = 0x0123456789ABCDEFULL;
+    struct hrtimer timer;
+    uint64_t deadline, inside;
+
+    test_check("FP/SIMD trapped outside a section", cpacr_fpen() == CPACR_EL1_FPEN_TRAP);
+
+    kernel_neon_begin();
+    inside = cpacr_fpen();
+    write_v16(pattern);
+
+    // A timer interrupt opens its own section on top of ours
+    hrtimer_init(&timer, neon_in_handler);
+    nested.fired = false;
+    hrtimer_start(&timer, ktime_get_ns() + NSEC_PER_MSEC);
+    deadline = ktime_get_ns() + 1000 * NSEC_PER_MSEC;
+    while (!__atomic_load_n(&nested.fired, __ATOMIC_ACQUIRE) && ktime_get_ns() < deadline) {
+        arch_cpu_relax();
+    }
+    hrtimer_cancel(&timer);
+
+    test_check("interrupted section's register intact", read_v16() == pattern);
+    kernel_neon_end();
+
+    test_check("FP/SIMD allowed inside a section", inside == CPACR_EL1_FPEN_ALLOW);
+    test_check("handler could open a nested section", nested.fired && nested.usable);
+    test_check("handler saw its own register value", nested.seen == 0x1111111111111111ULL);
+    test_check("FP/SIMD trapped again after the section", cpacr_fpen() == CPACR_EL1_FPEN_TRAP);
+}
+
+#endif
+
+void run_simd_tests(void) {
+    pattern_seed = 7;
+
+    test_suite_begin("SIMD Tests");
+
+    test_bitmap_find_zero_word();
+    test_csum();
+    test_memcpy_large();
+#ifdef __aarch64__
+    test_neon_sections();
+#endif
+
+    test_suite_end("SIMD tests");
+}
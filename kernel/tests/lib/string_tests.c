@@ -0,0 +1,392 @@
+/*
+ * kernel/tests/lib/string_tests.c
+ *
+ * Tests for memcpy, memmove, memset, memcmp and the string functions
+ *
+ * Every length from 0 to 300 is tried at every source and destination
+ * offset within a 16-byte line, so each head, middle and tail path runs
+ * with every alignment. Bytes just outside the destination must not
+ * change. memmove is also run with the buffers overlapping by various
+ * amounts in both directions. memcmp gets a single differing byte at
+ * each position and strlen a terminator at each; both are also run
+ * across page boundaries, where an RVV load may stop short. strcmp,
+ * strncmp and strchr are run with both strings at every pair of offsets,
+ * so the word loops see s2 aligned and misaligned relative to s1.
+ */
+
+#include <tests/string_tests.h>
+#include <tests/test_check.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <uart.h>
+#include <memory/pmm.h>
+#include <memory/vmparam.h>
+
+#define STR_TEST_MAX_LEN    300
+#define STR_TEST_GUARD      32
+#define STR_TEST_BUF        (STR_TEST_MAX_LEN + 2 * STR_TEST_GUARD)
+
+static uint8_t src_buf[STR_TEST_BUF] __attribute__((aligned(64)));
+static uint8_t dst_buf[STR_TEST_BUF] __attribute__((aligned(64)));
+static uint8_t ref_buf[STR_TEST_BUF] __attribute__((aligned(64)));
+
+// Deterministic, and different at every position and on every call
+static uint32_t pattern_seed;
+
+static void fill_pattern(uint8_t *buf, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        pattern_seed = pattern_seed * 1103515245 + 12345;
+        buf[i] = (uint8_t)(pattern_seed >> 16);
+    }
+}
+
+// Reference copies and fills. volatile keeps the compiler from turning
+// these loops into calls to the functions under test.
+static void ref_copy(uint8_t *dst, const uint8_t *src, size_t n) {
+    volatile uint8_t *d = dst;
+
+    for (size_t i = 0; i < n; i++) {
+        d[i] = src[i];
+    }
+}
+
+static void ref_fill(uint8_t *dst, uint8_t c, size_t n) {
+    volatile uint8_t *d = dst;
+
+    for (size_t i = 0; i < n; i++) {
+        d[i] = c;
+    }
+}
+
+static bool bytes_equal(const uint8_t *a, const uint8_t *b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_memcpy(void) {
+    bool ok = true;
+
+    for (size_t len = 0; len <= STR_TEST_MAX_LEN && ok; len++) {
+        for (size_t so = 0; so < 16 && ok; so++) {
+            for (size_t d = 0; d < 16; d++) {
+                uint8_t *dst = dst_buf + STR_TEST_GUARD + d;
+                const uint8_t *src = src_buf + STR_TEST_GUARD + so;
+
+                fill_pattern(src_buf, STR_TEST_BUF);
+                fill_pattern(dst_buf, STR_TEST_BUF);
+                ref_copy(ref_buf, dst_buf, STR_TEST_BUF);
+                ref_copy(ref_buf + STR_TEST_GUARD + d, src, len);
+
+                if (memcpy(dst, src, len) != dst ||
+                    !bytes_equal(dst_buf, ref_buf, STR_TEST_BUF)) {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+    }
+    test_check("memcpy: every length and alignment, guards intact", ok);
+}
+
+static void test_memset(void) {
+    bool ok = true;
+
+    for (size_t len = 0; len <= STR_TEST_MAX_LEN && ok; len++) {
+        for (size_t d = 0; d < 16; d++) {
+            uint8_t *dst = dst_buf + STR_TEST_GUARD + d;
+            int c = 0x100 | (int)(len * 7 + d);     // Only the low byte counts
+
+            fill_pattern(dst_buf, STR_TEST_BUF);
+            ref_copy(ref_buf, dst_buf, STR_TEST_BUF);
+            ref_fill(ref_buf + STR_TEST_GUARD + d, (uint8_t)c, len);
+
+            if (memset(dst, c, len) != dst ||
+                !bytes_equal(dst_buf, ref_buf, STR_TEST_BUF)) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    test_check("memset: every length and alignment, guards intact", ok);
+}
+
+// Move len bytes within one buffer, from offset from to offset to
+static bool move_one(size_t from, size_t to, size_t len) {
+    fill_pattern(dst_buf, STR_TEST_BUF);
+    ref_copy(ref_buf, dst_buf, STR_TEST_BUF);
+    // Reference: through a separate buffer, so overlap cannot matter
+    ref_copy(src_buf, dst_buf + from, len);
+    ref_copy(ref_buf + to, src_buf, len);
+
+    return memmove(dst_buf + to, dst_buf + from, len) == dst_buf + to &&
+           bytes_equal(dst_buf, ref_buf, STR_TEST_BUF);
+}
+
+static void test_memmove(void) {
+    static const int shifts[] = { 1, 3, 7, 8, 9, 15, 16, 17, 31, 64, 100 };
+    bool fwd = true, back = true, same = true;
+
+    for (size_t len = 0; len <= STR_TEST_MAX_LEN - 100; len++) {
+        for (size_t base = 0; base < 16; base++) {
+            for (unsigned int i = 0; i < sizeof(shifts) / sizeof(shifts[0]); i++) {
+                size_t lo = STR_TEST_GUARD + base;
+                size_t hi = lo + shifts[i];
+
+                // dst below src, then above it
+                if (!move_one(hi, lo, len)) {
+                    fwd = false;
+                }
+                if (!move_one(lo, hi, len)) {
+                    back = false;
+                }
+            }
+            if (!move_one(STR_TEST_GUARD + base, STR_TEST_GUARD + base, len)) {
+                same = false;
+            }
+        }
+    }
+    test_check("memmove: overlapping, dst below src", fwd);
+    test_check("memmove: overlapping, dst above src", back);
+    test_check("memmove: dst == src", same);
+}
+
+static void test_memcmp(void) {
+    bool equal = true, order = true;
+
+    for (size_t len = 0; len <= STR_TEST_MAX_LEN && equal && order; len++) {
+        for (size_t so = 0; so < 16; so++) {
+            uint8_t *a = src_buf + STR_TEST_GUARD + so;
+            uint8_t *b = dst_buf + STR_TEST_GUARD + (15 - so);
+
+            fill_pattern(a, len);
+            ref_copy(b, a, len);
+            if (memcmp(a, b, len) != 0) {
+                equal = false;
+                break;
+            }
+
+            // One byte larger at each position; a later one smaller must
+            // not matter. Four alignments are plenty for this part.
+            if (so % 5 != 0) {
+                continue;
+            }
+            for (size_t i = 0; i < len; i++) {
+                uint8_t saved = b[i];
+
+                a[i] = 0x80;
+                b[i] = 0x7F;
+                if (memcmp(a, b, len) <= 0 || memcmp(b, a, len) >= 0) {
+                    order = false;
+                }
+                if (i + 1 < len) {
+                    b[i + 1] = (uint8_t)(a[i + 1] + 1);
+                    if (memcmp(a, b, len) <= 0) {
+                        order = false;
+                    }
+                    b[i + 1] = a[i + 1];
+                }
+                a[i] = saved;
+                b[i] = saved;
+            }
+        }
+    }
+    test_check("memcmp: equal buffers, every length and alignment", equal);
+    test_check("memcmp: first difference decides, as unsigned bytes", order);
+}
+
+static void test_strlen(void) {
+    bool ok = true;
+
+    for (size_t len = 0; len <= STR_TEST_MAX_LEN && ok; len++) {
+        for (size_t so = 0; so < 16; so++) {
+            char *s = (char *)src_buf + STR_TEST_GUARD + so;
+
+            ref_fill((uint8_t *)s, 'x', len);
+            s[len] = '\0';
+            if (strlen(s) != len) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    test_check("strlen: every length and alignment", ok);
+}
+
+// Two copies of a len-byte string at offsets oa and ob
+static void make_pair(char **a, char **b, size_t len, size_t oa, size_t ob) {
+    *a = (char *)src_buf + STR_TEST_GUARD + oa;
+    *b = (char *)dst_buf + STR_TEST_GUARD + ob;
+    for (size_t i = 0; i < len; i++) {
+        (*a)[i] = (char)('a' + (i * 7 + oa) % 26);
+    }
+    (*a)[len] = '\0';
+    ref_copy((uint8_t *)*b, (uint8_t *)*a, len + 1);
+}
+
+static int sign(int v) {
+    return (v > 0) - (v < 0);
+}
+
+static void test_strcmp(void) {
+    bool equal = true, order = true, prefix = true;
+
+    for (size_t len = 0; len <= 80; len++) {
+        for (size_t oa = 0; oa < 8; oa++) {
+            for (size_t ob = 0; ob < 8; ob++) {
+                char *a, *b;
+
+                make_pair(&a, &b, len, oa, ob);
+                if (strcmp(a, b) != 0 || strcmp(b, a) != 0) {
+                    equal = false;
+                }
+
+                // Differences compare as unsigned bytes, and one string
+                // ending early is smaller
+                for (size_t i = 0; i < len; i += 3) {
+                    char saved = b[i];
+
+                    b[i] = (char)0x80;
+                    if (sign(strcmp(a, b)) != -1 || sign(strcmp(b, a)) != 1) {
+                        order = false;
+                    }
+                    b[i] = '\0';
+                    if (sign(strcmp(a, b)) != 1 || sign(strcmp(b, a)) != -1) {
+                        prefix = false;
+                    }
+                    b[i] = saved;
+                }
+            }
+        }
+    }
+    test_check("strcmp: equal strings, every length and relative alignment", equal);
+    test_check("strcmp: first difference decides, as unsigned bytes", order);
+    test_check("strcmp: a prefix is smaller", prefix);
+}
+
+static void test_strncmp(void) {
+    bool ok = true;
+
+    for (size_t len = 0; len <= 40 && ok; len++) {
+        for (size_t oa = 0; oa < 8; oa++) {
+            for (size_t ob = 0; ob < 8; ob++) {
+                char *a, *b;
+
+                make_pair(&a, &b, len, oa, ob);
+                if (len) {
+                    b[len - 1] = (char)0xFF;
+                }
+
+                // Equal up to n < len, different from n == len on, and
+                // nothing past the terminators counts
+                for (size_t n = 0; n <= len + 9; n++) {
+                    int want = (len && n >= len) ? -1 : 0;
+
+                    if (sign(strncmp(a, b, n)) != want ||
+                        sign(strncmp(b, a, n)) != -want) {
+                        ok = false;
+                    }
+                }
+            }
+        }
+    }
+    test_check("strncmp: every n around the difference and the terminator", ok);
+}
+
+static void test_strchr(void) {
+    bool found = true, missing = true, nul = true;
+
+    for (size_t len = 0; len <= 80; len++) {
+        for (size_t so = 0; so < 8; so++) {
+            char *s = (char *)src_buf + STR_TEST_GUARD + so;
+
+            ref_fill((uint8_t *)s, 'x', len);
+            s[len] = '\0';
+            // A match just past the terminator, in the same word
+            s[len + 1] = '@';
+
+            if (strchr(s, '@') != NULL) {
+                missing = false;
+            }
+            if (strchr(s, 0) != s + len) {
+                nul = false;
+            }
+            for (size_t i = 0; i < len; i++) {
+                s[i] = '@';
+                if (strchr(s, '@') != s + i || strchr(s, 0x100 | '@') != s + i) {
+                    found = false;
+                }
+                s[i] = (char)0xC0;
+                if (strchr(s, 0xC0) != s + i) {
+                    found = false;
+                }
+                s[i] = 'x';
+            }
+        }
+    }
+    test_check("strchr: finds the first match at every position", found);
+    test_check("strchr: stops at the terminator", missing);
+    test_check("strchr: c == 0 finds the terminator", nul);
+}
+
+// Strings and compares that end just short of, at and just past a page
+// boundary, with the next page mapped
+static void test_page_boundary(void) {
+    uint64_t phys = pmm_alloc_pages(2);
+    uint8_t *page, *b;
+    bool ok = true;
+
+    if (!phys) {
+        uart_puts("[SKIP] page boundary: cannot allocate 2 pages\n");
+        return;
+    }
+    page = (uint8_t *)PHYS_TO_DMAP(phys);
+    b = dst_buf;
+
+    for (size_t back = 1; back <= 100 && ok; back += 3) {
+        for (size_t len = 0; len < back + 100; len += 7) {
+            uint8_t *s = page + PMM_PAGE_SIZE - back;
+            size_t n = len < STR_TEST_BUF ? len : STR_TEST_BUF - 1;
+
+            ref_fill(s, 'y', len);
+            s[len] = '\0';
+            ref_copy(b, s, n);
+            b[n] = '\0';
+            if (strlen((char *)s) != len || memcmp(s, b, n) != 0) {
+                ok = false;
+                break;
+            }
+            if (strcmp((char *)s, (char *)b) != 0 ||
+                strncmp((char *)b, (char *)s, len + 8) != 0 ||
+                strchr((char *)s, 'z') != NULL) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    test_check("strlen/memcmp/strcmp/strchr: across a page boundary", ok);
+
+    pmm_free_pages(phys, 2);
+}
+
+void run_string_tests(void) {
+    pattern_seed = 1;
+
+    test_suite_begin("memcpy/memmove/memset/memcmp and string Tests");
+
+    test_memcpy();
+    test_memset();
+    test_memmove();
+    test_memcmp();
+    test_strlen();
+    test_strcmp();
+    test_strncmp();
+    test_strchr();
+    test_page_boundary();
+
+    test_suite_end("String tests");
+}
@@ -5,6 +5,7 @@
  */
 
 #include <lib/radix_tree.h>
+#include <rcu.h>
 #include <string.h>
 #include <panic.h>
 #include <uart.h>
@@ -248,6 +249,10 @@ static void test_churn(void) {
         index = iter.next_index;
     }
     
+    // Deleted nodes are freed after a grace period; let them go now
+    // rather than carrying them into the next test
+    rcu_barrier();
+    
     if (count == 0) {
         TEST_FAIL("No entries after churn");
         return;
@@ -0,0 +1,211 @@
+/*
+ * kernel/tests/memory/dma_tests.c
+ *
+ * DMA mapping API tests
+ *
+ * There is no real device here: the test plays the device by reading and
+ * writing the bus address through the DMAP, and for a device that does
+ * not snoop it pushes its writes past the cache the way a DMA master
+ * would see them. Checks that reachable buffers map in place, that
+ * buffers above the device's mask bounce and come back intact in each
+ * direction, that a scatter-gather list maps every entry and returns its
+ * bounce slots, and that coherent memory comes zeroed and goes back.
+ */
+
+#include <tests/dma_tests.h>
+#include <tests/test_check.h>
+#include <memory/dma.h>
+#include <memory/cpu_cache.h>
+#include <memory/pmm.h>
+#include <memory/vmparam.h>
+#include <device/device.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <uart.h>
+
+#define DMA_TEST_PAGES  4
+#define DMA_TEST_SIZE   (DMA_TEST_PAGES * PMM_PAGE_SIZE)
+
+static uint8_t *device_view(dma_addr_t addr) {
+    return (uint8_t *)PHYS_TO_DMAP(addr);
+}
+
+// What the device wrote must reach memory, not sit in a cache line the
+// CPU then invalidates
+static void device_write(struct device *dev, dma_addr_t addr, uint8_t val, size_t size) {
+    memset(device_view(addr), val, size);
+    if (!dma_is_coherent(dev)) {
+        cpu_dcache_clean_invalidate_range(device_view(addr), size);
+    }
+}
+
+static bool all_bytes(const uint8_t *p, uint8_t val, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (p[i] != val) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_direct(struct device *dev, uint8_t *buf, uint64_t phys) {
+    dma_addr_t addr;
+
+    memset(buf, 0x5a, PMM_PAGE_SIZE);
+    addr = dma_map_single(dev, buf, PMM_PAGE_SIZE, DMA_TO_DEVICE);
+    test_check("reachable buffer maps in place", addr == phys);
+    test_check("device sees what the CPU wrote", !dma_mapping_error(addr) &&
+               all_bytes(device_view(addr), 0x5a, PMM_PAGE_SIZE));
+    dma_unmap_single(dev, addr, PMM_PAGE_SIZE, DMA_TO_DEVICE);
+
+    addr = dma_map_single(dev, buf, PMM_PAGE_SIZE, DMA_FROM_DEVICE);
+    if (!dma_mapping_error(addr)) {
+        device_write(dev, addr, 0xa5, PMM_PAGE_SIZE);
+    }
+    dma_unmap_single(dev, addr, PMM_PAGE_SIZE, DMA_FROM_DEVICE);
+    test_check("CPU sees what the device wrote", all_bytes(buf, 0xa5, PMM_PAGE_SIZE));
+}
+
+static void test_bounce(struct device *dev, uint8_t *buf, uint64_t phys) {
+    struct dma_stats before, after;
+    dma_addr_t addr;
+
+    // Put the buffer just out of reach
+    dev->dma_mask = phys - 1;
+    dma_get_stats(&before);
+
+    memset(buf, 0x3c, 1000);
+    addr = dma_map_single(dev, buf, 1000, DMA_BIDIRECTIONAL);
+    if (dma_mapping_error(addr)) {
+        uart_puts("[SKIP] bounce buffers are not below the test buffer\n");
+        dev->dma_mask = 0;
+        return;
+    }
+    test_check("unreachable buffer bounces below the mask",
+               addr != phys && addr + 1000 - 1 <= dev->dma_mask);
+    test_check("bounce buffer holds the CPU's data", all_bytes(device_view(addr), 0x3c, 1000));
+
+    device_write(dev, addr, 0xc3, 1000);
+    dma_sync_single_for_cpu(dev, addr, 1000, DMA_BIDIRECTIONAL);
+    test_check("sync_for_cpu copies the device's data back", all_bytes(buf, 0xc3, 1000));
+
+    memset(buf, 0x77, 1000);
+    dma_sync_single_for_device(dev, addr, 1000, DMA_BIDIRECTIONAL);
+    test_check("sync_for_device copies the CPU's data out", all_bytes(device_view(addr), 0x77, 1000));
+
+    device_write(dev, addr, 0x11, 1000);
+    dma_unmap_single(dev, addr, 1000, DMA_TO_DEVICE);
+    test_check("DMA_TO_DEVICE unmap leaves the CPU buffer alone", all_bytes(buf, 0x77, 1000));
+
+    dma_get_stats(&after);
+    test_check("bounce slots are returned", after.swiotlb_free == before.swiotlb_free &&
+               after.bounce_maps == before.bounce_maps + 1);
+    dev->dma_mask = 0;
+}
+
+static void test_sg(struct device *dev, uint8_t *buf, uint64_t phys) {
+    struct dma_sg sg[DMA_TEST_PAGES];
+    struct dma_stats before, after;
+    bool in_place = true, seen = true, back = true;
+    int n;
+
+    for (int i = 0; i < DMA_TEST_PAGES; i++) {
+        sg[i].addr = buf + i * PMM_PAGE_SIZE;
+        sg[i].length = PMM_PAGE_SIZE;
+        memset(sg[i].addr, i + 1, PMM_PAGE_SIZE);
+    }
+    n = dma_map_sg(dev, sg, DMA_TEST_PAGES, DMA_TO_DEVICE);
+    test_check("dma_map_sg maps every entry", n == DMA_TEST_PAGES);
+    for (int i = 0; i < n; i++) {
+        if (sg[i].dma_address != phys + i * PMM_PAGE_SIZE) {
+            in_place = false;
+        }
+        if (!all_bytes(device_view(sg[i].dma_address), i + 1, PMM_PAGE_SIZE)) {
+            seen = false;
+        }
+    }
+    test_check("adjacent entries map in place", in_place);
+    test_check("device sees every entry", seen);
+    dma_unmap_sg(dev, sg, n, DMA_TO_DEVICE);
+
+    // Entries out of reach bounce; the list is all or nothing
+    dev->dma_mask = phys - 1;
+    dma_get_stats(&before);
+    n = dma_map_sg(dev, sg, DMA_TEST_PAGES, DMA_FROM_DEVICE);
+    if (n) {
+        for (int i = 0; i < n; i++) {
+            device_write(dev, sg[i].dma_address, 0xe0 + i, PMM_PAGE_SIZE);
+        }
+        dma_unmap_sg(dev, sg, n, DMA_FROM_DEVICE);
+        for (int i = 0; i < DMA_TEST_PAGES; i++) {
+            if (!all_bytes(buf + i * PMM_PAGE_SIZE, 0xe0 + i, PMM_PAGE_SIZE)) {
+                back = false;
+            }
+        }
+        test_check("bounced entries copy back on unmap", back);
+    } else {
+        uart_puts("[SKIP] bounce buffers are not below the test buffer\n");
+    }
+    dma_get_stats(&after);
+    test_check("bounce slots are returned", after.swiotlb_free == before.swiotlb_free);
+    dev->dma_mask = 0;
+}
+
+static void test_coherent(struct device *dev) {
+    struct dma_stats before, after;
+    dma_addr_t handle = 0;
+    uint8_t *cpu;
+
+    dma_get_stats(&before);
+    cpu = dma_alloc_coherent(dev, 3 * PMM_PAGE_SIZE, &handle);
+    if (!cpu) {
+        uart_puts("[SKIP] no coherent memory for this device\n");
+        return;
+    }
+    test_check("coherent memory comes zeroed", all_bytes(cpu, 0, 3 * PMM_PAGE_SIZE));
+    test_check("coherent handle is page aligned", handle && (handle & (PMM_PAGE_SIZE - 1)) == 0);
+
+    // Read memory through the cached DMAP alias of uncached pool pages,
+    // dropping the lines before and after so no stale copy survives
+    memset(cpu, 0x42, 3 * PMM_PAGE_SIZE);
+    if (!dma_is_coherent(dev)) {
+        cpu_dcache_invalidate_range(device_view(handle), 3 * PMM_PAGE_SIZE);
+    }
+    test_check("device sees coherent writes without a sync",
+               all_bytes(device_view(handle), 0x42, 3 * PMM_PAGE_SIZE));
+    if (!dma_is_coherent(dev)) {
+        cpu_dcache_invalidate_range(device_view(handle), 3 * PMM_PAGE_SIZE);
+    }
+
+    dma_free_coherent(dev, 3 * PMM_PAGE_SIZE, cpu, handle);
+    dma_get_stats(&after);
+    test_check("coherent pool pages are returned",
+               after.coherent_pool_free == before.coherent_pool_free);
+}
+
+void run_dma_tests(void) {
+    static struct device test_dev;
+    uint64_t phys;
+    uint8_t *buf;
+
+    test_suite_begin("DMA Mapping Tests");
+    uart_puts(dma_is_coherent(&test_dev) ? "Device snoops the caches\n"
+                                         : "Device does not snoop: cache maintenance on\n");
+
+    phys = pmm_alloc_pages(DMA_TEST_PAGES);
+    if (!phys) {
+        uart_puts("[SKIP] cannot allocate test buffer\n");
+        return;
+    }
+    buf = (uint8_t *)PHYS_TO_DMAP(phys);
+
+    test_direct(&test_dev, buf, phys);
+    test_bounce(&test_dev, buf, phys);
+    test_sg(&test_dev, buf, phys);
+    test_coherent(&test_dev);
+
+    pmm_free_pages(phys, DMA_TEST_PAGES);
+
+    test_suite_end("DMA tests");
+}
@@ -8,6 +8,10 @@
 #include <memory/kmalloc.h>
 #include <memory/size_classes.h>
 #include <memory/vmm.h>
+#include <memory/pmm.h>
+#include <memory/page_alloc.h>
+#include <smp.h>
+#include <arch_timer.h>
 #include <uart.h>
 #include <string.h>
 
@@ -554,6 +558,85 @@ static int test_statistics(void) {
     return 1;
 }
 
+#define SNAPSHOT_CHURN_ROUNDS 2000
+
+static volatile bool churn_done;
+
+// Another CPU allocating and freeing while this one takes snapshots
+static void stats_churn(void *arg) {
+    (void)arg;
+    for (int i = 0; i < SNAPSHOT_CHURN_ROUNDS; i++) {
+        void *small = kmalloc(64, 0);
+        void *large = kmalloc(64 * 1024, 0);
+        uint64_t page = pmm_alloc_page();
+        kfree(large);
+        kfree(small);
+        if (page) {
+            pmm_free_page(page);
+        }
+    }
+    __atomic_store_n(&churn_done, true, __ATOMIC_RELEASE);
+}
+
+// Every snapshot must satisfy the invariants between its own fields
+static bool stats_snapshot_consistent(void) {
+    struct kmalloc_stats km;
+    struct page_alloc_stats pa;
+    pmm_stats_t pmm;
+
+    kmalloc_get_stats(&km);
+    if (km.total_allocs - km.total_frees != km.active_allocs) {
+        return false;
+    }
+
+    page_alloc_get_stats(&pa);
+    for (int order = 0; order <= PAGE_ALLOC_MAX_ORDER; order++) {
+        if (pa.allocations[order] - pa.frees[order] != pa.current_allocated[order]) {
+            return false;
+        }
+    }
+
+    pmm_get_stats(&pmm);
+    return pmm.free_pages + pmm.allocated_pages + pmm.reserved_pages == pmm.total_pages;
+}
+
+static int test_statistics_snapshot(void) {
+    TEST_START("Statistics snapshots under concurrent updates");
+    
+    unsigned int cpu, other = NR_CPUS;
+    for_each_online_cpu(cpu) {
+        if (cpu != smp_processor_id()) {
+            other = cpu;
+            break;
+        }
+    }
+    if (other == NR_CPUS) {
+        uart_puts("SKIP (needs a secondary CPU)\n");
+        tests_run--;
+        return 1;
+    }
+    
+    uint64_t snapshots = 0, torn = 0;
+    churn_done = false;
+    smp_call_function_single(other, stats_churn, NULL, false);
+    
+    while (!__atomic_load_n(&churn_done, __ATOMIC_ACQUIRE)) {
+        if (!stats_snapshot_consistent()) {
+            torn++;
+        }
+        snapshots++;
+        arch_cpu_relax();
+    }
+    
+    ASSERT(torn == 0, "Snapshot fields disagree with each other");
+    ASSERT(stats_snapshot_consistent(), "Final snapshot inconsistent");
+    
+    uart_putdec(snapshots);
+    uart_puts(" snapshots, ");
+    TEST_PASS();
+    return 1;
+}
+
 // Main test runner
 int run_kmalloc_tests(void) {
     uart_puts("\n=== Running kmalloc tests ===\n");
@@ -577,6 +660,7 @@ int run_kmalloc_tests(void) {
     test_alignment();
     test_memory_efficiency();
     test_statistics();
+    test_statistics_snapshot();
     
     // Print summary
     uart_puts("\n=== kmalloc test summary ===\n");
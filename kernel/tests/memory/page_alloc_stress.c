@@ -7,11 +7,20 @@
 #include <memory/page_alloc.h>
 #include <memory/pmm.h>
 #include <memory/vmparam.h>
+#include <workqueue.h>
+#include <atomic.h>
+#include <smp.h>
 #include <uart.h>
 #include <string.h>
 
 #define MAX_ALLOCS 10000  // Increased to handle 16GB+ of RAM with various block sizes
 
+// Parallel random pattern: slots shared out by parallel_for, operations per slot
+#define RANDOM_PATTERN_SLOTS    1024
+#define RANDOM_PATTERN_OPS      4
+#define RANDOM_PATTERN_MAX_ORDER 6
+#define RANDOM_PATTERN_MAGIC    0x5041474553545253ULL
+
 struct allocation {
     uint64_t addr;
     uint32_t order;
@@ -21,11 +30,11 @@ struct allocation {
 static struct allocation allocs[MAX_ALLOCS];
 static int num_allocs = 0;
 
-// Random-ish number generator (simple LCG)
-static uint32_t seed = 12345;
-static uint32_t rand(void) {
-    seed = seed * 1103515245 + 12345;
-    return (seed / 65536) % 32768;
+// Random-ish number generator (simple LCG). Each caller keeps its own
+// seed so parallel_for ranges do not share state.
+static uint32_t rand(uint32_t *seed) {
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed / 65536) % 32768;
 }
 
 static void print_test_header(const char *name) {
@@ -44,6 +53,17 @@ static void print_result(const char *test, bool passed) {
     uart_puts("\n");
 }
 
+static void free_allocs_range(uint64_t start, uint64_t end, void *arg) {
+    (void)arg;
+    
+    for (uint64_t i = start; i < end; i++) {
+        if (allocs[i].allocated) {
+            page_free(allocs[i].addr, allocs[i].order);
+            allocs[i].allocated = false;
+        }
+    }
+}
+
 // Test 1: Maximum memory allocation
 static void test_max_memory_allocation(void) {
     print_test_header("Maximum Memory Allocation Test");
@@ -147,14 +167,9 @@ static void test_max_memory_allocation(void) {
         uart_puts("%)\n");
     }
     
-    // Free everything
+    // Free everything, spread over all CPUs
     uart_puts("\nFreeing all allocations...\n");
-    for (int i = 0; i < count; i++) {
-        if (allocs[i].allocated) {
-            page_free(allocs[i].addr, allocs[i].order);
-            allocs[i].allocated = false;
-        }
-    }
+    parallel_for(0, count, free_allocs_range, NULL);
     
     // Check if memory was properly freed
     pmm_stats_t pmm_stats_freed;
@@ -190,81 +205,106 @@ static void test_max_memory_allocation(void) {
     num_allocs = 0; // Reset for next test
 }
 
-// Test 2: Random allocation/deallocation pattern
-static void test_random_pattern(void) {
-    print_test_header("Random Allocation Pattern Test");
-    
-    int total_allocs = 0;
-    int total_frees = 0;
-    int active_allocs = 0;
-    
-    // Run for many iterations (reduced for performance)
-    for (int iter = 0; iter < 200; iter++) {
-        // Randomly decide to allocate or free
-        if ((rand() % 100) < 60 && active_allocs < MAX_ALLOCS) {
-            // 60% chance to allocate
-            uint32_t order = rand() % (PAGE_ALLOC_MAX_ORDER + 1);
+// Test 2: Random allocation/deallocation pattern, run on every CPU at once.
+// Each parallel_for range owns its slots; blocks are tagged with their
+// slot so a block handed out twice shows up as a wrong tag.
+struct random_pattern_totals {
+    atomic_t allocs;
+    atomic_t frees;
+    atomic_t bad_tags;
+};
+
+static uint64_t *block_tag_ptr(uint64_t addr, uint32_t order, bool last) {
+    uint64_t offset = last ? (PAGE_SIZE << order) - sizeof(uint64_t) : 0;
+    return (uint64_t *)PHYS_TO_DMAP(addr + offset);
+}
+
+static void tag_block(uint64_t slot) {
+    uint64_t tag = RANDOM_PATTERN_MAGIC ^ slot;
+    *block_tag_ptr(allocs[slot].addr, allocs[slot].order, false) = tag;
+    *block_tag_ptr(allocs[slot].addr, allocs[slot].order, true) = tag;
+}
+
+static bool check_block_tag(uint64_t slot) {
+    uint64_t tag = RANDOM_PATTERN_MAGIC ^ slot;
+    return *block_tag_ptr(allocs[slot].addr, allocs[slot].order, false) == tag &&
+           *block_tag_ptr(allocs[slot].addr, allocs[slot].order, true) == tag;
+}
+
+static void random_pattern_range(uint64_t start, uint64_t end, void *arg) {
+    struct random_pattern_totals *totals = arg;
+    uint32_t seed = 12345 + (uint32_t)start * 7919;
+    uint64_t nslots = end - start;
+    int local_allocs = 0, local_frees = 0, bad = 0;
+    
+    for (uint64_t op = 0; op < nslots * RANDOM_PATTERN_OPS; op++) {
+        uint64_t slot = start + rand(&seed) % nslots;
+        
+        if (!allocs[slot].allocated) {
+            uint32_t order = rand(&seed) % (RANDOM_PATTERN_MAX_ORDER + 1);
             uint64_t addr = page_alloc(order);
-            
-            if (addr != 0) {
-                // Find a free slot
-                for (int i = 0; i < MAX_ALLOCS; i++) {
-                    if (!allocs[i].allocated) {
-                        allocs[i].addr = addr;
-                        allocs[i].order = order;
-                        allocs[i].allocated = true;
-                        active_allocs++;
-                        total_allocs++;
-                        break;
-                    }
-                }
+            if (addr == 0) {
+                continue;
             }
-        } else if (active_allocs > 0) {
-            // Free a random allocation
-            int attempts = 0;
-            while (attempts < 100) {
-                int idx = rand() % MAX_ALLOCS;
-                if (allocs[idx].allocated) {
-                    page_free(allocs[idx].addr, allocs[idx].order);
-                    allocs[idx].allocated = false;
-                    active_allocs--;
-                    total_frees++;
-                    break;
-                }
-                attempts++;
+            allocs[slot].addr = addr;
+            allocs[slot].order = order;
+            allocs[slot].allocated = true;
+            tag_block(slot);
+            local_allocs++;
+        } else {
+            if (!check_block_tag(slot)) {
+                bad++;
             }
-        }
-        
-        if (iter % 50 == 49) {
-            uart_puts("  Iteration ");
-            uart_putdec(iter + 1);
-            uart_puts(": active=");
-            uart_putdec(active_allocs);
-            uart_puts(" total_allocs=");
-            uart_putdec(total_allocs);
-            uart_puts(" total_frees=");
-            uart_putdec(total_frees);
-            uart_puts("\n");
+            page_free(allocs[slot].addr, allocs[slot].order);
+            allocs[slot].allocated = false;
+            local_frees++;
         }
     }
     
     // Free remaining allocations
-    for (int i = 0; i < MAX_ALLOCS; i++) {
-        if (allocs[i].allocated) {
-            page_free(allocs[i].addr, allocs[i].order);
-            allocs[i].allocated = false;
-            total_frees++;
+    for (uint64_t slot = start; slot < end; slot++) {
+        if (allocs[slot].allocated) {
+            if (!check_block_tag(slot)) {
+                bad++;
+            }
+            page_free(allocs[slot].addr, allocs[slot].order);
+            allocs[slot].allocated = false;
+            local_frees++;
         }
     }
     
+    atomic_add(local_allocs, &totals->allocs);
+    atomic_add(local_frees, &totals->frees);
+    atomic_add(bad, &totals->bad_tags);
+}
+
+static void test_random_pattern(void) {
+    print_test_header("Random Allocation Pattern Test");
+    
+    struct random_pattern_totals totals = {
+        ATOMIC_INIT(0), ATOMIC_INIT(0), ATOMIC_INIT(0)
+    };
+    
+    uart_puts("Running on ");
+    uart_putdec(num_online_cpus());
+    uart_puts(" CPU(s)\n");
+    
+    parallel_for(0, RANDOM_PATTERN_SLOTS, random_pattern_range, &totals);
+    
+    int total_allocs = atomic_read(&totals.allocs);
+    int total_frees = atomic_read(&totals.frees);
+    int bad_tags = atomic_read(&totals.bad_tags);
+    
     uart_puts("\nFinal stats:\n");
     uart_puts("  Total allocations: ");
     uart_putdec(total_allocs);
     uart_puts("\n  Total frees: ");
     uart_putdec(total_frees);
+    uart_puts("\n  Corrupted blocks: ");
+    uart_putdec(bad_tags);
     uart_puts("\n");
     
-    bool passed = (total_allocs == total_frees) && (total_allocs > 100);
+    bool passed = (total_allocs == total_frees) && (total_allocs > 100) && bad_tags == 0;
     print_result("Random allocation pattern", passed);
     
     num_allocs = 0;
@@ -459,7 +499,7 @@ void page_alloc_stress_tests(void) {
     
     // Run tests
     test_max_memory_allocation();
-    // test_random_pattern();  // Commented out - takes too long on real hardware
+    test_random_pattern();
     test_fragmentation();
     test_buddy_splitting();
     test_large_passthrough_stress();
@@ -107,8 +107,10 @@ static int test_empty_slab_destruction(void) {
     }
     
     // Check slab counts
+    struct kmem_stats cstats;
+    kmem_cache_stats(cache, &cstats);
     uart_puts("  Initial state - total slabs: ");
-    uart_putdec(cache->stats.total_slabs);
+    uart_putdec(cstats.total_slabs);
     uart_puts("\n");
     
     // Free all objects from one slab
@@ -208,8 +210,10 @@ static int test_noreap_flag(void) {
         ASSERT(objs[i] != NULL, "Allocation failed");
     }
     
+    struct kmem_stats cstats;
+    kmem_cache_stats(cache, &cstats);
     uart_puts("  Created ");
-    uart_putdec(cache->stats.total_slabs);
+    uart_putdec(cstats.total_slabs);
     uart_puts(" slabs\n");
     
     // Free all objects
@@ -269,7 +273,9 @@ static int test_mixed_patterns(void) {
     
     // Verify final state
     ASSERT(verify_slab_cache_pointers(cache), "Cache pointers corrupted");
-    ASSERT(cache->stats.active_objs == 0, "Objects leaked");
+    struct kmem_stats cstats;
+    kmem_cache_stats(cache, &cstats);
+    ASSERT(cstats.active_objs == 0, "Objects leaked");
     
     int empty_count = count_slabs_in_list(&cache->warm.empty_slabs);
     uart_puts("  Final empty slabs: ");
@@ -0,0 +1,152 @@
+/*
+ * kernel/tests/sched/sched_bench.c
+ *
+ * Context-switch latency benchmark
+ *
+ * Two threads of equal priority on the same CPU hand the CPU back and
+ * forth, first with sched_yield() (the bare switch path) and then through
+ * a pair of wait queues (wakeup plus switch). Runs on the boot CPU, where
+ * the tick is live, and on the first secondary CPU if there is one.
+ */
+
+#include <tests/sched_tests.h>
+#include <sched.h>
+#include <wait.h>
+#include <preempt.h>
+#include <atomic.h>
+#include <smp.h>
+#include <time/timekeeping.h>
+#include <uart.h>
+
+#define SCHED_BENCH_ITERS       10000
+#define SCHED_BENCH_PRIO        (SCHED_PRIO_DEFAULT - 8)
+#define SCHED_BENCH_TIMEOUT_MS  10000
+
+static struct {
+    volatile bool go;
+    atomic_t done;
+    uint64_t start;
+    uint64_t end;
+
+    // Ping-pong state: whose turn it is, and where each side waits
+    volatile int turn;
+    struct wait_queue_head wq[2];
+} bench;
+
+// Both threads exist and are queued before either starts counting
+static void bench_wait_go(void) {
+    while (!__atomic_load_n(&bench.go, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+static void bench_finish(void) {
+    if (atomic_inc_return(&bench.done) == 2) {
+        bench.end = ktime_get_ns();
+    }
+}
+
+static void yield_thread(void *arg) {
+    (void)arg;
+
+    bench_wait_go();
+    for (int i = 0; i < SCHED_BENCH_ITERS; i++) {
+        sched_yield();
+    }
+    bench_finish();
+}
+
+static void pingpong_thread(void *arg) {
+    int self = (int)(uintptr_t)arg;
+    int other = !self;
+
+    bench_wait_go();
+    for (int i = 0; i < SCHED_BENCH_ITERS; i++) {
+        wait_event(bench.wq[self], bench.turn == self);
+        bench.turn = other;
+        wake_up(&bench.wq[other]);
+    }
+    bench_finish();
+}
+
+// Run fn in two threads on cpu; returns ns, 0 on failure
+static uint64_t sched_bench_run(void (*fn)(void *), unsigned int cpu) {
+    struct task *task[2];
+
+    bench.go = false;
+    atomic_set(&bench.done, 0);
+    bench.turn = 0;
+    init_waitqueue_head(&bench.wq[0]);
+    init_waitqueue_head(&bench.wq[1]);
+
+    for (int i = 0; i < 2; i++) {
+        task[i] = kthread_create_on_cpu(fn, (void *)(uintptr_t)i, "sched-bench", cpu);
+        if (!task[i]) {
+            // The first one is still asleep; let it run through and exit
+            if (i == 1) {
+                wake_up_process(task[0]);
+            }
+            return 0;
+        }
+        kthread_set_prio(task[i], SCHED_BENCH_PRIO);
+    }
+
+    // The threads outrank us: wake both before giving up the CPU
+    preempt_disable();
+    wake_up_process(task[0]);
+    wake_up_process(task[1]);
+    bench.start = ktime_get_ns();
+    __atomic_store_n(&bench.go, true, __ATOMIC_RELEASE);
+    preempt_enable();
+    sched_preempt_point();
+
+    for (int waited = 0; atomic_read(&bench.done) != 2; waited += 10) {
+        if (waited >= SCHED_BENCH_TIMEOUT_MS) {
+            return 0;
+        }
+        msleep(10);
+    }
+    return bench.end - bench.start;
+}
+
+static void sched_bench_report(const char *name, unsigned int cpu,
+                               uint64_t elapsed, uint64_t switches) {
+    uart_puts(elapsed ? "[PASS] " : "[FAIL] ");
+    uart_puts(name);
+    uart_puts(", CPU ");
+    uart_putdec(cpu);
+    if (!elapsed) {
+        uart_puts(": did not complete\n");
+        return;
+    }
+    uart_puts(": ");
+    uart_putdec(elapsed / switches);
+    uart_puts(" ns/switch over ");
+    uart_putdec(switches);
+    uart_puts(" switches\n");
+}
+
+static void sched_bench_cpu(unsigned int cpu) {
+    // Each yield is one switch. Each ping-pong round is two wakeups and
+    // two switches.
+    sched_bench_report("yield", cpu, sched_bench_run(yield_thread, cpu),
+                       2 * SCHED_BENCH_ITERS);
+    sched_bench_report("wait queue ping-pong", cpu, sched_bench_run(pingpong_thread, cpu),
+                       2 * SCHED_BENCH_ITERS);
+}
+
+void run_sched_benchmarks(void) {
+    unsigned int cpu;
+
+    uart_puts("\n=== Context Switch Benchmark ===\n");
+
+    sched_bench_cpu(smp_processor_id());
+
+    // Secondary CPUs switch only cooperatively, which is all this needs
+    for_each_online_cpu(cpu) {
+        if (cpu != smp_processor_id()) {
+            sched_bench_cpu(cpu);
+            break;
+        }
+    }
+}
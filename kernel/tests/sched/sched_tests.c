@@ -0,0 +1,317 @@
+/*
+ * kernel/tests/sched/sched_tests.c
+ *
+ * Tests for kernel threads, the scheduler and wait queues
+ *
+ * Run from kernel_main after tick_init(): the tests rely on the
+ * tick for preemption and for msleep().
+ */
+
+#include <tests/sched_tests.h>
+#include <tests/test_check.h>
+#include <sched.h>
+#include <wait.h>
+#include <preempt.h>
+#include <atomic.h>
+#include <smp.h>
+#include <time/timekeeping.h>
+#include <arch_timer.h>
+#include <arch_cpu.h>
+#include <memory/pmm.h>
+#include <uart.h>
+
+#define SCHED_TEST_TIMEOUT_MS   2000
+#define SCHED_REAP_THREADS      64
+
+// Sleep-poll until *flag is set; false on timeout
+static bool wait_flag(volatile bool *flag, uint64_t timeout_ms) {
+    for (uint64_t waited = 0; waited < timeout_ms; waited += 10) {
+        if (__atomic_load_n(flag, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+        msleep(10);
+    }
+    return __atomic_load_n(flag, __ATOMIC_ACQUIRE);
+}
+
+static void set_flag(volatile bool *flag) {
+    __atomic_store_n(flag, true, __ATOMIC_RELEASE);
+}
+
+// kthread_run() runs the function with its argument and the thread exits
+
+static volatile bool basic_done;
+static void *basic_arg;
+static struct task *basic_self;
+
+static void basic_thread(void *arg) {
+    basic_arg = arg;
+    basic_self = get_current();
+    set_flag(&basic_done);
+}
+
+static void test_kthread_basic(void) {
+    static int token;
+    struct task *task;
+
+    basic_done = false;
+    task = kthread_run(basic_thread, &token, "sched-basic");
+
+    test_check("kthread_run creates a thread", task != NULL);
+    if (!task) {
+        return;
+    }
+    test_check("thread runs and exits", wait_flag(&basic_done, SCHED_TEST_TIMEOUT_MS));
+    test_check("thread gets its argument and task", basic_arg == &token && basic_self == task);
+}
+
+// The highest-priority runnable thread is picked, whatever the wake order
+
+static atomic_t prio_seq;
+static volatile int prio_order[2];
+static volatile bool prio_done[2];
+
+static void prio_thread(void *arg) {
+    int id = (int)(uintptr_t)arg;
+
+    prio_order[id] = atomic_inc_return(&prio_seq);
+    set_flag(&prio_done[id]);
+}
+
+static void test_priority_order(void) {
+    struct task *low, *high;
+
+    atomic_set(&prio_seq, 0);
+    prio_done[0] = prio_done[1] = false;
+
+    low = kthread_create(prio_thread, (void *)0, "sched-low");
+    high = kthread_create(prio_thread, (void *)1, "sched-high");
+    if (!low || !high) {
+        test_check("create priority threads", false);
+        return;
+    }
+    kthread_set_prio(low, SCHED_PRIO_DEFAULT + 4);
+    kthread_set_prio(high, SCHED_PRIO_DEFAULT - 8);
+
+    // Queue both before either can run
+    preempt_disable();
+    wake_up_process(low);
+    wake_up_process(high);
+    preempt_enable();
+
+    bool ok = wait_flag(&prio_done[0], SCHED_TEST_TIMEOUT_MS) &&
+              wait_flag(&prio_done[1], SCHED_TEST_TIMEOUT_MS);
+    test_check("priority threads complete", ok);
+    test_check("higher priority runs first", ok && prio_order[1] == 1 && prio_order[0] == 2);
+}
+
+// A thread waiting on a wait queue sleeps until the condition holds
+
+static DECLARE_WAIT_QUEUE_HEAD(wq_test);
+static volatile int wq_value;
+static volatile int wq_seen;
+static volatile bool wq_waiting;
+static volatile bool wq_done;
+
+static void wq_thread(void *arg) {
+    (void)arg;
+
+    set_flag(&wq_waiting);
+    wait_event(wq_test, wq_value != 0);
+    wq_seen = wq_value;
+    set_flag(&wq_done);
+}
+
+static void test_wait_queue(void) {
+    wq_value = 0;
+    wq_seen = 0;
+    wq_waiting = false;
+    wq_done = false;
+
+    if (!kthread_run(wq_thread, NULL, "sched-wq")) {
+        test_check("create wait queue thread", false);
+        return;
+    }
+
+    wait_flag(&wq_waiting, SCHED_TEST_TIMEOUT_MS);
+    msleep(30);
+    test_check("waiter sleeps while condition is false", !wq_done);
+
+    wq_value = 42;
+    wake_up(&wq_test);
+
+    test_check("wake_up wakes the waiter", wait_flag(&wq_done, SCHED_TEST_TIMEOUT_MS));
+    test_check("waiter sees the new value", wq_seen == 42);
+}
+
+// msleep() sleeps at least as long as asked, and not much longer
+
+static void test_msleep(void) {
+    uint64_t start = ktime_get_ns();
+    msleep(50);
+    uint64_t ms = (ktime_get_ns() - start) / NSEC_PER_MSEC;
+
+    test_check("msleep(50) sleeps at least 50 ms", ms >= 50);
+    test_check("msleep(50) returns within 100 ms", ms < 100);
+}
+
+// The tick preempts a thread that never yields, but not inside
+// preempt_disable()
+
+static volatile bool spin_ran;
+static volatile bool spin_stop;
+static volatile bool spin_done;
+
+static void spin_thread(void *arg) {
+    (void)arg;
+
+    set_flag(&spin_ran);
+    while (!__atomic_load_n(&spin_stop, __ATOMIC_ACQUIRE)) {
+        arch_cpu_relax();
+    }
+    set_flag(&spin_done);
+}
+
+static bool busy_wait_flag(volatile bool *flag, uint64_t ms) {
+    uint64_t end = ktime_get_ns() + ms * NSEC_PER_MSEC;
+
+    while (ktime_get_ns() < end) {
+        if (__atomic_load_n(flag, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+        arch_cpu_relax();
+    }
+    return false;
+}
+
+static void test_preemption(void) {
+    struct task *task;
+    uint64_t slice_ms = SCHED_TIMESLICE * 1000 / HZ;
+
+    spin_ran = false;
+    spin_stop = false;
+    spin_done = false;
+
+    // Same priority as us, so it only runs if the tick takes the CPU away
+    task = kthread_create(spin_thread, NULL, "sched-spin");
+    if (!task) {
+        test_check("create spinning thread", false);
+        return;
+    }
+
+    preempt_disable();
+    wake_up_process(task);
+    bool ran_early = busy_wait_flag(&spin_ran, 3 * slice_ms);
+    preempt_enable();
+    test_check("no preemption inside preempt_disable()", !ran_early);
+
+    // Both threads now spin; each only gets the CPU through the tick
+    test_check("tick preempts a spinning thread", busy_wait_flag(&spin_ran, SCHED_TEST_TIMEOUT_MS));
+
+    set_flag(&spin_stop);
+    test_check("spinning thread preempted back", wait_flag(&spin_done, SCHED_TEST_TIMEOUT_MS));
+}
+
+// Exited threads give back their stack and task struct
+
+static atomic_t reap_count;
+
+static void reap_thread(void *arg) {
+    (void)arg;
+    atomic_inc(&reap_count);
+}
+
+static bool reap_batch(void) {
+    atomic_set(&reap_count, 0);
+    for (int i = 0; i < SCHED_REAP_THREADS; i++) {
+        if (!kthread_run(reap_thread, NULL, "sched-reap")) {
+            return false;
+        }
+    }
+    for (int waited = 0; waited < SCHED_TEST_TIMEOUT_MS; waited += 10) {
+        if (atomic_read(&reap_count) == SCHED_REAP_THREADS) {
+            break;
+        }
+        msleep(10);
+    }
+    // Let the last one be switched away from and freed
+    msleep(10);
+    return atomic_read(&reap_count) == SCHED_REAP_THREADS;
+}
+
+static void test_thread_reaping(void) {
+    pmm_stats_t before, after;
+
+    // The first batch may grow the kmalloc caches; measure the second
+    bool ok = reap_batch();
+    pmm_get_stats(&before);
+    ok = ok && reap_batch();
+    pmm_get_stats(&after);
+
+    test_check("many short-lived threads run", ok);
+    test_check("exited threads are freed", ok && after.free_pages == before.free_pages);
+}
+
+// Threads created for another CPU run there and can sleep there
+
+static volatile bool remote_done;
+static volatile unsigned int remote_cpu;
+
+static void remote_thread(void *arg) {
+    (void)arg;
+
+    remote_cpu = smp_processor_id();
+    msleep(20);
+    if (smp_processor_id() != remote_cpu) {
+        remote_cpu = NR_CPUS;
+    }
+    set_flag(&remote_done);
+}
+
+static void test_remote_thread(void) {
+    unsigned int cpu, target = NR_CPUS;
+
+    for_each_online_cpu(cpu) {
+        if (cpu != smp_processor_id()) {
+            target = cpu;
+            break;
+        }
+    }
+    if (target == NR_CPUS) {
+        uart_puts("[SKIP] remote thread (single CPU)\n");
+        return;
+    }
+
+    remote_done = false;
+    remote_cpu = NR_CPUS;
+
+    test_check("kthread_create_on_cpu rejects a bad CPU",
+               kthread_create_on_cpu(remote_thread, NULL, "sched-bad", NR_CPUS) == NULL);
+
+    struct task *task = kthread_create_on_cpu(remote_thread, NULL, "sched-remote", target);
+    if (!task) {
+        test_check("create thread on another CPU", false);
+        return;
+    }
+
+    // Created threads stay asleep until woken
+    test_check("created thread waits for wake_up_process", !busy_wait_flag(&remote_done, 20));
+
+    wake_up_process(task);
+    test_check("remote thread runs", wait_flag(&remote_done, SCHED_TEST_TIMEOUT_MS));
+    test_check("remote thread runs and sleeps on its CPU", remote_cpu == target);
+}
+
+void run_sched_tests(void) {
+    test_suite_begin("Scheduler Tests");
+
+    test_kthread_basic();
+    test_priority_order();
+    test_wait_queue();
+    test_msleep();
+    test_preemption();
+    test_thread_reaping();
+    test_remote_thread();
+
+    test_suite_end("Scheduler tests");
+}
@@ -0,0 +1,345 @@
+/*
+ * kernel/tests/sched/smp_tests.c
+ *
+ * Tests for IPIs, cross-CPU function calls and TLB shootdown
+ *
+ * Needs secondary CPUs (e.g. SMP=4). Calls to every other CPU must run
+ * there, in order, exactly once; a burst of them should cost each target
+ * far fewer interrupts than calls. The shootdown test has the other CPUs
+ * read a page through a scratch mapping, points the mapping at another
+ * page, and checks that none of them still sees the first one. It ends
+ * by timing a page-at-a-time unmap against a batched one.
+ */
+
+#include <tests/smp_tests.h>
+#include <tests/test_check.h>
+#include <smp.h>
+#include <sched.h>
+#include <atomic.h>
+#include <memory/vmm.h>
+#include <memory/pmm.h>
+#include <memory/vmparam.h>
+#include <memory/tlbflush.h>
+#include <time/timekeeping.h>
+#include <arch_timer.h>
+#include <uart.h>
+
+#define SMP_TEST_ASYNC_CALLS    1000
+#define SMP_TEST_TIMEOUT_MS     1000
+#define SMP_TEST_UNMAP_PAGES    32
+
+// Unused kernel VA just below the top of the device mapping window
+#ifdef __riscv
+#define SMP_TEST_SCRATCH_VA     0xFFFFFFE0F0000000UL
+#else
+#define SMP_TEST_SCRATCH_VA     0xFFFF0001F0000000ULL
+#endif
+
+// Poll until the counter reaches the target or the timeout runs out
+static bool wait_for_count(atomic_t *count, int target) {
+    uint64_t deadline = ktime_get_ns() + SMP_TEST_TIMEOUT_MS * NSEC_PER_MSEC;
+
+    while (atomic_read(count) < target) {
+        if (ktime_get_ns() > deadline) {
+            return false;
+        }
+        arch_cpu_relax();
+    }
+    return true;
+}
+
+// Any CPU other than the caller, or NR_CPUS if there is none
+static unsigned int other_cpu(void) {
+    unsigned int cpu;
+
+    for_each_online_cpu(cpu) {
+        if (cpu != smp_processor_id()) {
+            return cpu;
+        }
+    }
+    return NR_CPUS;
+}
+
+// A waited call runs on the target and is done when the caller returns
+
+static unsigned int ran_on[NR_CPUS];
+
+static void record_cpu(void *arg) {
+    unsigned int *slot = arg;
+
+    *slot = smp_processor_id() + 1;
+}
+
+static void test_call_single(void) {
+    unsigned int cpu;
+    bool ok = true;
+
+    for_each_online_cpu(cpu) {
+        if (cpu == smp_processor_id()) {
+            continue;
+        }
+        ran_on[cpu] = 0;
+        if (smp_call_function_single(cpu, record_cpu, &ran_on[cpu], true) != 0 ||
+            ran_on[cpu] != cpu + 1) {
+            ok = false;
+        }
+    }
+    test_check("waited call runs on the target CPU before returning", ok);
+
+    test_check("call to the calling CPU is refused",
+               smp_call_function_single(smp_processor_id(), record_cpu, &ran_on[0], true) == -1);
+    test_check("call to an offline CPU is refused",
+               smp_call_function_single(NR_CPUS, record_cpu, &ran_on[0], true) == -1);
+}
+
+// Back-to-back calls without waiting: none lost, run in the order sent
+
+static atomic_t async_done;
+static volatile int async_next;
+static volatile bool async_in_order;
+
+static void async_call(void *arg) {
+    int seq = (int)(uintptr_t)arg;
+
+    if (seq != async_next) {
+        async_in_order = false;
+    }
+    async_next = seq + 1;
+    atomic_inc(&async_done);
+}
+
+static void test_call_async(void) {
+    unsigned int cpu = other_cpu();
+    uint64_t before = smp_ipi_count(cpu, IPI_CALL_FUNC);
+    uint64_t ipis;
+    bool queued = true;
+
+    atomic_set(&async_done, 0);
+    async_next = 0;
+    async_in_order = true;
+
+    for (int i = 0; i < SMP_TEST_ASYNC_CALLS; i++) {
+        if (smp_call_function_single(cpu, async_call, (void *)(uintptr_t)i, false) != 0) {
+            queued = false;
+        }
+    }
+
+    test_check("async calls all queued", queued);
+    test_check("async calls all run", wait_for_count(&async_done, SMP_TEST_ASYNC_CALLS));
+    test_check("async calls run in the order sent", async_in_order);
+
+    ipis = smp_ipi_count(cpu, IPI_CALL_FUNC) - before;
+    uart_puts("  ");
+    uart_putdec(SMP_TEST_ASYNC_CALLS);
+    uart_puts(" calls to CPU ");
+    uart_putdec(cpu);
+    uart_puts(" took ");
+    uart_putdec(ipis);
+    uart_puts(smp_ipi_available() ? " interrupts\n" : " interrupts (no IPI, polled)\n");
+}
+
+// One call to many CPUs runs once on each of them
+
+static atomic_t many_hits;
+static atomic_t many_per_cpu[NR_CPUS];
+
+static void many_call(void *arg) {
+    (void)arg;
+    atomic_inc(&many_per_cpu[smp_processor_id()]);
+    atomic_inc(&many_hits);
+}
+
+static void test_call_many(void) {
+    unsigned int cpu;
+    int queued;
+    bool once = true;
+
+    atomic_set(&many_hits, 0);
+    for (cpu = 0; cpu < NR_CPUS; cpu++) {
+        atomic_set(&many_per_cpu[cpu], 0);
+    }
+
+    queued = smp_call_function_many(cpu_online_mask(), many_call, NULL, true);
+
+    for_each_online_cpu(cpu) {
+        int expect = cpu == smp_processor_id() ? 0 : 1;
+        if (atomic_read(&many_per_cpu[cpu]) != expect) {
+            once = false;
+        }
+    }
+    test_check("call_many skips the caller and counts the rest",
+               queued == (int)num_online_cpus() - 1);
+    test_check("call_many ran once on every other CPU", once && atomic_read(&many_hits) == queued);
+}
+
+// Waking a thread on an idle CPU interrupts it straight away
+
+static atomic_t wake_ran;
+
+static void wake_thread(void *arg) {
+    (void)arg;
+    atomic_inc(&wake_ran);
+}
+
+static void test_remote_wakeup(void) {
+    unsigned int cpu = other_cpu();
+    uint64_t before = smp_ipi_count(cpu, IPI_RESCHEDULE);
+    struct task *task;
+
+    atomic_set(&wake_ran, 0);
+    task = kthread_create_on_cpu(wake_thread, NULL, "smp-wake", cpu);
+    if (!task) {
+        test_check("thread for the remote wakeup", false);
+        return;
+    }
+    wake_up_process(task);
+
+    test_check("thread woken on another CPU runs", wait_for_count(&wake_ran, 1));
+    if (smp_ipi_available()) {
+        test_check("remote wakeup sent a reschedule IPI",
+                   smp_ipi_count(cpu, IPI_RESCHEDULE) > before);
+    }
+}
+
+// TLB shootdown: no CPU keeps using a mapping that was changed
+
+static volatile uint64_t remote_seen[NR_CPUS];
+
+static void read_scratch(void *arg) {
+    remote_seen[smp_processor_id()] = *(volatile uint64_t *)arg;
+}
+
+static bool others_saw(uint64_t value) {
+    unsigned int cpu;
+
+    for_each_online_cpu(cpu) {
+        if (cpu != smp_processor_id() && remote_seen[cpu] != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_tlb_shootdown(void) {
+    vmm_context_t *ctx = vmm_get_kernel_context();
+    uintptr_t va = SMP_TEST_SCRATCH_VA;
+    uint64_t page_a = pmm_alloc_pages(1);
+    uint64_t page_b = pmm_alloc_pages(1);
+    cpumask_t others = cpu_online_mask() & ~cpumask_of(smp_processor_id());
+
+    if (!page_a || !page_b) {
+        test_check("pages for the shootdown test", false);
+        goto out;
+    }
+
+    *(volatile uint64_t *)PHYS_TO_DMAP(page_a) = 0xAAAAAAAAAAAAAAAAULL;
+    *(volatile uint64_t *)PHYS_TO_DMAP(page_b) = 0xBBBBBBBBBBBBBBBBULL;
+
+    if (!vmm_map_page(ctx, va, page_a, VMM_ATTR_RW)) {
+        test_check("scratch mapping", false);
+        goto out;
+    }
+
+    // Every other CPU now has the translation to A cached
+    smp_call_function_many(others, read_scratch, (void *)va, true);
+    test_check("other CPUs read the first page", others_saw(0xAAAAAAAAAAAAAAAAULL));
+
+    vmm_unmap_page(ctx, va);
+    vmm_map_page(ctx, va, page_b, VMM_ATTR_RW);
+
+    smp_call_function_many(others, read_scratch, (void *)va, true);
+    test_check("after remapping no CPU reads the old page", others_saw(0xBBBBBBBBBBBBBBBBULL));
+
+    vmm_unmap_page(ctx, va);
+
+out:
+    if (page_a) {
+        pmm_free_pages(page_a, 1);
+    }
+    if (page_b) {
+        pmm_free_pages(page_b, 1);
+    }
+}
+
+// Cost of unmapping page by page (one shootdown each) against one range
+
+static bool map_scratch_range(vmm_context_t *ctx, uint64_t page) {
+    for (int i = 0; i < SMP_TEST_UNMAP_PAGES; i++) {
+        if (!vmm_map_page(ctx, SMP_TEST_SCRATCH_VA + i * PAGE_SIZE, page, VMM_ATTR_RW)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void report_unmap(const char *name, uint64_t ns, const struct tlb_flush_stats *before) {
+    struct tlb_flush_stats after;
+
+    tlb_flush_get_stats(&after);
+    uart_puts("  ");
+    uart_puts(name);
+    uart_puts(": ");
+    uart_putdec(ns / NSEC_PER_USEC);
+    uart_puts(" us, ");
+    uart_putdec(after.flushes - before->flushes);
+    uart_puts(" flushes, ");
+    uart_putdec(after.firmware_rounds - before->firmware_rounds);
+    uart_puts(" via SBI, ");
+    uart_putdec(after.ipi_rounds - before->ipi_rounds);
+    uart_puts(" via IPI\n");
+}
+
+static void bench_unmap(void) {
+    vmm_context_t *ctx = vmm_get_kernel_context();
+    uint64_t page = pmm_alloc_pages(1);
+    struct tlb_flush_stats before;
+    uint64_t start, ns;
+
+    if (!page) {
+        return;
+    }
+
+    uart_puts("Unmapping ");
+    uart_putdec(SMP_TEST_UNMAP_PAGES);
+    uart_puts(" pages:\n");
+
+    if (map_scratch_range(ctx, page)) {
+        tlb_flush_get_stats(&before);
+        start = ktime_get_ns();
+        for (int i = 0; i < SMP_TEST_UNMAP_PAGES; i++) {
+            vmm_unmap_page(ctx, SMP_TEST_SCRATCH_VA + i * PAGE_SIZE);
+        }
+        ns = ktime_get_ns() - start;
+        report_unmap("page by page", ns, &before);
+    }
+
+    if (map_scratch_range(ctx, page)) {
+        tlb_flush_get_stats(&before);
+        start = ktime_get_ns();
+        vmm_unmap_range(ctx, SMP_TEST_SCRATCH_VA, SMP_TEST_UNMAP_PAGES * PAGE_SIZE);
+        ns = ktime_get_ns() - start;
+        report_unmap("batched", ns, &before);
+    }
+
+    pmm_free_pages(page, 1);
+}
+
+void run_smp_tests(void) {
+    test_suite_begin("SMP Tests");
+
+    if (num_online_cpus() < 2) {
+        uart_puts("[SKIP] needs a secondary CPU\n");
+        return;
+    }
+
+    uart_puts(smp_ipi_available() ? "IPIs available\n" : "No IPIs, calls are polled\n");
+
+    test_call_single();
+    test_call_async();
+    test_call_many();
+    test_remote_wakeup();
+    test_tlb_shootdown();
+    bench_unmap();
+
+    test_suite_end("SMP tests");
+}
@@ -0,0 +1,173 @@
+/*
+ * kernel/tests/sched/workqueue_tests.c
+ *
+ * Tests for queue_work/flush_work and parallel_for
+ */
+
+#include <tests/workqueue_tests.h>
+#include <tests/test_check.h>
+#include <workqueue.h>
+#include <atomic.h>
+#include <smp.h>
+#include <time/timekeeping.h>
+#include <arch_timer.h>
+#include <arch_cpu.h>
+#include <uart.h>
+
+#define WQ_TEST_ITEMS       600         // More than one deque holds
+#define WQ_TEST_RANGE       10000
+
+static void spin_us(uint64_t us) {
+    uint64_t end = ktime_get_ns() + us * NSEC_PER_USEC;
+
+    while (ktime_get_ns() < end) {
+        arch_cpu_relax();
+    }
+}
+
+// A single item runs once and flush_work() waits for it
+
+static atomic_t single_runs;
+
+static void single_work_fn(struct work_struct *work) {
+    (void)work;
+    spin_us(1000);
+    atomic_inc(&single_runs);
+}
+
+static void test_queue_flush(void) {
+    static DECLARE_WORK(work, single_work_fn);
+
+    atomic_set(&single_runs, 0);
+
+    test_check("queue_work on an idle item", queue_work(&work));
+    // The handler takes a millisecond, so the item is still pending
+    test_check("pending item is not queued twice", !queue_work(&work));
+    flush_work(&work);
+
+    test_check("flush_work waits for the handler", atomic_read(&single_runs) == 1);
+    test_check("item is idle after flush", !work_pending(&work));
+
+    test_check("item can be queued again", queue_work(&work));
+    flush_work(&work);
+    test_check("requeued item runs", atomic_read(&single_runs) == 2);
+}
+
+// Many items, more than the deque holds: every one runs exactly once
+
+static struct work_struct many_work[WQ_TEST_ITEMS];
+static atomic_t many_hits[WQ_TEST_ITEMS];
+
+static void many_work_fn(struct work_struct *work) {
+    atomic_inc(&many_hits[work - many_work]);
+}
+
+static void test_many_items(void) {
+    bool ok = true;
+
+    for (int i = 0; i < WQ_TEST_ITEMS; i++) {
+        INIT_WORK(&many_work[i], many_work_fn);
+        atomic_set(&many_hits[i], 0);
+    }
+    for (int i = 0; i < WQ_TEST_ITEMS; i++) {
+        ok = queue_work(&many_work[i]) && ok;
+    }
+    for (int i = 0; i < WQ_TEST_ITEMS; i++) {
+        flush_work(&many_work[i]);
+    }
+
+    test_check("all items queued", ok);
+
+    ok = true;
+    for (int i = 0; i < WQ_TEST_ITEMS; i++) {
+        if (atomic_read(&many_hits[i]) != 1) {
+            ok = false;
+        }
+    }
+    test_check("every item runs exactly once", ok);
+}
+
+// parallel_for covers the range exactly once and spreads across CPUs
+
+static atomic_t range_hits[WQ_TEST_RANGE];
+static atomic_t cpu_chunks[NR_CPUS];
+
+static void range_fn(uint64_t start, uint64_t end, void *arg) {
+    (void)arg;
+
+    for (uint64_t i = start; i < end; i++) {
+        atomic_inc(&range_hits[i]);
+    }
+    atomic_inc(&cpu_chunks[smp_processor_id()]);
+}
+
+static void slow_range_fn(uint64_t start, uint64_t end, void *arg) {
+    (void)start;
+    (void)end;
+    (void)arg;
+
+    // Long enough for idle workers elsewhere to wake and steal
+    spin_us(2000);
+    atomic_inc(&cpu_chunks[smp_processor_id()]);
+}
+
+static void test_parallel_for(void) {
+    unsigned int cpu, used = 0;
+    bool ok = true;
+
+    for (int i = 0; i < WQ_TEST_RANGE; i++) {
+        atomic_set(&range_hits[i], 0);
+    }
+
+    parallel_for(0, WQ_TEST_RANGE, range_fn, NULL);
+    for (int i = 0; i < WQ_TEST_RANGE; i++) {
+        if (atomic_read(&range_hits[i]) != 1) {
+            ok = false;
+        }
+    }
+    test_check("parallel_for visits each index once", ok);
+
+    // Ranges that do not start at zero, and smaller than the split
+    atomic_set(&range_hits[0], 0);
+    atomic_set(&range_hits[1], 0);
+    atomic_set(&range_hits[2], 0);
+    parallel_for(1, 3, range_fn, NULL);
+    test_check("parallel_for with a short range", atomic_read(&range_hits[0]) == 0 &&
+               atomic_read(&range_hits[1]) == 1 && atomic_read(&range_hits[2]) == 1);
+
+    atomic_set(&range_hits[5], 0);
+    parallel_for(5, 5, range_fn, NULL);
+    parallel_for(6, 5, range_fn, NULL);
+    test_check("parallel_for with an empty range", atomic_read(&range_hits[5]) == 0);
+
+    if (num_online_cpus() == 1) {
+        uart_puts("[SKIP] work stealing (single CPU)\n");
+        return;
+    }
+
+    for_each_possible_cpu(cpu) {
+        atomic_set(&cpu_chunks[cpu], 0);
+    }
+    parallel_for(0, 64, slow_range_fn, NULL);
+    for_each_possible_cpu(cpu) {
+        if (atomic_read(&cpu_chunks[cpu]) != 0) {
+            used++;
+        }
+    }
+    uart_puts("  Chunks ran on ");
+    uart_putdec(used);
+    uart_puts(" of ");
+    uart_putdec(num_online_cpus());
+    uart_puts(" CPUs\n");
+    test_check("other CPUs steal parallel_for chunks", used > 1);
+}
+
+void run_workqueue_tests(void) {
+    test_suite_begin("Workqueue Tests");
+
+    test_queue_flush();
+    test_many_items();
+    test_parallel_for();
+
+    test_suite_end("Workqueue tests");
+}
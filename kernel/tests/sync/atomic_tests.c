@@ -0,0 +1,122 @@
+/*
+ * kernel/tests/sync/atomic_tests.c
+ *
+ * Tests for atomic_t / atomic64_t
+ */
+
+#include <tests/atomic_tests.h>
+#include <tests/test_check.h>
+#include <atomic.h>
+#include <smp.h>
+#include <arch_timer.h>
+#include <uart.h>
+
+#define ATOMIC_SMP_ITERS    100000
+
+static void test_atomic32_ops(void) {
+    atomic_t v = ATOMIC_INIT(5);
+
+    test_check("atomic_read initial value", atomic_read(&v) == 5);
+
+    atomic_inc(&v);
+    atomic_add(10, &v);
+    atomic_dec(&v);
+    atomic_sub(4, &v);
+    test_check("atomic_add/sub/inc/dec", atomic_read(&v) == 11);
+
+    test_check("atomic_fetch_add returns old", atomic_fetch_add(4, &v) == 11 && atomic_read(&v) == 15);
+    test_check("atomic_add_return returns new", atomic_add_return_acquire(5, &v) == 20);
+    test_check("atomic_sub_return returns new", atomic_sub_return_release(21, &v) == -1);
+    test_check("atomic_inc_return wraps through zero", atomic_inc_return_relaxed(&v) == 0);
+
+    atomic_set(&v, 0xF0);
+    test_check("atomic_fetch_or", atomic_fetch_or(0x0F, &v) == 0xF0 && atomic_read(&v) == 0xFF);
+    test_check("atomic_fetch_and", atomic_fetch_and(0x3C, &v) == 0xFF && atomic_read(&v) == 0x3C);
+    test_check("atomic_fetch_xor", atomic_fetch_xor(0xFF, &v) == 0x3C && atomic_read(&v) == 0xC3);
+
+    test_check("atomic_xchg", atomic_xchg(&v, 7) == 0xC3 && atomic_read(&v) == 7);
+    test_check("atomic_cmpxchg success", atomic_cmpxchg(&v, 7, 9) == 7 && atomic_read(&v) == 9);
+    test_check("atomic_cmpxchg failure", atomic_cmpxchg(&v, 7, 11) == 9 && atomic_read(&v) == 9);
+
+    int32_t old = 1;
+    bool ok = !atomic_try_cmpxchg(&v, &old, 2) && old == 9;
+    ok = ok && atomic_try_cmpxchg(&v, &old, 2) && atomic_read(&v) == 2;
+    test_check("atomic_try_cmpxchg updates expected value", ok);
+
+    // Negative values exercise the sign-extension in LR/SC compares
+    atomic_set(&v, -3);
+    test_check("atomic_cmpxchg negative", atomic_cmpxchg(&v, -3, -4) == -3 && atomic_read(&v) == -4);
+
+    atomic_set(&v, 2);
+    test_check("atomic_dec_and_test", !atomic_dec_and_test(&v) && atomic_dec_and_test(&v));
+    test_check("atomic_inc_not_zero on zero", !atomic_inc_not_zero(&v) && atomic_read(&v) == 0);
+    atomic_set(&v, 1);
+    test_check("atomic_inc_not_zero on live", atomic_inc_not_zero(&v) && atomic_read(&v) == 2);
+}
+
+static void test_atomic64_ops(void) {
+    atomic64_t v = ATOMIC64_INIT(0x100000000LL);
+
+    atomic64_add(0x100000000LL, &v);
+    test_check("atomic64_add carries past 32 bits", atomic64_read(&v) == 0x200000000LL);
+    test_check("atomic64_fetch_sub", atomic64_fetch_sub(1, &v) == 0x200000000LL &&
+                                     atomic64_read(&v) == 0x1FFFFFFFFLL);
+    test_check("atomic64_cmpxchg", atomic64_cmpxchg(&v, 0x1FFFFFFFFLL, -1) == 0x1FFFFFFFFLL &&
+                                   atomic64_read(&v) == -1);
+    test_check("atomic64_xchg", atomic64_xchg_acquire(&v, 42) == -1 && atomic64_read(&v) == 42);
+}
+
+static atomic_t smp_counter;
+static atomic64_t smp_counter64;
+static volatile bool smp_done[NR_CPUS];
+
+static void atomic_smp_worker(void *arg) {
+    unsigned int cpu = (unsigned int)(uintptr_t)arg;
+
+    for (int i = 0; i < ATOMIC_SMP_ITERS; i++) {
+        atomic_inc(&smp_counter);
+        atomic64_add(2, &smp_counter64);
+    }
+    __atomic_store_n(&smp_done[cpu], true, __ATOMIC_RELEASE);
+}
+
+// Every online CPU hammers the same counters; none of the updates may be lost
+static void test_atomic_smp(void) {
+    unsigned int cpu, n = 0;
+
+    atomic_set(&smp_counter, 0);
+    atomic64_set(&smp_counter64, 0);
+
+    for_each_online_cpu(cpu) {
+        smp_done[cpu] = false;
+        if (cpu != smp_processor_id()) {
+            smp_call_function_single(cpu, atomic_smp_worker, (void *)(uintptr_t)cpu, false);
+        }
+        n++;
+    }
+    atomic_smp_worker((void *)(uintptr_t)smp_processor_id());
+
+    for_each_online_cpu(cpu) {
+        while (!__atomic_load_n(&smp_done[cpu], __ATOMIC_ACQUIRE)) {
+            arch_cpu_relax();
+        }
+    }
+
+    uart_puts("  ");
+    uart_putdec(n);
+    uart_puts(" CPU(s) x ");
+    uart_putdec(ATOMIC_SMP_ITERS);
+    uart_puts(" increments\n");
+    test_check("concurrent atomic_inc", atomic_read(&smp_counter) == (int32_t)(n * ATOMIC_SMP_ITERS));
+    test_check("concurrent atomic64_add", atomic64_read(&smp_counter64) == (int64_t)n * ATOMIC_SMP_ITERS * 2);
+}
+
+void run_atomic_tests(void) {
+    test_suite_begin("Atomic Operations Tests");
+
+    test_atomic32_ops();
+    test_atomic64_ops();
+    test_atomic_smp();
+
+    test_suite_end("Atomic tests");
+}
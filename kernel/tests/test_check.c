@@ -0,0 +1,43 @@
+/*
+ * kernel/tests/test_check.c
+ *
+ * Pass/fail bookkeeping shared by the test suites
+ */
+
+#include <tests/test_check.h>
+#include <uart.h>
+
+static int tests_run;
+static int tests_failed;
+
+void test_suite_begin(const char *title) {
+    tests_run = 0;
+    tests_failed = 0;
+
+    uart_puts("\n=== ");
+    uart_puts(title);
+    uart_puts(" ===\n");
+}
+
+void test_check(const char *name, bool ok) {
+    tests_run++;
+    if (ok) {
+        uart_puts("[PASS] ");
+    } else {
+        uart_puts("[FAIL] ");
+        tests_failed++;
+    }
+    uart_puts(name);
+    uart_puts("\n");
+}
+
+int test_suite_end(const char *label) {
+    uart_puts(label);
+    uart_puts(": ");
+    uart_putdec(tests_run - tests_failed);
+    uart_puts("/");
+    uart_putdec(tests_run);
+    uart_puts(" passed\n");
+
+    return tests_failed;
+}
@@ -0,0 +1,118 @@
+/*
+ * kernel/tests/time/clockevent_bench.c
+ *
+ * Cost of reprogramming the timer
+ *
+ * Times back-to-back calls of the clock event device's set_next_event()
+ * and of clockevents_program_event(), which adds the ns-to-ticks
+ * conversion and clamping. Deadlines are a second out and interrupts are
+ * masked, so nothing fires while it runs. On RISC-V it also times both
+ * ways of setting the compare value: an SBI ecall, and a direct stimecmp
+ * write when the hart has Sstc. Boot QEMU with -cpu rv64 and again with
+ * -cpu rv64,sstc=off to see what the device costs either way.
+ */
+
+#include <tests/timer_tests.h>
+#include <time/clockevents.h>
+#include <time/timekeeping.h>
+#include <arch_timer.h>
+#include <spinlock.h>
+#include <uart.h>
+
+#define CE_BENCH_ITERS          10000
+
+static void ce_bench_report(const char *name, uint64_t elapsed) {
+    uart_puts("  ");
+    uart_puts(name);
+    uart_puts(": ");
+    uart_putdec(elapsed / CE_BENCH_ITERS);
+    uart_puts(".");
+    uart_putdec((elapsed * 10 / CE_BENCH_ITERS) % 10);
+    uart_puts(" ns/call\n");
+}
+
+static uint64_t bench_set_next_event(struct clock_event_device *dev) {
+    uint64_t start = ktime_get_ns();
+
+    for (int i = 0; i < CE_BENCH_ITERS; i++) {
+        dev->set_next_event(dev, dev->freq);
+    }
+    return ktime_get_ns() - start;
+}
+
+static uint64_t bench_program_event(struct clock_event_device *dev) {
+    uint64_t start = ktime_get_ns();
+
+    for (int i = 0; i < CE_BENCH_ITERS; i++) {
+        clockevents_program_event(dev, start + NSEC_PER_SEC);
+    }
+    return ktime_get_ns() - start;
+}
+
+#ifdef __riscv
+static uint64_t bench_sbi_set_timer(void) {
+    uint64_t start = ktime_get_ns();
+    uint64_t far = arch_timer_get_counter() + arch_timer_get_frequency();
+
+    for (int i = 0; i < CE_BENCH_ITERS; i++) {
+        arch_timer_set_compare_sbi(far + i);
+    }
+    return ktime_get_ns() - start;
+}
+
+static uint64_t bench_stimecmp(void) {
+    uint64_t start = ktime_get_ns();
+    uint64_t far = arch_timer_get_counter() + arch_timer_get_frequency();
+
+    for (int i = 0; i < CE_BENCH_ITERS; i++) {
+        arch_timer_set_compare_sstc(far + i);
+    }
+    return ktime_get_ns() - start;
+}
+#endif
+
+void run_clockevent_benchmarks(void) {
+    struct clock_event_device *dev = clockevents_get_device();
+    irqflags_t flags;
+    uint64_t saved, saved_programmed;
+
+    uart_puts("\n=== Timer Reprogramming Benchmark ===\n");
+
+    if (!dev) {
+        uart_puts("[SKIP] no clock event device\n");
+        return;
+    }
+
+    uart_puts("  device: ");
+    uart_puts(dev->name);
+    uart_puts("\n");
+
+    flags = arch_local_irq_save();
+    saved = dev->next_event;
+    saved_programmed = dev->nr_programmed;
+
+    ce_bench_report("set_next_event", bench_set_next_event(dev));
+    ce_bench_report("clockevents_program_event", bench_program_event(dev));
+
+#ifdef __riscv
+    ce_bench_report("SBI set_timer ecall", bench_sbi_set_timer());
+    if (cpu_has_feature(CPU_FEATURE_SSTC)) {
+        ce_bench_report("stimecmp write", bench_stimecmp());
+        // Leave no SBI deadline behind to fire later
+        arch_timer_set_compare_sbi(UINT64_MAX);
+    } else {
+        uart_puts("  stimecmp write: no Sstc\n");
+    }
+#endif
+
+    // Put back whatever the hrtimer queue had asked for, and keep the
+    // benchmark out of the device's statistics
+    if (saved != UINT64_MAX) {
+        clockevents_program_event(dev, saved);
+    } else {
+        clockevents_shutdown(dev);
+    }
+    dev->nr_programmed = saved_programmed;
+
+    arch_local_irq_restore(flags);
+}
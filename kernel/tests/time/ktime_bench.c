@@ -0,0 +1,152 @@
+/*
+ * kernel/tests/time/ktime_bench.c
+ *
+ * Cost of reading the time
+ *
+ * Times back-to-back calls of the raw counter read, of ktime_get_ns(),
+ * and of the counter-times-1e9-over-frequency division callers used to
+ * do by hand. Then runs a ktime_get_ns() reader on every online CPU at
+ * once: the timekeeper is read-only for them, so the per-call cost
+ * should not grow with the number of CPUs.
+ */
+
+#include <tests/timer_tests.h>
+#include <time/timekeeping.h>
+#include <sched.h>
+#include <preempt.h>
+#include <atomic.h>
+#include <smp.h>
+#include <arch_timer.h>
+#include <uart.h>
+
+#define KTIME_BENCH_ITERS       100000
+#define KTIME_BENCH_PRIO        (SCHED_PRIO_DEFAULT - 8)
+#define KTIME_BENCH_TIMEOUT_MS  10000
+
+// Keeps the compiler from dropping reads whose result is unused
+static volatile uint64_t ktime_sink;
+
+static uint64_t bench_counter(void) {
+    uint64_t start = ktime_get_ns();
+
+    for (int i = 0; i < KTIME_BENCH_ITERS; i++) {
+        ktime_sink = arch_timer_get_counter();
+    }
+    return ktime_get_ns() - start;
+}
+
+static uint64_t bench_counter_div(void) {
+    uint64_t start = ktime_get_ns();
+
+    for (int i = 0; i < KTIME_BENCH_ITERS; i++) {
+        ktime_sink = arch_timer_get_counter() * NSEC_PER_SEC / arch_timer_get_frequency();
+    }
+    return ktime_get_ns() - start;
+}
+
+static uint64_t bench_ktime(void) {
+    uint64_t start = ktime_get_ns();
+
+    for (int i = 0; i < KTIME_BENCH_ITERS; i++) {
+        ktime_sink = ktime_get_ns();
+    }
+    return ktime_get_ns() - start;
+}
+
+static void ktime_bench_report(const char *name, uint64_t elapsed) {
+    uart_puts("  ");
+    uart_puts(name);
+    uart_puts(": ");
+    uart_putdec(elapsed / KTIME_BENCH_ITERS);
+    uart_puts(".");
+    uart_putdec((elapsed * 10 / KTIME_BENCH_ITERS) % 10);
+    uart_puts(" ns/call\n");
+}
+
+// Every online CPU reading at once
+
+static struct {
+    volatile bool go;
+    atomic_t done;
+    uint64_t elapsed[NR_CPUS];
+    bool monotonic[NR_CPUS];
+} par;
+
+static void ktime_reader_thread(void *arg) {
+    unsigned int cpu = (unsigned int)(uintptr_t)arg;
+    bool monotonic = true;
+
+    while (!__atomic_load_n(&par.go, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+
+    uint64_t start = ktime_get_ns();
+    uint64_t prev = start;
+    for (int i = 0; i < KTIME_BENCH_ITERS; i++) {
+        uint64_t now = ktime_get_ns();
+        if (now < prev) {
+            monotonic = false;
+        }
+        prev = now;
+    }
+
+    par.elapsed[cpu] = prev - start;
+    par.monotonic[cpu] = monotonic;
+    atomic_inc(&par.done);
+}
+
+static void ktime_bench_parallel(void) {
+    unsigned int cpu, started = 0;
+
+    par.go = false;
+    atomic_set(&par.done, 0);
+
+    // The readers outrank us: wake them all before giving up the CPU
+    preempt_disable();
+    for_each_online_cpu(cpu) {
+        struct task *task = kthread_create_on_cpu(ktime_reader_thread, (void *)(uintptr_t)cpu,
+                                                  "ktime-bench", cpu);
+        par.elapsed[cpu] = 0;
+        if (task) {
+            kthread_set_prio(task, KTIME_BENCH_PRIO);
+            wake_up_process(task);
+            started++;
+        }
+    }
+    __atomic_store_n(&par.go, true, __ATOMIC_RELEASE);
+    preempt_enable();
+    sched_preempt_point();
+
+    for (int waited = 0; atomic_read(&par.done) != (int)started; waited += 10) {
+        if (waited >= KTIME_BENCH_TIMEOUT_MS) {
+            uart_puts("[FAIL] parallel ktime_get_ns: readers did not finish\n");
+            return;
+        }
+        msleep(10);
+    }
+
+    for_each_online_cpu(cpu) {
+        if (!par.elapsed[cpu]) {
+            continue;
+        }
+        uart_puts(par.monotonic[cpu] ? "[PASS] " : "[FAIL] ");
+        uart_puts("ktime_get_ns with ");
+        uart_putdec(started);
+        uart_puts(" readers, CPU ");
+        uart_putdec(cpu);
+        uart_puts(": ");
+        uart_putdec(par.elapsed[cpu] / KTIME_BENCH_ITERS);
+        uart_puts(" ns/call");
+        uart_puts(par.monotonic[cpu] ? "\n" : ", went backwards\n");
+    }
+}
+
+void run_ktime_benchmarks(void) {
+    uart_puts("\n=== ktime_get_ns Benchmark ===\n");
+
+    ktime_bench_report("raw counter read", bench_counter());
+    ktime_bench_report("counter * 1e9 / freq", bench_counter_div());
+    ktime_bench_report("ktime_get_ns", bench_ktime());
+
+    ktime_bench_parallel();
+}
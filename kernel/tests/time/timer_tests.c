@@ -0,0 +1,339 @@
+/*
+ * kernel/tests/time/timer_tests.c
+ *
+ * Tests for timekeeping, the timer wheel and hrtimers
+ *
+ * Run after tick_init(). Takes about four seconds: one timer is placed
+ * beyond the first wheel level and has to cascade down.
+ */
+
+#include <tests/timer_tests.h>
+#include <tests/test_check.h>
+#include <time/timer.h>
+#include <time/hrtimer.h>
+#include <time/tick.h>
+#include <time/clockevents.h>
+#include <time/clocksource.h>
+#include <time/timekeeping.h>
+#include <sched.h>
+#include <smp.h>
+#include <uart.h>
+
+#define TIMER_ORDER_COUNT   4
+#define HRTIMER_PERIODS     20
+#define KTIME_READS         100000
+
+// mult/shift for common counter rates: one second of ticks converts to
+// within a part per million of 1e9 ns, and CLOCKSOURCE_MAX_SEC of ticks
+// does not overflow
+
+static void test_mult_shift(void) {
+    static const uint32_t rates[] = {
+        10000000, 19200000, 24000000, 25000000, 54000000, 62500000, 1000000000,
+    };
+    bool precise = true, fits = true;
+
+    for (unsigned int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        uint32_t mult, shift;
+        uint64_t ns, err;
+
+        clocks_calc_mult_shift(&mult, &shift, rates[i], NSEC_PER_SEC, CLOCKSOURCE_MAX_SEC);
+        ns = clocksource_cyc2ns(rates[i], mult, shift);
+        err = ns > NSEC_PER_SEC ? ns - NSEC_PER_SEC : NSEC_PER_SEC - ns;
+        if (err > NSEC_PER_SEC / 1000000) {
+            precise = false;
+        }
+        if ((uint64_t)rates[i] * CLOCKSOURCE_MAX_SEC > UINT64_MAX / mult) {
+            fits = false;
+        }
+    }
+    test_check("mult/shift converts within 1 ppm", precise);
+    test_check("mult/shift covers CLOCKSOURCE_MAX_SEC", fits);
+}
+
+// ktime_get_ns() never goes backwards and agrees with the tick
+
+static void test_ktime(void) {
+    uint64_t prev = ktime_get_ns();
+    bool monotonic = true;
+
+    for (int i = 0; i < KTIME_READS; i++) {
+        uint64_t now = ktime_get_ns();
+        if (now < prev) {
+            monotonic = false;
+        }
+        prev = now;
+    }
+    test_check("ktime_get_ns is monotonic", monotonic);
+
+    uint64_t j = jiffies;
+    uint64_t start = ktime_get_ns();
+    msleep(100);
+    uint64_t slept = ktime_get_ns() - start;
+    uint64_t ticks = jiffies - j;
+
+    uart_puts("  msleep(100): ");
+    uart_putdec(slept / NSEC_PER_USEC);
+    uart_puts(" us, ");
+    uart_putdec(ticks);
+    uart_puts(" ticks\n");
+    test_check("ktime and jiffies agree to a tick",
+               slept + TICK_NSEC >= ticks * TICK_NSEC && slept <= (ticks + 1) * TICK_NSEC);
+}
+
+// Sleep until the given jiffy has passed
+static void wait_until_jiffy(uint64_t j) {
+    while (jiffies <= j) {
+        msleep(10);
+    }
+}
+
+// A timer fires on the jiffy it was set for
+
+struct recorded_timer {
+    struct timer_list timer;
+    volatile uint64_t fired_at;
+    volatile int fired;
+};
+
+static void record_fn(struct timer_list *timer) {
+    struct recorded_timer *rt = container_of(timer, struct recorded_timer, timer);
+
+    rt->fired_at = jiffies;
+    rt->fired++;
+}
+
+static void test_timer_basic(void) {
+    struct recorded_timer rt = { .fired = 0 };
+
+    timer_setup(&rt.timer, record_fn);
+    rt.timer.expires = jiffies + 5;
+    add_timer(&rt.timer);
+    test_check("timer is pending after add_timer", timer_pending(&rt.timer));
+
+    wait_until_jiffy(rt.timer.expires + 2);
+    test_check("timer fires once", rt.fired == 1);
+    test_check("timer fires on its jiffy", rt.fired_at == rt.timer.expires);
+    test_check("timer is not pending after firing", !timer_pending(&rt.timer));
+    del_timer_sync(&rt.timer);
+}
+
+// mod_timer moves a pending timer; del_timer cancels one
+
+static void test_timer_mod_del(void) {
+    struct recorded_timer moved = { .fired = 0 };
+    struct recorded_timer cancelled = { .fired = 0 };
+    uint64_t now = jiffies;
+
+    timer_setup(&moved.timer, record_fn);
+    timer_setup(&cancelled.timer, record_fn);
+
+    test_check("mod_timer on an idle timer returns 0", mod_timer(&moved.timer, now + 3) == 0);
+    test_check("mod_timer on a pending timer returns 1", mod_timer(&moved.timer, now + 8) == 1);
+
+    mod_timer(&cancelled.timer, now + 4);
+    test_check("del_timer on a pending timer returns 1", del_timer(&cancelled.timer) == 1);
+    test_check("del_timer on an idle timer returns 0", del_timer(&cancelled.timer) == 0);
+
+    wait_until_jiffy(now + 10);
+    test_check("moved timer fires at the new time", moved.fired == 1 && moved.fired_at == now + 8);
+    test_check("cancelled timer never fires", cancelled.fired == 0);
+    test_check("del_timer_sync on a fired timer", del_timer_sync(&moved.timer) == 0);
+}
+
+// Timers fire in expiry order, whatever order they were added in
+
+static struct timer_list order_timers[TIMER_ORDER_COUNT];
+static volatile int order_seen[TIMER_ORDER_COUNT];
+static volatile int order_next;
+
+static void order_fn(struct timer_list *timer) {
+    order_seen[order_next++] = (int)(timer - order_timers);
+}
+
+static void test_timer_order(void) {
+    uint64_t now = jiffies;
+    bool ok = true;
+
+    order_next = 0;
+    for (int i = TIMER_ORDER_COUNT - 1; i >= 0; i--) {
+        timer_setup(&order_timers[i], order_fn);
+        mod_timer(&order_timers[i], now + 3 + i * 2);
+    }
+
+    wait_until_jiffy(now + 3 + TIMER_ORDER_COUNT * 2);
+    for (int i = 0; i < TIMER_ORDER_COUNT; i++) {
+        if (order_seen[i] != i) {
+            ok = false;
+        }
+    }
+    test_check("timers fire in expiry order", ok && order_next == TIMER_ORDER_COUNT);
+}
+
+// A timer past the first 256-slot level cascades down and still fires
+// on the right jiffy
+
+static void test_timer_cascade(void) {
+    struct recorded_timer rt = { .fired = 0 };
+
+    timer_setup(&rt.timer, record_fn);
+    mod_timer(&rt.timer, jiffies + 300);
+
+    wait_until_jiffy(rt.timer.expires + 2);
+    test_check("cascaded timer fires on its jiffy", rt.fired == 1 && rt.fired_at == rt.timer.expires);
+    del_timer_sync(&rt.timer);
+}
+
+// A callback can re-arm its own timer
+
+static struct timer_list rearm_timer;
+static volatile int rearm_count;
+
+static void rearm_fn(struct timer_list *timer) {
+    if (++rearm_count < 5) {
+        mod_timer(timer, jiffies + 1);
+    }
+}
+
+static void test_timer_rearm(void) {
+    rearm_count = 0;
+    timer_setup(&rearm_timer, rearm_fn);
+    mod_timer(&rearm_timer, jiffies + 1);
+
+    msleep(200);
+    test_check("timer re-arms itself from its callback", rearm_count == 5);
+}
+
+// An hrtimer fires at its counter value, well inside a tick
+
+static struct hrtimer oneshot;
+static volatile uint64_t oneshot_fired;
+
+static enum hrtimer_restart oneshot_fn(struct hrtimer *timer) {
+    (void)timer;
+    oneshot_fired = ktime_get_ns();
+    return HRTIMER_NORESTART;
+}
+
+static void test_hrtimer_oneshot(void) {
+    uint64_t expires = ktime_get_ns() + 2500 * NSEC_PER_USEC;
+
+    oneshot_fired = 0;
+    hrtimer_init(&oneshot, oneshot_fn);
+    hrtimer_start(&oneshot, expires);
+
+    msleep(30);
+
+    bool fired = oneshot_fired != 0;
+    test_check("hrtimer fires", fired);
+    if (!fired) {
+        return;
+    }
+
+    uint64_t late = oneshot_fired - expires;
+    uart_puts("  hrtimer latency: ");
+    uart_putdec(late);
+    uart_puts(" ns\n");
+    test_check("hrtimer does not fire early", oneshot_fired >= expires);
+    test_check("hrtimer fires within a tick", late < TICK_NSEC);
+}
+
+// A periodic hrtimer keeps its period with hrtimer_forward()
+
+static struct hrtimer periodic;
+static volatile int periodic_count;
+static uint64_t periodic_interval;
+
+static enum hrtimer_restart periodic_fn(struct hrtimer *timer) {
+    if (++periodic_count >= HRTIMER_PERIODS) {
+        return HRTIMER_NORESTART;
+    }
+    hrtimer_forward(timer, ktime_get_ns(), periodic_interval);
+    return HRTIMER_RESTART;
+}
+
+static void test_hrtimer_periodic(void) {
+    uint64_t start = ktime_get_ns();
+
+    periodic_count = 0;
+    periodic_interval = NSEC_PER_MSEC;
+    hrtimer_init(&periodic, periodic_fn);
+    hrtimer_start(&periodic, start + periodic_interval);
+
+    msleep(HRTIMER_PERIODS + 30);
+    test_check("periodic hrtimer runs its periods", periodic_count == HRTIMER_PERIODS);
+    test_check("periodic hrtimer is idle afterwards", !hrtimer_is_queued(&periodic));
+}
+
+// A cancelled hrtimer does not fire
+
+static void test_hrtimer_cancel(void) {
+    oneshot_fired = 0;
+    hrtimer_init(&oneshot, oneshot_fn);
+    hrtimer_start(&oneshot, ktime_get_ns() + 5 * NSEC_PER_MSEC);
+
+    test_check("hrtimer_cancel on a queued timer returns 1", hrtimer_cancel(&oneshot) == 1);
+    msleep(20);
+    test_check("cancelled hrtimer never fires", oneshot_fired == 0);
+    test_check("hrtimer_cancel on an idle timer returns 0", hrtimer_cancel(&oneshot) == 0);
+}
+
+// Sleeping on a timer 20 ticks out, the idle boot CPU defers the tick to
+// that timer instead of taking every tick in between
+
+static void test_nohz_idle(void) {
+    unsigned int cpu = smp_processor_id();
+    struct idle_stats before, after;
+
+    tick_idle_get_stats(cpu, &before);
+    msleep(200);
+    tick_idle_get_stats(cpu, &after);
+
+    uint64_t idle_ticks = after.idle_ticks - before.idle_ticks;
+    uart_puts("  200 ms asleep: ");
+    uart_putdec(after.ticks - before.ticks);
+    uart_puts(" ticks, ");
+    uart_putdec(idle_ticks);
+    uart_puts(" while idle, ");
+    uart_putdec((after.idle_ns - before.idle_ns) / NSEC_PER_MSEC);
+    uart_puts(" ms idle\n");
+
+    test_check("idle time is accounted", after.idle_ns - before.idle_ns >= 150 * NSEC_PER_MSEC);
+    if (after.tick_stops == before.tick_stops) {
+        uart_puts("[SKIP] tick kept while idle (other CPUs online)\n");
+        return;
+    }
+    test_check("idle CPU skips the ticks in between", idle_ticks <= 2);
+}
+
+void run_timer_tests(void) {
+    test_suite_begin("Timer Tests");
+
+    test_mult_shift();
+
+    if (!tick_is_running()) {
+        uart_puts("[SKIP] no tick\n");
+        return;
+    }
+
+    test_ktime();
+    test_timer_basic();
+    test_timer_mod_del();
+    test_timer_order();
+    test_timer_cascade();
+    test_timer_rearm();
+    test_hrtimer_oneshot();
+    test_hrtimer_periodic();
+    test_hrtimer_cancel();
+    test_nohz_idle();
+
+    struct clock_event_device *dev = clockevents_get_device();
+    uart_puts("  Clock events: ");
+    uart_putdec(dev->nr_events);
+    uart_puts(" interrupts, ");
+    uart_putdec(dev->nr_programmed);
+    uart_puts(" reprograms\n");
+    tick_idle_print_stats();
+
+    test_suite_end("Timer tests");
+}
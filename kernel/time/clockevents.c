@@ -0,0 +1,122 @@
+/*
+ * kernel/time/clockevents.c
+ *
+ * Clock event device registration and programming
+ */
+
+#include <time/clockevents.h>
+#include <time/clocksource.h>
+#include <time/timekeeping.h>
+#include <irq/irq.h>
+#include <smp.h>
+#include <uart.h>
+#include <stddef.h>
+
+static struct clock_event_device *ce_dev;
+
+static void clockevents_irq(void *data) {
+    struct clock_event_device *dev = data;
+
+    dev->nr_events++;
+    dev->next_event = UINT64_MAX;
+
+    if (dev->event_handler) {
+        dev->event_handler(dev);
+    }
+
+    // The interrupt stays asserted until the timer is reprogrammed or
+    // stopped; stop it if the handler had nothing further to schedule
+    if (dev->next_event == UINT64_MAX) {
+        dev->set_state_shutdown(dev);
+    }
+}
+
+// Ticks to ns without overflowing, rounded up or down
+static uint64_t clockevent_ticks_to_ns(uint64_t ticks, uint32_t freq, bool round_up) {
+    uint64_t rem = (ticks % freq) * NSEC_PER_SEC;
+
+    return (ticks / freq) * NSEC_PER_SEC + (rem + (round_up ? freq - 1 : 0)) / freq;
+}
+
+static int clockevents_register_device(struct clock_event_device *dev) {
+    dev->cpu = smp_processor_id();
+    dev->next_event = UINT64_MAX;
+    dev->set_state_shutdown(dev);
+
+    if (request_irq(dev->virq, clockevents_irq, 0, dev->name, dev) != 0) {
+        uart_puts("CLOCKEVENTS: cannot claim timer interrupt\n");
+        return -1;
+    }
+
+    ce_dev = dev;
+
+    uart_puts("CLOCKEVENTS: ");
+    uart_puts(dev->name);
+    uart_puts(", ");
+    uart_putdec(dev->freq);
+    uart_puts(" Hz, mult ");
+    uart_putdec(dev->mult);
+    uart_puts(" shift ");
+    uart_putdec(dev->shift);
+    uart_puts(", IRQ ");
+    uart_putdec(dev->virq);
+    uart_puts("\n");
+    return 0;
+}
+
+int clockevents_config_and_register(struct clock_event_device *dev, uint32_t freq,
+                                    uint64_t min_delta, uint64_t max_delta) {
+    uint64_t sec;
+
+    if (!dev || !dev->set_next_event || !dev->set_state_shutdown || freq == 0) {
+        return -1;
+    }
+
+    // mult is chosen so the longest delta, in ns, cannot overflow the
+    // multiply; no deadline needs to be further out than a few minutes
+    sec = max_delta / freq;
+    if (sec == 0) {
+        sec = 1;
+    } else if (sec > CLOCKSOURCE_MAX_SEC) {
+        sec = CLOCKSOURCE_MAX_SEC;
+    }
+
+    if (max_delta > sec * freq) {
+        max_delta = sec * freq;
+    }
+
+    dev->freq = freq;
+    clocks_calc_mult_shift(&dev->mult, &dev->shift, NSEC_PER_SEC, freq, (uint32_t)sec);
+    dev->min_delta_ns = clockevent_ticks_to_ns(min_delta ? min_delta : 1, freq, true);
+    dev->max_delta_ns = clockevent_ticks_to_ns(max_delta, freq, false);
+
+    return clockevents_register_device(dev);
+}
+
+void clockevents_program_event(struct clock_event_device *dev, uint64_t expires) {
+    uint64_t now = ktime_get_ns();
+    uint64_t delta = expires > now ? expires - now : 0;
+    uint64_t ticks;
+
+    if (delta < dev->min_delta_ns) {
+        delta = dev->min_delta_ns;
+    } else if (delta > dev->max_delta_ns) {
+        delta = dev->max_delta_ns;
+    }
+
+    // Rounding down could fire a fraction of a tick early
+    ticks = ((delta * dev->mult) >> dev->shift) + 1;
+
+    dev->next_event = expires;
+    dev->nr_programmed++;
+    dev->set_next_event(dev, ticks);
+}
+
+void clockevents_shutdown(struct clock_event_device *dev) {
+    dev->next_event = UINT64_MAX;
+    dev->set_state_shutdown(dev);
+}
+
+struct clock_event_device *clockevents_get_device(void) {
+    return ce_dev;
+}
@@ -0,0 +1,75 @@
+/*
+ * kernel/time/clocksource.c
+ *
+ * Clocksource registration and cycle to nanosecond conversion factors
+ */
+
+#include <time/clocksource.h>
+#include <time/timekeeping.h>
+#include <uart.h>
+
+void clocks_calc_mult_shift(uint32_t *mult, uint32_t *shift, uint32_t from,
+                            uint32_t to, uint32_t maxsec) {
+    uint64_t tmp;
+    uint32_t sft, sftacc = 32;
+
+    // Bits of headroom needed above 32 for maxsec worth of input; mult
+    // has to fit in what is left
+    tmp = ((uint64_t)maxsec * from) >> 32;
+    while (tmp) {
+        tmp >>= 1;
+        sftacc--;
+    }
+
+    // The largest shift, hence the most precise mult, that still fits
+    for (sft = 32; sft > 0; sft--) {
+        tmp = (uint64_t)to << sft;
+        tmp += from / 2;
+        tmp /= from;
+        if ((tmp >> sftacc) == 0) {
+            break;
+        }
+    }
+    *mult = (uint32_t)tmp;
+    *shift = sft;
+}
+
+int clocksource_register_hz(struct clocksource *cs, uint32_t hz) {
+    uint64_t sec;
+
+    if (!cs || !cs->read || !cs->mask || hz == 0) {
+        return -1;
+    }
+
+    // Convert at most CLOCKSOURCE_MAX_SEC at once, or one counter wrap
+    // if that comes sooner. The tick folds time in far more often.
+    sec = cs->mask / hz;
+    if (sec == 0) {
+        sec = 1;
+    } else if (sec > CLOCKSOURCE_MAX_SEC) {
+        sec = CLOCKSOURCE_MAX_SEC;
+    }
+
+    cs->freq = hz;
+    clocks_calc_mult_shift(&cs->mult, &cs->shift, hz, NSEC_PER_SEC, (uint32_t)sec);
+
+    // Half the range, leaving room for the sub-nanosecond remainder the
+    // timekeeper adds on top
+    cs->max_cycles = (UINT64_MAX >> 1) / cs->mult;
+    if (cs->max_cycles > cs->mask) {
+        cs->max_cycles = cs->mask;
+    }
+
+    uart_puts("CLOCKSOURCE: ");
+    uart_puts(cs->name);
+    uart_puts(", ");
+    uart_putdec(hz);
+    uart_puts(" Hz, mult ");
+    uart_putdec(cs->mult);
+    uart_puts(" shift ");
+    uart_putdec(cs->shift);
+    uart_puts("\n");
+
+    timekeeping_set_clocksource(cs);
+    return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * kernel/time/hrtimer.c
+ *
+ * Sorted hrtimer queue driven by the clock event device
+ */
+
+#include <time/hrtimer.h>
+#include <time/clockevents.h>
+#include <time/timekeeping.h>
+#include <spinlock.h>
+#include <smp.h>
+#include <arch_timer.h>
+#include <stddef.h>
+
+static struct hrtimer_base {
+    spinlock_t lock;
+    struct list_head queue;             // Sorted by expires, earliest first
+    struct hrtimer *running;            // Callback in progress
+    struct clock_event_device *dev;
+} hrtimer_base = {
+    .lock = SPINLOCK_INITIALIZER,
+    .queue = LIST_HEAD_INIT(hrtimer_base.queue),
+};
+
+// Program the device for the first queued timer, or stop it if there is
+// none, if this CPU owns it. Returns false if another CPU does and has to
+// be asked. Called with the lock held.
+static bool hrtimer_reprogram(void) {
+    struct clock_event_device *dev = hrtimer_base.dev;
+
+    if (!dev) {
+        return true;
+    }
+    if (dev->cpu != smp_processor_id()) {
+        return false;
+    }
+
+    // Nothing queued: no interrupt at all, so an idle CPU stays asleep
+    if (list_empty(&hrtimer_base.queue)) {
+        if (dev->next_event != UINT64_MAX) {
+            clockevents_shutdown(dev);
+        }
+        return true;
+    }
+
+    struct hrtimer *first = list_first_entry(&hrtimer_base.queue, struct hrtimer, node);
+    if (first->expires != dev->next_event) {
+        clockevents_program_event(dev, first->expires);
+    }
+    return true;
+}
+
+// Insert in expiry order, after timers with the same expiry. Returns true
+// if the timer went to the front. Called with the lock held.
+static bool enqueue_hrtimer(struct hrtimer *timer) {
+    struct list_head *pos;
+
+    list_for_each(pos, &hrtimer_base.queue) {
+        struct hrtimer *other = list_entry(pos, struct hrtimer, node);
+        if (other->expires > timer->expires) {
+            break;
+        }
+    }
+    // Before pos: at the tail if the loop ran off the end
+    list_add_tail(&timer->node, pos);
+    return hrtimer_base.queue.next == &timer->node;
+}
+
+void hrtimer_init(struct hrtimer *timer, enum hrtimer_restart (*function)(struct hrtimer *)) {
+    list_init(&timer->node);
+    timer->expires = 0;
+    timer->function = function;
+}
+
+void hrtimer_start(struct hrtimer *timer, uint64_t expires) {
+    unsigned long flags;
+    bool was_first = false;
+    bool remote = false;
+
+    spin_lock_irqsave(&hrtimer_base.lock, flags);
+    if (hrtimer_is_queued(timer)) {
+        was_first = hrtimer_base.queue.next == &timer->node;
+        list_del(&timer->node);
+    }
+    timer->expires = expires;
+    // Moving the first timer later also changes the next event. Inside
+    // the handler the queue is reprogrammed on the way out.
+    if ((enqueue_hrtimer(timer) || was_first) && hrtimer_base.running == NULL) {
+        remote = !hrtimer_reprogram();
+    }
+    spin_unlock_irqrestore(&hrtimer_base.lock, flags);
+
+    // The device belongs to another CPU, which may be asleep with it
+    // programmed for later or not at all
+    if (remote) {
+        smp_send_ipi(hrtimer_base.dev->cpu, IPI_TIMER);
+    }
+}
+
+int hrtimer_try_to_cancel(struct hrtimer *timer) {
+    unsigned long flags;
+    int was_queued = 0;
+
+    spin_lock_irqsave(&hrtimer_base.lock, flags);
+    if (hrtimer_is_queued(timer)) {
+        bool first = hrtimer_base.queue.next == &timer->node;
+
+        list_del(&timer->node);
+        was_queued = 1;
+
+        // Move the device on to the next timer rather than take an
+        // interrupt for nothing; the handler reprograms on its way out
+        // A CPU that does not own the device leaves it alone: the early
+        // interrupt finds nothing to run and programs the next timer.
+        if (first && hrtimer_base.running == NULL) {
+            hrtimer_reprogram();
+        }
+    }
+    spin_unlock_irqrestore(&hrtimer_base.lock, flags);
+
+    return was_queued;
+}
+
+int hrtimer_cancel(struct hrtimer *timer) {
+    int was_queued = hrtimer_try_to_cancel(timer);
+
+    while (__atomic_load_n(&hrtimer_base.running, __ATOMIC_ACQUIRE) == timer) {
+        arch_cpu_relax();
+    }
+    // A periodic callback may have requeued itself meanwhile
+    return hrtimer_try_to_cancel(timer) || was_queued;
+}
+
+uint64_t hrtimer_forward(struct hrtimer *timer, uint64_t now, uint64_t interval) {
+    uint64_t overruns;
+
+    if (now < timer->expires || interval == 0) {
+        return 0;
+    }
+
+    overruns = (now - timer->expires) / interval + 1;
+    timer->expires += overruns * interval;
+    return overruns;
+}
+
+static void hrtimer_interrupt(struct clock_event_device *dev) {
+    unsigned long flags;
+
+    (void)dev;
+
+    spin_lock_irqsave(&hrtimer_base.lock, flags);
+    while (!list_empty(&hrtimer_base.queue)) {
+        struct hrtimer *timer = list_first_entry(&hrtimer_base.queue, struct hrtimer, node);
+
+        if (timer->expires > ktime_get_ns()) {
+            break;
+        }
+
+        list_del(&timer->node);
+        hrtimer_base.running = timer;
+        spin_unlock_irqrestore(&hrtimer_base.lock, flags);
+
+        enum hrtimer_restart restart = timer->function(timer);
+
+        spin_lock_irqsave(&hrtimer_base.lock, flags);
+        // The callback may also have restarted it with hrtimer_start()
+        if (restart == HRTIMER_RESTART && !hrtimer_is_queued(timer)) {
+            enqueue_hrtimer(timer);
+        }
+        __atomic_store_n(&hrtimer_base.running, NULL, __ATOMIC_RELEASE);
+    }
+    hrtimer_reprogram();
+    spin_unlock_irqrestore(&hrtimer_base.lock, flags);
+}
+
+void hrtimer_ipi(void) {
+    unsigned long flags;
+
+    spin_lock_irqsave(&hrtimer_base.lock, flags);
+    // A running callback reprograms on its way out
+    if (hrtimer_base.running == NULL) {
+        hrtimer_reprogram();
+    }
+    spin_unlock_irqrestore(&hrtimer_base.lock, flags);
+}
+
+void hrtimers_init(void) {
+    unsigned long flags;
+    struct clock_event_device *dev = clockevents_get_device();
+
+    if (!dev) {
+        return;
+    }
+
+    spin_lock_irqsave(&hrtimer_base.lock, flags);
+    hrtimer_base.dev = dev;
+    dev->event_handler = hrtimer_interrupt;
+    hrtimer_reprogram();
+    spin_unlock_irqrestore(&hrtimer_base.lock, flags);
+}
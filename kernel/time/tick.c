@@ -0,0 +1,299 @@
+/*
+ * kernel/time/tick.c
+ *
+ * Periodic tick emulated with an hrtimer, stopped while the CPU idles
+ */
+
+#include <time/tick.h>
+#include <time/timer.h>
+#include <time/hrtimer.h>
+#include <time/clockevents.h>
+#include <time/timekeeping.h>
+#include <sched.h>
+#include <rcu.h>
+#include <smp.h>
+#include <percpu.h>
+#include <seqlock.h>
+#include <spinlock.h>
+#include <arch_cpu.h>
+#include <uart.h>
+
+static struct hrtimer tick_timer;
+static uint64_t tick_next;              // Next tick boundary, in ns
+static spinlock_t tick_lock = SPINLOCK_INITIALIZER;    // jiffies, tick_next
+static unsigned int tick_cpu;
+static volatile bool tick_running;
+static bool tick_stopped;               // Idle with the tick off or pushed out
+
+// Per-CPU idle state. Written only by its own CPU with interrupts
+// masked; other CPUs read it under the sequence count.
+struct tick_idle {
+    seqcount_t seq;
+    struct idle_stats stats;
+    uint64_t idle_start;
+    bool in_idle;                       // Between idle_enter and idle_exit
+};
+
+static DEFINE_PER_CPU_ALIGNED(struct tick_idle, tick_idle);
+
+// Count every period that passed, so jiffies keeps time even if the
+// interrupt was held off or the tick was stopped for a while. Also run
+// by a CPU leaving idle while the tick is stopped. Returns the next tick
+// boundary.
+static uint64_t tick_update_jiffies(uint64_t now) {
+    unsigned long flags;
+    uint64_t next;
+
+    spin_lock_irqsave(&tick_lock, flags);
+    if (now >= tick_next) {
+        uint64_t ticks = (now - tick_next) / TICK_NSEC + 1;
+
+        tick_next += ticks * TICK_NSEC;
+        jiffies += ticks;
+    }
+    next = tick_next;
+    spin_unlock_irqrestore(&tick_lock, flags);
+
+    return next;
+}
+
+static void tick_account(void) {
+    struct tick_idle *ti = this_cpu_ptr(tick_idle);
+
+    write_seqcount_begin(&ti->seq);
+    ti->stats.ticks++;
+    if (get_current()->flags & TASK_FLAG_IDLE) {
+        ti->stats.idle_ticks++;
+    }
+    write_seqcount_end(&ti->seq);
+}
+
+// Only this CPU has a tick. Pass it on to the others that are running
+// something, so their threads get time-sliced and report quiescent
+// states too; an idle CPU has nothing to slice and stays asleep.
+static void tick_forward(void) {
+    cpumask_t mask = 0;
+    unsigned int cpu;
+
+    if (!smp_ipi_available()) {
+        return;
+    }
+
+    for_each_online_cpu(cpu) {
+        if (cpu != tick_cpu &&
+            !__atomic_load_n(&per_cpu_ptr(tick_idle, cpu)->in_idle, __ATOMIC_RELAXED)) {
+            mask |= cpumask_of(cpu);
+        }
+    }
+    if (mask) {
+        smp_send_ipi_mask(mask, IPI_TICK);
+    }
+}
+
+static enum hrtimer_restart tick_handler(struct hrtimer *timer) {
+    uint64_t next = tick_update_jiffies(ktime_get_ns());
+
+    tick_account();
+
+    timekeeping_update();
+    run_timers();
+    smp_poll_call_queue();
+    sched_tick();
+    tick_forward();
+
+    timer->expires = next;
+    return HRTIMER_RESTART;
+}
+
+void tick_ipi(void) {
+    tick_account();
+    sched_tick();
+}
+
+void tick_init(void) {
+    if (arch_clockevent_init() != 0) {
+        uart_puts("TICK: no timer interrupt, running without a tick\n");
+        return;
+    }
+    hrtimers_init();
+
+    tick_cpu = smp_processor_id();
+    tick_next = ktime_get_ns() + TICK_NSEC;
+    hrtimer_init(&tick_timer, tick_handler);
+    tick_running = true;
+    hrtimer_start(&tick_timer, tick_next);
+
+    uart_puts("TICK: ");
+    uart_putdec(HZ);
+    uart_puts(" Hz, stopped when idle\n");
+
+    arch_enable_interrupts();
+}
+
+bool tick_is_running(void) {
+    return tick_running;
+}
+
+// True if every other online CPU is in its idle loop. Seen together with
+// tick_stopped in tick_nohz_idle_exit(): each side stores, then loads the
+// other's flag, both sequentially consistent, so at least one of them
+// notices the other.
+static bool tick_others_idle(void) {
+    unsigned int cpu;
+
+    for_each_online_cpu(cpu) {
+        if (cpu != tick_cpu &&
+            !__atomic_load_n(&per_cpu_ptr(tick_idle, cpu)->in_idle, __ATOMIC_SEQ_CST)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Stop the tick, or push it out to the next timer_list expiry. The
+// hrtimer queue then programs the device for whatever is due first, or
+// switches it off if nothing is. Returns true if the tick was changed.
+static bool tick_nohz_stop_tick(void) {
+    unsigned long flags;
+    uint64_t next, expires = 0;
+    bool stop;
+
+    // Callbacks queued here only advance when this CPU comes round its
+    // idle loop
+    if (rcu_pending()) {
+        return false;
+    }
+
+    // Without IPIs this CPU only notices work handed to it on a tick
+    if (num_online_cpus() > 1 && !smp_ipi_available()) {
+        return false;
+    }
+
+    // A busy CPU may read jiffies or queue timers at any moment: keep
+    // ticking for it. One that leaves idle from here on sees the flag and
+    // kicks this CPU; wakeups and hrtimers armed here send their own IPI.
+    __atomic_store_n(&tick_stopped, true, __ATOMIC_SEQ_CST);
+    if (!tick_others_idle()) {
+        tick_stopped = false;
+        return false;
+    }
+
+    next = timer_next_expiry();
+
+    spin_lock_irqsave(&tick_lock, flags);
+    stop = next > jiffies + 1;
+    if (stop && next != UINT64_MAX) {
+        // The tick that takes jiffies to next
+        expires = tick_next + (next - jiffies - 1) * TICK_NSEC;
+    }
+    spin_unlock_irqrestore(&tick_lock, flags);
+
+    if (!stop) {
+        tick_stopped = false;
+        return false;
+    }
+
+    if (next == UINT64_MAX) {
+        hrtimer_try_to_cancel(&tick_timer);
+    } else {
+        hrtimer_start(&tick_timer, expires);
+    }
+    return true;
+}
+
+void tick_nohz_idle_enter(void) {
+    struct tick_idle *ti = this_cpu_ptr(tick_idle);
+    bool stopped = false;
+
+    // Without IPIs the tick is how other CPUs' calls and wakeups reach
+    // this one, so it keeps running
+    if (tick_running && smp_processor_id() == tick_cpu &&
+        (smp_ipi_available() || num_online_cpus() == 1)) {
+        stopped = tick_nohz_stop_tick();
+    }
+
+    write_seqcount_begin(&ti->seq);
+    if (stopped) {
+        ti->stats.tick_stops++;
+    }
+    ti->idle_start = ktime_get_ns();
+    write_seqcount_end(&ti->seq);
+
+    __atomic_store_n(&ti->in_idle, true, __ATOMIC_SEQ_CST);
+}
+
+void tick_nohz_idle_exit(void) {
+    struct tick_idle *ti = this_cpu_ptr(tick_idle);
+    uint64_t now = ktime_get_ns();
+    uint64_t residency = now - ti->idle_start;
+
+    __atomic_store_n(&ti->in_idle, false, __ATOMIC_SEQ_CST);
+
+    write_seqcount_begin(&ti->seq);
+    ti->stats.sleeps++;
+    ti->stats.idle_ns += residency;
+    if (residency > ti->stats.max_idle_ns) {
+        ti->stats.max_idle_ns = residency;
+    }
+    write_seqcount_end(&ti->seq);
+
+    // Back on the period. If tick boundaries passed while it was off,
+    // the tick fires at once and catches jiffies up.
+    if (smp_processor_id() == tick_cpu) {
+        if (tick_stopped) {
+            unsigned long flags;
+            uint64_t next;
+
+            spin_lock_irqsave(&tick_lock, flags);
+            next = tick_next;
+            spin_unlock_irqrestore(&tick_lock, flags);
+
+            tick_stopped = false;
+            hrtimer_start(&tick_timer, next);
+        }
+        return;
+    }
+
+    // Busy from here on, with the tick CPU asleep: bring jiffies up to
+    // date for whatever runs next, and get the tick going again
+    if (tick_running && __atomic_load_n(&tick_stopped, __ATOMIC_SEQ_CST)) {
+        tick_update_jiffies(now);
+        smp_send_reschedule(tick_cpu);
+    }
+}
+
+void tick_idle_get_stats(unsigned int cpu, struct idle_stats *stats) {
+    struct tick_idle *ti = per_cpu_ptr(tick_idle, cpu);
+    unsigned int seq;
+
+    do {
+        seq = read_seqcount_begin(&ti->seq);
+        *stats = ti->stats;
+    } while (read_seqcount_retry(&ti->seq, seq));
+}
+
+void tick_idle_print_stats(void) {
+    unsigned int cpu;
+
+    uart_puts("\nIdle statistics:\n");
+    for_each_online_cpu(cpu) {
+        struct idle_stats stats;
+
+        tick_idle_get_stats(cpu, &stats);
+        uart_puts("  CPU ");
+        uart_putdec(cpu);
+        uart_puts(": ");
+        uart_putdec(stats.sleeps);
+        uart_puts(" sleeps, ");
+        uart_putdec(stats.idle_ns / NSEC_PER_MSEC);
+        uart_puts(" ms idle, longest ");
+        uart_putdec(stats.max_idle_ns / NSEC_PER_USEC);
+        uart_puts(" us, ");
+        uart_putdec(stats.ticks);
+        uart_puts(" ticks (");
+        uart_putdec(stats.idle_ticks);
+        uart_puts(" idle), tick stopped ");
+        uart_putdec(stats.tick_stops);
+        uart_puts(" times\n");
+    }
+}
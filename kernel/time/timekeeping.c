@@ -0,0 +1,137 @@
+/*
+ * kernel/time/timekeeping.c
+ *
+ * Seqcount-protected timekeeper behind ktime_get_ns()
+ */
+
+#include <time/timekeeping.h>
+#include <time/clocksource.h>
+#include <seqlock.h>
+#include <spinlock.h>
+#include <uart.h>
+
+static uint64_t dummy_read(struct clocksource *cs) {
+    (void)cs;
+    return 0;
+}
+
+// Stands in until the architecture registers its counter; time stays 0
+static struct clocksource clocksource_dummy = {
+    .name = "dummy",
+    .read = dummy_read,
+    .mask = CLOCKSOURCE_MASK(64),
+    .max_cycles = UINT64_MAX,
+};
+
+/*
+ * Everything a reader needs, on its own cache line. The clocksource's
+ * conversion factors are copied in so a read touches nothing else.
+ */
+static struct timekeeper {
+    seqcount_t seq;
+    struct clocksource *cs;
+    uint64_t cycle_last;                // Counter at the last update
+    uint64_t base_ns;                   // Whole ns at cycle_last
+    uint64_t frac;                      // Sub-ns remainder at cycle_last, << shift
+    uint64_t mask;
+    uint64_t max_cycles;
+    uint32_t mult;
+    uint32_t shift;
+} tk __attribute__((aligned(64))) = {
+    .seq = SEQCNT_ZERO,
+    .cs = &clocksource_dummy,
+    .mask = CLOCKSOURCE_MASK(64),
+    .max_cycles = UINT64_MAX,
+};
+
+// Serialises writers. A raw lock: spinlock_t's lock statistics read the
+// time, which would spin on the odd sequence count held here.
+static arch_spinlock_t tk_lock = ARCH_SPINLOCK_INITIALIZER;
+
+// Cycles since cycle_last. A counter read that was ordered before the
+// last update looks like a huge delta; count it as zero.
+static inline uint64_t tk_delta(uint64_t cycles) {
+    uint64_t delta = (cycles - tk.cycle_last) & tk.mask;
+
+    return delta > (tk.mask >> 1) ? 0 : delta;
+}
+
+// (frac + delta * mult) >> shift, exactly, for any delta
+static inline uint64_t tk_delta_to_ns(uint64_t delta) {
+    if (delta <= tk.max_cycles) {
+        return (tk.frac + delta * tk.mult) >> tk.shift;
+    }
+
+    // A long stretch without an update, e.g. before the tick starts:
+    // split the multiply so nothing overflows. shift is at most 32.
+    uint64_t lo = (delta & 0xffffffffULL) * tk.mult + tk.frac;
+    uint64_t hi = (delta >> 32) * tk.mult;
+    return (hi << (32 - tk.shift)) + (lo >> tk.shift);
+}
+
+uint64_t ktime_get_ns(void) {
+    struct clocksource *cs;
+    unsigned int seq;
+    uint64_t ns;
+
+    do {
+        seq = read_seqcount_begin(&tk.seq);
+        cs = tk.cs;
+        ns = tk.base_ns + tk_delta_to_ns(tk_delta(cs->read(cs)));
+    } while (read_seqcount_retry(&tk.seq, seq));
+
+    return ns;
+}
+
+// Move cycle_last up to now, keeping the sub-ns remainder so the sum of
+// many updates loses nothing. Inside the write section.
+static void tk_forward(void) {
+    uint64_t now = tk.cs->read(tk.cs);
+    uint64_t delta = tk_delta(now);
+
+    tk.base_ns += tk_delta_to_ns(delta);
+    // The low shift bits of the wrapped 64-bit product are still exact
+    tk.frac = (tk.frac + delta * tk.mult) & ((1ULL << tk.shift) - 1);
+    tk.cycle_last = now;
+}
+
+void timekeeping_update(void) {
+    irqflags_t flags = arch_local_irq_save();
+
+    arch_spin_lock(&tk_lock);
+    write_seqcount_begin(&tk.seq);
+    tk_forward();
+    write_seqcount_end(&tk.seq);
+    arch_spin_unlock(&tk_lock);
+
+    arch_local_irq_restore(flags);
+}
+
+void timekeeping_set_clocksource(struct clocksource *cs) {
+    irqflags_t flags = arch_local_irq_save();
+
+    arch_spin_lock(&tk_lock);
+    write_seqcount_begin(&tk.seq);
+
+    // Account for the time so far on the old source, then carry on from
+    // the same nanosecond on the new one
+    tk_forward();
+    tk.cs = cs;
+    tk.mask = cs->mask;
+    tk.mult = cs->mult;
+    tk.shift = cs->shift;
+    tk.max_cycles = cs->max_cycles;
+    tk.frac = 0;
+    tk.cycle_last = cs->read(cs);
+
+    write_seqcount_end(&tk.seq);
+    arch_spin_unlock(&tk_lock);
+
+    arch_local_irq_restore(flags);
+}
+
+void timekeeping_init(void) {
+    if (arch_clocksource_init() != 0) {
+        uart_puts("TIMEKEEPING: no clocksource, time stands still\n");
+    }
+}
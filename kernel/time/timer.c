@@ -0,0 +1,242 @@
+/*
+ * kernel/time/timer.c
+ *
+ * Cascading timer wheel
+ */
+
+#include <time/timer.h>
+#include <spinlock.h>
+#include <arch_timer.h>
+
+#define TVR_BITS    8
+#define TVN_BITS    6
+#define TVR_SIZE    (1 << TVR_BITS)
+#define TVN_SIZE    (1 << TVN_BITS)
+#define TVR_MASK    (TVR_SIZE - 1)
+#define TVN_MASK    (TVN_SIZE - 1)
+#define TVN_LEVELS  4
+
+// Furthest a timer can be placed: the span of the whole wheel
+#define MAX_TVAL    ((1ULL << (TVR_BITS + TVN_LEVELS * TVN_BITS)) - 1)
+
+// Slot of level n (0 = first 64-slot level) that the clock is in
+#define TVN_INDEX(clk, n)  (((clk) >> (TVR_BITS + (n) * TVN_BITS)) & TVN_MASK)
+
+volatile uint64_t jiffies;
+
+static struct timer_base {
+    spinlock_t lock;
+    uint64_t clk;                       // Next jiffy to process
+    struct timer_list *running;         // Callback in progress
+    struct list_head tv1[TVR_SIZE];
+    struct list_head tvn[TVN_LEVELS][TVN_SIZE];
+    bool initialized;
+} base = {
+    .lock = SPINLOCK_INITIALIZER,
+};
+
+static void timer_base_init(void) {
+    for (int i = 0; i < TVR_SIZE; i++) {
+        list_init(&base.tv1[i]);
+    }
+    for (int n = 0; n < TVN_LEVELS; n++) {
+        for (int i = 0; i < TVN_SIZE; i++) {
+            list_init(&base.tvn[n][i]);
+        }
+    }
+    base.clk = jiffies;
+    base.initialized = true;
+}
+
+// Pick the slot from how far away the timer is. Called with base.lock held.
+static void internal_add_timer(struct timer_list *timer) {
+    uint64_t expires = timer->expires;
+    uint64_t idx = expires - base.clk;
+    struct list_head *vec;
+
+    if ((int64_t)idx < 0) {
+        // Already due: the slot processed next
+        vec = &base.tv1[base.clk & TVR_MASK];
+    } else if (idx < TVR_SIZE) {
+        vec = &base.tv1[expires & TVR_MASK];
+    } else {
+        if (idx > MAX_TVAL) {
+            idx = MAX_TVAL;
+            expires = base.clk + idx;
+        }
+
+        int n = 0;
+        while (idx >= (1ULL << (TVR_BITS + (n + 1) * TVN_BITS))) {
+            n++;
+        }
+        vec = &base.tvn[n][TVN_INDEX(expires, n)];
+    }
+
+    list_add_tail(&timer->entry, vec);
+}
+
+// Move the timers in one slot of level n down to where they now belong.
+// Returns the slot index; zero means level n has turned over too.
+static int cascade(int n, int index) {
+    struct list_head moving;
+
+    list_init(&moving);
+    list_splice_tail_init(&base.tvn[n][index], &moving);
+
+    while (!list_empty(&moving)) {
+        struct timer_list *timer = list_first_entry(&moving, struct timer_list, entry);
+        list_del(&timer->entry);
+        internal_add_timer(timer);
+    }
+    return index;
+}
+
+void timer_setup(struct timer_list *timer, void (*function)(struct timer_list *)) {
+    list_init(&timer->entry);
+    timer->expires = 0;
+    timer->function = function;
+}
+
+// Called with base.lock held
+static int detach_timer(struct timer_list *timer) {
+    if (!timer_pending(timer)) {
+        return 0;
+    }
+    list_del(&timer->entry);
+    return 1;
+}
+
+int mod_timer(struct timer_list *timer, uint64_t expires) {
+    unsigned long flags;
+    int was_pending;
+
+    spin_lock_irqsave(&base.lock, flags);
+    if (!base.initialized) {
+        timer_base_init();
+    }
+    was_pending = detach_timer(timer);
+    timer->expires = expires;
+    internal_add_timer(timer);
+    spin_unlock_irqrestore(&base.lock, flags);
+
+    return was_pending;
+}
+
+void add_timer(struct timer_list *timer) {
+    mod_timer(timer, timer->expires);
+}
+
+int del_timer(struct timer_list *timer) {
+    unsigned long flags;
+    int was_pending;
+
+    spin_lock_irqsave(&base.lock, flags);
+    was_pending = detach_timer(timer);
+    spin_unlock_irqrestore(&base.lock, flags);
+
+    return was_pending;
+}
+
+int del_timer_sync(struct timer_list *timer) {
+    unsigned long flags;
+    int was_pending;
+
+    for (;;) {
+        spin_lock_irqsave(&base.lock, flags);
+        was_pending = detach_timer(timer);
+        if (base.running != timer) {
+            spin_unlock_irqrestore(&base.lock, flags);
+            return was_pending;
+        }
+        spin_unlock_irqrestore(&base.lock, flags);
+        arch_cpu_relax();
+    }
+}
+
+// Earliest expiry among the timers on one list. Called with base.lock held.
+static uint64_t list_next_expiry(struct list_head *list, uint64_t next) {
+    struct list_head *pos;
+
+    list_for_each(pos, list) {
+        struct timer_list *timer = list_entry(pos, struct timer_list, entry);
+        if (timer->expires < next) {
+            next = timer->expires;
+        }
+    }
+    return next;
+}
+
+uint64_t timer_next_expiry(void) {
+    unsigned long flags;
+    uint64_t next = UINT64_MAX;
+
+    spin_lock_irqsave(&base.lock, flags);
+    if (!base.initialized) {
+        spin_unlock_irqrestore(&base.lock, flags);
+        return UINT64_MAX;
+    }
+
+    // First level: the first non-empty slot from the clock on holds the
+    // earliest timers there, each expiring on that slot's jiffy or overdue
+    for (int i = 0; i < TVR_SIZE; i++) {
+        struct list_head *vec = &base.tv1[(base.clk + i) & TVR_MASK];
+        if (!list_empty(vec)) {
+            next = list_next_expiry(vec, UINT64_MAX);
+            break;
+        }
+    }
+
+    // A timer in an upper level may have come within reach of the first
+    // level without being cascaded yet, so check all of them
+    for (int n = 0; n < TVN_LEVELS; n++) {
+        for (int i = 0; i < TVN_SIZE; i++) {
+            next = list_next_expiry(&base.tvn[n][i], next);
+        }
+    }
+    spin_unlock_irqrestore(&base.lock, flags);
+
+    return next;
+}
+
+void run_timers(void) {
+    unsigned long flags;
+    struct list_head work_list;
+
+    list_init(&work_list);
+
+    spin_lock_irqsave(&base.lock, flags);
+    if (!base.initialized) {
+        timer_base_init();
+    }
+
+    while (jiffies >= base.clk) {
+        int index = base.clk & TVR_MASK;
+
+        // The first level wrapped: refill it from the level above, and
+        // so on up while each level wraps in turn
+        if (!index) {
+            for (int n = 0; n < TVN_LEVELS; n++) {
+                if (cascade(n, TVN_INDEX(base.clk, n))) {
+                    break;
+                }
+            }
+        }
+        base.clk++;
+
+        list_splice_tail_init(&base.tv1[index], &work_list);
+        while (!list_empty(&work_list)) {
+            struct timer_list *timer = list_first_entry(&work_list, struct timer_list, entry);
+            void (*fn)(struct timer_list *) = timer->function;
+
+            list_del(&timer->entry);
+            base.running = timer;
+            spin_unlock_irqrestore(&base.lock, flags);
+
+            fn(timer);
+
+            spin_lock_irqsave(&base.lock, flags);
+            base.running = NULL;
+        }
+    }
+    spin_unlock_irqrestore(&base.lock, flags);
+}
@@ -3,6 +3,9 @@
 # Direct kernel boot with QEMU (for testing without U-Boot)
 # This bypasses U-Boot and loads the kernel directly
 
+# Number of CPUs (override with SMP=n)
+SMP="${SMP:-4}"
+
 KERNEL_BIN="build/arm64/kernel.bin"
 
 if [ ! -f "$KERNEL_BIN" ]; then
@@ -18,5 +21,6 @@ qemu-system-aarch64 \
     -M virt \
     -cpu cortex-a53 \
     -m 1G \
+    -smp "$SMP" \
     -nographic \
     -kernel "$KERNEL_BIN"
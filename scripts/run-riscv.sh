@@ -3,6 +3,15 @@
 # Direct kernel boot with QEMU (for testing without U-Boot)
 # This bypasses U-Boot and loads the kernel directly
 
+# Number of CPUs (override with SMP=n)
+SMP="${SMP:-4}"
+
+# CPU model (override with CPU=...). rv64 has Sstc; CPU=rv64,sstc=off
+# makes the kernel fall back to SBI timer calls. For a RISCV_VECTOR=1
+# build, CPU=rv64,v=on,vlen=256 sets the vector length and v=off runs the
+# scalar string routines.
+CPU="${CPU:-rv64}"
+
 KERNEL_BIN="build/riscv/kernel.bin"
 
 if [ ! -f "$KERNEL_BIN" ]; then
@@ -18,7 +27,9 @@ echo "Press Ctrl-A X to exit QEMU"
 # The APLIC driver will configure it for direct mode until MSI is implemented
 qemu-system-riscv64 \
     -M virt,aia=aplic-imsic \
+    -cpu "$CPU" \
     -bios default \
     -m 1G \
+    -smp "$SMP" \
     -nographic \
     -kernel "$KERNEL_BIN"